@@ -0,0 +1,811 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Benchmark of the color conversions and of the de-mosaicing on synthetic frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  Every conversion that dc1394_convert_frames() supports between the color
+  codings, and every de-mosaicing method to each output it supports, is run
+  on frames of each size until it has taken --min-time milliseconds (and at
+  least three times). The median run is reported as nanoseconds and cycles
+  per input pixel, and as millions of input pixels per second. The cycles are
+  those of the time stamp counter on x86, which ticks at a fixed rate, or
+  the nanoseconds times --ghz elsewhere.
+
+  The frames hold a gradient with some noise, which is closer to camera
+  images than uniform noise for the de-mosaicing methods that adapt to the
+  edges. Set DC1394_NO_SIMD in the environment to measure the scalar code.
+
+  With --quality, the de-mosaicing methods are scored instead: full-color
+  reference patterns are mosaiced with each of the four color filters, and
+  the PSNR of the decoded images against the references is reported with
+  the throughput, so the cheapest method that meets a quality bar can be
+  picked. The methods that no other one beats at once in CPSNR and in speed
+  are marked as the Pareto front.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <dc1394/dc1394.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#define BENCH_TICKS() __rdtsc()
+#else
+#define BENCH_HAVE_TSC 0
+#define BENCH_TICKS() 0
+#endif
+
+#define MAX_SIZES 16
+#define MAX_RUNS 1000
+#define PATTERNS 3             /* references of the quality scores */
+
+typedef enum {
+    FORMAT_TABLE = 0,
+    FORMAT_CSV,
+    FORMAT_JSON
+} format_t;
+
+typedef enum {
+    JOB_CONVERT = 0,           /* dc1394_convert_frames() */
+    JOB_DEBAYER,               /* dc1394_debayer_frames(), or _parallel() */
+    JOB_DEBAYER_TO_YUV422,     /* dc1394_debayer_frames_to_YUV422(), or _parallel() */
+    JOB_DEBAYER_TO_CODING      /* dc1394_debayer_frames_to_coding() */
+} job_kind_t;
+
+static const char *job_names[] = { "convert", "debayer", "debayer_to_yuv422", "debayer_to_coding" };
+
+typedef struct {
+    job_kind_t kind;
+    dc1394video_frame_t *in, *out;
+    dc1394bayer_method_t method;
+    dc1394debayer_context_t *ctx; /* NULL for a single thread */
+} job_t;
+
+typedef struct {
+    format_t format;
+    double min_ms;
+    double ghz;
+    uint32_t threads;
+    const char *filter;
+    int quality;               /* score the de-mosaicing instead */
+    int sizes;
+    uint32_t width[MAX_SIZES], height[MAX_SIZES];
+    int results;               /* printed so far */
+} options_t;
+
+static const char *pattern_names[PATTERNS] = { "zoneplate", "edges", "smooth" };
+
+static const char *method_names[DC1394_BAYER_METHOD_NUM] = {
+    "NEAREST", "SIMPLE", "BILINEAR", "HQLINEAR", "DOWNSAMPLE", "EDGESENSE", "VNG", "AHD"
+};
+
+static const char*
+coding_name(dc1394color_coding_t coding)
+{
+    static const char *camera[DC1394_COLOR_CODING_NUM] = {
+        "MONO8", "YUV411", "YUV422", "YUV444", "RGB8", "MONO16", "RGB16", "MONO16S", "RGB16S", "RAW8", "RAW16"
+    };
+    static const char *converted[] = { "RGBA8", "BGRA8", "RGB8_PLANAR", "NV12", "I420" };
+
+    if ((coding >= DC1394_COLOR_CODING_MIN) && (coding <= DC1394_COLOR_CODING_MAX))
+        return camera[coding - DC1394_COLOR_CODING_MIN];
+    if ((coding >= DC1394_COLOR_CODING_CONVERTED_MIN) && (coding <= DC1394_COLOR_CODING_CONVERTED_MAX))
+        return converted[coding - DC1394_COLOR_CODING_CONVERTED_MIN];
+    return "?";
+}
+
+static double
+now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*-----------------------------------------------------------------------
+ *  Synthetic frames
+ *-----------------------------------------------------------------------*/
+
+static uint32_t
+xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/* a frame of the given coding with a diagonal gradient and noise, of 12 bits for 16-bit codings */
+static dc1394error_t
+make_frame(dc1394video_frame_t *frame, dc1394color_coding_t coding, uint32_t width, uint32_t height)
+{
+    uint32_t bits, row, x, y, v, state = 2463534242u;
+    uint8_t *p;
+
+    memset(frame, 0, sizeof(*frame));
+    if (dc1394_get_color_coding_bit_size(coding, &bits) != DC1394_SUCCESS)
+        return DC1394_INVALID_COLOR_CODING;
+
+    frame->size[0] = width;
+    frame->size[1] = height;
+    frame->color_coding = coding;
+    frame->color_filter = DC1394_COLOR_FILTER_RGGB;
+    frame->yuv_byte_order = DC1394_BYTE_ORDER_UYVY;
+    frame->data_depth = (bits % 16 == 0) ? 12 : 8;
+    row = (uint32_t)(((uint64_t)width * bits) / 8);
+    frame->image_bytes = frame->total_bytes = frame->allocated_image_bytes = row * height;
+    frame->image = (uint8_t*)malloc(frame->image_bytes);
+    if (frame->image == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+
+    for (y = 0; y < height; y++) {
+        p = frame->image + (size_t)y * row;
+        if (frame->data_depth == 8) {
+            for (x = 0; x < row; x++) {
+                v = ((x / 3 + y) >> 3) + (xorshift(&state) & 15);
+                p[x] = (uint8_t)v;
+            }
+        } else {
+            for (x = 0; x < row / 2; x++) {
+                v = ((x / 3 + y) << 1) + (xorshift(&state) & 63);
+                ((uint16_t*)p)[x] = (uint16_t)(v & 4095);
+            }
+        }
+    }
+
+    return DC1394_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------
+ *  Measurements
+ *-----------------------------------------------------------------------*/
+
+static dc1394error_t
+run_job(job_t *job)
+{
+    switch (job->kind) {
+    case JOB_CONVERT:
+        return dc1394_convert_frames(job->in, job->out);
+    case JOB_DEBAYER:
+        if (job->ctx != NULL)
+            return dc1394_debayer_frames_parallel(job->ctx, job->in, job->out, job->method);
+        return dc1394_debayer_frames(job->in, job->out, job->method);
+    case JOB_DEBAYER_TO_YUV422:
+        if (job->ctx != NULL)
+            return dc1394_debayer_frames_to_YUV422_parallel(job->ctx, job->in, job->out, job->method);
+        return dc1394_debayer_frames_to_YUV422(job->in, job->out, job->method);
+    case JOB_DEBAYER_TO_CODING:
+        return dc1394_debayer_frames_to_coding(job->ctx, job->in, job->out, job->method);
+    }
+    return DC1394_INVALID_ARGUMENT_VALUE;
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+    const double x = *(const double*)a, y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+  Runs job once to warm up and to allocate the output, then until min_ms have elapsed. Returns the median of
+  the runs in nanoseconds and in ticks of the time stamp counter.
+ */
+static dc1394error_t
+measure(job_t *job, double min_ms, int *runs, double *ns, double *ticks)
+{
+    static double times[MAX_RUNS], counts[MAX_RUNS];
+    double start, t0;
+    uint64_t c0;
+    dc1394error_t err;
+    int n;
+
+    err = run_job(job);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    start = now_ns();
+    for (n = 0; (n < MAX_RUNS) && ((n < 3) || (now_ns() - start < min_ms * 1e6)); n++) {
+        t0 = now_ns();
+        c0 = BENCH_TICKS();
+        run_job(job);
+        counts[n] = (double)(BENCH_TICKS() - c0);
+        times[n] = now_ns() - t0;
+    }
+    qsort(times, n, sizeof(double), compare_doubles);
+    qsort(counts, n, sizeof(double), compare_doubles);
+
+    *runs = n;
+    *ns = times[n / 2];
+    *ticks = counts[n / 2];
+    return DC1394_SUCCESS;
+}
+
+static void
+print_header(const options_t *opt)
+{
+    int p;
+
+    switch (opt->format) {
+    case FORMAT_TABLE:
+        if (opt->quality) {
+            printf("%-7s %-10s %-9s %5s %9s %9s %9s %6s %6s %6s %6s", "input", "method", "size", "runs", "ns/px",
+                   "MPix/s", "cycles/px", "R", "G", "B", "CPSNR");
+            for (p = 0; p < PATTERNS; p++)
+                printf(" %9s", pattern_names[p]);
+            printf(" pareto\n");
+        } else {
+            printf("%-18s %-7s %-11s %-10s %-9s %5s %9s %9s %9s\n", "kernel", "input", "output", "method", "size",
+                   "runs", "ns/px", "MPix/s", "cycles/px");
+        }
+        break;
+    case FORMAT_CSV:
+        if (opt->quality) {
+            printf("input,method,width,height,threads,runs,ns_per_pixel,mpix_per_s,cycles_per_pixel,"
+                   "psnr_r,psnr_g,psnr_b,cpsnr");
+            for (p = 0; p < PATTERNS; p++)
+                printf(",cpsnr_%s", pattern_names[p]);
+            printf(",pareto\n");
+        } else {
+            printf("kernel,input,output,method,width,height,threads,runs,ns_per_pixel,mpix_per_s,cycles_per_pixel\n");
+        }
+        break;
+    case FORMAT_JSON:
+        printf("{\n  \"mode\": \"%s\",\n  \"simd\": \"%s\",\n  \"threads\": %u,\n  \"cycles\": \"%s\",\n  \"results\": [",
+               opt->quality ? "quality" : "speed", getenv("DC1394_NO_SIMD") ? "off" : "auto", opt->threads,
+               BENCH_HAVE_TSC ? "tsc" : (opt->ghz > 0 ? "ghz" : "none"));
+        break;
+    }
+}
+
+static void
+print_footer(const options_t *opt)
+{
+    if (opt->format == FORMAT_JSON)
+        printf("\n  ]\n}\n");
+}
+
+static void
+print_result(options_t *opt, const job_t *job, int runs, double ns, double ticks)
+{
+    const uint32_t width = job->in->size[0], height = job->in->size[1];
+    const double pixels = (double)width * height;
+    const char *method = (job->kind == JOB_CONVERT) ? "" : method_names[job->method];
+    const char *output = coding_name(job->out->color_coding);
+    char size[32];
+    double cycles = -1;
+
+    if (BENCH_HAVE_TSC)
+        cycles = ticks / pixels;
+    else if (opt->ghz > 0)
+        cycles = ns * opt->ghz / pixels;
+
+    switch (opt->format) {
+    case FORMAT_TABLE:
+        snprintf(size, sizeof(size), "%ux%u", width, height);
+        printf("%-18s %-7s %-11s %-10s %-9s %5d %9.3f %9.1f ", job_names[job->kind], coding_name(job->in->color_coding),
+               output, method, size, runs, ns / pixels, 1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("%9.2f\n", cycles);
+        else
+            printf("%9s\n", "-");
+        break;
+    case FORMAT_CSV:
+        printf("%s,%s,%s,%s,%u,%u,%u,%d,%.4f,%.2f,", job_names[job->kind], coding_name(job->in->color_coding),
+               output, method, width, height, opt->threads, runs, ns / pixels, 1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("%.3f\n", cycles);
+        else
+            printf("\n");
+        break;
+    case FORMAT_JSON:
+        printf("%s\n    { \"kernel\": \"%s\", \"input\": \"%s\", \"output\": \"%s\", \"method\": \"%s\", "
+               "\"width\": %u, \"height\": %u, \"threads\": %u, \"runs\": %d, \"ns_per_pixel\": %.4f, "
+               "\"mpix_per_s\": %.2f, ", opt->results ? "," : "", job_names[job->kind],
+               coding_name(job->in->color_coding), output, method, width, height, opt->threads, runs, ns / pixels,
+               1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("\"cycles_per_pixel\": %.3f }", cycles);
+        else
+            printf("\"cycles_per_pixel\": null }");
+        break;
+    }
+    opt->results++;
+    fflush(stdout);
+}
+
+/* whether the name of job contains the filter, if there is one */
+static int
+selected(const options_t *opt, const job_t *job, dc1394color_coding_t out)
+{
+    char name[128];
+
+    if (opt->filter == NULL)
+        return 1;
+    snprintf(name, sizeof(name), "%s/%s/%s/%s", job_names[job->kind], coding_name(job->in->color_coding),
+             coding_name(out), job->kind == JOB_CONVERT ? "" : method_names[job->method]);
+    return strstr(name, opt->filter) != NULL;
+}
+
+/* runs job to the output coding out, unless it is not active */
+static void
+bench_job(options_t *opt, job_t *job, dc1394color_coding_t out)
+{
+    dc1394video_frame_t frame;
+    double ns, ticks;
+    int runs;
+
+    if (!selected(opt, job, out))
+        return;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.color_coding = out;
+    frame.yuv_byte_order = DC1394_BYTE_ORDER_UYVY;
+    job->out = &frame;
+    if (measure(job, opt->min_ms, &runs, &ns, &ticks) == DC1394_SUCCESS) {
+        // the output coding may have been set by the function, as for dc1394_debayer_frames()
+        print_result(opt, job, runs, ns, ticks);
+    }
+    free(frame.image);
+}
+
+static void
+bench_size(options_t *opt, uint32_t width, uint32_t height)
+{
+    dc1394video_frame_t in;
+    dc1394color_coding_t from, to;
+    dc1394bayer_method_t method;
+    job_t job;
+
+    job.ctx = (opt->threads > 1) ? dc1394_debayer_context_new(opt->threads) : NULL;
+
+    for (from = DC1394_COLOR_CODING_MIN; from <= DC1394_COLOR_CODING_MAX; from++) {
+        if (make_frame(&in, from, width, height) != DC1394_SUCCESS) {
+            fprintf(stderr, "can't make a %ux%u %s frame\n", width, height, coding_name(from));
+            continue;
+        }
+        job.in = &in;
+
+        job.kind = JOB_CONVERT;
+        job.method = DC1394_BAYER_METHOD_MIN;
+        for (to = DC1394_COLOR_CODING_MIN; to <= DC1394_COLOR_CODING_MAX; to++)
+            bench_job(opt, &job, to);
+        for (to = DC1394_COLOR_CODING_CONVERTED_MIN; to <= DC1394_COLOR_CODING_CONVERTED_MAX; to++)
+            bench_job(opt, &job, to);
+
+        if ((from != DC1394_COLOR_CODING_RAW8) && (from != DC1394_COLOR_CODING_RAW16)) {
+            free(in.image);
+            continue;
+        }
+        for (method = DC1394_BAYER_METHOD_MIN; method <= DC1394_BAYER_METHOD_MAX; method++) {
+            job.method = method;
+            job.kind = JOB_DEBAYER;
+            bench_job(opt, &job, from == DC1394_COLOR_CODING_RAW8 ? DC1394_COLOR_CODING_RGB8 : DC1394_COLOR_CODING_RGB16);
+            job.kind = JOB_DEBAYER_TO_YUV422;
+            bench_job(opt, &job, DC1394_COLOR_CODING_YUV422);
+            job.kind = JOB_DEBAYER_TO_CODING;
+            bench_job(opt, &job, DC1394_COLOR_CODING_MONO8);
+            bench_job(opt, &job, DC1394_COLOR_CODING_MONO16);
+            for (to = DC1394_COLOR_CODING_CONVERTED_MIN; to <= DC1394_COLOR_CODING_CONVERTED_MAX; to++)
+                bench_job(opt, &job, to);
+        }
+        free(in.image);
+    }
+
+    dc1394_debayer_context_free(job.ctx);
+}
+
+/*-----------------------------------------------------------------------
+ *  Quality of the de-mosaicing
+ *-----------------------------------------------------------------------*/
+
+#define TIMED_PATTERN 1        /* the throughput is measured on the edges, with the RGGB filter */
+#define MARGIN 8               /* output pixels of the borders left out of the scores */
+
+/* the component of each pixel of a 2x2 tile, 0 for red, 1 for green and 2 for blue, for each color filter */
+static const int filter_components[DC1394_COLOR_FILTER_NUM][2][2] = {
+    { { 0, 1 }, { 1, 2 } },    /* RGGB */
+    { { 1, 2 }, { 0, 1 } },    /* GBRG */
+    { { 1, 0 }, { 2, 1 } },    /* GRBG */
+    { { 2, 1 }, { 1, 0 } }     /* BGGR */
+};
+
+typedef struct {
+    int active;                /* selected by the filter, and supported */
+    double error[PATTERNS][3]; /* sums of the squared errors of each component */
+    double samples[PATTERNS];  /* of each component */
+    double psnr[3], cpsnr, pattern_cpsnr[PATTERNS];
+    double ns, ticks;
+    int runs;
+    int pareto;
+} score_t;
+
+static double
+psnr(double peak, double error, double samples)
+{
+    // identical images would give an infinite PSNR
+    return 10 * log10(peak * peak * samples / (error > 1e-9 ? error : 1e-9));
+}
+
+/*
+  A full-color reference of the pattern, with samples of depth bits:
+    zoneplate  gray circular chirp, from a flat center up to half the Nyquist frequency in the corners,
+               beyond which the sparser red and blue samples of the mosaic alias whatever the method
+    edges      tiles of 32x32 pixels cut in two colors by a line of random slope
+    smooth     slow color gradients
+ */
+static void
+make_reference(uint16_t *rgb, int pattern, uint32_t width, uint32_t height, uint32_t depth)
+{
+    const double peak = (1 << depth) - 1;
+    const double radius = sqrt((double)width * width + (double)height * height) / 2;
+    double v[3], cx, cy, nx, ny, angle;
+    uint32_t x, y, c, state;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            switch (pattern) {
+            case 0:
+                cx = x - width / 2.0;
+                cy = y - height / 2.0;
+                v[0] = v[1] = v[2] = 0.5 + 0.5 * cos(M_PI / (4 * radius) * (cx * cx + cy * cy));
+                break;
+            case 1:
+                state = (y / 32) * 7919 + (x / 32) * 104729 + 1;
+                xorshift(&state);
+                angle = (xorshift(&state) & 1023) * (M_PI / 1024);
+                nx = cos(angle);
+                ny = sin(angle);
+                cx = (x % 32) - 15.5;
+                cy = (y % 32) - 15.5;
+                if (nx * cx + ny * cy < 0)
+                    xorshift(&state);
+                for (c = 0; c < 3; c++)
+                    v[c] = (xorshift(&state) & 255) / 255.0;
+                break;
+            default:
+                v[0] = 0.5 + 0.45 * sin(2 * M_PI * (2.0 * x / width + 1.0 * y / height));
+                v[1] = 0.5 + 0.45 * sin(2 * M_PI * (1.5 * x / width - 2.0 * y / height) + 1);
+                v[2] = 0.5 + 0.45 * sin(2 * M_PI * (3.0 * y / height) + 2);
+                break;
+            }
+            for (c = 0; c < 3; c++)
+                rgb[3 * ((size_t)y * width + x) + c] = (uint16_t)(v[c] * peak + 0.5);
+        }
+    }
+}
+
+/* the samples of the reference that the color filter of frame lets through */
+static void
+mosaic(const uint16_t *rgb, dc1394video_frame_t *frame)
+{
+    const int (*components)[2] = filter_components[frame->color_filter - DC1394_COLOR_FILTER_MIN];
+    const uint32_t width = frame->size[0], height = frame->size[1];
+    uint32_t x, y;
+    uint16_t v;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            v = rgb[3 * ((size_t)y * width + x) + components[y & 1][x & 1]];
+            if (frame->color_coding == DC1394_COLOR_CODING_RAW8)
+                frame->image[(size_t)y * width + x] = (uint8_t)v;
+            else
+                ((uint16_t*)frame->image)[(size_t)y * width + x] = v;
+        }
+    }
+}
+
+/*
+  Adds the squared errors of the RGB frame against the reference, out of the margin. The half-size output of
+  DOWNSAMPLE is compared with the means of the 2x2 tiles of the reference.
+ */
+static void
+add_errors(score_t *score, int pattern, const uint16_t *rgb, const dc1394video_frame_t *frame, uint32_t width)
+{
+    const uint32_t scale = width / frame->size[0];
+    const uint32_t margin = MARGIN / scale;
+    double v, expected;
+    uint32_t x, y, c, i, j;
+    size_t k;
+
+    for (y = margin; y + margin < frame->size[1]; y++) {
+        for (x = margin; x + margin < frame->size[0]; x++) {
+            for (c = 0; c < 3; c++) {
+                k = 3 * ((size_t)y * frame->size[0] + x) + c;
+                if (frame->color_coding == DC1394_COLOR_CODING_RGB8)
+                    v = frame->image[k];
+                else
+                    v = ((const uint16_t*)frame->image)[k];
+                expected = 0;
+                for (j = 0; j < scale; j++) {
+                    for (i = 0; i < scale; i++)
+                        expected += rgb[3 * ((size_t)(y * scale + j) * width + x * scale + i) + c];
+                }
+                expected /= scale * scale;
+                score->error[pattern][c] += (v - expected) * (v - expected);
+            }
+            score->samples[pattern]++;
+        }
+    }
+}
+
+static void
+print_score(options_t *opt, dc1394color_coding_t input, dc1394bayer_method_t method, const score_t *score,
+            uint32_t width, uint32_t height)
+{
+    const double pixels = (double)width * height;
+    const double ns = score->ns;
+    double cycles = -1;
+    char size[32];
+    int p;
+
+    if (BENCH_HAVE_TSC)
+        cycles = score->ticks / pixels;
+    else if (opt->ghz > 0)
+        cycles = ns * opt->ghz / pixels;
+
+    switch (opt->format) {
+    case FORMAT_TABLE:
+        snprintf(size, sizeof(size), "%ux%u", width, height);
+        printf("%-7s %-10s %-9s %5d %9.3f %9.1f ", coding_name(input), method_names[method], size, score->runs,
+               ns / pixels, 1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("%9.2f", cycles);
+        else
+            printf("%9s", "-");
+        printf(" %6.2f %6.2f %6.2f %6.2f", score->psnr[0], score->psnr[1], score->psnr[2], score->cpsnr);
+        for (p = 0; p < PATTERNS; p++)
+            printf(" %9.2f", score->pattern_cpsnr[p]);
+        printf(" %s\n", score->pareto ? "*" : "");
+        break;
+    case FORMAT_CSV:
+        printf("%s,%s,%u,%u,%u,%d,%.4f,%.2f,", coding_name(input), method_names[method], width, height, opt->threads,
+               score->runs, ns / pixels, 1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("%.3f", cycles);
+        printf(",%.3f,%.3f,%.3f,%.3f", score->psnr[0], score->psnr[1], score->psnr[2], score->cpsnr);
+        for (p = 0; p < PATTERNS; p++)
+            printf(",%.3f", score->pattern_cpsnr[p]);
+        printf(",%d\n", score->pareto);
+        break;
+    case FORMAT_JSON:
+        printf("%s\n    { \"input\": \"%s\", \"method\": \"%s\", \"width\": %u, \"height\": %u, \"threads\": %u, "
+               "\"runs\": %d, \"ns_per_pixel\": %.4f, \"mpix_per_s\": %.2f, ", opt->results ? "," : "",
+               coding_name(input), method_names[method], width, height, opt->threads, score->runs, ns / pixels,
+               1e3 * pixels / ns);
+        if (cycles >= 0)
+            printf("\"cycles_per_pixel\": %.3f, ", cycles);
+        else
+            printf("\"cycles_per_pixel\": null, ");
+        printf("\"psnr_r\": %.3f, \"psnr_g\": %.3f, \"psnr_b\": %.3f, \"cpsnr\": %.3f, ", score->psnr[0],
+               score->psnr[1], score->psnr[2], score->cpsnr);
+        for (p = 0; p < PATTERNS; p++)
+            printf("\"cpsnr_%s\": %.3f, ", pattern_names[p], score->pattern_cpsnr[p]);
+        printf("\"pareto\": %s }", score->pareto ? "true" : "false");
+        break;
+    }
+    opt->results++;
+    fflush(stdout);
+}
+
+/* scores every method on the patterns with each color filter, for RAW8 and 12-bit RAW16 */
+static void
+quality_size(options_t *opt, uint32_t width, uint32_t height)
+{
+    score_t scores[DC1394_BAYER_METHOD_NUM], *score;
+    dc1394video_frame_t in, out;
+    dc1394color_coding_t input;
+    dc1394color_filter_t filter;
+    dc1394bayer_method_t method;
+    double peak, error, samples;
+    uint16_t *rgb;
+    job_t job;
+    int p, c, i;
+
+    rgb = (uint16_t*)malloc((size_t)width * height * 3 * sizeof(uint16_t));
+    if (rgb == NULL) {
+        fprintf(stderr, "can't allocate a %ux%u reference\n", width, height);
+        return;
+    }
+    job.kind = JOB_DEBAYER;
+    job.ctx = (opt->threads > 1) ? dc1394_debayer_context_new(opt->threads) : NULL;
+
+    for (input = DC1394_COLOR_CODING_RAW8; input <= DC1394_COLOR_CODING_RAW16; input++) {
+        if (make_frame(&in, input, width, height) != DC1394_SUCCESS) {
+            fprintf(stderr, "can't make a %ux%u %s frame\n", width, height, coding_name(input));
+            continue;
+        }
+        job.in = &in;
+        job.out = &out;
+        memset(scores, 0, sizeof(scores));
+        for (method = DC1394_BAYER_METHOD_MIN; method <= DC1394_BAYER_METHOD_MAX; method++) {
+            job.method = method;
+            scores[method - DC1394_BAYER_METHOD_MIN].active =
+                selected(opt, &job, input == DC1394_COLOR_CODING_RAW8 ? DC1394_COLOR_CODING_RGB8 : DC1394_COLOR_CODING_RGB16);
+        }
+
+        for (p = 0; p < PATTERNS; p++) {
+            make_reference(rgb, p, width, height, in.data_depth);
+            for (filter = DC1394_COLOR_FILTER_MIN; filter <= DC1394_COLOR_FILTER_MAX; filter++) {
+                in.color_filter = filter;
+                mosaic(rgb, &in);
+                for (method = DC1394_BAYER_METHOD_MIN; method <= DC1394_BAYER_METHOD_MAX; method++) {
+                    score = &scores[method - DC1394_BAYER_METHOD_MIN];
+                    if (!score->active)
+                        continue;
+                    job.method = method;
+                    memset(&out, 0, sizeof(out));
+                    if ((p == TIMED_PATTERN) && (filter == DC1394_COLOR_FILTER_RGGB))
+                        score->active = (measure(&job, opt->min_ms, &score->runs, &score->ns, &score->ticks) == DC1394_SUCCESS);
+                    else
+                        score->active = (run_job(&job) == DC1394_SUCCESS);
+                    if (score->active)
+                        add_errors(score, p, rgb, &out, width);
+                    free(out.image);
+                }
+            }
+        }
+
+        // the front of the methods that no other one beats in quality without being slower
+        peak = (1 << in.data_depth) - 1;
+        for (i = 0; i < DC1394_BAYER_METHOD_NUM; i++) {
+            score = &scores[i];
+            if (!score->active)
+                continue;
+            samples = 0;
+            for (p = 0; p < PATTERNS; p++) {
+                score->pattern_cpsnr[p] = psnr(peak, score->error[p][0] + score->error[p][1] + score->error[p][2],
+                                               3 * score->samples[p]);
+                samples += score->samples[p];
+            }
+            for (c = 0; c < 3; c++) {
+                error = 0;
+                for (p = 0; p < PATTERNS; p++)
+                    error += score->error[p][c];
+                score->psnr[c] = psnr(peak, error, samples);
+            }
+            error = 0;
+            for (p = 0; p < PATTERNS; p++)
+                error += score->error[p][0] + score->error[p][1] + score->error[p][2];
+            score->cpsnr = psnr(peak, error, 3 * samples);
+        }
+        for (i = 0; i < DC1394_BAYER_METHOD_NUM; i++) {
+            score = &scores[i];
+            score->pareto = score->active;
+            for (c = 0; (c < DC1394_BAYER_METHOD_NUM) && score->pareto; c++) {
+                if ((c != i) && scores[c].active && (scores[c].cpsnr >= score->cpsnr) && (scores[c].ns <= score->ns) &&
+                    ((scores[c].cpsnr > score->cpsnr) || (scores[c].ns < score->ns)))
+                    score->pareto = 0;
+            }
+        }
+        for (i = 0; i < DC1394_BAYER_METHOD_NUM; i++) {
+            if (scores[i].active)
+                print_score(opt, input, (dc1394bayer_method_t)(DC1394_BAYER_METHOD_MIN + i), &scores[i], width, height);
+        }
+        free(in.image);
+    }
+
+    dc1394_debayer_context_free(job.ctx);
+    free(rgb);
+}
+
+/*-----------------------------------------------------------------------
+ *  Command line
+ *-----------------------------------------------------------------------*/
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --quality            score the de-mosaicing methods against reference patterns\n"
+            "  --csv, --json        machine-readable output instead of a table\n"
+            "  --sizes WxH[,WxH...] even frame sizes, which all the codings accept\n"
+            "                       (default 640x480,1280x960,1920x1080,2448x2048,4096x3000,\n"
+            "                       or 1280x960 with --quality)\n"
+            "  --filter TEXT        only the kernels whose kernel/input/output/method name contains TEXT\n"
+            "  --min-time MS        time spent on each kernel and size (default 100)\n"
+            "  --threads N          de-mosaic with N threads (default 1)\n"
+            "  --ghz F              clock of the CPU for the cycles, where there is no time stamp counter\n",
+            name);
+}
+
+static int
+parse_sizes(options_t *opt, const char *list)
+{
+    const char *p = list;
+    int n;
+
+    opt->sizes = 0;
+    while ((*p != '\0') && (opt->sizes < MAX_SIZES)) {
+        if ((sscanf(p, "%ux%u%n", &opt->width[opt->sizes], &opt->height[opt->sizes], &n) != 2) ||
+            (opt->width[opt->sizes] < 2) || (opt->height[opt->sizes] < 2) ||
+            (opt->width[opt->sizes] & 1) || (opt->height[opt->sizes] & 1))
+            return 0;
+        opt->sizes++;
+        p += n;
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return 0;
+    }
+    return opt->sizes > 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    options_t opt;
+    int i;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.format = FORMAT_TABLE;
+    opt.min_ms = 100;
+    opt.threads = 1;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quality") == 0) {
+            opt.quality = 1;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            opt.format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            opt.format = FORMAT_JSON;
+        } else if ((strcmp(argv[i], "--sizes") == 0) && (i + 1 < argc)) {
+            if (!parse_sizes(&opt, argv[++i])) {
+                fprintf(stderr, "invalid sizes: %s\n", argv[i]);
+                return 1;
+            }
+        } else if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+            opt.filter = argv[++i];
+        } else if ((strcmp(argv[i], "--min-time") == 0) && (i + 1 < argc)) {
+            opt.min_ms = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc)) {
+            opt.threads = (uint32_t)atoi(argv[++i]);
+            if (opt.threads < 1)
+                opt.threads = 1;
+        } else if ((strcmp(argv[i], "--ghz") == 0) && (i + 1 < argc)) {
+            opt.ghz = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opt.sizes == 0)
+        parse_sizes(&opt, opt.quality ? "1280x960" : "640x480,1280x960,1920x1080,2448x2048,4096x3000");
+
+    print_header(&opt);
+    for (i = 0; i < opt.sizes; i++) {
+        if (opt.quality)
+            quality_size(&opt, opt.width[i], opt.height[i]);
+        else
+            bench_size(&opt, opt.width[i], opt.height[i]);
+    }
+    print_footer(&opt);
+
+    return 0;
+}
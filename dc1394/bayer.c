@@ -27,6 +27,28 @@
 #include <stdint.h>
 #include <string.h>
 #include "conversions.h"
+#include "simd.h"
+#include "threads.h"
+#include "isp.h"
+#include "stats.h"
+
+/* from conversions.c */
+dc1394error_t dc1394_RGB8_to_YUV422(uint8_t *restrict src, uint8_t *restrict dest, uint32_t width, uint32_t height,
+                                    uint32_t byte_order);
+dc1394error_t Adapt_buffer_convert(dc1394video_frame_t *in, dc1394video_frame_t *out);
+uint32_t frame_packed_row(const dc1394video_frame_t *frame);
+uint32_t frame_row_bytes(const dc1394video_frame_t *frame);
+void frame_output_stride(dc1394video_frame_t *out);
+uint32_t packed_row_bytes(uint32_t width, dc1394packing_t packing);
+void rgb8_rows_to_image(const uint8_t *rgb, uint8_t *dest, dc1394color_coding_t coding, uint32_t width,
+                        uint32_t height, size_t stride, uint32_t y, uint32_t n, const dc1394yuv_params_t *params);
+int stereo_frame_sensors(const dc1394video_frame_t *frame);
+void stereo_sensor_frame(const dc1394video_frame_t *in, dc1394video_frame_t *sensor);
+void stereo_sensor_rows(const dc1394video_frame_t *in, int sensors, int sensor, dc1394stereo_method_t method,
+                        uint32_t y, uint32_t n, uint8_t *dest, size_t stride);
+
+/* from framepool.c */
+void frame_image_reserve(dc1394video_frame_t *frame);
 
 #define CLIP(in, out)\
    in = in < 0 ? 0 : in;\
@@ -38,6 +60,46 @@
    in = in > ((1<<bits)-1) ? ((1<<bits)-1) : in;\
    out=in;
 
+#if defined(__GNUC__)
+#define BAYER_INLINE static inline __attribute__ ((always_inline))
+#else
+#define BAYER_INLINE static inline
+#endif
+
+/*
+  The phase of a row (whether blue follows red in its pixel pairs, and whether
+  it starts with a green pixel) alternates from one row to the next. The rows
+  are decoded by pairs with row(bayer, rgb, ..., blue, start_with_green), row
+  being an inlined function: each of the four phases of the first row gets its
+  own copy of the loops, in which blue and start_with_green are constants, and
+  the tile is looked at once per image.
+ */
+#define BAYER_ROW_PAIRS(row, blue, green, bayer, rgb, height, bayerStep, rgbStep, ...)        \
+    do {                                                                                   \
+        int y_;                                                                            \
+        for (y_ = 0; y_ + 1 < (height); y_ += 2) {                                         \
+            row((bayer) + y_ * (bayerStep), (rgb) + y_ * (rgbStep), __VA_ARGS__, blue, green); \
+            row((bayer) + (y_ + 1) * (bayerStep), (rgb) + (y_ + 1) * (rgbStep), __VA_ARGS__,  \
+                -(blue), !(green));                                                        \
+        }                                                                                  \
+        if (y_ < (height))                                                                 \
+            row((bayer) + y_ * (bayerStep), (rgb) + y_ * (rgbStep), __VA_ARGS__, blue, green); \
+    } while (0)
+
+#define BAYER_ROWS(row, blue, start_with_green, ...)                                         \
+    do {                                                                                   \
+        if ((blue) > 0)                                                                    \
+            if (start_with_green)                                                          \
+                BAYER_ROW_PAIRS(row, 1, 1, __VA_ARGS__);                                   \
+            else                                                                           \
+                BAYER_ROW_PAIRS(row, 1, 0, __VA_ARGS__);                                   \
+        else                                                                               \
+            if (start_with_green)                                                          \
+                BAYER_ROW_PAIRS(row, -1, 1, __VA_ARGS__);                                  \
+            else                                                                           \
+                BAYER_ROW_PAIRS(row, -1, 0, __VA_ARGS__);                                  \
+    } while (0)
+
 void
 ClearBorders(uint8_t *rgb, int sx, int sy, int w)
 {
@@ -98,8 +160,52 @@ ClearBorders_uint16(uint16_t * rgb, int sx, int sy, int w)
  **************************************************************/
 
 /* 8-bits versions */
-/* insprired by OpenCV's Bayer decoding */
 
+/* a row of dc1394_bayer_NearestNeighbor(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+nearest_row(const uint8_t *restrict bayer, uint8_t *restrict rgb, int width, int bayerStep,
+            const int blue, const int start_with_green)
+{
+    const uint8_t *bayerEnd = bayer + width;
+
+    if (start_with_green) {
+        rgb[-blue] = bayer[1];
+        rgb[0] = bayer[bayerStep + 1];
+        rgb[blue] = bayer[bayerStep];
+        bayer++;
+        rgb += 3;
+    }
+
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[-1] = bayer[0];
+            rgb[0] = bayer[1];
+            rgb[1] = bayer[bayerStep + 1];
+
+            rgb[2] = bayer[2];
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[4] = bayer[bayerStep + 1];
+        }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[1] = bayer[0];
+            rgb[0] = bayer[1];
+            rgb[-1] = bayer[bayerStep + 1];
+
+            rgb[4] = bayer[2];
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[2] = bayer[bayerStep + 1];
+        }
+    }
+
+    if (bayer < bayerEnd) {
+        rgb[-blue] = bayer[0];
+        rgb[0] = bayer[1];
+        rgb[blue] = bayer[bayerStep + 1];
+    }
+}
+
+/* insprired by OpenCV's Bayer decoding */
 dc1394error_t
 dc1394_bayer_NearestNeighbor(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile)
 {
@@ -107,10 +213,8 @@ dc1394_bayer_NearestNeighbor(const uint8_t *restrict bayer, uint8_t *restrict rg
     const int rgbStep = 3 * sx;
     int width = sx;
     int height = sy;
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
     int i, imax, iinc;
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
@@ -132,56 +236,79 @@ dc1394_bayer_NearestNeighbor(const uint8_t *restrict bayer, uint8_t *restrict rg
     width -= 1;
     height -= 1;
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-      //int t0, t1;
-        const uint8_t *bayerEnd = bayer + width;
+    BAYER_ROWS(nearest_row, blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
-        if (start_with_green) {
-            rgb[-blue] = bayer[1];
-            rgb[0] = bayer[bayerStep + 1];
-            rgb[blue] = bayer[bayerStep];
-            bayer++;
-            rgb += 3;
-        }
+    return DC1394_SUCCESS;
+}
 
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[-1] = bayer[0];
-                rgb[0] = bayer[1];
-                rgb[1] = bayer[bayerStep + 1];
+/* a row of dc1394_bayer_Bilinear(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+bilinear_row(const uint8_t *restrict bayer, uint8_t *restrict rgb, int width, int bayerStep,
+             const int blue, const int start_with_green)
+{
+    int t0, t1;
+    const uint8_t *bayerEnd = bayer + width;
+
+    if (start_with_green) {
+        /* OpenCV has a bug in the next line, which was
+           t0 = (bayer[0] + bayer[bayerStep * 2] + 1) >> 1; */
+        t0 = (bayer[1] + bayer[bayerStep * 2 + 1] + 1) >> 1;
+        t1 = (bayer[bayerStep] + bayer[bayerStep + 2] + 1) >> 1;
+        rgb[-blue] = (uint8_t) t0;
+        rgb[0] = bayer[bayerStep + 1];
+        rgb[blue] = (uint8_t) t1;
+        bayer++;
+        rgb += 3;
+    }
 
-                rgb[2] = bayer[2];
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[4] = bayer[bayerStep + 1];
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[1] = bayer[0];
-                rgb[0] = bayer[1];
-                rgb[-1] = bayer[bayerStep + 1];
-
-                rgb[4] = bayer[2];
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[2] = bayer[bayerStep + 1];
-            }
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+                  bayer[bayerStep * 2 + 2] + 2) >> 2;
+            t1 = (bayer[1] + bayer[bayerStep] +
+                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+                  2) >> 2;
+            rgb[-1] = (uint8_t) t0;
+            rgb[0] = (uint8_t) t1;
+            rgb[1] = bayer[bayerStep + 1];
+
+            t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
+            t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                  1) >> 1;
+            rgb[2] = (uint8_t) t0;
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[4] = (uint8_t) t1;
         }
-
-        if (bayer < bayerEnd) {
-            rgb[-blue] = bayer[0];
-            rgb[0] = bayer[1];
-            rgb[blue] = bayer[bayerStep + 1];
-            bayer++;
-            rgb += 3;
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+                  bayer[bayerStep * 2 + 2] + 2) >> 2;
+            t1 = (bayer[1] + bayer[bayerStep] +
+                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+                  2) >> 2;
+            rgb[1] = (uint8_t) t0;
+            rgb[0] = (uint8_t) t1;
+            rgb[-1] = bayer[bayerStep + 1];
+
+            t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
+            t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                  1) >> 1;
+            rgb[4] = (uint8_t) t0;
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[2] = (uint8_t) t1;
         }
-
-        bayer -= width;
-        rgb -= width * 3;
-
-        blue = -blue;
-        start_with_green = !start_with_green;
     }
 
-    return DC1394_SUCCESS;
+    if (bayer < bayerEnd) {
+        t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+              bayer[bayerStep * 2 + 2] + 2) >> 2;
+        t1 = (bayer[1] + bayer[bayerStep] +
+              bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+              2) >> 2;
+        rgb[-blue] = (uint8_t) t0;
+        rgb[0] = (uint8_t) t1;
+        rgb[blue] = bayer[bayerStep + 1];
+    }
 }
 
 /* OpenCV's Bayer decoding */
@@ -204,10 +331,8 @@ dc1394_bayer_Bilinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int
        int blue = tile == CV_BayerBG2BGR || tile == CV_BayerGB2BGR ? -1 : 1;
        int start_with_green = tile == CV_BayerGB2BGR || tile == CV_BayerGR2BGR;
      */
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
         return DC1394_INVALID_COLOR_FILTER;
@@ -217,80 +342,175 @@ dc1394_bayer_Bilinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int
     height -= 2;
     width -= 2;
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-        int t0, t1;
-        const uint8_t *bayerEnd = bayer + width;
-
-        if (start_with_green) {
-            /* OpenCV has a bug in the next line, which was
-               t0 = (bayer[0] + bayer[bayerStep * 2] + 1) >> 1; */
-            t0 = (bayer[1] + bayer[bayerStep * 2 + 1] + 1) >> 1;
-            t1 = (bayer[bayerStep] + bayer[bayerStep + 2] + 1) >> 1;
-            rgb[-blue] = (uint8_t) t0;
-            rgb[0] = bayer[bayerStep + 1];
-            rgb[blue] = (uint8_t) t1;
-            bayer++;
-            rgb += 3;
-        }
+    BAYER_ROWS(bilinear_row, blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                      bayer[bayerStep * 2 + 2] + 2) >> 2;
-                t1 = (bayer[1] + bayer[bayerStep] +
-                      bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                      2) >> 2;
-                rgb[-1] = (uint8_t) t0;
-                rgb[0] = (uint8_t) t1;
-                rgb[1] = bayer[bayerStep + 1];
-
-                t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
-                t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                      1) >> 1;
-                rgb[2] = (uint8_t) t0;
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[4] = (uint8_t) t1;
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                      bayer[bayerStep * 2 + 2] + 2) >> 2;
-                t1 = (bayer[1] + bayer[bayerStep] +
-                      bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                      2) >> 2;
-                rgb[1] = (uint8_t) t0;
-                rgb[0] = (uint8_t) t1;
-                rgb[-1] = bayer[bayerStep + 1];
-
-                t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
-                t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                      1) >> 1;
-                rgb[4] = (uint8_t) t0;
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[2] = (uint8_t) t1;
-            }
-        }
+    return DC1394_SUCCESS;
+}
 
-        if (bayer < bayerEnd) {
-            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                  bayer[bayerStep * 2 + 2] + 2) >> 2;
-            t1 = (bayer[1] + bayer[bayerStep] +
-                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                  2) >> 2;
-            rgb[-blue] = (uint8_t) t0;
-            rgb[0] = (uint8_t) t1;
-            rgb[blue] = bayer[bayerStep + 1];
-            bayer++;
-            rgb += 3;
+/* a row of dc1394_bayer_HQLinear(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+hqlinear_row(const uint8_t *restrict bayer, uint8_t *restrict rgb, int width, int bayerStep,
+             const int blue, const int start_with_green)
+{
+    int t0, t1;
+    const uint8_t *bayerEnd = bayer + width;
+    const int bayerStep2 = bayerStep * 2;
+    const int bayerStep3 = bayerStep * 3;
+    const int bayerStep4 = bayerStep * 4;
+
+    if (start_with_green) {
+        /* at green pixel */
+        rgb[0] = bayer[bayerStep2 + 2];
+        t0 = rgb[0] * 5
+            + ((bayer[bayerStep + 2] + bayer[bayerStep3 + 2]) << 2)
+            - bayer[2]
+            - bayer[bayerStep + 1]
+            - bayer[bayerStep + 3]
+            - bayer[bayerStep3 + 1]
+            - bayer[bayerStep3 + 3]
+            - bayer[bayerStep4 + 2]
+            + ((bayer[bayerStep2] + bayer[bayerStep2 + 4] + 1) >> 1);
+        t1 = rgb[0] * 5 +
+            ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 3]) << 2)
+            - bayer[bayerStep2]
+            - bayer[bayerStep + 1]
+            - bayer[bayerStep + 3]
+            - bayer[bayerStep3 + 1]
+            - bayer[bayerStep3 + 3]
+            - bayer[bayerStep2 + 4]
+            + ((bayer[2] + bayer[bayerStep4 + 2] + 1) >> 1);
+        t0 = (t0 + 4) >> 3;
+        CLIP(t0, rgb[-blue]);
+        t1 = (t1 + 4) >> 3;
+        CLIP(t1, rgb[blue]);
+        bayer++;
+        rgb += 3;
+    }
+
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            /* B at B */
+            rgb[1] = bayer[bayerStep2 + 2];
+            /* R at B */
+            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                   bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
+                -
+                (((bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                                 2]) * 3 + 1) >> 1)
+                + rgb[1] * 6;
+            /* G at B */
+            t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                   bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2]) << 1)
+                - (bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+                + (rgb[1] << 2);
+            t0 = (t0 + 4) >> 3;
+            CLIP(t0, rgb[-1]);
+            t1 = (t1 + 4) >> 3;
+            CLIP(t1, rgb[0]);
+            /* at green pixel */
+            rgb[3] = bayer[bayerStep2 + 3];
+            t0 = rgb[3] * 5
+                + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
+                - bayer[3]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep4 + 3]
+                +
+                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
+                  1) >> 1);
+            t1 = rgb[3] * 5 +
+                ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
+                - bayer[bayerStep2 + 1]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep2 + 5]
+                + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
+            t0 = (t0 + 4) >> 3;
+            CLIP(t0, rgb[2]);
+            t1 = (t1 + 4) >> 3;
+            CLIP(t1, rgb[4]);
         }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            /* R at R */
+            rgb[-1] = bayer[bayerStep2 + 2];
+            /* B at R */
+            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                   bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
+                -
+                (((bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                                 2]) * 3 + 1) >> 1)
+                + rgb[-1] * 6;
+            /* G at R */
+            t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                   bayer[bayerStep2 + 3] + bayer[bayerStep * 3 +
+                                                 2]) << 1)
+                - (bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+                + (rgb[-1] << 2);
+            t0 = (t0 + 4) >> 3;
+            CLIP(t0, rgb[1]);
+            t1 = (t1 + 4) >> 3;
+            CLIP(t1, rgb[0]);
 
-        bayer -= width;
-        rgb -= width * 3;
+            /* at green pixel */
+            rgb[3] = bayer[bayerStep2 + 3];
+            t0 = rgb[3] * 5
+                + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
+                - bayer[3]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep4 + 3]
+                +
+                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
+                  1) >> 1);
+            t1 = rgb[3] * 5 +
+                ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
+                - bayer[bayerStep2 + 1]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep2 + 5]
+                + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
+            t0 = (t0 + 4) >> 3;
+            CLIP(t0, rgb[4]);
+            t1 = (t1 + 4) >> 3;
+            CLIP(t1, rgb[2]);
+        }
+    }
 
-        blue = -blue;
-        start_with_green = !start_with_green;
+    if (bayer < bayerEnd) {
+        /* B at B */
+        rgb[blue] = bayer[bayerStep2 + 2];
+        /* R at B */
+        t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+               bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
+            -
+            (((bayer[2] + bayer[bayerStep2] +
+               bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                             2]) * 3 + 1) >> 1)
+            + rgb[blue] * 6;
+        /* G at B */
+        t1 = (((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2])) << 1)
+            - (bayer[2] + bayer[bayerStep2] +
+               bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+            + (rgb[blue] << 2);
+        t0 = (t0 + 4) >> 3;
+        CLIP(t0, rgb[-blue]);
+        t1 = (t1 + 4) >> 3;
+        CLIP(t1, rgb[0]);
     }
-    return DC1394_SUCCESS;
 }
 
 /* High-Quality Linear Interpolation For Demosaicing Of
@@ -303,10 +523,8 @@ dc1394_bayer_HQLinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int
     const int rgbStep = 3 * sx;
     int width = sx;
     int height = sy;
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
       return DC1394_INVALID_COLOR_FILTER;
@@ -317,177 +535,7 @@ dc1394_bayer_HQLinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int
     width -= 4;
 
     /* We begin with a (+1 line,+1 column) offset with respect to bilinear decoding, so start_with_green is the same, but blue is opposite */
-    blue = -blue;
-
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-        int t0, t1;
-        const uint8_t *bayerEnd = bayer + width;
-        const int bayerStep2 = bayerStep * 2;
-        const int bayerStep3 = bayerStep * 3;
-        const int bayerStep4 = bayerStep * 4;
-
-        if (start_with_green) {
-            /* at green pixel */
-            rgb[0] = bayer[bayerStep2 + 2];
-            t0 = rgb[0] * 5
-                + ((bayer[bayerStep + 2] + bayer[bayerStep3 + 2]) << 2)
-                - bayer[2]
-                - bayer[bayerStep + 1]
-                - bayer[bayerStep + 3]
-                - bayer[bayerStep3 + 1]
-                - bayer[bayerStep3 + 3]
-                - bayer[bayerStep4 + 2]
-                + ((bayer[bayerStep2] + bayer[bayerStep2 + 4] + 1) >> 1);
-            t1 = rgb[0] * 5 +
-                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 3]) << 2)
-                - bayer[bayerStep2]
-                - bayer[bayerStep + 1]
-                - bayer[bayerStep + 3]
-                - bayer[bayerStep3 + 1]
-                - bayer[bayerStep3 + 3]
-                - bayer[bayerStep2 + 4]
-                + ((bayer[2] + bayer[bayerStep4 + 2] + 1) >> 1);
-            t0 = (t0 + 4) >> 3;
-            CLIP(t0, rgb[-blue]);
-            t1 = (t1 + 4) >> 3;
-            CLIP(t1, rgb[blue]);
-            bayer++;
-            rgb += 3;
-        }
-
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                /* B at B */
-                rgb[1] = bayer[bayerStep2 + 2];
-                /* R at B */
-                t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                       bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
-                    -
-                    (((bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                     2]) * 3 + 1) >> 1)
-                    + rgb[1] * 6;
-                /* G at B */
-                t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                       bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2]) << 1)
-                    - (bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                    + (rgb[1] << 2);
-                t0 = (t0 + 4) >> 3;
-                CLIP(t0, rgb[-1]);
-                t1 = (t1 + 4) >> 3;
-                CLIP(t1, rgb[0]);
-                /* at green pixel */
-                rgb[3] = bayer[bayerStep2 + 3];
-                t0 = rgb[3] * 5
-                    + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
-                    - bayer[3]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep4 + 3]
-                    +
-                    ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
-                      1) >> 1);
-                t1 = rgb[3] * 5 +
-                    ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
-                    - bayer[bayerStep2 + 1]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep2 + 5]
-                    + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
-                t0 = (t0 + 4) >> 3;
-                CLIP(t0, rgb[2]);
-                t1 = (t1 + 4) >> 3;
-                CLIP(t1, rgb[4]);
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                /* R at R */
-                rgb[-1] = bayer[bayerStep2 + 2];
-                /* B at R */
-                t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                       bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
-                    -
-                    (((bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                     2]) * 3 + 1) >> 1)
-                    + rgb[-1] * 6;
-                /* G at R */
-                t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                       bayer[bayerStep2 + 3] + bayer[bayerStep * 3 +
-                                                     2]) << 1)
-                    - (bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                    + (rgb[-1] << 2);
-                t0 = (t0 + 4) >> 3;
-                CLIP(t0, rgb[1]);
-                t1 = (t1 + 4) >> 3;
-                CLIP(t1, rgb[0]);
-
-                /* at green pixel */
-                rgb[3] = bayer[bayerStep2 + 3];
-                t0 = rgb[3] * 5
-                    + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
-                    - bayer[3]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep4 + 3]
-                    +
-                    ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
-                      1) >> 1);
-                t1 = rgb[3] * 5 +
-                    ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
-                    - bayer[bayerStep2 + 1]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep2 + 5]
-                    + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
-                t0 = (t0 + 4) >> 3;
-                CLIP(t0, rgb[4]);
-                t1 = (t1 + 4) >> 3;
-                CLIP(t1, rgb[2]);
-            }
-        }
-
-        if (bayer < bayerEnd) {
-            /* B at B */
-            rgb[blue] = bayer[bayerStep2 + 2];
-            /* R at B */
-            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                   bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
-                -
-                (((bayer[2] + bayer[bayerStep2] +
-                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                 2]) * 3 + 1) >> 1)
-                + rgb[blue] * 6;
-            /* G at B */
-            t1 = (((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                    bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2])) << 1)
-                - (bayer[2] + bayer[bayerStep2] +
-                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                + (rgb[blue] << 2);
-            t0 = (t0 + 4) >> 3;
-            CLIP(t0, rgb[-blue]);
-            t1 = (t1 + 4) >> 3;
-            CLIP(t1, rgb[0]);
-            bayer++;
-            rgb += 3;
-        }
-
-        bayer -= width;
-        rgb -= width * 3;
-
-        blue = -blue;
-        start_with_green = !start_with_green;
-    }
+    BAYER_ROWS(hqlinear_row, -blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
     return DC1394_SUCCESS;
 
@@ -674,7 +722,7 @@ dc1394_bayer_EdgeSense(const uint8_t *restrict bayer, uint8_t *restrict rgb, int
 				CLIP(tmp, outG[base]);
 			}
 		}
-		for (i3=3*sx3; i3 < (sy - 3)*sx3; i3 += (sx3<<1)) {
+		for (i3=3*sx3; i3 < (sy - 2)*sx3; i3 += (sx3<<1)) {
 			for (j3=9; j3 < sx3 - 6; j3+=6) {
 				base=i3+j3;
 				dh = abs(((outR[base - 6] +
@@ -833,6 +881,50 @@ dc1394_bayer_Downsample(const uint8_t *restrict bayer, uint8_t *restrict rgb, in
 
 }
 
+/* a row of dc1394_bayer_Simple(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+simple_row(const uint8_t *restrict bayer, uint8_t *restrict rgb, int width, int bayerStep,
+           const int blue, const int start_with_green)
+{
+    const uint8_t *bayerEnd = bayer + width;
+
+    if (start_with_green) {
+        rgb[-blue] = bayer[1];
+        rgb[0] = (bayer[0] + bayer[bayerStep + 1] + 1) >> 1;
+        rgb[blue] = bayer[bayerStep];
+        bayer++;
+        rgb += 3;
+    }
+
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[-1] = bayer[0];
+            rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
+            rgb[1] = bayer[bayerStep + 1];
+
+            rgb[2] = bayer[2];
+            rgb[3] = (bayer[1] + bayer[bayerStep + 2] + 1) >> 1;
+            rgb[4] = bayer[bayerStep + 1];
+        }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[1] = bayer[0];
+            rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
+            rgb[-1] = bayer[bayerStep + 1];
+
+            rgb[4] = bayer[2];
+            rgb[3] = (bayer[1] + bayer[bayerStep + 2] + 1) >> 1;
+            rgb[2] = bayer[bayerStep + 1];
+        }
+    }
+
+    if (bayer < bayerEnd) {
+        rgb[-blue] = bayer[0];
+        rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
+        rgb[blue] = bayer[bayerStep + 1];
+    }
+}
+
 /* this is the method used inside AVT cameras. See AVT docs. */
 dc1394error_t
 dc1394_bayer_Simple(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile)
@@ -841,10 +933,8 @@ dc1394_bayer_Simple(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx
     const int rgbStep = 3 * sx;
     int width = sx;
     int height = sy;
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
     int i, imax, iinc;
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
@@ -866,60 +956,58 @@ dc1394_bayer_Simple(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx
     width -= 1;
     height -= 1;
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-        const uint8_t *bayerEnd = bayer + width;
+    BAYER_ROWS(simple_row, blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
-        if (start_with_green) {
-            rgb[-blue] = bayer[1];
-            rgb[0] = (bayer[0] + bayer[bayerStep + 1] + 1) >> 1;
-            rgb[blue] = bayer[bayerStep];
-            bayer++;
-            rgb += 3;
-        }
+    return DC1394_SUCCESS;
 
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[-1] = bayer[0];
-                rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
-                rgb[1] = bayer[bayerStep + 1];
+}
 
-                rgb[2] = bayer[2];
-                rgb[3] = (bayer[1] + bayer[bayerStep + 2] + 1) >> 1;
-                rgb[4] = bayer[bayerStep + 1];
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[1] = bayer[0];
-                rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
-                rgb[-1] = bayer[bayerStep + 1];
-
-                rgb[4] = bayer[2];
-                rgb[3] = (bayer[1] + bayer[bayerStep + 2] + 1) >> 1;
-                rgb[2] = bayer[bayerStep + 1];
-            }
-        }
+/* 16-bits versions */
 
-        if (bayer < bayerEnd) {
-            rgb[-blue] = bayer[0];
-            rgb[0] = (bayer[1] + bayer[bayerStep] + 1) >> 1;
-            rgb[blue] = bayer[bayerStep + 1];
-            bayer++;
-            rgb += 3;
-        }
+/* a row of dc1394_bayer_NearestNeighbor_uint16(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+nearest_row_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int width, int bayerStep,
+                   const int blue, const int start_with_green)
+{
+    const uint16_t *bayerEnd = bayer + width;
+
+    if (start_with_green) {
+        rgb[-blue] = bayer[1];
+        rgb[0] = bayer[bayerStep + 1];
+        rgb[blue] = bayer[bayerStep];
+        bayer++;
+        rgb += 3;
+    }
 
-        bayer -= width;
-        rgb -= width * 3;
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[-1] = bayer[0];
+            rgb[0] = bayer[1];
+            rgb[1] = bayer[bayerStep + 1];
 
-        blue = -blue;
-        start_with_green = !start_with_green;
-    }
+            rgb[2] = bayer[2];
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[4] = bayer[bayerStep + 1];
+        }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            rgb[1] = bayer[0];
+            rgb[0] = bayer[1];
+            rgb[-1] = bayer[bayerStep + 1];
 
-    return DC1394_SUCCESS;
+            rgb[4] = bayer[2];
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[2] = bayer[bayerStep + 1];
+        }
+    }
 
+    if (bayer < bayerEnd) {
+        rgb[-blue] = bayer[0];
+        rgb[0] = bayer[1];
+        rgb[blue] = bayer[bayerStep + 1];
+    }
 }
 
-/* 16-bits versions */
-
 /* insprired by OpenCV's Bayer decoding */
 dc1394error_t
 dc1394_bayer_NearestNeighbor_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
@@ -928,10 +1016,8 @@ dc1394_bayer_NearestNeighbor_uint16(const uint16_t *restrict bayer, uint16_t *re
     const int rgbStep = 3 * sx;
     int width = sx;
     int height = sy;
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
     int i, iinc, imax;
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
@@ -953,58 +1039,82 @@ dc1394_bayer_NearestNeighbor_uint16(const uint16_t *restrict bayer, uint16_t *re
     height -= 1;
     width -= 1;
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-      //int t0, t1;
-        const uint16_t *bayerEnd = bayer + width;
+    BAYER_ROWS(nearest_row_uint16, blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
-        if (start_with_green) {
-            rgb[-blue] = bayer[1];
-            rgb[0] = bayer[bayerStep + 1];
-            rgb[blue] = bayer[bayerStep];
-            bayer++;
-            rgb += 3;
-        }
+    return DC1394_SUCCESS;
 
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[-1] = bayer[0];
-                rgb[0] = bayer[1];
-                rgb[1] = bayer[bayerStep + 1];
+}
 
-                rgb[2] = bayer[2];
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[4] = bayer[bayerStep + 1];
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                rgb[1] = bayer[0];
-                rgb[0] = bayer[1];
-                rgb[-1] = bayer[bayerStep + 1];
-
-                rgb[4] = bayer[2];
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[2] = bayer[bayerStep + 1];
-            }
-        }
+/* a row of dc1394_bayer_Bilinear_uint16(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+bilinear_row_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int width, int bayerStep,
+                    const int blue, const int start_with_green)
+{
+    int t0, t1;
+    const uint16_t *bayerEnd = bayer + width;
+
+    if (start_with_green) {
+        /* OpenCV has a bug in the next line, which was
+           t0 = (bayer[0] + bayer[bayerStep * 2] + 1) >> 1; */
+        t0 = (bayer[1] + bayer[bayerStep * 2 + 1] + 1) >> 1;
+        t1 = (bayer[bayerStep] + bayer[bayerStep + 2] + 1) >> 1;
+        rgb[-blue] = (uint16_t) t0;
+        rgb[0] = bayer[bayerStep + 1];
+        rgb[blue] = (uint16_t) t1;
+        bayer++;
+        rgb += 3;
+    }
 
-        if (bayer < bayerEnd) {
-            rgb[-blue] = bayer[0];
-            rgb[0] = bayer[1];
-            rgb[blue] = bayer[bayerStep + 1];
-            bayer++;
-            rgb += 3;
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+                  bayer[bayerStep * 2 + 2] + 2) >> 2;
+            t1 = (bayer[1] + bayer[bayerStep] +
+                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+                  2) >> 2;
+            rgb[-1] = (uint16_t) t0;
+            rgb[0] = (uint16_t) t1;
+            rgb[1] = bayer[bayerStep + 1];
+
+            t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
+            t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                  1) >> 1;
+            rgb[2] = (uint16_t) t0;
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[4] = (uint16_t) t1;
+        }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+                  bayer[bayerStep * 2 + 2] + 2) >> 2;
+            t1 = (bayer[1] + bayer[bayerStep] +
+                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+                  2) >> 2;
+            rgb[1] = (uint16_t) t0;
+            rgb[0] = (uint16_t) t1;
+            rgb[-1] = bayer[bayerStep + 1];
+
+            t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
+            t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                  1) >> 1;
+            rgb[4] = (uint16_t) t0;
+            rgb[3] = bayer[bayerStep + 2];
+            rgb[2] = (uint16_t) t1;
         }
-
-        bayer -= width;
-        rgb -= width * 3;
-
-        blue = -blue;
-        start_with_green = !start_with_green;
     }
 
-    return DC1394_SUCCESS;
-
+    if (bayer < bayerEnd) {
+        t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
+              bayer[bayerStep * 2 + 2] + 2) >> 2;
+        t1 = (bayer[1] + bayer[bayerStep] +
+              bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
+              2) >> 2;
+        rgb[-blue] = (uint16_t) t0;
+        rgb[0] = (uint16_t) t1;
+        rgb[blue] = bayer[bayerStep + 1];
+    }
 }
+
 /* OpenCV's Bayer decoding */
 dc1394error_t
 dc1394_bayer_Bilinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
@@ -1013,94 +1123,188 @@ dc1394_bayer_Bilinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict
     const int rgbStep = 3 * sx;
     int width = sx;
     int height = sy;
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
       return DC1394_INVALID_COLOR_FILTER;
 
+    ClearBorders_uint16(rgb, sx, sy, 1);
     rgb += rgbStep + 3 + 1;
     height -= 2;
     width -= 2;
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-        int t0, t1;
-        const uint16_t *bayerEnd = bayer + width;
-
-        if (start_with_green) {
-            /* OpenCV has a bug in the next line, which was
-               t0 = (bayer[0] + bayer[bayerStep * 2] + 1) >> 1; */
-            t0 = (bayer[1] + bayer[bayerStep * 2 + 1] + 1) >> 1;
-            t1 = (bayer[bayerStep] + bayer[bayerStep + 2] + 1) >> 1;
-            rgb[-blue] = (uint16_t) t0;
-            rgb[0] = bayer[bayerStep + 1];
-            rgb[blue] = (uint16_t) t1;
-            bayer++;
-            rgb += 3;
-        }
-
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                      bayer[bayerStep * 2 + 2] + 2) >> 2;
-                t1 = (bayer[1] + bayer[bayerStep] +
-                      bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                      2) >> 2;
-                rgb[-1] = (uint16_t) t0;
-                rgb[0] = (uint16_t) t1;
-                rgb[1] = bayer[bayerStep + 1];
-
-                t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
-                t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                      1) >> 1;
-                rgb[2] = (uint16_t) t0;
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[4] = (uint16_t) t1;
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                      bayer[bayerStep * 2 + 2] + 2) >> 2;
-                t1 = (bayer[1] + bayer[bayerStep] +
-                      bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                      2) >> 2;
-                rgb[1] = (uint16_t) t0;
-                rgb[0] = (uint16_t) t1;
-                rgb[-1] = bayer[bayerStep + 1];
-
-                t0 = (bayer[2] + bayer[bayerStep * 2 + 2] + 1) >> 1;
-                t1 = (bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                      1) >> 1;
-                rgb[4] = (uint16_t) t0;
-                rgb[3] = bayer[bayerStep + 2];
-                rgb[2] = (uint16_t) t1;
-            }
-        }
+    BAYER_ROWS(bilinear_row_uint16, blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep);
 
-        if (bayer < bayerEnd) {
-            t0 = (bayer[0] + bayer[2] + bayer[bayerStep * 2] +
-                  bayer[bayerStep * 2 + 2] + 2) >> 2;
-            t1 = (bayer[1] + bayer[bayerStep] +
-                  bayer[bayerStep + 2] + bayer[bayerStep * 2 + 1] +
-                  2) >> 2;
-            rgb[-blue] = (uint16_t) t0;
-            rgb[0] = (uint16_t) t1;
-            rgb[blue] = bayer[bayerStep + 1];
-            bayer++;
-            rgb += 3;
-        }
+    return DC1394_SUCCESS;
 
-        bayer -= width;
-        rgb -= width * 3;
+}
 
-        blue = -blue;
-        start_with_green = !start_with_green;
+/* a row of dc1394_bayer_HQLinear_uint16(), blue and start_with_green being those of the row */
+BAYER_INLINE void
+hqlinear_row_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int width, int bayerStep, int bits,
+                    const int blue, const int start_with_green)
+{
+    int t0, t1;
+    const uint16_t *bayerEnd = bayer + width;
+    const int bayerStep2 = bayerStep * 2;
+    const int bayerStep3 = bayerStep * 3;
+    const int bayerStep4 = bayerStep * 4;
+
+    if (start_with_green) {
+        /* at green pixel */
+        rgb[0] = bayer[bayerStep2 + 2];
+        t0 = rgb[0] * 5
+            + ((bayer[bayerStep + 2] + bayer[bayerStep3 + 2]) << 2)
+            - bayer[2]
+            - bayer[bayerStep + 1]
+            - bayer[bayerStep + 3]
+            - bayer[bayerStep3 + 1]
+            - bayer[bayerStep3 + 3]
+            - bayer[bayerStep4 + 2]
+            + ((bayer[bayerStep2] + bayer[bayerStep2 + 4] + 1) >> 1);
+        t1 = rgb[0] * 5 +
+            ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 3]) << 2)
+            - bayer[bayerStep2]
+            - bayer[bayerStep + 1]
+            - bayer[bayerStep + 3]
+            - bayer[bayerStep3 + 1]
+            - bayer[bayerStep3 + 3]
+            - bayer[bayerStep2 + 4]
+            + ((bayer[2] + bayer[bayerStep4 + 2] + 1) >> 1);
+        t0 = (t0 + 4) >> 3;
+        CLIP16(t0, rgb[-blue], bits);
+        t1 = (t1 + 4) >> 3;
+        CLIP16(t1, rgb[blue], bits);
+        bayer++;
+        rgb += 3;
     }
 
-    return DC1394_SUCCESS;
+    if (blue > 0) {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            /* B at B */
+            rgb[1] = bayer[bayerStep2 + 2];
+            /* R at B */
+            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                   bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
+                -
+                (((bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                                 2]) * 3 + 1) >> 1)
+                + rgb[1] * 6;
+            /* G at B */
+            t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                   bayer[bayerStep2 + 3] + bayer[bayerStep * 3 +
+                                                 2]) << 1)
+                - (bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+                + (rgb[1] << 2);
+            t0 = (t0 + 4) >> 3;
+            CLIP16(t0, rgb[-1], bits);
+            t1 = (t1 + 4) >> 3;
+            CLIP16(t1, rgb[0], bits);
+            /* at green pixel */
+            rgb[3] = bayer[bayerStep2 + 3];
+            t0 = rgb[3] * 5
+                + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
+                - bayer[3]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep4 + 3]
+                +
+                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
+                  1) >> 1);
+            t1 = rgb[3] * 5 +
+                ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
+                - bayer[bayerStep2 + 1]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep2 + 5]
+                + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
+            t0 = (t0 + 4) >> 3;
+            CLIP16(t0, rgb[2], bits);
+            t1 = (t1 + 4) >> 3;
+            CLIP16(t1, rgb[4], bits);
+        }
+    } else {
+        for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
+            /* R at R */
+            rgb[-1] = bayer[bayerStep2 + 2];
+            /* B at R */
+            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+                   bayer[bayerStep * 3 + 1] + bayer[bayerStep3 +
+                                                    3]) << 1)
+                -
+                (((bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                                 2]) * 3 + 1) >> 1)
+                + rgb[-1] * 6;
+            /* G at R */
+            t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                   bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2]) << 1)
+                - (bayer[2] + bayer[bayerStep2] +
+                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+                + (rgb[-1] << 2);
+            t0 = (t0 + 4) >> 3;
+            CLIP16(t0, rgb[1], bits);
+            t1 = (t1 + 4) >> 3;
+            CLIP16(t1, rgb[0], bits);
+
+            /* at green pixel */
+            rgb[3] = bayer[bayerStep2 + 3];
+            t0 = rgb[3] * 5
+                + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
+                - bayer[3]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep4 + 3]
+                +
+                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
+                  1) >> 1);
+            t1 = rgb[3] * 5 +
+                ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
+                - bayer[bayerStep2 + 1]
+                - bayer[bayerStep + 2]
+                - bayer[bayerStep + 4]
+                - bayer[bayerStep3 + 2]
+                - bayer[bayerStep3 + 4]
+                - bayer[bayerStep2 + 5]
+                + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
+            t0 = (t0 + 4) >> 3;
+            CLIP16(t0, rgb[4], bits);
+            t1 = (t1 + 4) >> 3;
+            CLIP16(t1, rgb[2], bits);
+        }
+    }
 
+    if (bayer < bayerEnd) {
+        /* B at B */
+        rgb[blue] = bayer[bayerStep2 + 2];
+        /* R at B */
+        t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
+               bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
+            -
+            (((bayer[2] + bayer[bayerStep2] +
+               bayer[bayerStep2 + 4] + bayer[bayerStep4 +
+                                             2]) * 3 + 1) >> 1)
+            + rgb[blue] * 6;
+        /* G at B */
+        t1 = (((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
+                bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2])) << 1)
+            - (bayer[2] + bayer[bayerStep2] +
+               bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
+            + (rgb[blue] << 2);
+        t0 = (t0 + 4) >> 3;
+        CLIP16(t0, rgb[-blue], bits);
+        t1 = (t1 + 4) >> 3;
+        CLIP16(t1, rgb[0], bits);
+    }
 }
 
 /* High-Quality Linear Interpolation For Demosaicing Of
@@ -1125,10 +1329,8 @@ dc1394_bayer_HQLinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict
        int blue = tile == CV_BayerBG2BGR || tile == CV_BayerGB2BGR ? -1 : 1;
        int start_with_green = tile == CV_BayerGB2BGR || tile == CV_BayerGR2BGR;
      */
-    int blue = tile == DC1394_COLOR_FILTER_BGGR
-        || tile == DC1394_COLOR_FILTER_GBRG ? -1 : 1;
-    int start_with_green = tile == DC1394_COLOR_FILTER_GBRG
-        || tile == DC1394_COLOR_FILTER_GRBG;
+    const int blue = BAYER_FIRST_RED(tile) ? 1 : -1;
+    const int start_with_green = BAYER_FIRST_GREEN(tile);
 
     if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
       return DC1394_INVALID_COLOR_FILTER;
@@ -1139,181 +1341,10 @@ dc1394_bayer_HQLinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict
     width -= 4;
 
     /* We begin with a (+1 line,+1 column) offset with respect to bilinear decoding, so start_with_green is the same, but blue is opposite */
-    blue = -blue;
+    BAYER_ROWS(hqlinear_row_uint16, -blue, start_with_green, bayer, rgb, height, bayerStep, rgbStep, width, bayerStep, bits);
 
-    for (; height--; bayer += bayerStep, rgb += rgbStep) {
-        int t0, t1;
-        const uint16_t *bayerEnd = bayer + width;
-        const int bayerStep2 = bayerStep * 2;
-        const int bayerStep3 = bayerStep * 3;
-        const int bayerStep4 = bayerStep * 4;
-
-        if (start_with_green) {
-            /* at green pixel */
-            rgb[0] = bayer[bayerStep2 + 2];
-            t0 = rgb[0] * 5
-                + ((bayer[bayerStep + 2] + bayer[bayerStep3 + 2]) << 2)
-                - bayer[2]
-                - bayer[bayerStep + 1]
-                - bayer[bayerStep + 3]
-                - bayer[bayerStep3 + 1]
-                - bayer[bayerStep3 + 3]
-                - bayer[bayerStep4 + 2]
-                + ((bayer[bayerStep2] + bayer[bayerStep2 + 4] + 1) >> 1);
-            t1 = rgb[0] * 5 +
-                ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 3]) << 2)
-                - bayer[bayerStep2]
-                - bayer[bayerStep + 1]
-                - bayer[bayerStep + 3]
-                - bayer[bayerStep3 + 1]
-                - bayer[bayerStep3 + 3]
-                - bayer[bayerStep2 + 4]
-                + ((bayer[2] + bayer[bayerStep4 + 2] + 1) >> 1);
-            t0 = (t0 + 4) >> 3;
-            CLIP16(t0, rgb[-blue], bits);
-            t1 = (t1 + 4) >> 3;
-            CLIP16(t1, rgb[blue], bits);
-            bayer++;
-            rgb += 3;
-        }
-
-        if (blue > 0) {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                /* B at B */
-                rgb[1] = bayer[bayerStep2 + 2];
-                /* R at B */
-                t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                       bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
-                    -
-                    (((bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                     2]) * 3 + 1) >> 1)
-                    + rgb[1] * 6;
-                /* G at B */
-                t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                       bayer[bayerStep2 + 3] + bayer[bayerStep * 3 +
-                                                     2]) << 1)
-                    - (bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                    + (rgb[1] << 2);
-                t0 = (t0 + 4) >> 3;
-                CLIP16(t0, rgb[-1], bits);
-                t1 = (t1 + 4) >> 3;
-                CLIP16(t1, rgb[0], bits);
-                /* at green pixel */
-                rgb[3] = bayer[bayerStep2 + 3];
-                t0 = rgb[3] * 5
-                    + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
-                    - bayer[3]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep4 + 3]
-                    +
-                    ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
-                      1) >> 1);
-                t1 = rgb[3] * 5 +
-                    ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
-                    - bayer[bayerStep2 + 1]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep2 + 5]
-                    + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
-                t0 = (t0 + 4) >> 3;
-                CLIP16(t0, rgb[2], bits);
-                t1 = (t1 + 4) >> 3;
-                CLIP16(t1, rgb[4], bits);
-            }
-        } else {
-            for (; bayer <= bayerEnd - 2; bayer += 2, rgb += 6) {
-                /* R at R */
-                rgb[-1] = bayer[bayerStep2 + 2];
-                /* B at R */
-                t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                       bayer[bayerStep * 3 + 1] + bayer[bayerStep3 +
-                                                        3]) << 1)
-                    -
-                    (((bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                     2]) * 3 + 1) >> 1)
-                    + rgb[-1] * 6;
-                /* G at R */
-                t1 = ((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                       bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2]) << 1)
-                    - (bayer[2] + bayer[bayerStep2] +
-                       bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                    + (rgb[-1] << 2);
-                t0 = (t0 + 4) >> 3;
-                CLIP16(t0, rgb[1], bits);
-                t1 = (t1 + 4) >> 3;
-                CLIP16(t1, rgb[0], bits);
-
-                /* at green pixel */
-                rgb[3] = bayer[bayerStep2 + 3];
-                t0 = rgb[3] * 5
-                    + ((bayer[bayerStep + 3] + bayer[bayerStep3 + 3]) << 2)
-                    - bayer[3]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep4 + 3]
-                    +
-                    ((bayer[bayerStep2 + 1] + bayer[bayerStep2 + 5] +
-                      1) >> 1);
-                t1 = rgb[3] * 5 +
-                    ((bayer[bayerStep2 + 2] + bayer[bayerStep2 + 4]) << 2)
-                    - bayer[bayerStep2 + 1]
-                    - bayer[bayerStep + 2]
-                    - bayer[bayerStep + 4]
-                    - bayer[bayerStep3 + 2]
-                    - bayer[bayerStep3 + 4]
-                    - bayer[bayerStep2 + 5]
-                    + ((bayer[3] + bayer[bayerStep4 + 3] + 1) >> 1);
-                t0 = (t0 + 4) >> 3;
-                CLIP16(t0, rgb[4], bits);
-                t1 = (t1 + 4) >> 3;
-                CLIP16(t1, rgb[2], bits);
-            }
-        }
-
-        if (bayer < bayerEnd) {
-            /* B at B */
-            rgb[blue] = bayer[bayerStep2 + 2];
-            /* R at B */
-            t0 = ((bayer[bayerStep + 1] + bayer[bayerStep + 3] +
-                   bayer[bayerStep3 + 1] + bayer[bayerStep3 + 3]) << 1)
-                -
-                (((bayer[2] + bayer[bayerStep2] +
-                   bayer[bayerStep2 + 4] + bayer[bayerStep4 +
-                                                 2]) * 3 + 1) >> 1)
-                + rgb[blue] * 6;
-            /* G at B */
-            t1 = (((bayer[bayerStep + 2] + bayer[bayerStep2 + 1] +
-                    bayer[bayerStep2 + 3] + bayer[bayerStep3 + 2])) << 1)
-                - (bayer[2] + bayer[bayerStep2] +
-                   bayer[bayerStep2 + 4] + bayer[bayerStep4 + 2])
-                + (rgb[blue] << 2);
-            t0 = (t0 + 4) >> 3;
-            CLIP16(t0, rgb[-blue], bits);
-            t1 = (t1 + 4) >> 3;
-            CLIP16(t1, rgb[0], bits);
-            bayer++;
-            rgb += 3;
-        }
-
-        bayer -= width;
-        rgb -= width * 3;
-
-        blue = -blue;
-        start_with_green = !start_with_green;
-    }
-
-    return DC1394_SUCCESS;
-}
+    return DC1394_SUCCESS;
+}
 
 /* coriander's Bayer decoding */
 dc1394error_t
@@ -1492,7 +1523,7 @@ dc1394_bayer_EdgeSense_uint16(const uint16_t *restrict bayer, uint16_t *restrict
 				CLIP16(tmp, outG[base], bits);
 			}
 		}
-		for (i3=3*sx3; i3 < (sy - 3)*sx3; i3 += (sx3<<1)) {
+		for (i3=3*sx3; i3 < (sy - 2)*sx3; i3 += (sx3<<1)) {
 			for (j3=9; j3 < sx3 - 6; j3+=6) {
 				base=i3+j3;
 				dh = abs(((outR[base - 6] +
@@ -1867,41 +1898,60 @@ static const signed char bayervng_terms[] = {
     +1,+0,+2,+1,0,0x10
 }, bayervng_chood[] = { -1,-1, -1,0, -1,+1, 0,+1, +1,+1, +1,0, +1,-1, 0,-1 };
 
-dc1394error_t
-dc1394_bayer_VNG(const uint8_t *restrict bayer,
-                 uint8_t *restrict dst, int sx, int sy,
-                 dc1394color_filter_t pattern)
+/*
+  Working memory of the VNG and AHD decoders. The functions with the
+  historical interface use a temporary one; a de-mosaicing context keeps one
+  per band, so that nothing is allocated or recomputed after the first frame.
+ */
+typedef struct {
+    void *vng_rows;             /* three rows of interpolated pixels */
+    size_t vng_rows_size;
+    int vng_width;              /* vng_code is for images of this width... */
+    uint32_t vng_filters;       /* ...and this pattern (0: not computed yet) */
+    int vng_code[8][2][320];
+    char *ahd_buffer;           /* the AHD tiles, 26*TS*TS bytes */
+} bayer_scratch_t;
+
+static bayer_scratch_t*
+bayer_scratch_new(void)
 {
-    const int height = sy, width = sx;
-    static const signed char *cp;
-    /* the following has the same type as the image */
-    uint8_t (*brow[5])[3], *pix;          /* [FD] */
-    int code[8][2][320], *ip, gval[8], gmin, gmax, sum[4];
-    int row, col, x, y, x1, x2, y1, y2, t, weight, grads, color, diag;
-    int g, diff, thold, num, c;
-    uint32_t filters;                     /* [FD] */
+    return (bayer_scratch_t*)calloc(1, sizeof(bayer_scratch_t));
+}
 
-    /* first, use bilinear bayer decoding */
-    dc1394_bayer_Bilinear(bayer, dst, sx, sy, pattern);
+static void
+bayer_scratch_free(bayer_scratch_t *scratch)
+{
+    if (scratch == NULL)
+        return;
+    simd_free(scratch->vng_rows);
+    simd_free(scratch->ahd_buffer);
+    free(scratch);
+}
 
-    switch(pattern) {
-    case DC1394_COLOR_FILTER_BGGR:
-        filters = 0x16161616;
-        break;
-    case DC1394_COLOR_FILTER_GRBG:
-        filters = 0x61616161;
-        break;
-    case DC1394_COLOR_FILTER_RGGB:
-        filters = 0x94949494;
-        break;
-    case DC1394_COLOR_FILTER_GBRG:
-        filters = 0x49494949;
-        break;
-    default:
-        return DC1394_INVALID_COLOR_FILTER;
+/* returns size bytes of zeroed memory for the VNG rows, or NULL */
+static void*
+vng_rows(bayer_scratch_t *scratch, size_t size)
+{
+    if (size > scratch->vng_rows_size) {
+        simd_free(scratch->vng_rows);
+        scratch->vng_rows = simd_malloc(size);
+        scratch->vng_rows_size = scratch->vng_rows ? size : 0;
+        if (scratch->vng_rows == NULL)
+            return NULL;
     }
+    memset(scratch->vng_rows, 0, size);
+    return scratch->vng_rows;
+}
+
+/* gradient and neighbour offsets of VNG, which depend on the width and the pattern */
+static void
+vng_build_code(bayer_scratch_t *scratch, int width, uint32_t filters)
+{
+    const signed char *cp;
+    int (*code)[2][320] = scratch->vng_code;
+    int *ip, row, col, x, y, x1, x2, y1, y2, t, weight, grads, color, diag, g;
 
-    for (row=0; row < 8; row++) {                /* Precalculate for VNG */
+    for (row=0; row < 8; row++) {
         for (col=0; col < 2; col++) {
             ip = code[row][col];
             for (cp=bayervng_terms, t=0; t < 64; t++) {
@@ -1932,8 +1982,49 @@ dc1394_bayer_VNG(const uint8_t *restrict bayer,
             }
         }
     }
-    brow[4] = calloc (width*3, sizeof **brow);
-    //merror (brow[4], "vng_interpolate()");
+    scratch->vng_width = width;
+    scratch->vng_filters = filters;
+}
+
+static dc1394error_t
+bayer_VNG(bayer_scratch_t *scratch, const uint8_t *restrict bayer,
+          uint8_t *restrict dst, int sx, int sy,
+          dc1394color_filter_t pattern)
+{
+    const int height = sy, width = sx;
+    /* the following has the same type as the image */
+    uint8_t (*brow[5])[3], *pix;          /* [FD] */
+    int (*code)[2][320], *ip, gval[8], gmin, gmax, sum[4];
+    int row, col, t, color;
+    int g, diff, thold, num, c;
+    uint32_t filters;                     /* [FD] */
+
+    /* first, use bilinear bayer decoding */
+    dc1394_bayer_Bilinear(bayer, dst, sx, sy, pattern);
+
+    switch(pattern) {
+    case DC1394_COLOR_FILTER_BGGR:
+        filters = 0x16161616;
+        break;
+    case DC1394_COLOR_FILTER_GRBG:
+        filters = 0x61616161;
+        break;
+    case DC1394_COLOR_FILTER_RGGB:
+        filters = 0x94949494;
+        break;
+    case DC1394_COLOR_FILTER_GBRG:
+        filters = 0x49494949;
+        break;
+    default:
+        return DC1394_INVALID_COLOR_FILTER;
+    }
+
+    if ((scratch->vng_width != width) || (scratch->vng_filters != filters))
+        vng_build_code(scratch, width, filters);                /* Precalculate for VNG */
+    code = scratch->vng_code;
+    brow[4] = vng_rows (scratch, width*3 * sizeof **brow);
+    if (brow[4] == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
     for (row=0; row < 3; row++)
         brow[row] = brow[4] + row*width;
     for (row=2; row < height-2; row++) {                /* Do VNG interpolation */
@@ -1987,23 +2078,37 @@ dc1394_bayer_VNG(const uint8_t *restrict bayer,
     }
     memcpy (dst + 3*((row-2)*width+2), brow[0]+2, (width-4)*3*sizeof *dst);
     memcpy (dst + 3*((row-1)*width+2), brow[1]+2, (width-4)*3*sizeof *dst);
-    free (brow[4]);
 
     return DC1394_SUCCESS;
 }
 
 
 dc1394error_t
-dc1394_bayer_VNG_uint16(const uint16_t *restrict bayer,
-                        uint16_t *restrict dst, int sx, int sy,
-                        dc1394color_filter_t pattern, int bits)
+dc1394_bayer_VNG(const uint8_t *restrict bayer,
+                 uint8_t *restrict dst, int sx, int sy,
+                 dc1394color_filter_t pattern)
+{
+    bayer_scratch_t *scratch = bayer_scratch_new();
+    dc1394error_t err;
+
+    if (scratch == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    err = bayer_VNG(scratch, bayer, dst, sx, sy, pattern);
+    bayer_scratch_free(scratch);
+
+    return err;
+}
+
+static dc1394error_t
+bayer_VNG_uint16(bayer_scratch_t *scratch, const uint16_t *restrict bayer,
+                 uint16_t *restrict dst, int sx, int sy,
+                 dc1394color_filter_t pattern, int bits)
 {
     const int height = sy, width = sx;
-    static const signed char *cp;
     /* the following has the same type as the image */
     uint16_t (*brow[5])[3], *pix;          /* [FD] */
-    int code[8][2][320], *ip, gval[8], gmin, gmax, sum[4];
-    int row, col, x, y, x1, x2, y1, y2, t, weight, grads, color, diag;
+    int (*code)[2][320], *ip, gval[8], gmin, gmax, sum[4];
+    int row, col, t, color;
     int g, diff, thold, num, c;
     uint32_t filters;                     /* [FD] */
 
@@ -2028,39 +2133,12 @@ dc1394_bayer_VNG_uint16(const uint16_t *restrict bayer,
         return DC1394_INVALID_COLOR_FILTER;
     }
 
-    for (row=0; row < 8; row++) {                /* Precalculate for VNG */
-        for (col=0; col < 2; col++) {
-            ip = code[row][col];
-            for (cp=bayervng_terms, t=0; t < 64; t++) {
-                y1 = *cp++;  x1 = *cp++;
-                y2 = *cp++;  x2 = *cp++;
-                weight = *cp++;
-                grads = *cp++;
-                color = FC(row+y1,col+x1);
-                if (FC(row+y2,col+x2) != color) continue;
-                diag = (FC(row,col+1) == color && FC(row+1,col) == color) ? 2:1;
-                if (abs(y1-y2) == diag && abs(x1-x2) == diag) continue;
-                *ip++ = (y1*width + x1)*3 + color; /* [FD] */
-                *ip++ = (y2*width + x2)*3 + color; /* [FD] */
-                *ip++ = weight;
-                for (g=0; g < 8; g++)
-                    if (grads & 1<<g) *ip++ = g;
-                *ip++ = -1;
-            }
-            *ip++ = INT_MAX;
-            for (cp=bayervng_chood, g=0; g < 8; g++) {
-                y = *cp++;  x = *cp++;
-                *ip++ = (y*width + x) * 3;      /* [FD] */
-                color = FC(row,col);
-                if (FC(row+y,col+x) != color && FC(row+y*2,col+x*2) == color)
-                    *ip++ = (y*width + x) * 6 + color; /* [FD] */
-                else
-                    *ip++ = 0;
-            }
-        }
-    }
-    brow[4] = calloc (width*3, sizeof **brow);
-    //merror (brow[4], "vng_interpolate()");
+    if ((scratch->vng_width != width) || (scratch->vng_filters != filters))
+        vng_build_code(scratch, width, filters);                /* Precalculate for VNG */
+    code = scratch->vng_code;
+    brow[4] = vng_rows (scratch, width*3 * sizeof **brow);
+    if (brow[4] == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
     for (row=0; row < 3; row++)
         brow[row] = brow[4] + row*width;
     for (row=2; row < height-2; row++) {                /* Do VNG interpolation */
@@ -2114,15 +2192,30 @@ dc1394_bayer_VNG_uint16(const uint16_t *restrict bayer,
     }
     memcpy (dst + 3*((row-2)*width+2), brow[0]+2, (width-4)*3*sizeof *dst);
     memcpy (dst + 3*((row-1)*width+2), brow[1]+2, (width-4)*3*sizeof *dst);
-    free (brow[4]);
 
     return DC1394_SUCCESS;
 }
 
 
 
+dc1394error_t
+dc1394_bayer_VNG_uint16(const uint16_t *restrict bayer,
+                        uint16_t *restrict dst, int sx, int sy,
+                        dc1394color_filter_t pattern, int bits)
+{
+    bayer_scratch_t *scratch = bayer_scratch_new();
+    dc1394error_t err;
+
+    if (scratch == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    err = bayer_VNG_uint16(scratch, bayer, dst, sx, sy, pattern, bits);
+    bayer_scratch_free(scratch);
+
+    return err;
+}
+
 /* AHD interpolation ported from dcraw to libdc1394 by Samuel Audet */
-static dc1394bool_t ahd_inited = DC1394_FALSE; /* WARNING: not multi-processor safe */
+static int ahd_inited = 0;
 
 #define CLIPOUT(x)        LIM(x,0,255)
 #define CLIPOUT16(x,bits) LIM(x,0,((1<<bits)-1))
@@ -2133,68 +2226,126 @@ static const double xyz_rgb[3][3] = {                        /* XYZ from RGB */
   { 0.019334, 0.119193, 0.950227 } };
 static const float d65_white[3] = { 0.950456, 1, 1.088754 };
 
-static void cam_to_cielab (uint16_t cam[3], float lab[3]) /* [SA] */
+/*
+  The CIELab conversion is done in fixed point: the XYZ coefficients are
+  scaled by 2^AHD_XYZ_BITS, and the cube root table holds f(t) of the Lab
+  formulas scaled by 2^AHD_CBRT_BITS. The result is 64 times the CIELab
+  value truncated, as kept in the AHD tiles, like the floating point
+  computation of dcraw.
+ */
+#define AHD_XYZ_BITS  24
+#define AHD_CBRT_BITS 16
+
+static int32_t ahd_cbrt[0x10000];
+static uint32_t ahd_xyz_cam[3][3];
+
+/* v / 2^AHD_CBRT_BITS, rounded towards zero */
+#define AHD_UNSCALE(v) (((v) + ((v) < 0 ? (1 << AHD_CBRT_BITS) - 1 : 0)) >> AHD_CBRT_BITS)
+
+static inline void
+cam_to_cielab (const uint16_t cam[3], int16_t lab[3]) /* [SA] */
 {
-    int c, i, j;
-    float r, xyz[3];
-    static float cbrt[0x10000], xyz_cam[3][4];
+    int32_t f[3];
+    uint64_t xyz;
+    int i;
+
+    for (i=0; i < 3; i++) {
+        xyz = ((uint64_t) ahd_xyz_cam[i][0] * cam[0] + (uint64_t) ahd_xyz_cam[i][1] * cam[1] +
+               (uint64_t) ahd_xyz_cam[i][2] * cam[2] + (1 << (AHD_XYZ_BITS-1))) >> AHD_XYZ_BITS;
+        f[i] = ahd_cbrt[MIN(xyz, 0xffff)];
+    }
+    lab[0] = AHD_UNSCALE(64*116 * f[1] - (64*16 << AHD_CBRT_BITS));
+    lab[1] = AHD_UNSCALE(64*500 * (f[0] - f[1]));
+    lab[2] = AHD_UNSCALE(64*200 * (f[1] - f[2]));
+}
 
-    if (cam == NULL) {
-        for (i=0; i < 0x10000; i++) {
-            r = i / 65535.0;
-            cbrt[i] = r > 0.008856 ? pow(r,1/3.0) : 7.787*r + 16/116.0;
-        }
-        for (i=0; i < 3; i++)
-            for (j=0; j < 3; j++)                           /* [SA] */
-                xyz_cam[i][j] = xyz_rgb[i][j] / d65_white[i]; /* [SA] */
-    } else {
-        xyz[0] = xyz[1] = xyz[2] = 0.5;
-        FORC3 { /* [SA] */
-            xyz[0] += xyz_cam[0][c] * cam[c];
-            xyz[1] += xyz_cam[1][c] * cam[c];
-            xyz[2] += xyz_cam[2][c] * cam[c];
-        }
-        xyz[0] = cbrt[CLIPOUT16((int) xyz[0],16)];        /* [SA] */
-        xyz[1] = cbrt[CLIPOUT16((int) xyz[1],16)];        /* [SA] */
-        xyz[2] = cbrt[CLIPOUT16((int) xyz[2],16)];        /* [SA] */
-        lab[0] = 116 * xyz[1] - 16;
-        lab[1] = 500 * (xyz[0] - xyz[1]);
-        lab[2] = 200 * (xyz[1] - xyz[2]);
+static void
+ahd_fill_tables(void)
+{
+    double r;
+    int i, j;
+
+    for (i=0; i < 0x10000; i++) {
+        r = i / 65535.0;
+        r = r > 0.008856 ? pow(r,1/3.0) : 7.787*r + 16/116.0;
+        ahd_cbrt[i] = (int32_t) (r * (1 << AHD_CBRT_BITS) + 0.5);
     }
+    for (i=0; i < 3; i++)
+        for (j=0; j < 3; j++)                                 /* [SA] */
+            ahd_xyz_cam[i][j] = (uint32_t) (xyz_rgb[i][j] / d65_white[i] * (1 << AHD_XYZ_BITS) + 0.5);
+}
+
+/* fills the tables of cam_to_cielab() the first time it is called. They
+   never change afterwards, so all the threads and contexts share them. */
+static void
+ahd_init(void)
+{
+    thread_once(&ahd_inited, ahd_fill_tables);
 }
 
 /*
    Adaptive Homogeneity-Directed interpolation is based on
    the work of Keigo Hirakawa, Thomas Parks, and Paul Lee.
  */
-#define TS 256                /* Tile Size */
+#define TS AHD_TILE                /* Tile Size */
 
-dc1394error_t
-dc1394_bayer_AHD(const uint8_t *restrict bayer,
-                 uint8_t *restrict dst, int sx, int sy,
-                 dc1394color_filter_t pattern)
+/* homogeneity of n pixels of a tile row, see ahd_homogeneity_func_t in simd.h */
+void
+ahd_homogeneity(const int16_t *lab, int8_t *homo, int n)
+{
+    static const int dir[4] = { -1, 1, -TS, TS };
+    unsigned ldiff[2][4], abdiff[2][4], leps, abeps;
+    const int16_t *l;
+    int k, d, i, da, db;
+
+    for (k=0; k < n; k++) {
+        for (d=0; d < 2; d++) {
+            l = lab + d*3*AHD_PLANE + k;
+            for (i=0; i < 4; i++) {
+                ldiff[d][i] = ABS(l[0]-l[dir[i]]);
+                da = l[AHD_PLANE] - l[AHD_PLANE+dir[i]];
+                db = l[2*AHD_PLANE] - l[2*AHD_PLANE+dir[i]];
+                abdiff[d][i] = (unsigned) da*da + (unsigned) db*db;
+            }
+        }
+        leps = MIN(MAX(ldiff[0][0],ldiff[0][1]),
+                   MAX(ldiff[1][2],ldiff[1][3]));
+        abeps = MIN(MAX(abdiff[0][0],abdiff[0][1]),
+                    MAX(abdiff[1][2],abdiff[1][3]));
+        for (d=0; d < 2; d++) {
+            homo[d*AHD_PLANE + k] = 0;
+            for (i=0; i < 4; i++)
+                if (ldiff[d][i] <= leps && abdiff[d][i] <= abeps)
+                    homo[d*AHD_PLANE + k]++;
+        }
+    }
+}
+
+static dc1394error_t
+bayer_AHD(bayer_scratch_t *scratch, const uint8_t *restrict bayer,
+          uint8_t *restrict dst, int sx, int sy,
+          dc1394color_filter_t pattern)
 {
     int i, j, top, left, row, col, tr, tc, fc, c, d, val, hm[2];
     /* the following has the same type as the image */
     uint8_t (*pix)[3], (*rix)[3];      /* [SA] */
     uint16_t rix16[3];                 /* [SA] */
-    static const int dir[4] = { -1, 1, -TS, TS };
-    unsigned ldiff[2][4], abdiff[2][4], leps, abeps;
-    float flab[3];                     /* [SA] */
+    int16_t lab16[3];
     uint8_t (*rgb)[TS][TS][3];
-    short (*lab)[TS][TS][3];
-    char (*homo)[TS][TS], *buffer;
+    int16_t (*lab)[3][TS][TS];
+    int8_t (*homo)[TS][TS];
+    char *buffer;
+    ahd_homogeneity_func_t homogeneity;
 
     /* start - new code for libdc1394 */
     uint32_t filters;
     const int height = sy, width = sx;
     int x, y;
 
-    if (ahd_inited==DC1394_FALSE) {
-        /* WARNING: this might not be multi-processor safe */
-        cam_to_cielab (NULL,NULL);
-        ahd_inited = DC1394_TRUE;
-    }
+    ahd_init();
+    homogeneity = ahd_simd_get_homogeneity();
+    if (homogeneity == NULL)
+        homogeneity = ahd_homogeneity;
 
     switch(pattern) {
     case DC1394_COLOR_FILTER_BGGR:
@@ -2247,11 +2398,14 @@ dc1394_bayer_AHD(const uint8_t *restrict bayer,
     /* end - code from border_interpolate (int border) */
 
 
-    buffer = (char *) malloc (26*TS*TS);                /* 1664 kB */
-    /* merror (buffer, "ahd_interpolate()"); */
+    if (scratch->ahd_buffer == NULL)
+        scratch->ahd_buffer = (char *) simd_malloc (26*TS*TS); /* 1664 kB */
+    if (scratch->ahd_buffer == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    buffer = scratch->ahd_buffer;
     rgb  = (uint8_t(*)[TS][TS][3]) buffer;                /* [SA] */
-    lab  = (short (*)[TS][TS][3])(buffer + 12*TS*TS);
-    homo = (char  (*)[TS][TS])   (buffer + 24*TS*TS);
+    lab  = (int16_t (*)[3][TS][TS])(buffer + 12*TS*TS);
+    homo = (int8_t  (*)[TS][TS])   (buffer + 24*TS*TS);
 
     for (top=0; top < height; top += TS-6)
         for (left=0; left < width; left += TS-6) {
@@ -2295,33 +2449,14 @@ dc1394_bayer_AHD(const uint8_t *restrict bayer,
                         rix16[0] = rix[0][0];                 /* [SA] */
                         rix16[1] = rix[0][1];                 /* [SA] */
                         rix16[2] = rix[0][2];                 /* [SA] */
-                        cam_to_cielab (rix16, flab);          /* [SA] */
-                        FORC3 lab[d][row-top][col-left][c] = 64*flab[c];
+                        cam_to_cielab (rix16, lab16);         /* [SA] */
+                        FORC3 lab[d][c][row-top][col-left] = lab16[c];
                     }
             /*  Build homogeneity maps from the CIELab images:                */
             memset (homo, 0, 2*TS*TS);
-            for (row=top+2; row < top+TS-2 && row < height; row++) {
-                tr = row-top;
-                for (col=left+2; col < left+TS-2 && col < width; col++) {
-                    tc = col-left;
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            ldiff[d][i] = ABS(lab[d][tr][tc][0]-lab[d][tr][tc+dir[i]][0]);
-                    leps = MIN(MAX(ldiff[0][0],ldiff[0][1]),
-                               MAX(ldiff[1][2],ldiff[1][3]));
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            if (i >> 1 == d || ldiff[d][i] <= leps)
-                                abdiff[d][i] = SQR(lab[d][tr][tc][1]-lab[d][tr][tc+dir[i]][1])
-                                    + SQR(lab[d][tr][tc][2]-lab[d][tr][tc+dir[i]][2]);
-                    abeps = MIN(MAX(abdiff[0][0],abdiff[0][1]),
-                                MAX(abdiff[1][2],abdiff[1][3]));
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            if (ldiff[d][i] <= leps && abdiff[d][i] <= abeps)
-                                homo[d][tr][tc]++;
-                }
-            }
+            for (row=top+2; row < top+TS-2 && row < height; row++)
+                homogeneity (lab[0][0][row-top] + 2, homo[0][row-top] + 2,
+                             MIN(left+TS-2, width) - (left+2));
             /*  Combine the most homogenous pixels for the final result:        */
             for (row=top+3; row < top+TS-3 && row < height-3; row++) {
                 tr = row-top;
@@ -2339,36 +2474,50 @@ dc1394_bayer_AHD(const uint8_t *restrict bayer,
                 }
             }
         }
-    free (buffer);
 
     return DC1394_SUCCESS;
 }
 
 dc1394error_t
-dc1394_bayer_AHD_uint16(const uint16_t *restrict bayer,
-                        uint16_t *restrict dst, int sx, int sy,
-                        dc1394color_filter_t pattern, int bits)
+dc1394_bayer_AHD(const uint8_t *restrict bayer,
+                 uint8_t *restrict dst, int sx, int sy,
+                 dc1394color_filter_t pattern)
+{
+    bayer_scratch_t *scratch = bayer_scratch_new();
+    dc1394error_t err;
+
+    if (scratch == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    err = bayer_AHD(scratch, bayer, dst, sx, sy, pattern);
+    bayer_scratch_free(scratch);
+
+    return err;
+}
+
+static dc1394error_t
+bayer_AHD_uint16(bayer_scratch_t *scratch, const uint16_t *restrict bayer,
+                 uint16_t *restrict dst, int sx, int sy,
+                 dc1394color_filter_t pattern, int bits)
 {
     int i, j, top, left, row, col, tr, tc, fc, c, d, val, hm[2];
     /* the following has the same type as the image */
     uint16_t (*pix)[3], (*rix)[3];      /* [SA] */
-    static const int dir[4] = { -1, 1, -TS, TS };
-    unsigned ldiff[2][4], abdiff[2][4], leps, abeps;
-    float flab[3];
+    int16_t lab16[3];
     uint16_t (*rgb)[TS][TS][3];         /* [SA] */
-    short (*lab)[TS][TS][3];
-    char (*homo)[TS][TS], *buffer;
+    int16_t (*lab)[3][TS][TS];
+    int8_t (*homo)[TS][TS];
+    char *buffer;
+    ahd_homogeneity_func_t homogeneity;
 
     /* start - new code for libdc1394 */
     uint32_t filters;
     const int height = sy, width = sx;
     int x, y;
 
-    if (ahd_inited==DC1394_FALSE) {
-        /* WARNING: this might not be multi-processor safe */
-        cam_to_cielab (NULL,NULL);
-        ahd_inited = DC1394_TRUE;
-    }
+    ahd_init();
+    homogeneity = ahd_simd_get_homogeneity();
+    if (homogeneity == NULL)
+        homogeneity = ahd_homogeneity;
 
     switch(pattern) {
     case DC1394_COLOR_FILTER_BGGR:
@@ -2421,11 +2570,14 @@ dc1394_bayer_AHD_uint16(const uint16_t *restrict bayer,
     /* end - code from border_interpolate(int border) */
 
 
-    buffer = (char *) malloc (26*TS*TS);                /* 1664 kB */
-    /* merror (buffer, "ahd_interpolate()"); */
+    if (scratch->ahd_buffer == NULL)
+        scratch->ahd_buffer = (char *) simd_malloc (26*TS*TS); /* 1664 kB */
+    if (scratch->ahd_buffer == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    buffer = scratch->ahd_buffer;
     rgb  = (uint16_t(*)[TS][TS][3]) buffer;               /* [SA] */
-    lab  = (short (*)[TS][TS][3])(buffer + 12*TS*TS);
-    homo = (char  (*)[TS][TS])   (buffer + 24*TS*TS);
+    lab  = (int16_t (*)[3][TS][TS])(buffer + 12*TS*TS);
+    homo = (int8_t  (*)[TS][TS])   (buffer + 24*TS*TS);
 
     for (top=0; top < height; top += TS-6)
         for (left=0; left < width; left += TS-6) {
@@ -2466,33 +2618,14 @@ dc1394_bayer_AHD_uint16(const uint16_t *restrict bayer,
                         rix[0][c] = CLIPOUT16(val, bits);     /* [SA] */
                         c = FC(row,col);
                         rix[0][c] = pix[0][c];
-                        cam_to_cielab (rix[0], flab);
-                        FORC3 lab[d][row-top][col-left][c] = 64*flab[c];
+                        cam_to_cielab (rix[0], lab16);
+                        FORC3 lab[d][c][row-top][col-left] = lab16[c];
                     }
             /*  Build homogeneity maps from the CIELab images:                */
             memset (homo, 0, 2*TS*TS);
-            for (row=top+2; row < top+TS-2 && row < height; row++) {
-                tr = row-top;
-                for (col=left+2; col < left+TS-2 && col < width; col++) {
-                    tc = col-left;
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            ldiff[d][i] = ABS(lab[d][tr][tc][0]-lab[d][tr][tc+dir[i]][0]);
-                    leps = MIN(MAX(ldiff[0][0],ldiff[0][1]),
-                               MAX(ldiff[1][2],ldiff[1][3]));
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            if (i >> 1 == d || ldiff[d][i] <= leps)
-                                abdiff[d][i] = SQR(lab[d][tr][tc][1]-lab[d][tr][tc+dir[i]][1])
-                                    + SQR(lab[d][tr][tc][2]-lab[d][tr][tc+dir[i]][2]);
-                    abeps = MIN(MAX(abdiff[0][0],abdiff[0][1]),
-                                MAX(abdiff[1][2],abdiff[1][3]));
-                    for (d=0; d < 2; d++)
-                        for (i=0; i < 4; i++)
-                            if (ldiff[d][i] <= leps && abdiff[d][i] <= abeps)
-                                homo[d][tr][tc]++;
-                }
-            }
+            for (row=top+2; row < top+TS-2 && row < height; row++)
+                homogeneity (lab[0][0][row-top] + 2, homo[0][row-top] + 2,
+                             MIN(left+TS-2, width) - (left+2));
             /*  Combine the most homogenous pixels for the final result:        */
             for (row=top+3; row < top+TS-3 && row < height-3; row++) {
                 tr = row-top;
@@ -2510,14 +2643,34 @@ dc1394_bayer_AHD_uint16(const uint16_t *restrict bayer,
                 }
             }
         }
-    free (buffer);
 
     return DC1394_SUCCESS;
 }
 
+dc1394error_t
+dc1394_bayer_AHD_uint16(const uint16_t *restrict bayer,
+                        uint16_t *restrict dst, int sx, int sy,
+                        dc1394color_filter_t pattern, int bits)
+{
+    bayer_scratch_t *scratch = bayer_scratch_new();
+    dc1394error_t err;
+
+    if (scratch == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    err = bayer_AHD_uint16(scratch, bayer, dst, sx, sy, pattern, bits);
+    bayer_scratch_free(scratch);
+
+    return err;
+}
+
 dc1394error_t
 dc1394_bayer_decoding_8bit(const uint8_t *restrict bayer, uint8_t *restrict rgb, uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method)
 {
+    // use the vectorized decoder if this CPU has one for the method:
+    bayer_8bit_func_t simd = bayer_simd_get_8bit(method);
+    if (simd != NULL)
+        return simd(bayer, rgb, sx, sy, tile);
+
     switch (method) {
     case DC1394_BAYER_METHOD_NEAREST:
         return dc1394_bayer_NearestNeighbor(bayer, rgb, sx, sy, tile);
@@ -2544,6 +2697,11 @@ dc1394_bayer_decoding_8bit(const uint8_t *restrict bayer, uint8_t *restrict rgb,
 dc1394error_t
 dc1394_bayer_decoding_16bit(const uint16_t *restrict bayer, uint16_t *restrict rgb, uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits)
 {
+    // use the vectorized decoder if this CPU has one for the method:
+    bayer_16bit_func_t simd = bayer_simd_get_16bit(method);
+    if (simd != NULL)
+        return simd(bayer, rgb, sx, sy, tile, bits);
+
     switch (method) {
     case DC1394_BAYER_METHOD_NEAREST:
         return dc1394_bayer_NearestNeighbor_uint16(bayer, rgb, sx, sy, tile, bits);
@@ -2567,26 +2725,17 @@ dc1394_bayer_decoding_16bit(const uint16_t *restrict bayer, uint16_t *restrict r
 
 }
 
-dc1394error_t
-Adapt_buffer_bayer(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method)
+/* sets up out for the RGB result of de-mosaicing in, of the given size and position */
+static dc1394error_t
+Adapt_buffer_bayer_size(dc1394video_frame_t *in, dc1394video_frame_t *out, uint32_t width, uint32_t height,
+                        uint32_t left, uint32_t top)
 {
-    uint32_t bpp;
-
-    // conversions will halve the buffer size if the method is DOWNSAMPLE:
-    out->size[0]=in->size[0];
-    out->size[1]=in->size[1];
-    if (method == DC1394_BAYER_METHOD_DOWNSAMPLE) {
-        out->size[0]/=2; // ODD SIZE CASES NOT TAKEN INTO ACCOUNT
-        out->size[1]/=2;
-    }
+    uint32_t row;
 
-    // as a convention we divide the image position by two in the case of a DOWNSAMPLE:
-    out->position[0]=in->position[0];
-    out->position[1]=in->position[1];
-    if (method == DC1394_BAYER_METHOD_DOWNSAMPLE) {
-        out->position[0]/=2;
-        out->position[1]/=2;
-    }
+    out->size[0]=width;
+    out->size[1]=height;
+    out->position[0]=left;
+    out->position[1]=top;
 
     // the destination color coding is ALWAYS RGB. Set this.
     if ( (in->color_coding==DC1394_COLOR_CODING_RAW16) || 
@@ -2607,18 +2756,20 @@ Adapt_buffer_bayer(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394baye
     else
         out->data_depth=8;
 
-    // don't know what to do with stride... >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    // out->stride=??
-
     // the video mode should not change. Color coding and other stuff can be accessed in specific fields of this struct
     out->video_mode = in->video_mode;
 
     // padding is kept:
     out->padding_bytes = in->padding_bytes;
 
-    // image bytes changes:    >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    dc1394_get_color_coding_bit_size(out->color_coding, &bpp);
-    out->image_bytes=(out->size[0]*out->size[1]*bpp)/8;
+    // the stride of out is the caller's if its buffer holds the padded rows, else rows are packed
+    frame_output_stride(out);
+
+    // image bytes changes, with the stride of out. The stride of in must hold a row.
+    row = frame_row_bytes(out);
+    if ((row == 0) || (frame_row_bytes(in) == 0))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    out->image_bytes=out->size[1]*row;
 
     // total is image_bytes + padding_bytes
     out->total_bytes = out->image_bytes + out->padding_bytes;
@@ -2633,15 +2784,8 @@ Adapt_buffer_bayer(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394baye
     out->camera = in->camera;
     out->id = in->id;
 
-    // verify memory allocation:
-    if (out->total_bytes>out->allocated_image_bytes) {
-        free(out->image);
-        out->image=(uint8_t*)malloc(out->total_bytes*sizeof(uint8_t));
-        if (out->image)
-            out->allocated_image_bytes = out->total_bytes*sizeof(uint8_t);
-        else
-            out->allocated_image_bytes = 0;
-    }
+    // verify memory allocation. A buffer of the caller that is large enough is kept.
+    frame_image_reserve(out);
 
     // Copy padding bytes:
     if(out->image)
@@ -2657,65 +2801,1700 @@ Adapt_buffer_bayer(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394baye
 }
 
 dc1394error_t
-dc1394_debayer_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method)
+Adapt_buffer_bayer(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method)
 {
-    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
-        return DC1394_INVALID_BAYER_METHOD;
+    // conversions will halve the buffer size if the method is DOWNSAMPLE, and as a
+    // convention we divide the image position by two too:
+    if (method == DC1394_BAYER_METHOD_DOWNSAMPLE) // ODD SIZE CASES NOT TAKEN INTO ACCOUNT
+        return Adapt_buffer_bayer_size(in, out, in->size[0]/2, in->size[1]/2, in->position[0]/2, in->position[1]/2);
 
-    switch (in->color_coding) {
+    return Adapt_buffer_bayer_size(in, out, in->size[0], in->size[1], in->position[0], in->position[1]);
+}
+
+/* bytes per sample of a mosaic frame, 0 if its color coding can't hold one */
+static int
+bayer_frame_bpp(const dc1394video_frame_t *frame)
+{
+    switch (frame->color_coding) {
     case DC1394_COLOR_CODING_RAW8:
     case DC1394_COLOR_CODING_MONO8:
-        
-        if(DC1394_SUCCESS != Adapt_buffer_bayer(in,out,method))
-            return DC1394_MEMORY_ALLOCATION_FAILURE;
-            
-        switch (method) {
-        case DC1394_BAYER_METHOD_NEAREST:
-            return dc1394_bayer_NearestNeighbor(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_SIMPLE:
-            return dc1394_bayer_Simple(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_BILINEAR:
-            return dc1394_bayer_Bilinear(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_HQLINEAR:
-            return dc1394_bayer_HQLinear(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_DOWNSAMPLE:
-            return dc1394_bayer_Downsample(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_EDGESENSE:
-            return dc1394_bayer_EdgeSense(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_VNG:
-            return dc1394_bayer_VNG(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        case DC1394_BAYER_METHOD_AHD:
-            return dc1394_bayer_AHD(in->image, out->image, in->size[0], in->size[1], in->color_filter);
-        }
-        break;
+        return 1;
     case DC1394_COLOR_CODING_MONO16:
     case DC1394_COLOR_CODING_RAW16:
-    
-        if(DC1394_SUCCESS != Adapt_buffer_bayer(in,out,method))
-            return DC1394_MEMORY_ALLOCATION_FAILURE;
-            
-        switch (method) {
-        case DC1394_BAYER_METHOD_NEAREST:
-            return dc1394_bayer_NearestNeighbor_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_SIMPLE:
-            return dc1394_bayer_Simple_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_BILINEAR:
-            return dc1394_bayer_Bilinear_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_HQLINEAR:
-            return dc1394_bayer_HQLinear_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_DOWNSAMPLE:
-            return dc1394_bayer_Downsample_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_EDGESENSE:
-            return dc1394_bayer_EdgeSense_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_VNG:
-            return dc1394_bayer_VNG_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        case DC1394_BAYER_METHOD_AHD:
-            return dc1394_bayer_AHD_uint16((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, in->data_depth);
-        }
-        break;
+        return 2;
     default:
+        return 0;
+    }
+}
+
+dc1394error_t
+dc1394_debayer_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method)
+{
+    dc1394debayer_context_t *ctx;
+    dc1394error_t err;
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if (bayer_frame_bpp(in) == 0)
         return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    err = Adapt_buffer_bayer(in,out,method);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    // padded rows are decoded by the bands, here by a single one
+    if ((frame_row_bytes(in) != frame_packed_row(in)) || (frame_row_bytes(out) != frame_packed_row(out))) {
+        ctx = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+        err = dc1394_debayer_frames_parallel(ctx, in, out, method);
+        dc1394_debayer_context_free(ctx);
+        return err;
     }
 
+    if (bayer_frame_bpp(in) == 1)
+        return dc1394_bayer_decoding_8bit(in->image, out->image, in->size[0], in->size[1], in->color_filter, method);
+    else
+        return dc1394_bayer_decoding_16bit((uint16_t*)in->image, (uint16_t*)out->image, in->size[0], in->size[1], in->color_filter, method, in->data_depth);
+}
+
+
+/**************************************************************
+ *     Multithreaded de-mosaicing: the image is cut into      *
+ * horizontal bands, each decoded with the same functions as  *
+ * above on its rows plus a halo of input rows on both sides. *
+ * Only the rows of the band are then kept, so the result is  *
+ * identical to decoding the whole image at once.             *
+ *     When the output is converted to YUV422 or another      *
+ * coding, each band is decoded a few rows at a time in a     *
+ * buffer that stays in the cache, and these rows are         *
+ * converted at once: the RGB image is never written to       *
+ * memory. Padded input and output rows are                   *
+ * handled the same way, the input chunks being first packed  *
+ * next to the decoded rows.                                  *
+ **************************************************************/
+
+/* bands are never made thinner than this */
+#define BAYER_BAND_MIN_ROWS 64
+
+/* RGB bytes decoded at a time by a band when the rows are converted */
+#define BAYER_CHUNK_BYTES (1 << 19)
+
+/* the packing of an input of 8 or 16-bit samples */
+#define BAYER_NOT_PACKED (-1)
+
+/* one sensor of a stereo frame, whose mosaic is picked from the frame a chunk at a time */
+typedef struct {
+    const dc1394video_frame_t *in;
+    int sensors;
+    int sensor;
+    dc1394stereo_method_t method;
+} bayer_stereo_t;
+
+struct __dc1394debayer_context {
+    int threads;
+    uint8_t *buffer;           /* one output buffer per band */
+    size_t buffer_size;
+    bayer_scratch_t *scratch[THREAD_POOL_MAX_THREADS]; /* VNG and AHD memory of each band */
+    dc1394frame_stats_t *stats; /* if not NULL, filled by the calls made with the context */
+};
+
+typedef struct {
+    const uint8_t *bayer;
+    uint8_t *out;
+    dc1394color_coding_t coding; /* of out: RGB8 or RGB16 as decoded, YUV422, MONO8, MONO16, or one made from RGB8 rows */
+    int convert;               /* whether the rows are converted to another coding than the decoded one */
+    uint32_t byte_order;       /* of YUV422 */
+    const dc1394isp_t *isp;    /* if not NULL, applied to the rows before they are stored */
+    dc1394frame_stats_t *stats; /* if not NULL, counts the output rows in those of each band */
+    size_t in_stride, out_stride; /* bytes from one row to the next */
+    uint8_t *buffer;
+    size_t band_bytes;
+    size_t packed_offset;      /* of the packed input rows in the buffer of a band, if the input is padded or packed */
+    int packing;               /* of 10 or 12-bit input samples, unpacked with unpack, or BAYER_NOT_PACKED */
+    unpack_func_t unpack;
+    const bayer_stereo_t *stereo; /* if not NULL, where the 8-bit mosaic is picked from instead of bayer */
+    int direct;                /* whether the chunks inside a band are decoded straight to the output */
+    bayer_scratch_t **scratch;
+    int sx, sy, bpp;
+    int width, height;         /* of the output */
+    size_t out_row;            /* bytes of an output row without padding (of its first plane) */
+    int band_rows, chunk_rows, halo;
+    dc1394color_filter_t tile;
+    dc1394bayer_method_t method;
+    uint32_t bits;
+    dc1394error_t err[THREAD_POOL_MAX_THREADS];
+} bayer_bands_t;
+
+/*
+  Input rows a band needs beyond its own on each side for its rows to come
+  out exactly as in the full image. Always even, so that the bands start on
+  the same CFA phase as the image.
+ */
+static int
+bayer_band_halo(dc1394bayer_method_t method)
+{
+    switch (method) {
+    case DC1394_BAYER_METHOD_DOWNSAMPLE:
+        return 0;
+    case DC1394_BAYER_METHOD_NEAREST:   // next row
+    case DC1394_BAYER_METHOD_SIMPLE:    // next row
+    case DC1394_BAYER_METHOD_BILINEAR:  // 3x3 neighbourhood
+    case DC1394_BAYER_METHOD_HQLINEAR:  // 5x5 neighbourhood
+        return 2;
+    case DC1394_BAYER_METHOD_EDGESENSE: // green at +-2, then red and blue from it at +-1
+    case DC1394_BAYER_METHOD_VNG:       // 5x5 neighbourhood of the bilinear result
+        return 4;
+    case DC1394_BAYER_METHOD_AHD:       // green at +-2, Lab at +-1, homogeneity at +-1 and its sum at +-1
+    default:
+        return 6;
+    }
+}
+
+/* decodes with the memory of scratch where the method needs some */
+static dc1394error_t
+bayer_decode(bayer_scratch_t *scratch, const uint8_t *bayer, uint8_t *rgb, int sx, int sy, int bpp,
+             dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits)
+{
+    if ((method == DC1394_BAYER_METHOD_VNG) && (bpp == 1))
+        return bayer_VNG(scratch, bayer, rgb, sx, sy, tile);
+    if (method == DC1394_BAYER_METHOD_VNG)
+        return bayer_VNG_uint16(scratch, (const uint16_t*)bayer, (uint16_t*)rgb, sx, sy, tile, bits);
+    if ((method == DC1394_BAYER_METHOD_AHD) && (bpp == 1))
+        return bayer_AHD(scratch, bayer, rgb, sx, sy, tile);
+    if (method == DC1394_BAYER_METHOD_AHD)
+        return bayer_AHD_uint16(scratch, (const uint16_t*)bayer, (uint16_t*)rgb, sx, sy, tile, bits);
+
+    if (bpp == 1)
+        return dc1394_bayer_decoding_8bit(bayer, rgb, sx, sy, tile, method);
+    else
+        return dc1394_bayer_decoding_16bit((const uint16_t*)bayer, (uint16_t*)rgb, sx, sy, tile, method, bits);
+}
+
+/* 16-bit RGB rows, as decoded, to YUV422 with the formulas of dc1394_RGB16_to_YUV422() */
+static void
+bayer_rgb16_to_yuv422(const uint16_t *rgb, uint8_t *yuv, int pixels, uint32_t byte_order, uint32_t bits)
+{
+    int i, r, g, b, y0, y1, u0, u1, v0, v1;
+    const int shift = bits - 8;
+
+    for (i = 0; i < pixels; i += 2, rgb += 6, yuv += 4) {
+        r = rgb[0] >> shift;
+        g = rgb[1] >> shift;
+        b = rgb[2] >> shift;
+        RGB2YUV (r, g, b, y0, u0, v0);
+        r = rgb[3] >> shift;
+        g = rgb[4] >> shift;
+        b = rgb[5] >> shift;
+        RGB2YUV (r, g, b, y1, u1, v1);
+        if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+            yuv[0] = y0;
+            yuv[1] = (u0+u1) >> 1;
+            yuv[2] = y1;
+            yuv[3] = (v0+v1) >> 1;
+        } else {
+            yuv[0] = (u0+u1) >> 1;
+            yuv[1] = y0;
+            yuv[2] = (v0+v1) >> 1;
+            yuv[3] = y1;
+        }
+    }
+}
+
+/* 16-bit samples, as decoded, to their most significant 8 bits. dest may be src. */
+static void
+bayer_16bit_to_8bit(const uint16_t *src, uint8_t *dest, int samples, uint32_t bits)
+{
+    const int shift = bits - 8;
+    int i, v;
+
+    for (i = 0; i < samples; i++) {
+        v = src[i] >> shift;
+        dest[i] = v > 255 ? 255 : v;
+    }
+}
+
+/* the luminance of RGB rows to a MONO8 or MONO16 output. That of 16-bit rows is computed on all their bits. */
+static void
+bayer_rows_to_luma(bayer_bands_t *b, uint8_t *rows, uint8_t *out, int pixels)
+{
+    bayer_luma_8bit_func_t luma_8bit = bayer_simd_get_luma_8bit();
+    bayer_luma_16bit_func_t luma_16bit = bayer_simd_get_luma_16bit();
+
+    if (luma_8bit == NULL)
+        luma_8bit = bayer_luma_8bit;
+    if (luma_16bit == NULL)
+        luma_16bit = bayer_luma_16bit;
+
+    if (b->bpp == 1) {
+        luma_8bit(rows, out, pixels);
+    } else if (b->coding == DC1394_COLOR_CODING_MONO16) {
+        luma_16bit((const uint16_t*)rows, (uint16_t*)out, pixels);
+    } else {
+        luma_16bit((const uint16_t*)rows, (uint16_t*)rows, pixels);
+        bayer_16bit_to_8bit((const uint16_t*)rows, out, pixels, b->bits);
+    }
+}
+
+/*
+  The luminance of the n output rows of DOWNSAMPLE from row y, binned straight from
+  their 2n mosaic rows at bayer, which start on the phase of the tile. The start of
+  buffer holds the 16-bit luminances of a row that goes to MONO8.
+ */
+static void
+bayer_bin_rows(bayer_bands_t *b, const uint8_t *bayer, uint8_t *buffer, int y, int n)
+{
+    bayer_bin_luma_8bit_func_t bin_8bit = bayer_simd_get_bin_luma_8bit();
+    bayer_bin_luma_16bit_func_t bin_16bit = bayer_simd_get_bin_luma_16bit();
+    const size_t in_row = (size_t)b->sx * b->bpp;
+    const int first_green = BAYER_FIRST_GREEN(b->tile);
+    const int first_red = BAYER_FIRST_RED(b->tile);
+    const uint16_t *row0, *row1;
+    uint8_t *out;
+    int i;
+
+    if (bin_8bit == NULL)
+        bin_8bit = bayer_bin_luma_8bit;
+    if (bin_16bit == NULL)
+        bin_16bit = bayer_bin_luma_16bit;
+
+    for (i = 0; i < n; i++, bayer += 2 * in_row) {
+        out = b->out + (y + i) * b->out_stride;
+        row0 = (const uint16_t*)bayer;
+        row1 = (const uint16_t*)(bayer + in_row);
+        if (b->bpp == 1) {
+            bin_8bit(bayer, bayer + in_row, out, b->width, first_green, first_red);
+        } else if (b->coding == DC1394_COLOR_CODING_MONO16) {
+            bin_16bit(row0, row1, (uint16_t*)out, b->width, first_green, first_red);
+        } else {
+            bin_16bit(row0, row1, (uint16_t*)buffer, b->width, first_green, first_red);
+            bayer_16bit_to_8bit((const uint16_t*)buffer, out, b->width, b->bits);
+        }
+    }
+}
+
+/* stores n decoded rows that start at row y of the output, which are packed unless the coding has planes */
+static void
+bayer_store_rows(bayer_bands_t *b, uint8_t *rows, int y, int n)
+{
+    const int pixels = b->width * n;
+    uint8_t *out = b->out + y * b->out_stride;
+    uint8_t *dst = b->convert ? rows : out;
+
+    // the color processing goes straight to the output, or in place before the conversion
+    if ((b->isp != NULL) && (b->bpp == 1))
+        isp_apply_8bit(b->isp, rows, dst, pixels);
+    else if (b->isp != NULL)
+        isp_apply_16bit(b->isp, (const uint16_t*)rows, (uint16_t*)dst, pixels);
+    else if (!b->convert)
+        memcpy(out, rows, (size_t)pixels * 3 * b->bpp);
+
+    if (!b->convert)
+        return;
+    if ((b->coding == DC1394_COLOR_CODING_MONO8) || (b->coding == DC1394_COLOR_CODING_MONO16)) {
+        bayer_rows_to_luma(b, rows, out, pixels);
+        return;
+    }
+    if ((b->coding == DC1394_COLOR_CODING_YUV422) && (b->bpp == 1)) {
+        dc1394_RGB8_to_YUV422(rows, out, b->width, n, b->byte_order);
+        return;
+    }
+    if (b->coding == DC1394_COLOR_CODING_YUV422) {
+        bayer_rgb16_to_yuv422((const uint16_t*)rows, out, pixels, b->byte_order, b->bits);
+        return;
+    }
+    // the other codings are made from 8-bit rows, and place their planes themselves
+    if (b->bpp == 2)
+        bayer_16bit_to_8bit((const uint16_t*)rows, rows, 3 * pixels, b->bits);
+    rgb8_rows_to_image(rows, b->out, b->coding, b->width, b->height, b->out_stride, y, n, NULL);
+}
+
+/* stores n decoded rows that start at row y of the output */
+static void
+bayer_put_rows(bayer_bands_t *b, uint8_t *rows, int y, int n)
+{
+    const size_t row = (size_t)b->width * 3 * b->bpp;
+    int i;
+
+    if ((b->out_stride == b->out_row) || (b->coding >= DC1394_COLOR_CODING_CONVERTED_MIN)) {
+        bayer_store_rows(b, rows, y, n);
+        return;
+    }
+    // padded rows are stored one at a time
+    for (i = 0; i < n; i++)
+        bayer_store_rows(b, rows + i * row, y + i, 1);
+}
+
+/* the input rows top to bottom, packed in buffer if they are padded, or unpacked there */
+static const uint8_t*
+bayer_get_rows(bayer_bands_t *b, uint8_t *buffer, int top, int bottom)
+{
+    const size_t row = (size_t)b->sx * b->bpp;
+    int y;
+
+    if (b->stereo != NULL) {
+        stereo_sensor_rows(b->stereo->in, b->stereo->sensors, b->stereo->sensor, b->stereo->method, top,
+                           bottom - top, buffer, row);
+        return buffer;
+    }
+    if (b->packing != BAYER_NOT_PACKED) {
+        b->unpack(b->bayer + top * b->in_stride, (uint16_t*)buffer, b->sx * (bottom - top), b->packing);
+        return buffer;
+    }
+    if (b->in_stride == row)
+        return b->bayer + top * row;
+    for (y = top; y < bottom; y++)
+        memcpy(buffer + (y - top) * row, b->bayer + y * b->in_stride, row);
+    return buffer;
+}
+
+/*
+  Decodes the rows c0 to c1 of the band of rows y0 to y1 with the buffer and the scratch memory of the band.
+  c0 is even, and the input rows from c0 - halo to c1 + halo (within the image) must be available.
+ */
+static dc1394error_t
+bayer_decode_chunk_rows(bayer_bands_t *b, uint8_t *buffer, bayer_scratch_t *scratch, int y0, int y1, int c0, int c1)
+{
+    const size_t out_row = (size_t)b->sx * 3 * b->bpp;
+    const int down = (b->method == DC1394_BAYER_METHOD_DOWNSAMPLE);
+    const int top = MAX(c0 - b->halo, 0);
+    const int bottom = MIN(c1 + b->halo, b->sy);
+    const uint8_t *bayer;
+    uint8_t *out;
+    dc1394error_t err;
+
+    bayer = bayer_get_rows(b, buffer + b->packed_offset, top, bottom);
+
+    // the luminance of DOWNSAMPLE does without the decoded pixels
+    if (down && ((b->coding == DC1394_COLOR_CODING_MONO8) || (b->coding == DC1394_COLOR_CODING_MONO16))) {
+        if ((b->tile < DC1394_COLOR_FILTER_MIN) || (b->tile > DC1394_COLOR_FILTER_MAX))
+            return DC1394_INVALID_COLOR_FILTER;
+        bayer_bin_rows(b, bayer, buffer, c0 / 2, (c1 - c0) / 2);
+        return DC1394_SUCCESS;
+    }
+
+    // the halo rows above were stored by the previous chunk and are restored, those
+    // below are stored again by the next one. They must not belong to another band.
+    if (b->direct && (top >= y0) && (bottom <= y1)) {
+        out = b->out + (down ? c0 / 2 : top) * b->out_stride;
+        memcpy(buffer, out, (c0 - top) * b->out_stride);
+        err = bayer_decode(scratch, bayer, out, b->sx, bottom - top, b->bpp, b->tile, b->method, b->bits);
+        memcpy(out, buffer, (c0 - top) * b->out_stride);
+        return err;
+    }
+
+    err = bayer_decode(scratch, bayer, buffer, b->sx, bottom - top, b->bpp, b->tile, b->method, b->bits);
+    if (err != DC1394_SUCCESS)
+        return err;
+    // DOWNSAMPLE has no halo, and makes an output row of every two input rows
+    if (down)
+        bayer_put_rows(b, buffer, c0 / 2, (c1 - c0) / 2);
+    else
+        bayer_put_rows(b, buffer + (c0 - top) * out_row, c0, c1 - c0);
+
+    return DC1394_SUCCESS;
+}
+
+/* as bayer_decode_chunk_rows(), counting the output rows of the chunk in the statistics of band */
+static dc1394error_t
+bayer_decode_chunk(bayer_bands_t *b, uint8_t *buffer, bayer_scratch_t *scratch, int band, int y0, int y1, int c0,
+                   int c1)
+{
+    const int down = (b->method == DC1394_BAYER_METHOD_DOWNSAMPLE);
+    dc1394error_t err;
+
+    err = bayer_decode_chunk_rows(b, buffer, scratch, y0, y1, c0, c1);
+    if ((err == DC1394_SUCCESS) && (b->stats != NULL))
+        stats_rows(b->stats, band, b->out, b->width, b->height, b->out_stride, down ? c0 / 2 : c0,
+                   down ? (c1 - c0) / 2 : c1 - c0);
+    return err;
+}
+
+static void
+bayer_band_task(void *arg, int band)
+{
+    bayer_bands_t *b = (bayer_bands_t*)arg;
+    const size_t in_row = (size_t)b->sx * b->bpp;
+    const size_t out_row = 3 * in_row;
+    int y0 = band * b->band_rows;
+    int y1 = MIN(y0 + b->band_rows, b->sy);
+    int c0, c1;
+    uint8_t *buffer;
+
+    if ((b->method == DC1394_BAYER_METHOD_DOWNSAMPLE) && (b->buffer == NULL)) {
+        // the bands don't overlap and the rows are packed: decode in place
+        buffer = b->out + (y0 / 2) * (out_row / 2);
+        b->err[band] = bayer_decode(NULL, b->bayer + y0 * in_row, buffer, b->sx, y1 - y0, b->bpp,
+                                    b->tile, b->method, b->bits);
+        if ((b->err[band] == DC1394_SUCCESS) && (b->isp != NULL) && (b->bpp == 1))
+            isp_apply_8bit(b->isp, buffer, buffer, (b->sx / 2) * ((y1 - y0) / 2));
+        else if ((b->err[band] == DC1394_SUCCESS) && (b->isp != NULL))
+            isp_apply_16bit(b->isp, (uint16_t*)buffer, (uint16_t*)buffer, (b->sx / 2) * ((y1 - y0) / 2));
+        if ((b->err[band] == DC1394_SUCCESS) && (b->stats != NULL))
+            stats_rows(b->stats, band, b->out, b->width, b->height, b->out_stride, y0 / 2, (y1 - y0) / 2);
+        return;
+    }
+
+    buffer = b->buffer + band * b->band_bytes;
+    b->err[band] = DC1394_SUCCESS;
+
+    for (c0 = y0; (c0 < y1) && (b->err[band] == DC1394_SUCCESS); c0 = c1) {
+        c1 = MIN(c0 + b->chunk_rows, y1);
+        b->err[band] = bayer_decode_chunk(b, buffer, b->scratch[band], band, y0, y1, c0, c1);
+    }
+}
+
+/* grows the buffer of the context to at least size bytes, and returns it or NULL */
+static uint8_t*
+bayer_context_buffer(dc1394debayer_context_t *ctx, size_t size)
+{
+    if (size > ctx->buffer_size) {
+        free(ctx->buffer);
+        ctx->buffer = (uint8_t*)malloc(size);
+        ctx->buffer_size = ctx->buffer ? size : 0;
+    }
+    return ctx->buffer;
+}
+
+/*
+  Decodes to out with the given coding, with the color processing of isp if it is not NULL. The coding is
+  RGB8 or RGB16 (for bpp 2) for the decoded pixels, YUV422 with the given byte order, MONO8 or MONO16 (for
+  bpp 2) for their luminance, or one of the codings made from RGB8 rows (not with DOWNSAMPLE). The strides
+  are the bytes from one row to the next of the mosaic and of the output, 0 for packed rows. If packing is
+  not BAYER_NOT_PACKED, the mosaic has samples of 10 or 12 bits packed that way, which are unpacked to 16
+  bits (bpp 2) a chunk at a time; its rows can't be padded. If stereo is not NULL, the 8-bit mosaic is that
+  of a sensor of a stereo frame, picked from it a chunk at a time, and bayer and in_stride are not used.
+  The statistics of the context count the output, but for stereo frames.
+ */
+static dc1394error_t
+bayer_decoding_parallel(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *out,
+                        dc1394color_coding_t coding, uint32_t byte_order, const dc1394isp_t *isp, int sx, int sy,
+                        int bpp, size_t in_stride, size_t out_stride, dc1394color_filter_t tile,
+                        dc1394bayer_method_t method, uint32_t bits, int packing, const bayer_stereo_t *stereo)
+{
+    bayer_bands_t b;
+    dc1394frame_stats_t *stats;
+    dc1394error_t err;
+    int bands, i, packed;
+    size_t in_row, out_row;
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if (ctx == NULL)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    b.width = (method == DC1394_BAYER_METHOD_DOWNSAMPLE) ? sx / 2 : sx;
+    b.height = (method == DC1394_BAYER_METHOD_DOWNSAMPLE) ? sy / 2 : sy;
+    b.coding = coding;
+    b.convert = (coding != DC1394_COLOR_CODING_RGB8) && (coding != DC1394_COLOR_CODING_RGB16);
+    in_row = (packing == BAYER_NOT_PACKED) ? (size_t)sx * bpp : packed_row_bytes(sx, packing);
+    switch (coding) {
+    case DC1394_COLOR_CODING_YUV422:
+        out_row = (size_t)b.width * 2;
+        break;
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+        out_row = (size_t)b.width * 4;
+        break;
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
+    case DC1394_COLOR_CODING_MONO8:
+        out_row = b.width;
+        break;
+    case DC1394_COLOR_CODING_MONO16:
+        out_row = (size_t)b.width * 2;
+        break;
+    default:
+        out_row = (size_t)b.width * 3 * bpp;
+        break;
+    }
+    b.out_row = out_row;
+    b.in_stride = in_stride ? in_stride : in_row;
+    b.out_stride = out_stride ? out_stride : out_row;
+    if ((in_row == 0) || (b.in_stride < in_row) || (b.out_stride < out_row))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    // whether the rows can be decoded where they are
+    packed = (b.in_stride == (size_t)sx * bpp) && (b.out_stride == out_row) && (packing == BAYER_NOT_PACKED) &&
+             (stereo == NULL);
+    stats = (stereo == NULL) ? ctx->stats : NULL;
+
+    bands = MIN(ctx->threads, sy / BAYER_BAND_MIN_ROWS);
+    // these two only handle even sizes properly: keep odd ones in a single piece
+    if (((method == DC1394_BAYER_METHOD_DOWNSAMPLE) || (method == DC1394_BAYER_METHOD_EDGESENSE)) &&
+        ((sx & 1) || (sy & 1)))
+        bands = 1;
+    if (bands < 1)
+        bands = 1;
+
+    // the bands that need scratch memory get it once and keep it
+    if ((method == DC1394_BAYER_METHOD_VNG) || (method == DC1394_BAYER_METHOD_AHD)) {
+        for (i = 0; i < bands; i++) {
+            if (ctx->scratch[i] == NULL)
+                ctx->scratch[i] = bayer_scratch_new();
+            if (ctx->scratch[i] == NULL)
+                return DC1394_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+    if ((bands == 1) && !b.convert && (isp == NULL) && packed && (stats == NULL))
+        return bayer_decode(ctx->scratch[0], bayer, out, sx, sy, bpp, tile, method, bits);
+
+    b.bayer = bayer;
+    b.out = out;
+    b.byte_order = byte_order;
+    b.isp = isp;
+    b.stats = stats;
+    b.sx = sx;
+    b.sy = sy;
+    b.bpp = bpp;
+    b.tile = tile;
+    b.method = method;
+    b.bits = bits;
+    b.packing = packing;
+    b.unpack = NULL;
+    if (packing != BAYER_NOT_PACKED)
+        b.unpack = conversion_simd_get_unpack();
+    if ((packing != BAYER_NOT_PACKED) && (b.unpack == NULL))
+        b.unpack = unpack_row;
+    b.stereo = stereo;
+    b.halo = bayer_band_halo(method);
+    b.band_rows = (sy + bands - 1) / bands;
+    b.band_rows += b.band_rows & 1;
+    bands = (sy + b.band_rows - 1) / b.band_rows;
+
+    // processed or counted rows are decoded by chunks that fit in the cache, of at
+    // least four times the halo so that decoding the halos does not cost too much.
+    // Only the input of the chunks needs to when they are decoded in place.
+    b.direct = !b.convert && (isp == NULL) && (b.out_stride == out_row);
+    b.chunk_rows = b.band_rows;
+    if (b.convert || (isp != NULL) || !packed || (stats != NULL)) {
+        b.chunk_rows = MAX(BAYER_CHUNK_BYTES / (sx * (b.direct ? 1 : 3) * bpp), MAX(4 * b.halo, 2));
+        b.chunk_rows += b.chunk_rows & 1;
+        if ((bands == 1) && (method == DC1394_BAYER_METHOD_EDGESENSE) && (sy & 1))
+            b.chunk_rows = sy;
+        b.chunk_rows = MIN(b.chunk_rows, b.band_rows);
+    }
+    b.packed_offset = (size_t)(b.chunk_rows + 2 * b.halo) * sx * 3 * bpp;
+    b.band_bytes = b.packed_offset;
+    if ((b.in_stride != (size_t)sx * bpp) || (packing != BAYER_NOT_PACKED) || (stereo != NULL))
+        b.band_bytes += (size_t)(b.chunk_rows + 2 * b.halo) * sx * bpp;
+
+    // DOWNSAMPLE decodes packed rows in place, without the buffer
+    b.buffer = NULL;
+    if ((method != DC1394_BAYER_METHOD_DOWNSAMPLE) || !packed || b.convert) {
+        b.buffer = bayer_context_buffer(ctx, b.band_bytes * bands);
+        if (b.buffer == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    b.scratch = ctx->scratch;
+    if (stats != NULL) {
+        err = stats_prepare(stats, coding, byte_order, bits, bands);
+        if (err != DC1394_SUCCESS)
+            return err;
+    }
+
+    thread_pool_run(ctx->threads, bands, bayer_band_task, &b);
+
+    for (i = 0; i < bands; i++)
+        if (b.err[i] != DC1394_SUCCESS)
+            return b.err[i];
+
+    if (stats != NULL)
+        stats_merge(stats);
+    return DC1394_SUCCESS;
+}
+
+dc1394debayer_context_t*
+dc1394_debayer_context_new(uint32_t threads)
+{
+    dc1394debayer_context_t *ctx;
+
+    ctx = (dc1394debayer_context_t*)calloc(1, sizeof(dc1394debayer_context_t));
+    if (ctx == NULL)
+        return NULL;
+
+    if (threads == 0)
+        threads = thread_pool_cpu_count();
+    ctx->threads = MIN(threads, THREAD_POOL_MAX_THREADS);
+
+    return ctx;
+}
+
+/* the number of threads of a context, for the conversions */
+int
+debayer_context_threads(const dc1394debayer_context_t *ctx)
+{
+    return ctx->threads;
+}
+
+/* the statistics of a context, for the conversions */
+dc1394frame_stats_t*
+debayer_context_stats(const dc1394debayer_context_t *ctx)
+{
+    return ctx->stats;
+}
+
+dc1394error_t
+dc1394_debayer_context_set_stats(dc1394debayer_context_t *ctx, dc1394frame_stats_t *stats)
+{
+    if (ctx == NULL)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    ctx->stats = stats;
+    return DC1394_SUCCESS;
+}
+
+void
+dc1394_debayer_context_free(dc1394debayer_context_t *ctx)
+{
+    int i;
+
+    if (ctx == NULL)
+        return;
+    for (i = 0; i < THREAD_POOL_MAX_THREADS; i++)
+        bayer_scratch_free(ctx->scratch[i]);
+    free(ctx->buffer);
+    free(ctx);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_parallel(dc1394debayer_context_t *ctx, const uint8_t *restrict bayer, uint8_t *restrict rgb,
+                                    uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method)
+{
+    return bayer_decoding_parallel(ctx, bayer, rgb, DC1394_COLOR_CODING_RGB8, 0, NULL, sx, sy, 1, 0, 0, tile, method, 8,
+                                   BAYER_NOT_PACKED, NULL);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_parallel(dc1394debayer_context_t *ctx, const uint16_t *restrict bayer, uint16_t *restrict rgb,
+                                     uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                                     uint32_t bits)
+{
+    return bayer_decoding_parallel(ctx, (const uint8_t*)bayer, (uint8_t*)rgb, DC1394_COLOR_CODING_RGB16, 0, NULL, sx, sy,
+                                   2, 0, 0, tile, method, bits, BAYER_NOT_PACKED, NULL);
+}
+
+dc1394error_t
+dc1394_debayer_frames_parallel(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                               dc1394bayer_method_t method)
+{
+    const int bpp = bayer_frame_bpp(in);
+    dc1394error_t err;
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if (bpp == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    err = Adapt_buffer_bayer(in,out,method);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    return bayer_decoding_parallel(ctx, in->image, out->image, out->color_coding, 0, NULL, in->size[0], in->size[1], bpp,
+                                   frame_row_bytes(in), frame_row_bytes(out), in->color_filter, method,
+                                   bpp == 1 ? 8 : in->data_depth, BAYER_NOT_PACKED, NULL);
+}
+
+/* checks the arguments of the YUV422 output, then decodes with ctx, or with a temporary context if it is NULL */
+static dc1394error_t
+bayer_to_yuv422(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *yuv, uint32_t sx, uint32_t sy,
+                int bpp, size_t in_stride, size_t out_stride, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                uint32_t bits, uint32_t byte_order, const bayer_stereo_t *stereo)
+{
+    dc1394debayer_context_t *tmp = NULL;
+    dc1394error_t err;
+
+    if ((byte_order != DC1394_BYTE_ORDER_YUYV) && (byte_order != DC1394_BYTE_ORDER_UYVY))
+        return DC1394_INVALID_BYTE_ORDER;
+    // YUV422 shares the chroma of pixel pairs, and the image must keep its size
+    if ((sx & 1) || (method == DC1394_BAYER_METHOD_DOWNSAMPLE))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    err = bayer_decoding_parallel(ctx, bayer, yuv, DC1394_COLOR_CODING_YUV422, byte_order, NULL, sx, sy, bpp, in_stride,
+                                  out_stride, tile, method, bits, BAYER_NOT_PACKED, stereo);
+    dc1394_debayer_context_free(tmp);
+
+    return err;
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_to_YUV422(const uint8_t *restrict bayer, uint8_t *restrict yuv, uint32_t sx, uint32_t sy,
+                                     dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t byte_order)
+{
+    return bayer_to_yuv422(NULL, bayer, yuv, sx, sy, 1, 0, 0, tile, method, 8, byte_order, NULL);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_to_YUV422(const uint16_t *restrict bayer, uint8_t *restrict yuv, uint32_t sx, uint32_t sy,
+                                      dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits,
+                                      uint32_t byte_order)
+{
+    return bayer_to_yuv422(NULL, (const uint8_t*)bayer, yuv, sx, sy, 2, 0, 0, tile, method, bits, byte_order, NULL);
+}
+
+static dc1394error_t
+debayer_frames_to_yuv422(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                         dc1394bayer_method_t method)
+{
+    const int bpp = bayer_frame_bpp(in);
+    dc1394error_t err;
+
+    if (bpp == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    // the output has the size of the input, and its YUV byte order was set by the caller
+    out->color_coding = DC1394_COLOR_CODING_YUV422;
+    err = Adapt_buffer_convert(in,out);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    return bayer_to_yuv422(ctx, in->image, out->image, in->size[0], in->size[1], bpp, frame_row_bytes(in),
+                           frame_row_bytes(out), in->color_filter, method, bpp == 1 ? 8 : in->data_depth,
+                           out->yuv_byte_order, NULL);
+}
+
+dc1394error_t
+dc1394_debayer_frames_to_YUV422(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method)
+{
+    return debayer_frames_to_yuv422(NULL, in, out, method);
+}
+
+dc1394error_t
+dc1394_debayer_frames_to_YUV422_parallel(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                         dc1394video_frame_t *out, dc1394bayer_method_t method)
+{
+    if (ctx == NULL)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    return debayer_frames_to_yuv422(ctx, in, out, method);
+}
+
+/*
+  checks the arguments of an output made from RGB8 rows or of a MONO one, then decodes with ctx, or with a
+  temporary context if it is NULL
+ */
+static dc1394error_t
+bayer_to_coding(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *dest, uint32_t sx, uint32_t sy,
+                int bpp, size_t in_stride, size_t out_stride, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                uint32_t bits, dc1394color_coding_t coding, const bayer_stereo_t *stereo)
+{
+    const int mono = (coding == DC1394_COLOR_CODING_MONO8) || (coding == DC1394_COLOR_CODING_MONO16);
+    dc1394debayer_context_t *tmp = NULL;
+    dc1394error_t err;
+
+    if (!mono && ((coding < DC1394_COLOR_CODING_CONVERTED_MIN) || (coding > DC1394_COLOR_CODING_CONVERTED_MAX)))
+        return DC1394_INVALID_COLOR_CODING;
+    // MONO16 keeps the bits of 16-bit pixels
+    if ((coding == DC1394_COLOR_CODING_MONO16) && (bpp != 2))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    // the image must keep its size but for the luminance, which DOWNSAMPLE bins,
+    // and NV12 and I420 share the chroma of 2x2 blocks
+    if ((method == DC1394_BAYER_METHOD_DOWNSAMPLE) && !mono)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    if (((coding == DC1394_COLOR_CODING_NV12) || (coding == DC1394_COLOR_CODING_I420)) && ((sx & 1) || (sy & 1)))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    err = bayer_decoding_parallel(ctx, bayer, dest, coding, 0, NULL, sx, sy, bpp, in_stride, out_stride, tile, method,
+                                  bits, BAYER_NOT_PACKED, stereo);
+    dc1394_debayer_context_free(tmp);
+
+    return err;
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_to_coding(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *dest,
+                                     uint32_t sx, uint32_t sy, dc1394color_filter_t tile,
+                                     dc1394bayer_method_t method, dc1394color_coding_t coding)
+{
+    return bayer_to_coding(ctx, bayer, dest, sx, sy, 1, 0, 0, tile, method, 8, coding, NULL);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_to_coding(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint8_t *dest,
+                                      uint32_t sx, uint32_t sy, dc1394color_filter_t tile,
+                                      dc1394bayer_method_t method, uint32_t bits, dc1394color_coding_t coding)
+{
+    return bayer_to_coding(ctx, (const uint8_t*)bayer, dest, sx, sy, 2, 0, 0, tile, method, bits, coding, NULL);
+}
+
+dc1394error_t
+dc1394_debayer_frames_to_coding(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                                dc1394bayer_method_t method)
+{
+    const int bpp = bayer_frame_bpp(in);
+    const int mono = (out->color_coding == DC1394_COLOR_CODING_MONO8) ||
+                     (out->color_coding == DC1394_COLOR_CODING_MONO16);
+    dc1394video_frame_t size = *in;
+    dc1394error_t err;
+
+    if (bpp == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    if (!mono && ((out->color_coding < DC1394_COLOR_CODING_CONVERTED_MIN) ||
+                  (out->color_coding > DC1394_COLOR_CODING_CONVERTED_MAX)))
+        return DC1394_INVALID_COLOR_CODING;
+
+    // the output has the size of the input, halved as in Adapt_buffer_bayer() by DOWNSAMPLE,
+    // and its coding was set by the caller. MONO16 keeps the bit depth of the input.
+    if (method == DC1394_BAYER_METHOD_DOWNSAMPLE) {
+        size.size[0] = in->size[0] / 2;
+        size.size[1] = in->size[1] / 2;
+        size.position[0] = in->position[0] / 2;
+        size.position[1] = in->position[1] / 2;
+    }
+    err = Adapt_buffer_convert(&size,out);
+    if (err != DC1394_SUCCESS)
+        return err;
+    if (out->color_coding == DC1394_COLOR_CODING_MONO16)
+        out->data_depth = in->data_depth;
+
+    return bayer_to_coding(ctx, in->image, out->image, in->size[0], in->size[1], bpp, frame_row_bytes(in),
+                           frame_row_bytes(out), in->color_filter, method, bpp == 1 ? 8 : in->data_depth,
+                           out->color_coding, NULL);
+}
+
+dc1394error_t
+dc1394_deinterlace_stereo_frames_debayer(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                         dc1394video_frame_t *out, uint32_t sensors, dc1394stereo_method_t method,
+                                         dc1394bayer_method_t bayer_method)
+{
+    dc1394video_frame_t size;
+    dc1394debayer_context_t *tmp = NULL;
+    bayer_stereo_t stereo;
+    dc1394color_coding_t coding;
+    dc1394error_t err = DC1394_SUCCESS;
+    uint32_t s;
+
+    if (stereo_frame_sensors(in) == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    if (sensors != (uint32_t)stereo_frame_sensors(in))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    if ((method < DC1394_STEREO_METHOD_MIN) || (method > DC1394_STEREO_METHOD_MAX))
+        return DC1394_INVALID_STEREO_METHOD;
+    if ((bayer_method < DC1394_BAYER_METHOD_MIN) || (bayer_method > DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if ((in->color_filter < DC1394_COLOR_FILTER_MIN) || (in->color_filter > DC1394_COLOR_FILTER_MAX))
+        return DC1394_INVALID_COLOR_FILTER;
+    if (frame_row_bytes(in) == 0)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    for (s = 0; s < sensors; s++) {
+        coding = out[s].color_coding;
+        if ((coding != DC1394_COLOR_CODING_RGB8) && (coding != DC1394_COLOR_CODING_YUV422) &&
+            (coding != DC1394_COLOR_CODING_MONO8) &&
+            ((coding < DC1394_COLOR_CODING_CONVERTED_MIN) || (coding > DC1394_COLOR_CODING_CONVERTED_MAX)))
+            return DC1394_INVALID_COLOR_CODING;
+    }
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // the output of each sensor has its size, halved as in Adapt_buffer_bayer() by DOWNSAMPLE
+    stereo_sensor_frame(in, &size);
+    if (bayer_method == DC1394_BAYER_METHOD_DOWNSAMPLE) {
+        size.size[0] = in->size[0] / 2;
+        size.size[1] = in->size[1] / 2;
+        size.position[0] = in->position[0] / 2;
+        size.position[1] = in->position[1] / 2;
+    }
+    stereo.in = in;
+    stereo.sensors = sensors;
+    stereo.method = method;
+
+    // each sensor is decoded by all the threads of ctx, straight from the stereo frame
+    for (s = 0; (s < sensors) && (err == DC1394_SUCCESS); s++) {
+        err = Adapt_buffer_convert(&size, &out[s]);
+        if (err != DC1394_SUCCESS)
+            break;
+        stereo.sensor = s;
+        switch (out[s].color_coding) {
+        case DC1394_COLOR_CODING_RGB8:
+            err = bayer_decoding_parallel(ctx, NULL, out[s].image, DC1394_COLOR_CODING_RGB8, 0, NULL, in->size[0],
+                                          in->size[1], 1, 0, frame_row_bytes(&out[s]), in->color_filter,
+                                          bayer_method, 8, BAYER_NOT_PACKED, &stereo);
+            break;
+        case DC1394_COLOR_CODING_YUV422:
+            err = bayer_to_yuv422(ctx, NULL, out[s].image, in->size[0], in->size[1], 1, 0, frame_row_bytes(&out[s]),
+                                  in->color_filter, bayer_method, 8, out[s].yuv_byte_order, &stereo);
+            break;
+        default:
+            err = bayer_to_coding(ctx, NULL, out[s].image, in->size[0], in->size[1], 1, 0, frame_row_bytes(&out[s]),
+                                  in->color_filter, bayer_method, 8, out[s].color_coding, &stereo);
+            break;
+        }
+    }
+    dc1394_debayer_context_free(tmp);
+
+    return err;
+}
+
+/* decodes with the color processing of isp, with ctx or with a temporary context if it is NULL */
+static dc1394error_t
+bayer_decoding_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, const uint8_t *bayer, uint8_t *rgb,
+                   uint32_t sx, uint32_t sy, int bpp, size_t in_stride, size_t out_stride, dc1394color_filter_t tile,
+                   dc1394bayer_method_t method, uint32_t bits)
+{
+    dc1394debayer_context_t *tmp = NULL;
+    dc1394error_t err;
+
+    if (isp == NULL)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    // the tables are built here, once for all the bands
+    err = isp_prepare(isp, bits);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    err = bayer_decoding_parallel(ctx, bayer, rgb, bpp == 1 ? DC1394_COLOR_CODING_RGB8 : DC1394_COLOR_CODING_RGB16, 0,
+                                  isp, sx, sy, bpp, in_stride, out_stride, tile, method, bits, BAYER_NOT_PACKED,
+                                  NULL);
+    dc1394_debayer_context_free(tmp);
+
+    return err;
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, const uint8_t *restrict bayer,
+                               uint8_t *restrict rgb, uint32_t sx, uint32_t sy, dc1394color_filter_t tile,
+                               dc1394bayer_method_t method)
+{
+    return bayer_decoding_isp(ctx, isp, bayer, rgb, sx, sy, 1, 0, 0, tile, method, 8);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, const uint16_t *restrict bayer,
+                                uint16_t *restrict rgb, uint32_t sx, uint32_t sy, dc1394color_filter_t tile,
+                                dc1394bayer_method_t method, uint32_t bits)
+{
+    return bayer_decoding_isp(ctx, isp, (const uint8_t*)bayer, (uint8_t*)rgb, sx, sy, 2, 0, 0, tile, method, bits);
+}
+
+dc1394error_t
+dc1394_debayer_frames_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, dc1394video_frame_t *in,
+                          dc1394video_frame_t *out, dc1394bayer_method_t method)
+{
+    const int bpp = bayer_frame_bpp(in);
+    dc1394error_t err;
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if (bpp == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    err = Adapt_buffer_bayer(in,out,method);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    return bayer_decoding_isp(ctx, isp, in->image, out->image, in->size[0], in->size[1], bpp, frame_row_bytes(in),
+                              frame_row_bytes(out), in->color_filter, method, bpp == 1 ? 8 : in->data_depth);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_packed(dc1394debayer_context_t *ctx, const uint8_t *restrict bayer, uint16_t *restrict rgb,
+                             uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                             dc1394packing_t packing)
+{
+    dc1394debayer_context_t *tmp = NULL;
+    dc1394error_t err;
+    uint32_t bits;
+
+    if (packed_row_bytes(sx, packing) == 0)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    bits = ((packing == DC1394_PACKING_12BIT) || (packing == DC1394_PACKING_12BIT_MIPI)) ? 12 : 10;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    err = bayer_decoding_parallel(ctx, bayer, (uint8_t*)rgb, DC1394_COLOR_CODING_RGB16, 0, NULL, sx, sy, 2, 0, 0, tile,
+                                  method, bits, packing, NULL);
+    dc1394_debayer_context_free(tmp);
+
+    return err;
+}
+
+/*
+  Scaled decoding: each output pixel is the average of the 2x2 quads of the
+  mosaic under it, each weighted by the part of its area that the output
+  pixel covers. The weights have BAYER_SCALE_BITS fractional bits and add up
+  to exactly one along each output row and column, so flat areas keep their
+  value. The mosaic rows are first summed with their vertical weights into
+  32-bit sums (one row of sums for each of the two rows of the quads), then
+  these are summed with the horizontal weights, once per output row.
+ */
+#define BAYER_SCALE_BITS 12
+
+/*
+  Weights of the source pixels covered by output pixel o when 'in' pixels
+  become 'out'. Sets start to the first source pixel and returns the number
+  of weights, at most in / out + 2.
+ */
+static int
+bayer_scale_weights(int in, int out, int o, int *start, uint32_t *w)
+{
+    // in units of 1/out of a source pixel, which are 1/in of an output pixel
+    const int64_t begin = (int64_t)o * in, end = begin + in;
+    uint32_t sum, previous = 0;
+    int64_t covered;
+    int i, n = 0;
+
+    *start = (int)(begin / out);
+    for (i = *start; (int64_t)i * out < end; i++) {
+        // the weights come from the rounded running sum, so they add up to one exactly
+        covered = MIN((int64_t)(i + 1) * out, end) - begin;
+        sum = (uint32_t)((covered * (1 << BAYER_SCALE_BITS) + in / 2) / in);
+        w[n++] = sum - previous;
+        previous = sum;
+    }
+    return n;
+}
+
+void
+bayer_accumulate_8bit(uint32_t *restrict acc, const uint8_t *restrict src, int n, uint32_t weight)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        acc[i] += weight * src[i];
+}
+
+void
+bayer_accumulate_16bit(uint32_t *restrict acc, const uint16_t *restrict src, int n, uint32_t weight)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+        acc[i] += weight * src[i];
+}
+
+void
+bayer_luma_8bit(const uint8_t *restrict rgb, uint8_t *restrict dest, int pixels)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++, rgb += 3)
+        dest[i] = (306 * rgb[0] + 601 * rgb[1] + 117 * rgb[2]) >> 10;
+}
+
+void
+bayer_luma_16bit(const uint16_t *rgb, uint16_t *dest, int pixels)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++, rgb += 3)
+        dest[i] = (306 * rgb[0] + 601 * rgb[1] + 117 * rgb[2]) >> 10;
+}
+
+/* the luma of DOWNSAMPLE: red and blue are taken as they are, and the two greens averaged */
+#define BAYER_BIN_LUMA(row0, row1, i, first_green, first_red)                           \
+    ({                                                                                  \
+        const int wx_ = (first_red) ? 306 : 117, wy_ = (first_red) ? 117 : 306;         \
+        (first_green) ?                                                                 \
+            (wx_ * row0[2*(i)+1] + 601 * ((row0[2*(i)] + row1[2*(i)+1]) >> 1) + wy_ * row1[2*(i)]) >> 10 : \
+            (wx_ * row0[2*(i)] + 601 * ((row0[2*(i)+1] + row1[2*(i)]) >> 1) + wy_ * row1[2*(i)+1]) >> 10; \
+    })
+
+void
+bayer_bin_luma_8bit(const uint8_t *restrict row0, const uint8_t *restrict row1, uint8_t *restrict dest, int pixels,
+                    int first_green, int first_red)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++)
+        dest[i] = BAYER_BIN_LUMA(row0, row1, i, first_green, first_red);
+}
+
+void
+bayer_bin_luma_16bit(const uint16_t *restrict row0, const uint16_t *restrict row1, uint16_t *restrict dest,
+                     int pixels, int first_green, int first_red)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++)
+        dest[i] = BAYER_BIN_LUMA(row0, row1, i, first_green, first_red);
+}
+
+typedef struct {
+    const uint8_t *bayer;
+    uint8_t *rgb;
+    size_t in_stride, out_stride;
+    int sx, sy, bpp;
+    int width, height;         /* of the output */
+    int band_rows;
+    int red, green0, green1, blue; /* offsets of the components of a quad in the sums */
+    uint32_t *sums;            /* 2 * sx sums for each band */
+    uint32_t *vweights;        /* sy / 2 / height + 2 weights for each band */
+    int vtaps;
+    int *hstart, *hcount, *hoffset; /* horizontal weights of each output column */
+    uint32_t *hweights;
+    bayer_accumulate_8bit_func_t accumulate_8bit;
+    bayer_accumulate_16bit_func_t accumulate_16bit;
+} bayer_scale_t;
+
+static void
+bayer_scale_task(void *arg, int band)
+{
+    bayer_scale_t *s = (bayer_scale_t*)arg;
+    uint32_t *sums = s->sums + (size_t)band * 2 * s->sx;
+    uint32_t *vw = s->vweights + (size_t)band * s->vtaps;
+    const uint32_t *hw, *q;
+    const int y1 = MIN((band + 1) * s->band_rows, s->height);
+    const uint64_t round = (uint64_t)1 << (2 * BAYER_SCALE_BITS - 1);
+    uint64_t r, g, b;
+    uint8_t *out8;
+    uint16_t *out16;
+    const uint8_t *row;
+    int y, n, k, top, x, i;
+
+    for (y = band * s->band_rows; y < y1; y++) {
+        memset(sums, 0, 2 * s->sx * sizeof(uint32_t));
+        n = bayer_scale_weights(s->sy / 2, s->height, y, &top, vw);
+        for (k = 0; k < n; k++) {
+            if (vw[k] == 0)
+                continue;
+            row = s->bayer + 2 * (top + k) * s->in_stride;
+            if (s->bpp == 1) {
+                s->accumulate_8bit(sums, row, s->sx, vw[k]);
+                s->accumulate_8bit(sums + s->sx, row + s->in_stride, s->sx, vw[k]);
+            } else {
+                s->accumulate_16bit(sums, (const uint16_t*)row, s->sx, vw[k]);
+                s->accumulate_16bit(sums + s->sx, (const uint16_t*)(row + s->in_stride), s->sx, vw[k]);
+            }
+        }
+
+        out8 = s->rgb + y * s->out_stride;
+        out16 = (uint16_t*)out8;
+        for (x = 0; x < s->width; x++) {
+            hw = s->hweights + s->hoffset[x];
+            q = sums + 2 * s->hstart[x];
+            r = g = b = 0;
+            for (i = 0; i < s->hcount[x]; i++, q += 2) {
+                r += (uint64_t)hw[i] * q[s->red];
+                g += (uint64_t)hw[i] * (q[s->green0] + q[s->green1]);
+                b += (uint64_t)hw[i] * q[s->blue];
+            }
+            // the green sums have two samples per quad
+            r = (r + round) >> (2 * BAYER_SCALE_BITS);
+            g = (g + 2 * round) >> (2 * BAYER_SCALE_BITS + 1);
+            b = (b + round) >> (2 * BAYER_SCALE_BITS);
+            if (s->bpp == 1) {
+                out8[3 * x] = (uint8_t) r;
+                out8[3 * x + 1] = (uint8_t) g;
+                out8[3 * x + 2] = (uint8_t) b;
+            } else {
+                out16[3 * x] = (uint16_t) r;
+                out16[3 * x + 1] = (uint16_t) g;
+                out16[3 * x + 2] = (uint16_t) b;
+            }
+        }
+    }
+}
+
+static dc1394error_t
+bayer_decoding_scaled(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *rgb, uint32_t sx, uint32_t sy,
+                      int bpp, size_t in_stride, size_t out_stride, dc1394color_filter_t tile, uint32_t width,
+                      uint32_t height)
+{
+    dc1394debayer_context_t *tmp = NULL;
+    bayer_scale_t s;
+    int bands, red_row, red_column, htaps, x, offset;
+    size_t size;
+    uint8_t *buffer;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+    // only whole quads are used, as in DC1394_BAYER_METHOD_DOWNSAMPLE
+    if ((width < 1) || (height < 1) || (width > sx / 2) || (height > sy / 2))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    s.in_stride = in_stride ? in_stride : (size_t)sx * bpp;
+    s.out_stride = out_stride ? out_stride : (size_t)width * 3 * bpp;
+    if ((s.in_stride < (size_t)sx * bpp) || (s.out_stride < (size_t)width * 3 * bpp))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    s.bayer = bayer;
+    s.rgb = rgb;
+    s.sx = sx;
+    s.sy = sy;
+    s.bpp = bpp;
+    s.width = width;
+    s.height = height;
+    bands = MIN(ctx->threads, (int)height);
+    s.band_rows = (height + bands - 1) / bands;
+    bands = (height + s.band_rows - 1) / s.band_rows;
+
+    red_row = (tile == DC1394_COLOR_FILTER_BGGR) || (tile == DC1394_COLOR_FILTER_GBRG);
+    red_column = (tile == DC1394_COLOR_FILTER_GRBG) || (tile == DC1394_COLOR_FILTER_BGGR);
+    s.red = red_row * sx + red_column;
+    s.green0 = red_row * sx + 1 - red_column;
+    s.green1 = (1 - red_row) * sx + red_column;
+    s.blue = (1 - red_row) * sx + 1 - red_column;
+
+    // the sums, the weights and their positions all have 32 bits
+    s.vtaps = sy / 2 / height + 2;
+    htaps = sx / 2 + width;
+    size = ((size_t)bands * (2 * sx + s.vtaps) + htaps + 3 * width) * sizeof(uint32_t);
+    buffer = bayer_context_buffer(ctx, size);
+    if (buffer == NULL) {
+        dc1394_debayer_context_free(tmp);
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    s.sums = (uint32_t*)buffer;
+    s.vweights = s.sums + (size_t)bands * 2 * sx;
+    s.hweights = s.vweights + (size_t)bands * s.vtaps;
+    s.hstart = (int*)(s.hweights + htaps);
+    s.hcount = s.hstart + width;
+    s.hoffset = s.hcount + width;
+
+    for (x = 0, offset = 0; x < (int)width; x++) {
+        s.hoffset[x] = offset;
+        s.hcount[x] = bayer_scale_weights(sx / 2, width, x, &s.hstart[x], s.hweights + offset);
+        offset += s.hcount[x];
+    }
+
+    s.accumulate_8bit = bayer_simd_get_accumulate_8bit();
+    if (s.accumulate_8bit == NULL)
+        s.accumulate_8bit = bayer_accumulate_8bit;
+    s.accumulate_16bit = bayer_simd_get_accumulate_16bit();
+    if (s.accumulate_16bit == NULL)
+        s.accumulate_16bit = bayer_accumulate_16bit;
+
+    thread_pool_run(ctx->threads, bands, bayer_scale_task, &s);
+
+    dc1394_debayer_context_free(tmp);
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_scaled(dc1394debayer_context_t *ctx, const uint8_t *restrict bayer, uint8_t *restrict rgb,
+                                  uint32_t sx, uint32_t sy, dc1394color_filter_t tile, uint32_t width,
+                                  uint32_t height)
+{
+    return bayer_decoding_scaled(ctx, bayer, rgb, sx, sy, 1, 0, 0, tile, width, height);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_scaled(dc1394debayer_context_t *ctx, const uint16_t *restrict bayer,
+                                   uint16_t *restrict rgb, uint32_t sx, uint32_t sy, dc1394color_filter_t tile,
+                                   uint32_t width, uint32_t height)
+{
+    return bayer_decoding_scaled(ctx, (const uint8_t*)bayer, (uint8_t*)rgb, sx, sy, 2, 0, 0, tile, width, height);
+}
+
+dc1394error_t
+dc1394_debayer_frames_scaled(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                             uint32_t width, uint32_t height)
+{
+    dc1394error_t err;
+
+    if ((width < 1) || (height < 1) || (width > in->size[0] / 2) || (height > in->size[1] / 2))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    switch (in->color_coding) {
+    case DC1394_COLOR_CODING_RAW8:
+    case DC1394_COLOR_CODING_MONO8:
+    case DC1394_COLOR_CODING_MONO16:
+    case DC1394_COLOR_CODING_RAW16:
+        break;
+    default:
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    }
+
+    // the position is scaled like the size
+    err = Adapt_buffer_bayer_size(in, out, width, height, (uint64_t)in->position[0] * width / in->size[0],
+                                  (uint64_t)in->position[1] * height / in->size[1]);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    return bayer_decoding_scaled(ctx, in->image, out->image, in->size[0], in->size[1], bayer_frame_bpp(in),
+                                 frame_row_bytes(in), frame_row_bytes(out), in->color_filter, width, height);
+}
+
+/*
+  Region of interest decoding: each rectangle is decoded from a window of
+  the mosaic that extends it by the halo of the method on every side, so
+  that its pixels come out as in the full frame. The window starts on even
+  coordinates to keep the color filter phase of the frame, and inside the
+  frame its size is even too, as some methods only handle even sizes well.
+  The rectangles are shared among the threads of the context; each thread
+  decodes its own ones, one after the other, in its part of the buffer.
+ */
+typedef struct {
+    const uint8_t *bayer;
+    int sx, sy, bpp;
+    dc1394color_filter_t tile;
+    dc1394bayer_method_t method;
+    uint32_t bits;
+    size_t in_stride;
+    const dc1394roi_t *rois;
+    uint8_t **rgb;
+    const size_t *out_strides; /* of each rgb, or NULL if they are all packed */
+    int count, slots;
+    uint8_t *buffer;
+    size_t slot_offset[THREAD_POOL_MAX_THREADS];
+    bayer_scratch_t **scratch;
+    dc1394error_t err[THREAD_POOL_MAX_THREADS];
+} bayer_rois_t;
+
+/* the window of the mosaic decoded for roi */
+static void
+bayer_roi_window(const bayer_rois_t *b, const dc1394roi_t *roi, int *x0, int *y0, int *x1, int *y1)
+{
+    const int halo = bayer_band_halo(b->method);
+
+    *x0 = MAX((int)roi->left - halo, 0) & ~1;
+    *y0 = MAX((int)roi->top - halo, 0) & ~1;
+    *x1 = MIN((int)(roi->left + roi->width) + halo, b->sx);
+    *y1 = MIN((int)(roi->top + roi->height) + halo, b->sy);
+    if (*x1 < b->sx)
+        *x1 += (*x1 - *x0) & 1;
+    if (*y1 < b->sy)
+        *y1 += (*y1 - *y0) & 1;
+}
+
+static void
+bayer_roi_task(void *arg, int slot)
+{
+    bayer_rois_t *b = (bayer_rois_t*)arg;
+    const dc1394roi_t *roi;
+    const size_t row = (size_t)3 * b->bpp;
+    const int d = (b->method == DC1394_BAYER_METHOD_DOWNSAMPLE) ? 2 : 1;
+    uint8_t *window, *decoded;
+    size_t out_row, stride;
+    int i, x0, y0, x1, y1, y;
+
+    window = b->buffer + b->slot_offset[slot];
+    b->err[slot] = DC1394_SUCCESS;
+
+    for (i = slot; i < b->count; i += b->slots) {
+        roi = &b->rois[i];
+        bayer_roi_window(b, roi, &x0, &y0, &x1, &y1);
+
+        for (y = y0; y < y1; y++)
+            memcpy(window + (size_t)(y - y0) * (x1 - x0) * b->bpp,
+                   b->bayer + y * b->in_stride + (size_t)x0 * b->bpp, (size_t)(x1 - x0) * b->bpp);
+
+        out_row = roi->width / d * row;
+        stride = (b->out_strides != NULL) ? b->out_strides[i] : out_row;
+
+        // the rectangle is exactly the window: decode in place if the rows are packed
+        if ((b->method == DC1394_BAYER_METHOD_DOWNSAMPLE) && (stride == out_row)) {
+            b->err[slot] = bayer_decode(NULL, window, b->rgb[i], x1 - x0, y1 - y0, b->bpp, b->tile, b->method, b->bits);
+            if (b->err[slot] != DC1394_SUCCESS)
+                return;
+            continue;
+        }
+
+        decoded = window + (size_t)(x1 - x0) * (y1 - y0) * b->bpp;
+        b->err[slot] = bayer_decode(b->scratch[slot], window, decoded, x1 - x0, y1 - y0, b->bpp, b->tile,
+                                    b->method, b->bits);
+        if (b->err[slot] != DC1394_SUCCESS)
+            return;
+        for (y = 0; y < (int)roi->height / d; y++)
+            memcpy(b->rgb[i] + y * stride,
+                   decoded + ((size_t)((roi->top - y0) / d + y) * ((x1 - x0) / d) + (roi->left - x0) / d) * row,
+                   out_row);
+    }
+}
+
+static dc1394error_t
+bayer_decoding_roi(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint32_t sx, uint32_t sy, int bpp,
+                   size_t in_stride, dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits,
+                   const dc1394roi_t *rois, uint8_t **rgb, const size_t *out_strides, uint32_t count)
+{
+    dc1394debayer_context_t *tmp = NULL;
+    bayer_rois_t b;
+    size_t size, largest;
+    int i, j, x0, y0, x1, y1;
+    dc1394error_t err = DC1394_SUCCESS;
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return DC1394_INVALID_BAYER_METHOD;
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+    if ((rois == NULL) || (rgb == NULL))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    in_stride = in_stride ? in_stride : (size_t)sx * bpp;
+    if (in_stride < (size_t)sx * bpp)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    for (i = 0; i < (int)count; i++) {
+        if ((rgb[i] == NULL) || (rois[i].width == 0) || (rois[i].height == 0) ||
+            (rois[i].left > sx) || (rois[i].width > sx - rois[i].left) ||
+            (rois[i].top > sy) || (rois[i].height > sy - rois[i].top))
+            return DC1394_INVALID_ARGUMENT_VALUE;
+        // the quads of DOWNSAMPLE must be whole
+        if ((method == DC1394_BAYER_METHOD_DOWNSAMPLE) &&
+            ((rois[i].left | rois[i].top | rois[i].width | rois[i].height) & 1))
+            return DC1394_INVALID_ARGUMENT_VALUE;
+    }
+    if (count == 0)
+        return DC1394_SUCCESS;
+
+    if (ctx == NULL) {
+        ctx = tmp = dc1394_debayer_context_new(1);
+        if (ctx == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    b.bayer = bayer;
+    b.in_stride = in_stride;
+    b.sx = sx;
+    b.sy = sy;
+    b.bpp = bpp;
+    b.tile = tile;
+    b.method = method;
+    b.bits = bits;
+    b.rois = rois;
+    b.rgb = rgb;
+    b.out_strides = out_strides;
+    b.count = count;
+    b.slots = MIN(ctx->threads, (int)count);
+
+    // each thread needs room for the largest of its windows, and its decoded pixels
+    size = 0;
+    for (i = 0; i < b.slots; i++) {
+        largest = 0;
+        for (j = i; j < b.count; j += b.slots) {
+            bayer_roi_window(&b, &rois[j], &x0, &y0, &x1, &y1);
+            largest = MAX(largest, (size_t)(x1 - x0) * (y1 - y0) * bpp * 4);
+        }
+        b.slot_offset[i] = size;
+        size += largest;
+    }
+
+    for (i = 0; (i < b.slots) && ((method == DC1394_BAYER_METHOD_VNG) || (method == DC1394_BAYER_METHOD_AHD)); i++) {
+        if (ctx->scratch[i] == NULL)
+            ctx->scratch[i] = bayer_scratch_new();
+        if (ctx->scratch[i] == NULL)
+            err = DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    b.buffer = bayer_context_buffer(ctx, size);
+    if (b.buffer == NULL)
+        err = DC1394_MEMORY_ALLOCATION_FAILURE;
+    b.scratch = ctx->scratch;
+
+    if (err == DC1394_SUCCESS) {
+        thread_pool_run(ctx->threads, b.slots, bayer_roi_task, &b);
+        for (i = 0; i < b.slots; i++)
+            if (b.err[i] != DC1394_SUCCESS)
+                err = b.err[i];
+    }
+
+    dc1394_debayer_context_free(tmp);
+    return err;
+}
+
+dc1394error_t
+dc1394_bayer_decoding_8bit_roi(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint32_t sx, uint32_t sy,
+                               dc1394color_filter_t tile, dc1394bayer_method_t method, const dc1394roi_t *rois,
+                               uint8_t **rgb, uint32_t count)
+{
+    return bayer_decoding_roi(ctx, bayer, sx, sy, 1, 0, tile, method, 8, rois, rgb, NULL, count);
+}
+
+dc1394error_t
+dc1394_bayer_decoding_16bit_roi(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint32_t sx, uint32_t sy,
+                                dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits,
+                                const dc1394roi_t *rois, uint16_t **rgb, uint32_t count)
+{
+    return bayer_decoding_roi(ctx, (const uint8_t*)bayer, sx, sy, 2, 0, tile, method, bits, rois, (uint8_t**)rgb,
+                              NULL, count);
+}
+
+dc1394error_t
+dc1394_debayer_frames_roi(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                          const dc1394roi_t *rois, uint32_t count, dc1394bayer_method_t method)
+{
+    uint8_t *images[THREAD_POOL_MAX_THREADS];
+    size_t strides[THREAD_POOL_MAX_THREADS];
+    uint32_t i, j, n, d;
+    int bpp;
+    dc1394error_t err;
+
+    switch (in->color_coding) {
+    case DC1394_COLOR_CODING_RAW8:
+    case DC1394_COLOR_CODING_MONO8:
+        bpp = 1;
+        break;
+    case DC1394_COLOR_CODING_MONO16:
+    case DC1394_COLOR_CODING_RAW16:
+        bpp = 2;
+        break;
+    default:
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    }
+    if ((rois == NULL) || (out == NULL))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    // the frames keep the position of their rectangle in the sensor, halved by DOWNSAMPLE as in Adapt_buffer_bayer()
+    d = (method == DC1394_BAYER_METHOD_DOWNSAMPLE) ? 2 : 1;
+    for (i = 0; i < count; i++) {
+        err = Adapt_buffer_bayer_size(in, &out[i], rois[i].width / d, rois[i].height / d,
+                                      (in->position[0] + rois[i].left) / d, (in->position[1] + rois[i].top) / d);
+        if (err != DC1394_SUCCESS)
+            return err;
+    }
+
+    // the images are passed by groups that fit in the array
+    for (i = 0; i < count; i += n) {
+        n = MIN(count - i, THREAD_POOL_MAX_THREADS);
+        for (j = 0; j < n; j++) {
+            images[j] = out[i + j].image;
+            strides[j] = frame_row_bytes(&out[i + j]);
+        }
+        err = bayer_decoding_roi(ctx, in->image, in->size[0], in->size[1], bpp, frame_row_bytes(in), in->color_filter,
+                                 method, bpp == 1 ? 8 : in->data_depth, rois + i, images, strides, n);
+        if (err != DC1394_SUCCESS)
+            return err;
+    }
+
+    return DC1394_SUCCESS;
+}
+
+
+/**************************************************************
+ *     Streaming de-mosaicing: the image is a single band,    *
+ * whose chunks are decoded as soon as the input rows of the  *
+ * chunk and of its halo below have arrived.                  *
+ **************************************************************/
+
+struct __dc1394debayer_stream {
+    bayer_bands_t b;           /* the image as a single band, whose chunks are decoded straight to the output */
+    uint8_t *buffer;           /* the halo rows above a chunk, saved while it is decoded */
+    bayer_scratch_t *scratch;  /* VNG and AHD memory */
+    int min_rows;              /* fewest rows decoded at a time but at the bottom, for the halos not to cost too much */
+    int next;                  /* first input row that is not decoded yet */
+    int rows;                  /* input rows available */
+};
+
+dc1394debayer_stream_t*
+dc1394_debayer_stream_new(uint32_t sx, uint32_t sy, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                          uint32_t bits)
+{
+    dc1394debayer_stream_t *s;
+    bayer_bands_t *b;
+    const int bpp = (bits == 8) ? 1 : 2;
+    const int down = (method == DC1394_BAYER_METHOD_DOWNSAMPLE);
+
+    if ((method<DC1394_BAYER_METHOD_MIN)||(method>DC1394_BAYER_METHOD_MAX))
+        return NULL;
+    if ((tile<DC1394_COLOR_FILTER_MIN)||(tile>DC1394_COLOR_FILTER_MAX))
+        return NULL;
+    if ((bits < 8) || (bits > 16) || (sx == 0) || (sy == 0) || (sx > INT_MAX / 6) || (sy > INT_MAX))
+        return NULL;
+
+    s = (dc1394debayer_stream_t*)calloc(1, sizeof(dc1394debayer_stream_t));
+    if (s == NULL)
+        return NULL;
+
+    b = &s->b;
+    b->coding = (bpp == 1) ? DC1394_COLOR_CODING_RGB8 : DC1394_COLOR_CODING_RGB16;
+    b->sx = sx;
+    b->sy = sy;
+    b->bpp = bpp;
+    b->width = down ? sx / 2 : sx;
+    b->height = down ? sy / 2 : sy;
+    b->out_row = (size_t)b->width * 3 * bpp;
+    b->in_stride = (size_t)sx * bpp;
+    b->out_stride = b->out_row;
+    b->tile = tile;
+    b->method = method;
+    b->bits = bits;
+    b->packing = BAYER_NOT_PACKED;
+    b->halo = bayer_band_halo(method);
+    b->band_rows = sy;
+    b->direct = 1;
+    b->chunk_rows = MAX(BAYER_CHUNK_BYTES / (sx * bpp), MAX(4 * b->halo, 2));
+    b->chunk_rows += b->chunk_rows & 1;
+    s->min_rows = MAX(4 * b->halo, 2);
+    // these two only handle even sizes properly: odd ones are decoded at once
+    if ((down || (method == DC1394_BAYER_METHOD_EDGESENSE)) && ((sx & 1) || (sy & 1)))
+        s->min_rows = b->chunk_rows = sy;
+
+    s->buffer = (uint8_t*)malloc(MAX(b->halo, 1) * (size_t)sx * 3 * bpp);
+    if ((method == DC1394_BAYER_METHOD_VNG) || (method == DC1394_BAYER_METHOD_AHD))
+        s->scratch = bayer_scratch_new();
+    if ((s->buffer == NULL) ||
+        (((method == DC1394_BAYER_METHOD_VNG) || (method == DC1394_BAYER_METHOD_AHD)) && (s->scratch == NULL))) {
+        dc1394_debayer_stream_free(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+void
+dc1394_debayer_stream_free(dc1394debayer_stream_t *s)
+{
+    if (s == NULL)
+        return;
+    bayer_scratch_free(s->scratch);
+    free(s->buffer);
+    free(s);
+}
+
+dc1394error_t
+dc1394_debayer_stream_start(dc1394debayer_stream_t *s, const void *bayer, void *rgb)
+{
+    if ((s == NULL) || (bayer == NULL) || (rgb == NULL))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    s->b.bayer = (const uint8_t*)bayer;
+    s->b.out = (uint8_t*)rgb;
+    s->next = 0;
+    s->rows = 0;
+
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+dc1394_debayer_stream_push(dc1394debayer_stream_t *s, uint32_t rows, uint32_t *done)
+{
+    bayer_bands_t *b;
+    int ready, c1;
+    dc1394error_t err;
+
+    if ((s == NULL) || (s->b.bayer == NULL) || (rows > (uint32_t)s->b.sy) || ((int)rows < s->rows))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    b = &s->b;
+    s->rows = rows;
+
+    // the rows are decoded once their halo below is there too, by chunks that start on even rows
+    ready = (s->rows == b->sy) ? b->sy : (s->rows - b->halo) & ~1;
+    if ((ready - s->next >= s->min_rows) || ((ready == b->sy) && (s->next < b->sy))) {
+        while (s->next < ready) {
+            // the last chunk is never much smaller than the others
+            c1 = (ready - s->next < 2 * b->chunk_rows) ? ready : s->next + b->chunk_rows;
+            err = bayer_decode_chunk(b, s->buffer, s->scratch, 0, 0, b->sy, s->next, c1);
+            if (err != DC1394_SUCCESS)
+                return err;
+            s->next = c1;
+        }
+    }
+
+    if (done != NULL)
+        *done = (b->method == DC1394_BAYER_METHOD_DOWNSAMPLE) ? s->next / 2 : s->next;
+
     return DC1394_SUCCESS;
 }
@@ -0,0 +1,788 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include "simd.h"
+
+/*
+  These decoders produce exactly the same output as their scalar
+  counterparts in bayer.c. Instead of walking the row with the
+  blue/start_with_green state, each output pixel is written as
+
+      X = the colour of the non-green pixels of its row
+      Y = the other colour
+      G = green
+
+  and the formula for X, Y and G only depends on whether the pixel is green.
+  A row is thus processed several pixels at a time with a per-row lane mask, and
+  the few pixels left at the end of the row go through the same formula in
+  scalar code.
+ */
+
+/* scalar decoders from bayer.c, used for images too small to vectorize */
+void ClearBorders(uint8_t *rgb, int sx, int sy, int w);
+dc1394error_t dc1394_bayer_NearestNeighbor(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile);
+dc1394error_t dc1394_bayer_Bilinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile);
+dc1394error_t dc1394_bayer_HQLinear(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile);
+void ClearBorders_uint16(uint16_t *rgb, int sx, int sy, int w);
+dc1394error_t dc1394_bayer_Bilinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits);
+dc1394error_t dc1394_bayer_HQLinear_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits);
+dc1394error_t dc1394_bayer_EdgeSense_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits);
+dc1394error_t dc1394_bayer_Downsample_uint16(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits);
+
+/* layout of a row: column parity of its green pixels, and whether its other pixels are red */
+static inline void
+row_layout(int tile, int row, int *green_parity, int *x_is_red)
+{
+    *green_parity = (BAYER_FIRST_GREEN(tile) ? 0 : 1) ^ (row & 1);
+    *x_is_red = BAYER_FIRST_RED(tile) ^ (row & 1);
+}
+
+static inline void
+put_pixel(uint8_t *out, int x_is_red, int x, int g, int y)
+{
+    out[0] = x_is_red ? x : y;
+    out[1] = g;
+    out[2] = x_is_red ? y : x;
+}
+
+static inline int
+clip8(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline void
+nearest_pixel(const uint8_t *b, uint8_t *out, int sx, int green, int x_is_red)
+{
+    if (green)
+        put_pixel(out, x_is_red, b[1], b[sx + 1], b[sx]);
+    else
+        put_pixel(out, x_is_red, b[0], b[1], b[sx + 1]);
+}
+
+static inline void
+bilinear_pixel(const uint8_t *b, uint8_t *out, int sx, int green, int x_is_red)
+{
+    if (green)
+        put_pixel(out, x_is_red, (b[-1] + b[1] + 1) >> 1, b[0], (b[-sx] + b[sx] + 1) >> 1);
+    else
+        put_pixel(out, x_is_red, b[0],
+                  (b[-sx] + b[sx] + b[-1] + b[1] + 2) >> 2,
+                  (b[-sx - 1] + b[-sx + 1] + b[sx - 1] + b[sx + 1] + 2) >> 2);
+}
+
+static inline void
+hqlinear_pixel(const uint8_t *b, uint8_t *out, int sx, int green, int x_is_red)
+{
+    const int sx2 = sx * 2;
+    int c = b[0];
+    int diag = b[-sx - 1] + b[-sx + 1] + b[sx - 1] + b[sx + 1];
+    int t0, t1;
+
+    if (green) {
+        /* t1 is the colour of the horizontal neighbours, t0 of the vertical ones */
+        t0 = c * 5 + ((b[-sx] + b[sx]) << 2) - b[-sx2] - diag - b[sx2] + ((b[-2] + b[2] + 1) >> 1);
+        t1 = c * 5 + ((b[-1] + b[1]) << 2) - b[-2] - diag - b[2] + ((b[-sx2] + b[sx2] + 1) >> 1);
+        put_pixel(out, x_is_red, clip8((t1 + 4) >> 3), c, clip8((t0 + 4) >> 3));
+    } else {
+        int cross2 = b[-sx2] + b[-2] + b[2] + b[sx2];
+        t0 = (diag << 1) - ((cross2 * 3 + 1) >> 1) + c * 6;
+        t1 = ((b[-sx] + b[-1] + b[1] + b[sx]) << 1) - cross2 + (c << 2);
+        put_pixel(out, x_is_red, c, clip8((t1 + 4) >> 3), clip8((t0 + 4) >> 3));
+    }
+}
+
+static inline void
+put_pixel_uint16(uint16_t *out, int x_is_red, int x, int g, int y)
+{
+    out[0] = x_is_red ? x : y;
+    out[1] = g;
+    out[2] = x_is_red ? y : x;
+}
+
+static inline int
+clip16(int v, int maxval)
+{
+    return v < 0 ? 0 : (v > maxval ? maxval : v);
+}
+
+static inline void
+bilinear_pixel_uint16(const uint16_t *b, uint16_t *out, int sx, int green, int x_is_red)
+{
+    if (green)
+        put_pixel_uint16(out, x_is_red, (b[-1] + b[1] + 1) >> 1, b[0], (b[-sx] + b[sx] + 1) >> 1);
+    else
+        put_pixel_uint16(out, x_is_red, b[0],
+                         (b[-sx] + b[sx] + b[-1] + b[1] + 2) >> 2,
+                         (b[-sx - 1] + b[-sx + 1] + b[sx - 1] + b[sx + 1] + 2) >> 2);
+}
+
+static inline void
+hqlinear_pixel_uint16(const uint16_t *b, uint16_t *out, int sx, int green, int x_is_red, int maxval)
+{
+    const int sx2 = sx * 2;
+    int c = b[0];
+    int diag = b[-sx - 1] + b[-sx + 1] + b[sx - 1] + b[sx + 1];
+    int t0, t1;
+
+    if (green) {
+        t0 = c * 5 + ((b[-sx] + b[sx]) << 2) - b[-sx2] - diag - b[sx2] + ((b[-2] + b[2] + 1) >> 1);
+        t1 = c * 5 + ((b[-1] + b[1]) << 2) - b[-2] - diag - b[2] + ((b[-sx2] + b[sx2] + 1) >> 1);
+        put_pixel_uint16(out, x_is_red, clip16((t1 + 4) >> 3, maxval), c, clip16((t0 + 4) >> 3, maxval));
+    } else {
+        int cross2 = b[-sx2] + b[-2] + b[2] + b[sx2];
+        t0 = (diag << 1) - ((cross2 * 3 + 1) >> 1) + c * 6;
+        t1 = ((b[-sx] + b[-1] + b[1] + b[sx]) << 1) - cross2 + (c << 2);
+        put_pixel_uint16(out, x_is_red, c, clip16((t1 + 4) >> 3, maxval), clip16((t0 + 4) >> 3, maxval));
+    }
+}
+
+/* edge sensing, first pass: green and (raw - green) at one pixel */
+static inline void
+edgesense_green_uint16(const uint16_t *b, int32_t *gi, int32_t *diff, int sx, int green, int maxval)
+{
+    int c = b[0];
+    int g = c;
+
+    if (!green) {
+        int dh = abs(((b[-2] + b[2]) >> 1) - c);
+        int dv = abs(((b[-2 * sx] + b[2 * sx]) >> 1) - c);
+        g = clip16(dh <= dv ? (b[-1] + b[1]) >> 1 : (b[-sx] + b[sx]) >> 1, maxval);
+    }
+    *gi = g;
+    *diff = c - g;
+}
+
+/* edge sensing, second pass: du, dc and dd point at the differences of the rows above, at and below */
+static inline void
+edgesense_pixel_uint16(const uint16_t *b, uint16_t *out, const int32_t *gi,
+                       const int32_t *du, const int32_t *dc, const int32_t *dd,
+                       int green, int x_is_red, int maxval)
+{
+    int c = b[0];
+
+    if (green)
+        put_pixel_uint16(out, x_is_red, clip16(c + ((dc[-1] + dc[1]) >> 1), maxval), c,
+                         clip16(c + ((du[0] + dd[0]) >> 1), maxval));
+    else
+        put_pixel_uint16(out, x_is_red, c, gi[0],
+                         clip16(gi[0] + ((du[-1] + du[1] + dd[-1] + dd[1]) >> 2), maxval));
+}
+
+/* one output pixel from the 2x2 quad at b */
+static inline void
+downsample_pixel_uint16(const uint16_t *b, uint16_t *out, int sx, int first_green, int x_is_red)
+{
+    if (first_green)
+        put_pixel_uint16(out, x_is_red, b[1], (b[0] + b[sx + 1]) >> 1, b[sx]);
+    else
+        put_pixel_uint16(out, x_is_red, b[0], (b[1] + b[sx]) >> 1, b[sx + 1]);
+}
+
+#ifdef DC1394_SIMD
+
+/* saturate to 0..255 */
+#define CLAMP_U8(v)                                     \
+    ({                                                  \
+        __typeof__(v) v_ = (v);                         \
+        v_ = SIMD_SELECT(v_ > 0, v_, 0);                \
+        SIMD_SELECT(v_ > 255, 255, v_);                 \
+    })
+
+/* interleave three planes of 8 pixels (already in 0..255) into 24 bytes of RGB */
+SIMD_INLINE void
+store_rgb_x8(uint8_t *dst, v8i16 r, v8i16 g, v8i16 b)
+{
+    v16u8 rg, o;
+
+    rg = SIMD_SHUFFLE(v16u8, (v16u8) r, (v16u8) g, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    o = SIMD_SHUFFLE(v16u8, rg, (v16u8) b, 0, 8, 16, 1, 9, 18, 2, 10, 20, 3, 11, 22, 4, 12, 24, 5);
+    SIMD_STORE(dst, o);
+    o = SIMD_SHUFFLE(v16u8, rg, (v16u8) b, 13, 26, 6, 14, 28, 7, 15, 30, 0, 0, 0, 0, 0, 0, 0, 0);
+    memcpy(dst + 16, &o, 8);
+}
+
+/* interleave three planes of 16 pixels into 48 bytes of RGB */
+SIMD_INLINE void
+store_rgb_x16(uint8_t *dst, v16u8 r, v16u8 g, v16u8 b)
+{
+    v16u8 t, o;
+
+    t = SIMD_SHUFFLE(v16u8, r, g, 0, 16, 0, 1, 17, 0, 2, 18, 0, 3, 19, 0, 4, 20, 0, 5);
+    o = SIMD_SHUFFLE(v16u8, t, b, 0, 1, 16, 3, 4, 17, 6, 7, 18, 9, 10, 19, 12, 13, 20, 15);
+    SIMD_STORE(dst, o);
+    t = SIMD_SHUFFLE(v16u8, r, g, 21, 0, 6, 22, 0, 7, 23, 0, 8, 24, 0, 9, 25, 0, 10, 26);
+    o = SIMD_SHUFFLE(v16u8, t, b, 0, 21, 2, 3, 22, 5, 6, 23, 8, 9, 24, 11, 12, 25, 14, 15);
+    SIMD_STORE(dst + 16, o);
+    t = SIMD_SHUFFLE(v16u8, r, g, 0, 11, 27, 0, 12, 28, 0, 13, 29, 0, 14, 30, 0, 15, 31, 0);
+    o = SIMD_SHUFFLE(v16u8, t, b, 26, 1, 2, 27, 4, 5, 28, 7, 8, 29, 10, 11, 30, 13, 14, 31);
+    SIMD_STORE(dst + 32, o);
+}
+
+/* 8 pixels per step: one 128-bit register (SSE2, SSSE3, NEON) */
+#define LANES 8
+#define VEC v8i16
+#define KERNEL(f) f##_x8
+#define LOAD(p) ({ v8u8 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v8i16); })
+#define STORE_RGB(dst, r, g, b) store_rgb_x8(dst, CLAMP_U8(r), CLAMP_U8(g), CLAMP_U8(b))
+#include "bayer_simd_kernels.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD
+#undef STORE_RGB
+
+/* 16 pixels per step: one 256-bit register (AVX2) */
+#define LANES 16
+#define VEC v16i16
+#define KERNEL(f) f##_x16
+#define LOAD(p) ({ v16u8 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v16i16); })
+#define STORE_RGB(dst, r, g, b)                                           \
+    store_rgb_x16(dst, __builtin_convertvector(CLAMP_U8(r), v16u8),       \
+                  __builtin_convertvector(CLAMP_U8(g), v16u8),            \
+                  __builtin_convertvector(CLAMP_U8(b), v16u8))
+#include "bayer_simd_kernels.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD
+#undef STORE_RGB
+
+/* interleave three planes of 4 pixels (already in 0..65535) into 12 words of RGB */
+SIMD_INLINE void
+store_rgb_uint16_x4(uint16_t *dst, v4i32 r, v4i32 g, v4i32 b)
+{
+    v8u16 rg, o;
+
+    rg = SIMD_SHUFFLE(v8u16, (v8u16) r, (v8u16) g, 0, 2, 4, 6, 8, 10, 12, 14);
+    o = SIMD_SHUFFLE(v8u16, rg, (v8u16) b, 0, 4, 8, 1, 5, 10, 2, 6);
+    SIMD_STORE(dst, o);
+    o = SIMD_SHUFFLE(v8u16, rg, (v8u16) b, 12, 3, 7, 14, 0, 0, 0, 0);
+    memcpy(dst + 8, &o, 8);
+}
+
+/* interleave three planes of 8 pixels into 24 words of RGB */
+SIMD_INLINE void
+store_rgb_uint16_x8(uint16_t *dst, v8u16 r, v8u16 g, v8u16 b)
+{
+    v8u16 t, o;
+
+    t = SIMD_SHUFFLE(v8u16, r, g, 0, 8, 0, 1, 9, 0, 2, 10);
+    o = SIMD_SHUFFLE(v8u16, t, b, 0, 1, 8, 3, 4, 9, 6, 7);
+    SIMD_STORE(dst, o);
+    t = SIMD_SHUFFLE(v8u16, r, g, 0, 3, 11, 0, 4, 12, 0, 5);
+    o = SIMD_SHUFFLE(v8u16, t, b, 10, 1, 2, 11, 4, 5, 12, 7);
+    SIMD_STORE(dst + 8, o);
+    t = SIMD_SHUFFLE(v8u16, r, g, 13, 0, 6, 14, 0, 7, 15, 0);
+    o = SIMD_SHUFFLE(v8u16, t, b, 0, 13, 2, 3, 14, 5, 6, 15);
+    SIMD_STORE(dst + 16, o);
+}
+
+/* 4 pixels of 16 bits per step: one 128-bit register (SSSE3, NEON) */
+#define LANES 4
+#define VEC v4i32
+#define KERNEL(f) f##_u16x4
+#define LOAD(p) ({ v4u16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v4i32); })
+#define LOAD_PAIRS(p, e, o)                                                         \
+    do {                                                                            \
+        v8u16 l_;                                                                   \
+        SIMD_LOAD(l_, p);                                                           \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 0, 2, 4, 6), v4i32); \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 1, 3, 5, 7), v4i32); \
+    } while (0)
+#define STORE_RGB(dst, r, g, b) store_rgb_uint16_x4(dst, r, g, b)
+#include "bayer_simd_kernels_uint16.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD
+#undef LOAD_PAIRS
+#undef STORE_RGB
+
+/* 8 pixels of 16 bits per step: one 256-bit register (AVX2) */
+#define LANES 8
+#define VEC v8i32
+#define KERNEL(f) f##_u16x8
+#define LOAD(p) ({ v8u16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v8i32); })
+#define LOAD_PAIRS(p, e, o)                                                                         \
+    do {                                                                                            \
+        v16u16 l_;                                                                                  \
+        SIMD_LOAD(l_, p);                                                                           \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v8u16, l_, l_, 0, 2, 4, 6, 8, 10, 12, 14), v8i32);  \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v8u16, l_, l_, 1, 3, 5, 7, 9, 11, 13, 15), v8i32);  \
+    } while (0)
+#define STORE_RGB(dst, r, g, b)                                               \
+    store_rgb_uint16_x8(dst, __builtin_convertvector(r, v8u16),               \
+                        __builtin_convertvector(g, v8u16),                    \
+                        __builtin_convertvector(b, v8u16))
+#include "bayer_simd_kernels_uint16.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD
+#undef LOAD_PAIRS
+#undef STORE_RGB
+
+/* AHD homogeneity, 4 pixels per step: one 128-bit register (NEON) */
+#define LANES 4
+#define VEC v4i32
+#define UVEC v4u32
+#define KERNEL(f) f##_i32x4
+#define LOAD_LAB(p) ({ v4i16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v4i32); })
+#define STORE_HOMO(p, v) ({ v4i8 s_ = __builtin_convertvector(v, v4i8); SIMD_STORE(p, s_); })
+#include "bayer_simd_kernels_ahd.h"
+#undef LANES
+#undef VEC
+#undef UVEC
+#undef KERNEL
+#undef LOAD_LAB
+#undef STORE_HOMO
+
+/* AHD homogeneity, 8 pixels per step: one 256-bit register (AVX2) */
+#define LANES 8
+#define VEC v8i32
+#define UVEC v8u32
+#define KERNEL(f) f##_i32x8
+#define LOAD_LAB(p) ({ v8i16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v8i32); })
+#define STORE_HOMO(p, v) ({ v8i8 s_ = __builtin_convertvector(v, v8i8); SIMD_STORE(p, s_); })
+#include "bayer_simd_kernels_ahd.h"
+#undef LANES
+#undef VEC
+#undef UVEC
+#undef KERNEL
+#undef LOAD_LAB
+#undef STORE_HOMO
+
+/* scaled decoding accumulation, 4 samples per step: one 128-bit register (NEON) */
+#define LANES 4
+#define UVEC v4u32
+#define KERNEL(f) f##_u32x4
+#define LOAD_8BIT(p)                                                                        \
+    ({ v4u8 l_; SIMD_LOAD(l_, p); __builtin_convertvector(__builtin_convertvector(l_, v4u16), v4u32); })
+#define LOAD_16BIT(p) ({ v4u16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v4u32); })
+#include "bayer_simd_kernels_scale.h"
+#undef LANES
+#undef UVEC
+#undef KERNEL
+#undef LOAD_8BIT
+#undef LOAD_16BIT
+
+/* scaled decoding accumulation, 8 samples per step: one 256-bit register (AVX2) */
+#define LANES 8
+#define UVEC v8u32
+#define KERNEL(f) f##_u32x8
+#define LOAD_8BIT(p)                                                                        \
+    ({ v8u8 l_; SIMD_LOAD(l_, p); __builtin_convertvector(__builtin_convertvector(l_, v8u16), v8u32); })
+#define LOAD_16BIT(p) ({ v8u16 l_; SIMD_LOAD(l_, p); __builtin_convertvector(l_, v8u32); })
+#include "bayer_simd_kernels_scale.h"
+#undef LANES
+#undef UVEC
+#undef KERNEL
+#undef LOAD_8BIT
+#undef LOAD_16BIT
+
+/*
+  Luminance of the MONO outputs. 306*r + 601*g + 117*b is 256*(r + 2*g) + 50*r + 89*g + 117*b, whose
+  second part fits in 16 bits for 8-bit samples: their luma is computed in 16-bit words, exactly.
+ */
+#define LUMA_16BIT_WORDS(r, g, b) (((r) + 2 * (g) + ((50 * (r) + 89 * (g) + 117 * (b)) >> 8)) >> 2)
+#define LUMA_32BIT_WORDS(r, g, b) ((306 * (r) + 601 * (g) + 117 * (b)) >> 10)
+
+/* luminance of 8-bit samples, 8 pixels per step: one 128-bit register (SSSE3, NEON) */
+#define LANES 8
+#define SAMPLE uint8_t
+#define UVEC v8u16
+#define KERNEL(f) f##_8bit_u16x8
+#define SCALAR(f) f##_8bit
+#define LOAD_RGB(p, r, g, b)                                                                            \
+    do {                                                                                                \
+        v16u8 a_, b_;                                                                                   \
+        SIMD_LOAD(a_, p);                                                                               \
+        SIMD_LOAD(b_, (p) + 16);                                                                        \
+        r = __builtin_convertvector(SIMD_SHUFFLE(v8u8, a_, b_, 0, 3, 6, 9, 12, 15, 18, 21), v8u16);      \
+        g = __builtin_convertvector(SIMD_SHUFFLE(v8u8, a_, b_, 1, 4, 7, 10, 13, 16, 19, 22), v8u16);     \
+        b = __builtin_convertvector(SIMD_SHUFFLE(v8u8, a_, b_, 2, 5, 8, 11, 14, 17, 20, 23), v8u16);     \
+    } while (0)
+#define LOAD_PAIRS(p, e, o)                                                                             \
+    do {                                                                                                \
+        v16u8 l_;                                                                                       \
+        SIMD_LOAD(l_, p);                                                                               \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v8u8, l_, l_, 0, 2, 4, 6, 8, 10, 12, 14), v8u16);       \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v8u8, l_, l_, 1, 3, 5, 7, 9, 11, 13, 15), v8u16);       \
+    } while (0)
+#define STORE(p, v)                                                                                     \
+    ({ v16u8 b_ = (v16u8)(v); v8u8 s_ = SIMD_SHUFFLE(v8u8, b_, b_, 0, 2, 4, 6, 8, 10, 12, 14); SIMD_STORE(p, s_); })
+#define LUMA LUMA_16BIT_WORDS
+#include "bayer_simd_kernels_luma.h"
+#undef LANES
+#undef SAMPLE
+#undef UVEC
+#undef KERNEL
+#undef SCALAR
+#undef LOAD_RGB
+#undef LOAD_PAIRS
+#undef STORE
+#undef LUMA
+
+/* luminance of 8-bit samples, 16 pixels per step: one 256-bit register (AVX2) */
+#define LANES 16
+#define SAMPLE uint8_t
+#define UVEC v16u16
+#define KERNEL(f) f##_8bit_u16x16
+#define SCALAR(f) f##_8bit
+#define LOAD_RGB(p, r, g, b)                                                                            \
+    do {                                                                                                \
+        v32u8 a_, b_;                                                                                   \
+        SIMD_LOAD(a_, p);                                                                               \
+        SIMD_LOAD(b_, (p) + 32);                                                                        \
+        r = __builtin_convertvector(SIMD_SHUFFLE(v16u8, a_, b_, 0, 3, 6, 9, 12, 15, 18, 21,              \
+                                                 24, 27, 30, 33, 36, 39, 42, 45), v16u16);              \
+        g = __builtin_convertvector(SIMD_SHUFFLE(v16u8, a_, b_, 1, 4, 7, 10, 13, 16, 19, 22,             \
+                                                 25, 28, 31, 34, 37, 40, 43, 46), v16u16);              \
+        b = __builtin_convertvector(SIMD_SHUFFLE(v16u8, a_, b_, 2, 5, 8, 11, 14, 17, 20, 23,             \
+                                                 26, 29, 32, 35, 38, 41, 44, 47), v16u16);              \
+    } while (0)
+#define LOAD_PAIRS(p, e, o)                                                                             \
+    do {                                                                                                \
+        v32u8 l_;                                                                                       \
+        SIMD_LOAD(l_, p);                                                                               \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v16u8, l_, l_, 0, 2, 4, 6, 8, 10, 12, 14,               \
+                                                 16, 18, 20, 22, 24, 26, 28, 30), v16u16);              \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v16u8, l_, l_, 1, 3, 5, 7, 9, 11, 13, 15,               \
+                                                 17, 19, 21, 23, 25, 27, 29, 31), v16u16);              \
+    } while (0)
+#define STORE(p, v)                                                                                     \
+    ({ v32u8 b_ = (v32u8)(v);                                                                           \
+       v16u8 s_ = SIMD_SHUFFLE(v16u8, b_, b_, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30); \
+       SIMD_STORE(p, s_); })
+#define LUMA LUMA_16BIT_WORDS
+#include "bayer_simd_kernels_luma.h"
+#undef LANES
+#undef SAMPLE
+#undef UVEC
+#undef KERNEL
+#undef SCALAR
+#undef LOAD_RGB
+#undef LOAD_PAIRS
+#undef STORE
+#undef LUMA
+
+/* luminance of 16-bit samples, 4 pixels per step: one 128-bit register (NEON) */
+#define LANES 4
+#define SAMPLE uint16_t
+#define UVEC v4u32
+#define KERNEL(f) f##_16bit_u32x4
+#define SCALAR(f) f##_16bit
+#define LOAD_RGB(p, r, g, b)                                                                            \
+    do {                                                                                                \
+        v16u16 l_;                                                                                      \
+        SIMD_LOAD(l_, p);                                                                               \
+        r = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 0, 3, 6, 9), v4u32);                     \
+        g = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 1, 4, 7, 10), v4u32);                    \
+        b = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 2, 5, 8, 11), v4u32);                    \
+    } while (0)
+#define LOAD_PAIRS(p, e, o)                                                                             \
+    do {                                                                                                \
+        v8u16 l_;                                                                                       \
+        SIMD_LOAD(l_, p);                                                                               \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 0, 2, 4, 6), v4u32);                     \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v4u16, l_, l_, 1, 3, 5, 7), v4u32);                     \
+    } while (0)
+#define STORE(p, v)                                                                                     \
+    ({ v8u16 w_ = (v8u16)(v); v4u16 s_ = SIMD_SHUFFLE(v4u16, w_, w_, 0, 2, 4, 6); SIMD_STORE(p, s_); })
+#define LUMA LUMA_32BIT_WORDS
+#include "bayer_simd_kernels_luma.h"
+#undef LANES
+#undef SAMPLE
+#undef UVEC
+#undef KERNEL
+#undef SCALAR
+#undef LOAD_RGB
+#undef LOAD_PAIRS
+#undef STORE
+#undef LUMA
+
+/* luminance of 16-bit samples, 8 pixels per step: one 256-bit register (AVX2) */
+#define LANES 8
+#define SAMPLE uint16_t
+#define UVEC v8u32
+#define KERNEL(f) f##_16bit_u32x8
+#define SCALAR(f) f##_16bit
+#define LOAD_RGB(p, r, g, b)                                                                            \
+    do {                                                                                                \
+        v16u16 a_, b_;                                                                                  \
+        SIMD_LOAD(a_, p);                                                                               \
+        SIMD_LOAD(b_, (p) + 16);                                                                        \
+        r = __builtin_convertvector(SIMD_SHUFFLE(v8u16, a_, b_, 0, 3, 6, 9, 12, 15, 18, 21), v8u32);     \
+        g = __builtin_convertvector(SIMD_SHUFFLE(v8u16, a_, b_, 1, 4, 7, 10, 13, 16, 19, 22), v8u32);    \
+        b = __builtin_convertvector(SIMD_SHUFFLE(v8u16, a_, b_, 2, 5, 8, 11, 14, 17, 20, 23), v8u32);    \
+    } while (0)
+#define LOAD_PAIRS(p, e, o)                                                                             \
+    do {                                                                                                \
+        v16u16 l_;                                                                                      \
+        SIMD_LOAD(l_, p);                                                                               \
+        e = __builtin_convertvector(SIMD_SHUFFLE(v8u16, l_, l_, 0, 2, 4, 6, 8, 10, 12, 14), v8u32);      \
+        o = __builtin_convertvector(SIMD_SHUFFLE(v8u16, l_, l_, 1, 3, 5, 7, 9, 11, 13, 15), v8u32);      \
+    } while (0)
+#define STORE(p, v)                                                                                     \
+    ({ v16u16 w_ = (v16u16)(v);                                                                         \
+       v8u16 s_ = SIMD_SHUFFLE(v8u16, w_, w_, 0, 2, 4, 6, 8, 10, 12, 14);                                \
+       SIMD_STORE(p, s_); })
+#define LUMA LUMA_32BIT_WORDS
+#include "bayer_simd_kernels_luma.h"
+#undef LANES
+#undef SAMPLE
+#undef UVEC
+#undef KERNEL
+#undef SCALAR
+#undef LOAD_RGB
+#undef LOAD_PAIRS
+#undef STORE
+#undef LUMA
+
+/* one copy of each decoder per instruction set */
+#define BAYER_8BIT_CLONE(kernel, width, isa, target)                                  \
+    target static dc1394error_t                                                       \
+    kernel##_##isa(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile) \
+    {                                                                                 \
+        return kernel##_##width(bayer, rgb, sx, sy, tile);                            \
+    }
+
+#define BAYER_16BIT_CLONE(kernel, width, isa, target)                                 \
+    target static dc1394error_t                                                       \
+    kernel##_##isa(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits) \
+    {                                                                                 \
+        return kernel##_##width(bayer, rgb, sx, sy, tile, bits);                      \
+    }
+
+#define AHD_HOMOGENEITY_CLONE(width, isa, target)                                     \
+    target static void                                                                \
+    ahd_homogeneity_##isa(const int16_t *lab, int8_t *homo, int n)                    \
+    {                                                                                 \
+        ahd_homogeneity_##width(lab, homo, n);                                        \
+    }
+
+#define BAYER_ACCUMULATE_CLONE(kernel, type, width, isa, target)                      \
+    target static void                                                                \
+    kernel##_##isa(uint32_t *restrict acc, const type *restrict src, int n, uint32_t weight) \
+    {                                                                                 \
+        kernel##_##width(acc, src, n, weight);                                        \
+    }
+
+/* the binning is instantiated with the phase of the rows as constants */
+#define BAYER_LUMA_CLONE(depth, type, width, isa, target)                             \
+    target static void                                                                \
+    bayer_luma_##depth##_##isa(const type *rgb, type *dest, int pixels)               \
+    {                                                                                 \
+        bayer_luma_##depth##_##width(rgb, dest, pixels);                              \
+    }                                                                                 \
+    target static void                                                                \
+    bayer_bin_luma_##depth##_##isa(const type *restrict row0, const type *restrict row1, \
+                                   type *restrict dest, int pixels, int first_green, int first_red) \
+    {                                                                                 \
+        if (first_green && first_red)                                                 \
+            bayer_bin_luma_##depth##_##width(row0, row1, dest, pixels, 1, 1);         \
+        else if (first_green)                                                         \
+            bayer_bin_luma_##depth##_##width(row0, row1, dest, pixels, 1, 0);         \
+        else if (first_red)                                                           \
+            bayer_bin_luma_##depth##_##width(row0, row1, dest, pixels, 0, 1);         \
+        else                                                                          \
+            bayer_bin_luma_##depth##_##width(row0, row1, dest, pixels, 0, 0);         \
+    }
+
+#ifdef DC1394_SIMD_X86
+BAYER_8BIT_CLONE(bilinear_8bit, x8, ssse3, SIMD_TARGET_SSSE3)
+BAYER_8BIT_CLONE(hqlinear_8bit, x8, ssse3, SIMD_TARGET_SSSE3)
+BAYER_8BIT_CLONE(nearest_8bit, x16, avx2, SIMD_TARGET_AVX2)
+BAYER_8BIT_CLONE(bilinear_8bit, x16, avx2, SIMD_TARGET_AVX2)
+BAYER_8BIT_CLONE(hqlinear_8bit, x16, avx2, SIMD_TARGET_AVX2)
+BAYER_16BIT_CLONE(edgesense_uint16, u16x4, ssse3, SIMD_TARGET_SSSE3)
+BAYER_16BIT_CLONE(downsample_uint16, u16x4, ssse3, SIMD_TARGET_SSSE3)
+BAYER_16BIT_CLONE(bilinear_uint16, u16x8, avx2, SIMD_TARGET_AVX2)
+BAYER_16BIT_CLONE(hqlinear_uint16, u16x8, avx2, SIMD_TARGET_AVX2)
+BAYER_16BIT_CLONE(edgesense_uint16, u16x8, avx2, SIMD_TARGET_AVX2)
+BAYER_16BIT_CLONE(downsample_uint16, u16x8, avx2, SIMD_TARGET_AVX2)
+AHD_HOMOGENEITY_CLONE(i32x8, avx2, SIMD_TARGET_AVX2)
+BAYER_ACCUMULATE_CLONE(bayer_accumulate_8bit, uint8_t, u32x8, avx2, SIMD_TARGET_AVX2)
+BAYER_ACCUMULATE_CLONE(bayer_accumulate_16bit, uint16_t, u32x8, avx2, SIMD_TARGET_AVX2)
+BAYER_LUMA_CLONE(8bit, uint8_t, u16x8, ssse3, SIMD_TARGET_SSSE3)
+BAYER_LUMA_CLONE(8bit, uint8_t, u16x16, avx2, SIMD_TARGET_AVX2)
+BAYER_LUMA_CLONE(16bit, uint16_t, u32x8, avx2, SIMD_TARGET_AVX2)
+
+/*
+  Without pshufb the interleaving of the RGB output costs more than the
+  vector arithmetic saves, so plain SSE2 keeps the scalar code. The nearest
+  neighbour decoder, and the 16-bit bilinear and HQ linear ones with only
+  four 32-bit lanes per SSE register, also need AVX2 to beat the scalar code.
+  So do the AHD homogeneity, the accumulation of the scaled decoding and
+  the luminance of 16-bit samples, which need the 32-bit multiply of SSE4.1.
+ */
+#define BAYER_SIMD_PICK(kernel)                                  \
+    ((features & SIMD_FEATURE_AVX2) ? kernel##_avx2 :            \
+     (features & SIMD_FEATURE_SSSE3) ? kernel##_ssse3 : NULL)
+#define BAYER_SIMD_PICK_WIDE(kernel)                             \
+    ((features & SIMD_FEATURE_AVX2) ? kernel##_avx2 : NULL)
+#else
+BAYER_8BIT_CLONE(nearest_8bit, x8, neon, )
+BAYER_8BIT_CLONE(bilinear_8bit, x8, neon, )
+BAYER_8BIT_CLONE(hqlinear_8bit, x8, neon, )
+BAYER_16BIT_CLONE(bilinear_uint16, u16x4, neon, )
+BAYER_16BIT_CLONE(hqlinear_uint16, u16x4, neon, )
+BAYER_16BIT_CLONE(edgesense_uint16, u16x4, neon, )
+BAYER_16BIT_CLONE(downsample_uint16, u16x4, neon, )
+AHD_HOMOGENEITY_CLONE(i32x4, neon, )
+BAYER_ACCUMULATE_CLONE(bayer_accumulate_8bit, uint8_t, u32x4, neon, )
+BAYER_ACCUMULATE_CLONE(bayer_accumulate_16bit, uint16_t, u32x4, neon, )
+BAYER_LUMA_CLONE(8bit, uint8_t, u16x8, neon, )
+BAYER_LUMA_CLONE(16bit, uint16_t, u32x4, neon, )
+
+#define BAYER_SIMD_PICK(kernel) \
+    ((features & SIMD_FEATURE_NEON) ? kernel##_neon : NULL)
+#define BAYER_SIMD_PICK_WIDE(kernel) BAYER_SIMD_PICK(kernel)
+#endif
+
+#endif /* DC1394_SIMD */
+
+bayer_8bit_func_t
+bayer_simd_get_8bit(dc1394bayer_method_t method)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    switch (method) {
+    case DC1394_BAYER_METHOD_NEAREST:
+        return BAYER_SIMD_PICK_WIDE(nearest_8bit);
+    case DC1394_BAYER_METHOD_BILINEAR:
+        return BAYER_SIMD_PICK(bilinear_8bit);
+    case DC1394_BAYER_METHOD_HQLINEAR:
+        return BAYER_SIMD_PICK(hqlinear_8bit);
+    default:
+        break;
+    }
+#endif
+    return NULL;
+}
+
+bayer_16bit_func_t
+bayer_simd_get_16bit(dc1394bayer_method_t method)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    switch (method) {
+    case DC1394_BAYER_METHOD_BILINEAR:
+        return BAYER_SIMD_PICK_WIDE(bilinear_uint16);
+    case DC1394_BAYER_METHOD_HQLINEAR:
+        return BAYER_SIMD_PICK_WIDE(hqlinear_uint16);
+    case DC1394_BAYER_METHOD_EDGESENSE:
+        return BAYER_SIMD_PICK(edgesense_uint16);
+    case DC1394_BAYER_METHOD_DOWNSAMPLE:
+        return BAYER_SIMD_PICK(downsample_uint16);
+    default:
+        break;
+    }
+#endif
+    return NULL;
+}
+
+ahd_homogeneity_func_t
+ahd_simd_get_homogeneity(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK_WIDE(ahd_homogeneity);
+#else
+    return NULL;
+#endif
+}
+
+bayer_accumulate_8bit_func_t
+bayer_simd_get_accumulate_8bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK_WIDE(bayer_accumulate_8bit);
+#else
+    return NULL;
+#endif
+}
+
+bayer_accumulate_16bit_func_t
+bayer_simd_get_accumulate_16bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK_WIDE(bayer_accumulate_16bit);
+#else
+    return NULL;
+#endif
+}
+
+bayer_luma_8bit_func_t
+bayer_simd_get_luma_8bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK(bayer_luma_8bit);
+#else
+    return NULL;
+#endif
+}
+
+bayer_luma_16bit_func_t
+bayer_simd_get_luma_16bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK_WIDE(bayer_luma_16bit);
+#else
+    return NULL;
+#endif
+}
+
+bayer_bin_luma_8bit_func_t
+bayer_simd_get_bin_luma_8bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK(bayer_bin_luma_8bit);
+#else
+    return NULL;
+#endif
+}
+
+bayer_bin_luma_16bit_func_t
+bayer_simd_get_bin_luma_16bit(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return BAYER_SIMD_PICK_WIDE(bayer_bin_luma_16bit);
+#else
+    return NULL;
+#endif
+}
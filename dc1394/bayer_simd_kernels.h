@@ -0,0 +1,176 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions: kernel bodies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by bayer_simd.c once per vector width, with:
+
+    LANES                      pixels per step
+    VEC                        vector of LANES signed 16-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD(p)                    LANES pixels at p, widened to VEC
+    STORE_RGB(dst, r, g, b)    interleaves three VEC planes into RGB at dst
+ */
+
+/* lanes holding a green pixel when the step starts at column col */
+SIMD_INLINE VEC
+KERNEL(green_lanes)(int col, int green_parity)
+{
+    VEC even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+    return ((col ^ green_parity) & 1) ? ~even : even;
+}
+
+#define STORE_XGY(dst, x_is_red, x, g, y)       \
+    do {                                        \
+        if (x_is_red)                           \
+            STORE_RGB(dst, x, g, y);            \
+        else                                    \
+            STORE_RGB(dst, y, g, x);            \
+    } while (0)
+
+SIMD_INLINE dc1394error_t
+KERNEL(nearest_8bit)(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile)
+{
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    if (sx < 2 * LANES + 2 || sy < 2)
+        return dc1394_bayer_NearestNeighbor(bayer, rgb, sx, sy, tile);
+
+    /* black border on the last row and column */
+    memset(rgb + (size_t) sx * (sy - 1) * 3, 0, sx * 3);
+    for (row = 0; row < sy - 1; row++)
+        memset(rgb + ((size_t) row * sx + sx - 1) * 3, 0, 3);
+
+    for (row = 0; row < sy - 1; row++) {
+        const uint8_t *b = bayer + (size_t) row * sx;
+        uint8_t *out = rgb + (size_t) row * sx * 3;
+        VEC g;
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(0, gp);
+        for (col = 0; col + LANES + 1 <= sx; col += LANES) {
+            const uint8_t *p = b + col;
+            VEC p00 = LOAD(p), p01 = LOAD(p + 1);
+            VEC p10 = LOAD(p + sx), p11 = LOAD(p + sx + 1);
+            STORE_XGY(out + col * 3, x_is_red,
+                      SIMD_SELECT(g, p01, p00), SIMD_SELECT(g, p11, p01), SIMD_SELECT(g, p10, p11));
+        }
+        for (; col < sx - 1; col++)
+            nearest_pixel(b + col, out + col * 3, sx, ((col ^ gp) & 1) == 0, x_is_red);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+SIMD_INLINE dc1394error_t
+KERNEL(bilinear_8bit)(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile)
+{
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    if (sx < 2 * LANES + 2 || sy < 3)
+        return dc1394_bayer_Bilinear(bayer, rgb, sx, sy, tile);
+
+    ClearBorders(rgb, sx, sy, 1);
+
+    for (row = 1; row < sy - 1; row++) {
+        const uint8_t *b = bayer + (size_t) row * sx;
+        uint8_t *out = rgb + (size_t) row * sx * 3;
+        VEC g;
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(1, gp);
+        for (col = 1; col + LANES + 1 <= sx; col += LANES) {
+            const uint8_t *p = b + col;
+            VEC c = LOAD(p);
+            VEC l = LOAD(p - 1), r = LOAD(p + 1);
+            VEC u = LOAD(p - sx), d = LOAD(p + sx);
+            VEC diag = LOAD(p - sx - 1) + LOAD(p - sx + 1) + LOAD(p + sx - 1) + LOAD(p + sx + 1);
+            VEC h2 = (l + r + 1) >> 1;
+            VEC v2 = (u + d + 1) >> 1;
+            VEC x4 = (u + d + l + r + 2) >> 2;
+            VEC d4 = (diag + 2) >> 2;
+            STORE_XGY(out + col * 3, x_is_red,
+                      SIMD_SELECT(g, h2, c), SIMD_SELECT(g, c, x4), SIMD_SELECT(g, v2, d4));
+        }
+        for (; col < sx - 1; col++)
+            bilinear_pixel(b + col, out + col * 3, sx, ((col ^ gp) & 1) == 0, x_is_red);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+SIMD_INLINE dc1394error_t
+KERNEL(hqlinear_8bit)(const uint8_t *restrict bayer, uint8_t *restrict rgb, int sx, int sy, int tile)
+{
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    if (sx < 2 * LANES + 4 || sy < 5)
+        return dc1394_bayer_HQLinear(bayer, rgb, sx, sy, tile);
+
+    ClearBorders(rgb, sx, sy, 2);
+
+    for (row = 2; row < sy - 2; row++) {
+        const uint8_t *b = bayer + (size_t) row * sx;
+        uint8_t *out = rgb + (size_t) row * sx * 3;
+        VEC g;
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(2, gp);
+        for (col = 2; col + LANES + 2 <= sx; col += LANES) {
+            const uint8_t *p = b + col;
+            VEC c = LOAD(p);
+            VEC l1 = LOAD(p - 1), r1 = LOAD(p + 1);
+            VEC l2 = LOAD(p - 2), r2 = LOAD(p + 2);
+            VEC u1 = LOAD(p - sx), d1 = LOAD(p + sx);
+            VEC u2 = LOAD(p - 2 * sx), d2 = LOAD(p + 2 * sx);
+            VEC diag = LOAD(p - sx - 1) + LOAD(p - sx + 1) + LOAD(p + sx - 1) + LOAD(p + sx + 1);
+            VEC cross2 = u2 + l2 + r2 + d2;
+            VEC c5 = c * 5;
+            /* at green pixels: colour of the vertical (t0) and horizontal (t1) neighbours */
+            VEC gt0 = c5 + ((u1 + d1) << 2) - u2 - diag - d2 + ((l2 + r2 + 1) >> 1);
+            VEC gt1 = c5 + ((l1 + r1) << 2) - l2 - diag - r2 + ((u2 + d2 + 1) >> 1);
+            /* at red and blue pixels: the other colour (t0) and green (t1) */
+            VEC xt0 = (diag << 1) - ((cross2 * 3 + 1) >> 1) + c * 6;
+            VEC xt1 = ((u1 + l1 + r1 + d1) << 1) - cross2 + (c << 2);
+            STORE_XGY(out + col * 3, x_is_red,
+                      SIMD_SELECT(g, (gt1 + 4) >> 3, c),
+                      SIMD_SELECT(g, c, (xt1 + 4) >> 3),
+                      (SIMD_SELECT(g, gt0, xt0) + 4) >> 3);
+        }
+        for (; col < sx - 2; col++)
+            hqlinear_pixel(b + col, out + col * 3, sx, ((col ^ gp) & 1) == 0, x_is_red);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+#undef STORE_XGY
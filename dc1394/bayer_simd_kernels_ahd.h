@@ -0,0 +1,73 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions: AHD homogeneity kernel body
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by bayer_simd.c once per vector width, with:
+
+    LANES                      pixels per step
+    VEC, UVEC                  vectors of LANES signed and unsigned 32-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD_LAB(p)                LANES 16-bit Lab values at p, widened to VEC
+    STORE_HOMO(p, v)           narrows v to LANES bytes at p
+
+  The differences of 16-bit values and the sums of their squares are
+  computed in 32 bits, exactly as ahd_homogeneity() in bayer.c does.
+ */
+
+#define VMIN(a, b) SIMD_SELECT((__typeof__(a)) ((a) < (b)), (a), (b))
+#define VMAX(a, b) SIMD_SELECT((__typeof__(a)) ((a) > (b)), (a), (b))
+
+SIMD_INLINE void
+KERNEL(ahd_homogeneity)(const int16_t *lab, int8_t *homo, int n)
+{
+    static const int dir[4] = { -1, 1, -AHD_TILE, AHD_TILE };
+    VEC ldiff[2][4], leps, count[2], t;
+    UVEC abdiff[2][4], abeps, a, b;
+    const int16_t *l;
+    int k, d, i;
+
+    for (k = 0; k + LANES <= n; k += LANES) {
+        for (d = 0; d < 2; d++) {
+            l = lab + d * 3 * AHD_PLANE + k;
+            for (i = 0; i < 4; i++) {
+                t = LOAD_LAB(l) - LOAD_LAB(l + dir[i]);
+                ldiff[d][i] = (t ^ (t >> 31)) - (t >> 31);
+                a = (UVEC) (LOAD_LAB(l + AHD_PLANE) - LOAD_LAB(l + AHD_PLANE + dir[i]));
+                b = (UVEC) (LOAD_LAB(l + 2 * AHD_PLANE) - LOAD_LAB(l + 2 * AHD_PLANE + dir[i]));
+                abdiff[d][i] = a * a + b * b;
+            }
+        }
+        leps = VMIN(VMAX(ldiff[0][0], ldiff[0][1]), VMAX(ldiff[1][2], ldiff[1][3]));
+        abeps = VMIN(VMAX(abdiff[0][0], abdiff[0][1]), VMAX(abdiff[1][2], abdiff[1][3]));
+        for (d = 0; d < 2; d++) {
+            // the comparisons give -1 where true
+            count[d] = (VEC) { 0 };
+            for (i = 0; i < 4; i++)
+                count[d] -= (ldiff[d][i] <= leps) & (abdiff[d][i] <= abeps);
+            STORE_HOMO(homo + d * AHD_PLANE + k, count[d]);
+        }
+    }
+
+    if (k < n)
+        ahd_homogeneity(lab + k, homo + k, n - k);
+}
+
+#undef VMIN
+#undef VMAX
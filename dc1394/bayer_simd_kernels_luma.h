@@ -0,0 +1,74 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions: luminance of the MONO8 and MONO16 outputs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by bayer_simd.c once per sample size and vector width, with:
+
+    LANES                      pixels per step
+    SAMPLE                     uint8_t or uint16_t, of the input and of the output
+    UVEC                       vector of LANES unsigned words, wide enough for LUMA()
+    KERNEL(f), SCALAR(f)       names of the instance of kernel f and of its scalar version
+    LOAD_RGB(p, r, g, b)       the components of LANES RGB pixels at p, widened to UVEC. Up to
+                               LANES components beyond them are read.
+    LOAD_PAIRS(p, e, o)        the even and odd ones of 2*LANES samples at p, widened to UVEC
+    STORE(p, v)                the LANES words of v narrowed to samples at p
+    LUMA(r, g, b)              (306*r + 601*g + 117*b) >> 10, the luma of RGB2YUV, computed
+                               without overflowing the words of UVEC
+
+  The results are those of the scalar functions in bayer.c.
+ */
+
+SIMD_INLINE void
+KERNEL(bayer_luma)(const SAMPLE *rgb, SAMPLE *dest, int pixels)
+{
+    UVEC r, g, b;
+    int i;
+
+    // one more step of pixels holds the components read beyond the last ones. In
+    // place, each step only overwrites components that were read before.
+    for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+        LOAD_RGB(rgb + 3 * i, r, g, b);
+        STORE(dest + i, LUMA(r, g, b));
+    }
+
+    SCALAR(bayer_luma)(rgb + 3 * i, dest + i, pixels - i);
+}
+
+SIMD_INLINE void
+KERNEL(bayer_bin_luma)(const SAMPLE *restrict row0, const SAMPLE *restrict row1, SAMPLE *restrict dest,
+                       int pixels, int first_green, int first_red)
+{
+    UVEC e0, o0, e1, o1, x, y;
+    int i;
+
+    // x is the red or blue sample of row0, y the other one, of row1
+    for (i = 0; i + LANES <= pixels; i += LANES) {
+        LOAD_PAIRS(row0 + 2 * i, e0, o0);
+        LOAD_PAIRS(row1 + 2 * i, e1, o1);
+        x = first_green ? o0 : e0;
+        y = first_green ? e1 : o1;
+        if (first_red)
+            STORE(dest + i, LUMA(x, (first_green ? e0 + o1 : o0 + e1) >> 1, y));
+        else
+            STORE(dest + i, LUMA(y, (first_green ? e0 + o1 : o0 + e1) >> 1, x));
+    }
+
+    SCALAR(bayer_bin_luma)(row0 + 2 * i, row1 + 2 * i, dest + i, pixels - i, first_green, first_red);
+}
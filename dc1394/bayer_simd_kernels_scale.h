@@ -0,0 +1,61 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions: row accumulation of the scaled decoding
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by bayer_simd.c once per vector width, with:
+
+    LANES                      samples per step
+    UVEC                       vector of LANES unsigned 32-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD_8BIT(p), LOAD_16BIT(p) LANES samples at p, widened to UVEC
+
+  The products and sums wrap around exactly as the scalar ones in bayer.c,
+  so the results are identical.
+ */
+
+SIMD_INLINE void
+KERNEL(bayer_accumulate_8bit)(uint32_t *restrict acc, const uint8_t *restrict src, int n, uint32_t weight)
+{
+    UVEC a, w = (UVEC) { 0 } + weight;
+    int i;
+
+    for (i = 0; i + LANES <= n; i += LANES) {
+        SIMD_LOAD(a, acc + i);
+        a += w * LOAD_8BIT(src + i);
+        SIMD_STORE(acc + i, a);
+    }
+
+    bayer_accumulate_8bit(acc + i, src + i, n - i, weight);
+}
+
+SIMD_INLINE void
+KERNEL(bayer_accumulate_16bit)(uint32_t *restrict acc, const uint16_t *restrict src, int n, uint32_t weight)
+{
+    UVEC a, w = (UVEC) { 0 } + weight;
+    int i;
+
+    for (i = 0; i + LANES <= n; i += LANES) {
+        SIMD_LOAD(a, acc + i);
+        a += w * LOAD_16BIT(src + i);
+        SIMD_STORE(acc + i, a);
+    }
+
+    bayer_accumulate_16bit(acc + i, src + i, n - i, weight);
+}
@@ -0,0 +1,290 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized Bayer pattern decoding functions: 16-bit kernel bodies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by bayer_simd.c once per vector width, with:
+
+    LANES                      pixels per step
+    VEC                        vector of LANES signed 32-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD(p)                    LANES 16-bit pixels at p, widened to VEC
+    LOAD_PAIRS(p, e, o)        2*LANES 16-bit pixels at p, split into the
+                               even (e) and odd (o) columns as VEC
+    STORE_RGB(dst, r, g, b)    interleaves three VEC planes (already in
+                               0..65535) into 16-bit RGB at dst
+
+  The 32-bit lanes hold the intermediate sums of 16-bit data without
+  overflow, so the arithmetic is the same as in the scalar code.
+ */
+
+/* lanes holding a green pixel when the step starts at column col */
+SIMD_INLINE VEC
+KERNEL(green_lanes)(int col, int green_parity)
+{
+    VEC even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+    return ((col ^ green_parity) & 1) ? ~even : even;
+}
+
+#define LOAD_VEC(p) ({ VEC l_; SIMD_LOAD(l_, p); l_; })
+
+#define CLIP_VEC(v, maxval)                             \
+    ({                                                  \
+        VEC v_ = (v);                                   \
+        v_ = SIMD_SELECT(v_ > 0, v_, 0);                \
+        SIMD_SELECT(v_ > (maxval), (maxval), v_);       \
+    })
+
+#define STORE_XGY(dst, x_is_red, x, g, y)       \
+    do {                                        \
+        if (x_is_red)                           \
+            STORE_RGB(dst, x, g, y);            \
+        else                                    \
+            STORE_RGB(dst, y, g, x);            \
+    } while (0)
+
+SIMD_INLINE dc1394error_t
+KERNEL(bilinear_uint16)(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
+{
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    if (sx < 2 * LANES + 2 || sy < 3)
+        return dc1394_bayer_Bilinear_uint16(bayer, rgb, sx, sy, tile, bits);
+
+    ClearBorders_uint16(rgb, sx, sy, 1);
+
+    for (row = 1; row < sy - 1; row++) {
+        const uint16_t *b = bayer + (size_t) row * sx;
+        uint16_t *out = rgb + (size_t) row * sx * 3;
+        VEC g;
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(1, gp);
+        for (col = 1; col + LANES + 1 <= sx; col += LANES) {
+            const uint16_t *p = b + col;
+            VEC c = LOAD(p);
+            VEC l = LOAD(p - 1), r = LOAD(p + 1);
+            VEC u = LOAD(p - sx), d = LOAD(p + sx);
+            VEC diag = LOAD(p - sx - 1) + LOAD(p - sx + 1) + LOAD(p + sx - 1) + LOAD(p + sx + 1);
+            VEC h2 = (l + r + 1) >> 1;
+            VEC v2 = (u + d + 1) >> 1;
+            VEC x4 = (u + d + l + r + 2) >> 2;
+            VEC d4 = (diag + 2) >> 2;
+            STORE_XGY(out + col * 3, x_is_red,
+                      SIMD_SELECT(g, h2, c), SIMD_SELECT(g, c, x4), SIMD_SELECT(g, v2, d4));
+        }
+        for (; col < sx - 1; col++)
+            bilinear_pixel_uint16(b + col, out + col * 3, sx, ((col ^ gp) & 1) == 0, x_is_red);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+SIMD_INLINE dc1394error_t
+KERNEL(hqlinear_uint16)(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
+{
+    const int maxval = (1 << bits) - 1;
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    if (sx < 2 * LANES + 4 || sy < 5)
+        return dc1394_bayer_HQLinear_uint16(bayer, rgb, sx, sy, tile, bits);
+
+    ClearBorders_uint16(rgb, sx, sy, 2);
+
+    for (row = 2; row < sy - 2; row++) {
+        const uint16_t *b = bayer + (size_t) row * sx;
+        uint16_t *out = rgb + (size_t) row * sx * 3;
+        VEC g;
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(2, gp);
+        for (col = 2; col + LANES + 2 <= sx; col += LANES) {
+            const uint16_t *p = b + col;
+            VEC c = LOAD(p);
+            VEC l1 = LOAD(p - 1), r1 = LOAD(p + 1);
+            VEC l2 = LOAD(p - 2), r2 = LOAD(p + 2);
+            VEC u1 = LOAD(p - sx), d1 = LOAD(p + sx);
+            VEC u2 = LOAD(p - 2 * sx), d2 = LOAD(p + 2 * sx);
+            VEC diag = LOAD(p - sx - 1) + LOAD(p - sx + 1) + LOAD(p + sx - 1) + LOAD(p + sx + 1);
+            VEC cross2 = u2 + l2 + r2 + d2;
+            VEC c5 = c * 5;
+            /* at green pixels: colour of the vertical (t0) and horizontal (t1) neighbours */
+            VEC gt0 = c5 + ((u1 + d1) << 2) - u2 - diag - d2 + ((l2 + r2 + 1) >> 1);
+            VEC gt1 = c5 + ((l1 + r1) << 2) - l2 - diag - r2 + ((u2 + d2 + 1) >> 1);
+            /* at red and blue pixels: the other colour (t0) and green (t1) */
+            VEC xt0 = (diag << 1) - ((cross2 * 3 + 1) >> 1) + c * 6;
+            VEC xt1 = ((u1 + l1 + r1 + d1) << 1) - cross2 + (c << 2);
+            STORE_XGY(out + col * 3, x_is_red,
+                      SIMD_SELECT(g, CLIP_VEC((gt1 + 4) >> 3, maxval), c),
+                      SIMD_SELECT(g, c, CLIP_VEC((xt1 + 4) >> 3, maxval)),
+                      CLIP_VEC((SIMD_SELECT(g, gt0, xt0) + 4) >> 3, maxval));
+        }
+        for (; col < sx - 2; col++)
+            hqlinear_pixel_uint16(b + col, out + col * 3, sx, ((col ^ gp) & 1) == 0, x_is_red, maxval);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+/*
+  Edge sensing works in two passes: green is first interpolated at the red
+  and blue pixels (gi), then red and blue are interpolated from their
+  difference to that green (diff = raw - gi). Both are kept for three rows
+  in a small ring buffer, so a single walk over the image is enough.
+ */
+SIMD_INLINE void
+KERNEL(edgesense_rows_uint16)(const uint16_t *b, int32_t *gi, int32_t *diff, int sx, int gp, int maxval)
+{
+    const int sx2 = sx * 2;
+    VEC g = KERNEL(green_lanes)(2, gp);
+    int col;
+
+    for (col = 2; col + LANES + 2 <= sx; col += LANES) {
+        const uint16_t *p = b + col;
+        VEC c = LOAD(p);
+        VEC dh = ((LOAD(p - 2) + LOAD(p + 2)) >> 1) - c;
+        VEC dv = ((LOAD(p - sx2) + LOAD(p + sx2)) >> 1) - c;
+        VEC h = (LOAD(p - 1) + LOAD(p + 1)) >> 1;
+        VEC v = (LOAD(p - sx) + LOAD(p + sx)) >> 1;
+        VEC t;
+
+        dh = SIMD_SELECT(dh < 0, -dh, dh);
+        dv = SIMD_SELECT(dv < 0, -dv, dv);
+        t = SIMD_SELECT(g, c, CLIP_VEC(SIMD_SELECT(dh <= dv, h, v), maxval));
+        SIMD_STORE(gi + col, t);
+        t = c - t;
+        SIMD_STORE(diff + col, t);
+    }
+    for (; col < sx - 2; col++)
+        edgesense_green_uint16(b + col, gi + col, diff + col, sx, ((col ^ gp) & 1) == 0, maxval);
+}
+
+SIMD_INLINE dc1394error_t
+KERNEL(edgesense_uint16)(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
+{
+    const int maxval = (1 << bits) - 1;
+    int32_t *ring, *gi[3], *diff[3];
+    int row, col, gp, x_is_red, i;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    // the scalar decoder only handles even sizes properly
+    if (sx < 2 * LANES + 8 || sy < 8 || (sx & 1) || (sy & 1))
+        return dc1394_bayer_EdgeSense_uint16(bayer, rgb, sx, sy, tile, bits);
+
+    ring = malloc(6 * (size_t) sx * sizeof(int32_t));
+    if (ring == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    for (i = 0; i < 3; i++) {
+        gi[i] = ring + 2 * i * sx;
+        diff[i] = gi[i] + sx;
+    }
+
+    for (row = 2; row < 4; row++) {
+        row_layout(tile, row, &gp, &x_is_red);
+        KERNEL(edgesense_rows_uint16)(bayer + (size_t) row * sx, gi[row % 3], diff[row % 3], sx, gp, maxval);
+    }
+
+    for (row = 3; row < sy - 3; row++) {
+        const uint16_t *b = bayer + (size_t) row * sx;
+        uint16_t *out = rgb + (size_t) row * sx * 3;
+        const int32_t *gc = gi[row % 3];
+        const int32_t *du = diff[(row - 1) % 3], *dc = diff[row % 3], *dd = diff[(row + 1) % 3];
+        VEC g;
+
+        row_layout(tile, row + 1, &gp, &x_is_red);
+        KERNEL(edgesense_rows_uint16)(b + sx, gi[(row + 1) % 3], diff[(row + 1) % 3], sx, gp, maxval);
+
+        row_layout(tile, row, &gp, &x_is_red);
+        g = KERNEL(green_lanes)(3, gp);
+        for (col = 3; col + LANES + 3 <= sx; col += LANES) {
+            VEC c = LOAD(b + col);
+            VEC gcv = LOAD_VEC(gc + col);
+            VEC dl = LOAD_VEC(dc + col - 1), dr = LOAD_VEC(dc + col + 1);
+            VEC dul = LOAD_VEC(du + col - 1), dur = LOAD_VEC(du + col + 1);
+            VEC ddl = LOAD_VEC(dd + col - 1), ddr = LOAD_VEC(dd + col + 1);
+            VEC dv = LOAD_VEC(du + col) + LOAD_VEC(dd + col);
+            /* at green pixels X and Y come from the horizontal and vertical
+               neighbours, at the others Y comes from the diagonal ones */
+            VEC x = SIMD_SELECT(g, CLIP_VEC(c + ((dl + dr) >> 1), maxval), c);
+            VEC y = SIMD_SELECT(g, c + (dv >> 1), gcv + ((dul + dur + ddl + ddr) >> 2));
+            STORE_XGY(out + col * 3, x_is_red, x, gcv, CLIP_VEC(y, maxval));
+        }
+        for (; col < sx - 3; col++)
+            edgesense_pixel_uint16(b + col, out + col * 3, gc + col, du + col, dc + col, dd + col,
+                                   ((col ^ gp) & 1) == 0, x_is_red, maxval);
+    }
+
+    free(ring);
+    ClearBorders_uint16(rgb, sx, sy, 3);
+
+    return DC1394_SUCCESS;
+}
+
+SIMD_INLINE dc1394error_t
+KERNEL(downsample_uint16)(const uint16_t *restrict bayer, uint16_t *restrict rgb, int sx, int sy, int tile, int bits)
+{
+    const int osx = sx >> 1;
+    int row, col, gp, x_is_red;
+
+    if ((tile>DC1394_COLOR_FILTER_MAX)||(tile<DC1394_COLOR_FILTER_MIN))
+        return DC1394_INVALID_COLOR_FILTER;
+
+    // the scalar decoder only handles even sizes properly
+    if (osx < LANES || (sx & 1) || (sy & 1))
+        return dc1394_bayer_Downsample_uint16(bayer, rgb, sx, sy, tile, bits);
+
+    /* the first row of each quad decides the layout of all of them */
+    row_layout(tile, 0, &gp, &x_is_red);
+
+    for (row = 0; row < sy; row += 2) {
+        const uint16_t *b0 = bayer + (size_t) row * sx;
+        const uint16_t *b1 = b0 + sx;
+        uint16_t *out = rgb + (size_t) (row >> 1) * osx * 3;
+
+        for (col = 0; col + LANES <= osx; col += LANES) {
+            VEC e0, o0, e1, o1;
+            LOAD_PAIRS(b0 + 2 * col, e0, o0);
+            LOAD_PAIRS(b1 + 2 * col, e1, o1);
+            if (gp == 0)
+                STORE_XGY(out + col * 3, x_is_red, o0, (e0 + o1) >> 1, e1);
+            else
+                STORE_XGY(out + col * 3, x_is_red, e0, (o0 + e1) >> 1, o1);
+        }
+        for (; col < osx; col++)
+            downsample_pixel_uint16(b0 + 2 * col, out + col * 3, sx, gp == 0, x_is_red);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+#undef LOAD_VEC
+#undef CLIP_VEC
+#undef STORE_XGY
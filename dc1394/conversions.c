@@ -22,11 +22,22 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include "conversions.h"
+#include "simd.h"
+#include "stats.h"
+#include "threads.h"
 
 // this should disappear...
 extern void swab();
 
+/* from bayer.c */
+int debayer_context_threads(const dc1394debayer_context_t *ctx);
+dc1394frame_stats_t *debayer_context_stats(const dc1394debayer_context_t *ctx);
+
+/* from framepool.c */
+void frame_image_reserve(dc1394video_frame_t *frame);
+
 /**********************************************************************
  *
  *  CONVERSION FUNCTIONS TO YUV422
@@ -254,17 +265,34 @@ dc1394_MONO16_to_YUV422(uint8_t *restrict src, uint8_t *restrict dest, uint32_t
 
 }
 
+void
+depth16_to_8_row(const uint8_t *restrict src, uint8_t *restrict dest, int samples, uint32_t shift,
+                 int little_endian)
+{
+    const int msb = little_endian ? 1 : 0;
+    int i;
+
+    for (i = 0; i < samples; i++, src += 2)
+        dest[i] = ((src[msb] << 8) | src[1-msb]) >> shift;
+}
+
+/* 16-bit samples of 'bits' bits to 8 bits, by a right shift */
+static void
+depth16_to_8(const uint8_t *restrict src, uint8_t *restrict dest, uint32_t samples, uint32_t bits,
+             int little_endian)
+{
+    depth_func_t simd = conversion_simd_get_depth16_to_8();
+
+    if (simd != NULL)
+        simd(src, dest, samples, bits-8, little_endian);
+    else
+        depth16_to_8_row(src, dest, samples, bits-8, little_endian);
+}
+
 dc1394error_t
 dc1394_MONO16_to_MONO8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t width, uint32_t height, uint32_t bits)
 {
-    register int i = ((width*height)<<1)-1;
-    register int j = (width*height)-1;
-    register int y;
-
-    while (i >= 0) {
-        y = src[i--];
-        dest[j--] = (y + (src[i--]<<8))>>(bits-8);
-    }
+    depth16_to_8(src, dest, width*height, bits, 0);
     return DC1394_SUCCESS;
 }
 
@@ -275,6 +303,15 @@ dc1394_RGB8_to_YUV422(uint8_t *restrict src, uint8_t *restrict dest, uint32_t wi
     register int j = ((width*height) << 1)-1;
     register int y0, y1, u0, u1, v0, v1 ;
     register int r, g, b;
+    conversion_8bit_func_t simd;
+
+    // use the vectorized conversion if this CPU has one (it needs pixel pairs):
+    simd = conversion_simd_get_rgb8_to_yuv422();
+    if ((simd != NULL) && (((width*height) & 1) == 0) &&
+        ((byte_order == DC1394_BYTE_ORDER_YUYV) || (byte_order == DC1394_BYTE_ORDER_UYVY))) {
+        simd(src, dest, width*height, byte_order);
+        return DC1394_SUCCESS;
+    }
 
     switch (byte_order) {
     case DC1394_BYTE_ORDER_YUYV:
@@ -381,21 +418,7 @@ dc1394_RGB16_to_YUV422(uint8_t *restrict src, uint8_t *restrict dest, uint32_t w
 dc1394error_t
 dc1394_RGB16_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t width, uint32_t height, uint32_t bits)
 {
-    register int i = (((width*height) + ( (width*height) << 1 )) << 1)-1;
-    register int j = (width*height) + ( (width*height) << 1 ) -1;
-    register int t;
-
-    while (i >= 0) {
-        t = src[i--];
-        t = (t + (src[i--]<<8))>>(bits-8);
-        dest[j--]=t;
-        t = src[i--];
-        t = (t + (src[i--]<<8))>>(bits-8);
-        dest[j--]=t;
-        t = src[i--];
-        t = (t + (src[i--]<<8))>>(bits-8);
-        dest[j--]=t;
-    }
+    depth16_to_8(src, dest, width*height*3, bits, 0);
     return DC1394_SUCCESS;
 }
 
@@ -407,6 +430,14 @@ dc1394_YUV444_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t wi
     register int j = (width*height) + ( (width*height) << 1 ) -1;
     register int y, u, v;
     register int r, g, b;
+    conversion_8bit_func_t simd;
+
+    // use the vectorized conversion if this CPU has one:
+    simd = conversion_simd_get_yuv444_to_rgb8();
+    if (simd != NULL) {
+        simd(src, dest, width*height, 0);
+        return DC1394_SUCCESS;
+    }
 
     while (i >= 0) {
         v = (uint8_t) src[i--] - 128;
@@ -427,7 +458,15 @@ dc1394_YUV422_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t wi
     register int j = (width*height) + ( (width*height) << 1 ) -1;
     register int y0, y1, u, v;
     register int r, g, b;
+    conversion_8bit_func_t simd;
 
+    // use the vectorized conversion if this CPU has one (it needs pixel pairs):
+    simd = conversion_simd_get_yuv422_to_rgb8();
+    if ((simd != NULL) && (((width*height) & 1) == 0) &&
+        ((byte_order == DC1394_BYTE_ORDER_YUYV) || (byte_order == DC1394_BYTE_ORDER_UYVY))) {
+        simd(src, dest, width*height, byte_order);
+        return DC1394_SUCCESS;
+    }
 
     switch (byte_order) {
     case DC1394_BYTE_ORDER_YUYV:
@@ -476,6 +515,14 @@ dc1394_YUV411_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t wi
     register int j = (width*height) + ( (width*height) << 1 )-1;
     register int y0, y1, y2, y3, u, v;
     register int r, g, b;
+    conversion_8bit_func_t simd;
+
+    // use the vectorized conversion if this CPU has one (it needs groups of 4 pixels):
+    simd = conversion_simd_get_yuv411_to_rgb8();
+    if ((simd != NULL) && (((width*height) & 3) == 0)) {
+        simd(src, dest, width*height, 0);
+        return DC1394_SUCCESS;
+    }
 
     while (i >= 0) {
         y3 = (uint8_t) src[i--];
@@ -540,22 +587,684 @@ dc1394_MONO16_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t wi
 }
 
 
+/**********************************************************************
+ *
+ *  MATRICES AND RANGES OF YUV
+ *
+ **********************************************************************/
+
+/*
+  The parameters other than BT.601 at full range are look-up tables in fixed
+  point, of YUV_SHIFT fractional bits: each component is the sum of the
+  entries of its inputs in their tables, and the offsets of the range and
+  the rounding are folded in the table of one of them.
+ */
+#define YUV_SHIFT 16
+
+struct __dc1394yuv_params {
+    dc1394yuv_matrix_t matrix;
+    dc1394yuv_range_t range;
+    int legacy;                /* BT.601 at full range: the conversions of dc1394_convert_frames() */
+    int32_t to_y[3][256];      /* RGB to YUV: the terms of red, green and blue in each component */
+    int32_t to_u[3][256];
+    int32_t to_v[3][256];
+    int32_t luma[256];         /* YUV to RGB: the term of Y in each component */
+    int32_t red_v[256];        /* and those of the chroma */
+    int32_t green_u[256];
+    int32_t green_v[256];
+    int32_t blue_u[256];
+    uint8_t mono[256];         /* gray levels to Y */
+};
+
+static int32_t
+fixed(double x)
+{
+    x *= 1 << YUV_SHIFT;
+    return (int32_t)(x < 0 ? x - 0.5 : x + 0.5);
+}
+
+dc1394yuv_params_t*
+dc1394_yuv_params_new(dc1394yuv_matrix_t matrix, dc1394yuv_range_t range)
+{
+    // the weights of red and blue in the luma
+    static const double weights[DC1394_YUV_MATRIX_NUM][2] = { { 0.299, 0.114 }, { 0.2126, 0.0722 } };
+    const double half = 0.5;
+    dc1394yuv_params_t *params;
+    double kr, kg, kb, ys, cs, yo, c;
+    int i;
+
+    if ((matrix < DC1394_YUV_MATRIX_MIN) || (matrix > DC1394_YUV_MATRIX_MAX) ||
+        (range < DC1394_YUV_RANGE_MIN) || (range > DC1394_YUV_RANGE_MAX))
+        return NULL;
+
+    params = (dc1394yuv_params_t*)calloc(1, sizeof(dc1394yuv_params_t));
+    if (params == NULL)
+        return NULL;
+    params->matrix = matrix;
+    params->range = range;
+    params->legacy = (matrix == DC1394_YUV_MATRIX_BT601) && (range == DC1394_YUV_RANGE_FULL);
+
+    kr = weights[matrix - DC1394_YUV_MATRIX_MIN][0];
+    kb = weights[matrix - DC1394_YUV_MATRIX_MIN][1];
+    kg = 1 - kr - kb;
+    // the scales of the luma and of the chroma, and the offset of the luma, in the range
+    ys = (range == DC1394_YUV_RANGE_LIMITED) ? 219.0 / 255 : 1;
+    cs = (range == DC1394_YUV_RANGE_LIMITED) ? 224.0 / 255 : 1;
+    yo = (range == DC1394_YUV_RANGE_LIMITED) ? 16 : 0;
+
+    for (i = 0; i < 256; i++) {
+        params->to_y[0][i] = fixed(ys * kr * i + yo + half);
+        params->to_y[1][i] = fixed(ys * kg * i);
+        params->to_y[2][i] = fixed(ys * kb * i);
+        params->to_u[0][i] = fixed(-cs * kr / (2 * (1 - kb)) * i + 128 + half);
+        params->to_u[1][i] = fixed(-cs * kg / (2 * (1 - kb)) * i);
+        params->to_u[2][i] = fixed(cs / 2 * i);
+        params->to_v[0][i] = fixed(cs / 2 * i + 128 + half);
+        params->to_v[1][i] = fixed(-cs * kg / (2 * (1 - kr)) * i);
+        params->to_v[2][i] = fixed(-cs * kb / (2 * (1 - kr)) * i);
+
+        c = (i - 128) / cs;
+        params->luma[i] = fixed((i - yo) / ys + half);
+        params->red_v[i] = fixed(2 * (1 - kr) * c);
+        params->green_u[i] = fixed(-2 * kb * (1 - kb) / kg * c);
+        params->green_v[i] = fixed(-2 * kr * (1 - kr) / kg * c);
+        params->blue_u[i] = fixed(2 * (1 - kb) * c);
+
+        params->mono[i] = (uint8_t)(yo + ys * i + half);
+    }
+
+    return params;
+}
+
+void
+dc1394_yuv_params_free(dc1394yuv_params_t *params)
+{
+    free(params);
+}
+
+/* a component in fixed point, clipped to 0..255 */
+static inline uint8_t
+yuv_clip(int32_t x)
+{
+    x >>= YUV_SHIFT;
+    return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+/* the sum of the entries of the pixel at src in the tables of a component */
+#define YUV_TERMS(table, src) (table[0][(src)[0]] + table[1][(src)[1]] + table[2][(src)[2]])
+
+static inline void
+yuv_params_pixel(const dc1394yuv_params_t *params, int y, int u, int v, uint8_t *rgb)
+{
+    const int32_t luma = params->luma[y];
+
+    rgb[0] = yuv_clip(luma + params->red_v[v]);
+    rgb[1] = yuv_clip(luma + params->green_u[u] + params->green_v[v]);
+    rgb[2] = yuv_clip(luma + params->blue_u[u]);
+}
+
+/* pixels of YUV411, YUV422 or YUV444 (coding) to RGB8 */
+static dc1394error_t
+yuv_params_to_rgb8(const dc1394yuv_params_t *params, const uint8_t *restrict src, uint8_t *restrict dest,
+                   uint32_t pixels, dc1394color_coding_t coding, uint32_t byte_order)
+{
+    uint32_t i;
+
+    switch (coding) {
+    case DC1394_COLOR_CODING_YUV444:
+        for (i = 0; i < pixels; i++, src += 3, dest += 3)
+            yuv_params_pixel(params, src[1], src[0], src[2], dest);
+        return DC1394_SUCCESS;
+    case DC1394_COLOR_CODING_YUV422:
+        switch (byte_order) {
+        case DC1394_BYTE_ORDER_YUYV:
+            for (i = 0; i + 1 < pixels; i += 2, src += 4, dest += 6) {
+                yuv_params_pixel(params, src[0], src[1], src[3], dest);
+                yuv_params_pixel(params, src[2], src[1], src[3], dest + 3);
+            }
+            return DC1394_SUCCESS;
+        case DC1394_BYTE_ORDER_UYVY:
+            for (i = 0; i + 1 < pixels; i += 2, src += 4, dest += 6) {
+                yuv_params_pixel(params, src[1], src[0], src[2], dest);
+                yuv_params_pixel(params, src[3], src[0], src[2], dest + 3);
+            }
+            return DC1394_SUCCESS;
+        default:
+            return DC1394_INVALID_BYTE_ORDER;
+        }
+    case DC1394_COLOR_CODING_YUV411:
+        for (i = 0; i + 3 < pixels; i += 4, src += 6, dest += 12) {
+            yuv_params_pixel(params, src[1], src[0], src[3], dest);
+            yuv_params_pixel(params, src[2], src[0], src[3], dest + 3);
+            yuv_params_pixel(params, src[4], src[0], src[3], dest + 6);
+            yuv_params_pixel(params, src[5], src[0], src[3], dest + 9);
+        }
+        return DC1394_SUCCESS;
+    default:
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    }
+}
+
+/* pixels of RGB8, or of big endian RGB16 of 'bits' bits, to YUV422 */
+static dc1394error_t
+yuv_params_to_yuv422(const dc1394yuv_params_t *params, const uint8_t *restrict src, uint8_t *restrict dest,
+                     uint32_t pixels, uint32_t byte_order, uint32_t bits)
+{
+    uint8_t rgb[6];
+    uint32_t i, k;
+    int32_t u, v;
+    int y0, y1;
+
+    if ((byte_order != DC1394_BYTE_ORDER_YUYV) && (byte_order != DC1394_BYTE_ORDER_UYVY))
+        return DC1394_INVALID_BYTE_ORDER;
+
+    for (i = 0; i + 1 < pixels; i += 2, dest += 4) {
+        if (bits == 8) {
+            memcpy(rgb, src, 6);
+            src += 6;
+        } else {
+            for (k = 0; k < 6; k++, src += 2)
+                rgb[k] = ((src[0] << 8) | src[1]) >> (bits - 8);
+        }
+        y0 = yuv_clip(YUV_TERMS(params->to_y, rgb));
+        y1 = yuv_clip(YUV_TERMS(params->to_y, rgb + 3));
+        // the chroma of the pair is the average of that of its pixels, rounded once
+        u = (YUV_TERMS(params->to_u, rgb) + YUV_TERMS(params->to_u, rgb + 3)) >> 1;
+        v = (YUV_TERMS(params->to_v, rgb) + YUV_TERMS(params->to_v, rgb + 3)) >> 1;
+        if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+            dest[0] = y0;
+            dest[1] = yuv_clip(u);
+            dest[2] = y1;
+            dest[3] = yuv_clip(v);
+        } else {
+            dest[0] = yuv_clip(u);
+            dest[1] = y0;
+            dest[2] = yuv_clip(v);
+            dest[3] = y1;
+        }
+    }
+
+    return DC1394_SUCCESS;
+}
+
+/* the luma of YUV422 bytes made from gray levels, from 0..255 to the range */
+static void
+yuv_params_gray_to_yuv422(const dc1394yuv_params_t *params, uint8_t *yuv, size_t bytes, uint32_t byte_order)
+{
+    size_t i;
+
+    for (i = (byte_order == DC1394_BYTE_ORDER_YUYV) ? 0 : 1; i < bytes; i += 2)
+        yuv[i] = params->mono[yuv[i]];
+}
+
+/* as rgb8_to_yuv420_rows() */
+static void
+yuv_params_to_yuv420(const dc1394yuv_params_t *params, const uint8_t *restrict src0, const uint8_t *restrict src1,
+                     uint8_t *restrict y0, uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v,
+                     uint32_t pixels, dc1394color_coding_t coding)
+{
+    int32_t us, vs;
+    uint32_t i;
+
+    for (i = 0; i + 1 < pixels; i += 2, src0 += 6, src1 += 6) {
+        y0[i] = yuv_clip(YUV_TERMS(params->to_y, src0));
+        y0[i+1] = yuv_clip(YUV_TERMS(params->to_y, src0 + 3));
+        y1[i] = yuv_clip(YUV_TERMS(params->to_y, src1));
+        y1[i+1] = yuv_clip(YUV_TERMS(params->to_y, src1 + 3));
+        us = (YUV_TERMS(params->to_u, src0) + YUV_TERMS(params->to_u, src0 + 3) +
+              YUV_TERMS(params->to_u, src1) + YUV_TERMS(params->to_u, src1 + 3)) >> 2;
+        vs = (YUV_TERMS(params->to_v, src0) + YUV_TERMS(params->to_v, src0 + 3) +
+              YUV_TERMS(params->to_v, src1) + YUV_TERMS(params->to_v, src1 + 3)) >> 2;
+        if (coding == DC1394_COLOR_CODING_NV12) {
+            u[i] = yuv_clip(us);
+            u[i+1] = yuv_clip(vs);
+        } else {
+            u[i/2] = yuv_clip(us);
+            v[i/2] = yuv_clip(vs);
+        }
+    }
+}
+
+#undef YUV_TERMS
+
+/**********************************************************************
+ *
+ *  CONVERSION OF RGB8 ROWS TO RGBA, BGRA, PLANAR RGB, NV12 AND I420
+ *
+ **********************************************************************/
+
+void
+rgb8_to_rgba_row(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, dc1394color_coding_t coding)
+{
+    const int r = (coding == DC1394_COLOR_CODING_BGRA8) ? 2 : 0;
+    int i;
+
+    for (i = 0; i < pixels; i++, src += 3, dest += 4) {
+        dest[r] = src[0];
+        dest[1] = src[1];
+        dest[2-r] = src[2];
+        dest[3] = 255;
+    }
+}
+
+void
+rgb8_to_planar_row(const uint8_t *restrict src, uint8_t *restrict r, uint8_t *restrict g, uint8_t *restrict b,
+                   int pixels)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++, src += 3) {
+        r[i] = src[0];
+        g[i] = src[1];
+        b[i] = src[2];
+    }
+}
+
+void
+rgb8_to_yuv420_rows(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                    uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                    dc1394color_coding_t coding)
+{
+    int i, y, u0, u1, u2, u3, v0, v1, v2, v3;
+
+    for (i = 0; i < pixels; i += 2, src0 += 6, src1 += 6) {
+        RGB2YUV (src0[0], src0[1], src0[2], y, u0, v0);
+        y0[i] = y;
+        RGB2YUV (src0[3], src0[4], src0[5], y, u1, v1);
+        y0[i+1] = y;
+        RGB2YUV (src1[0], src1[1], src1[2], y, u2, v2);
+        y1[i] = y;
+        RGB2YUV (src1[3], src1[4], src1[5], y, u3, v3);
+        y1[i+1] = y;
+        // the chroma of a 2x2 block is the average of its four pixels
+        if (coding == DC1394_COLOR_CODING_NV12) {
+            u[i] = (u0+u1+u2+u3) >> 2;
+            u[i+1] = (v0+v1+v2+v3) >> 2;
+        } else {
+            u[i/2] = (u0+u1+u2+u3) >> 2;
+            v[i/2] = (v0+v1+v2+v3) >> 2;
+        }
+    }
+}
+
+void
+yuv_to_yuv420_rows(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                   uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                   dc1394color_coding_t from, uint32_t byte_order, dc1394color_coding_t coding)
+{
+    // the bytes of the luma and of the chroma of the first pixel pair of YUV422 in each byte order
+    const int l = (byte_order == DC1394_BYTE_ORDER_YUYV) ? 0 : 1;
+    const int c = 1 - l;
+    const uint8_t *a, *b;
+    int i, k, us, vs;
+
+    for (i = 0; i < pixels; i += 2) {
+        switch (from) {
+        case DC1394_COLOR_CODING_YUV444:
+            a = src0 + 3 * i;
+            b = src1 + 3 * i;
+            y0[i] = a[1];
+            y0[i+1] = a[4];
+            y1[i] = b[1];
+            y1[i+1] = b[4];
+            us = (a[0] + a[3] + b[0] + b[3] + 2) >> 2;
+            vs = (a[2] + a[5] + b[2] + b[5] + 2) >> 2;
+            break;
+        case DC1394_COLOR_CODING_YUV411:
+            // the pair is the first or the second half of a UYYVYY group
+            a = src0 + 6 * (i / 4);
+            b = src1 + 6 * (i / 4);
+            k = (i & 2) ? 4 : 1;
+            y0[i] = a[k];
+            y0[i+1] = a[k+1];
+            y1[i] = b[k];
+            y1[i+1] = b[k+1];
+            us = (a[0] + b[0] + 1) >> 1;
+            vs = (a[3] + b[3] + 1) >> 1;
+            break;
+        default:
+            a = src0 + 2 * i;
+            b = src1 + 2 * i;
+            y0[i] = a[l];
+            y0[i+1] = a[l+2];
+            y1[i] = b[l];
+            y1[i+1] = b[l+2];
+            us = (a[c] + b[c] + 1) >> 1;
+            vs = (a[c+2] + b[c+2] + 1) >> 1;
+            break;
+        }
+        // the chroma of a 2x2 block is the rounded average of its four pixels
+        if (coding == DC1394_COLOR_CODING_NV12) {
+            u[i] = us;
+            u[i+1] = vs;
+        } else {
+            u[i/2] = us;
+            v[i/2] = vs;
+        }
+    }
+}
+
+/* the luma row y (even) of an NV12 or I420 image of height rows, and the chroma row of its 2x2 blocks */
+static void
+yuv420_planes(uint8_t *dest, dc1394color_coding_t coding, uint32_t height, size_t stride, uint32_t y,
+              uint8_t **l, uint8_t **u, uint8_t **v)
+{
+    // the chroma plane(s) follow the luma plane: interleaved U and V rows of the same stride for NV12,
+    // U then V with half the stride for I420
+    uint8_t *chroma = dest + height * stride;
+
+    *l = dest + y * stride;
+    if (coding == DC1394_COLOR_CODING_NV12) {
+        *u = chroma + (y / 2) * stride;
+        *v = NULL;
+    } else {
+        *u = chroma + (y / 2) * (stride / 2);
+        *v = chroma + ((height + 1) / 2) * (stride / 2) + (y / 2) * (stride / 2);
+    }
+}
+
+/*
+  Stores n rows of width RGB8 pixels as the rows y to y+n-1 of an image of
+  height rows of one of the codings made from RGB8 rows, at dest with rows
+  stride bytes apart. y and n are even for NV12 and I420, whose YUV has the
+  matrix and range of params if it is not NULL.
+ */
+void
+rgb8_rows_to_image(const uint8_t *rgb, uint8_t *dest, dc1394color_coding_t coding, uint32_t width,
+                   uint32_t height, size_t stride, uint32_t y, uint32_t n, const dc1394yuv_params_t *params)
+{
+    // the vector kernels leave the end of the rows to the scalar code
+    conversion_rgba_func_t rgba = conversion_simd_get_rgb8_to_rgba();
+    conversion_planar_func_t planar = conversion_simd_get_rgb8_to_planar();
+    conversion_yuv420_func_t yuv420 = conversion_simd_get_rgb8_to_yuv420();
+    const size_t row = (size_t)width * 3;
+    uint32_t i;
+
+    switch (coding) {
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+        for (i = 0; i < n; i++) {
+            if (rgba != NULL)
+                rgba(rgb + i * row, dest + (y + i) * stride, width, coding);
+            else
+                rgb8_to_rgba_row(rgb + i * row, dest + (y + i) * stride, width, coding);
+        }
+        break;
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+        // three planes of height rows
+        for (i = 0; i < n; i++) {
+            uint8_t *r = dest + (y + i) * stride;
+            if (planar != NULL)
+                planar(rgb + i * row, r, r + height * stride, r + 2 * height * stride, width);
+            else
+                rgb8_to_planar_row(rgb + i * row, r, r + height * stride, r + 2 * height * stride, width);
+        }
+        break;
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
+        for (i = 0; i < n; i += 2) {
+            uint8_t *l, *u, *v;
+            yuv420_planes(dest, coding, height, stride, y + i, &l, &u, &v);
+            if ((params != NULL) && !params->legacy)
+                yuv_params_to_yuv420(params, rgb + i * row, rgb + (i + 1) * row, l, l + stride, u, v, width, coding);
+            else if (yuv420 != NULL)
+                yuv420(rgb + i * row, rgb + (i + 1) * row, l, l + stride, u, v, width, coding);
+            else
+                rgb8_to_yuv420_rows(rgb + i * row, rgb + (i + 1) * row, l, l + stride, u, v, width, coding);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+  Converts the rows y to y+n-1 (y and n even) of the YUV411, YUV422 (in byte_order) or YUV444 pixels (from) of src,
+  whose rows are src_row bytes apart, to those of an NV12 or I420 image as rgb8_rows_to_image(). The samples are
+  kept: only the chroma is averaged, without going through RGB. YUV411 needs a width multiple of 4.
+ */
+static void
+yuv_rows_to_yuv420(const uint8_t *src, size_t src_row, dc1394color_coding_t from, uint32_t byte_order,
+                   uint8_t *dest, dc1394color_coding_t coding, uint32_t width, uint32_t height, size_t stride,
+                   uint32_t y, uint32_t n)
+{
+    // the vector kernels leave the end of the rows to the scalar code
+    conversion_yuv_to_yuv420_func_t simd = conversion_simd_get_yuv_to_yuv420(from);
+    const uint8_t *s;
+    uint8_t *l, *u, *v;
+    uint32_t i;
+
+    for (i = 0; i < n; i += 2) {
+        s = src + (size_t)(y + i) * src_row;
+        yuv420_planes(dest, coding, height, stride, y + i, &l, &u, &v);
+        if (simd != NULL)
+            simd(s, s + src_row, l, l + stride, u, v, width, byte_order, coding);
+        else
+            yuv_to_yuv420_rows(s, s + src_row, l, l + stride, u, v, width, from, byte_order, coding);
+    }
+}
+
+dc1394error_t
+dc1394_convert_to_YUV420(uint8_t *src, uint8_t *dest, uint32_t width, uint32_t height, uint32_t byte_order,
+                         dc1394color_coding_t source_coding, dc1394color_coding_t coding)
+{
+    size_t row;
+
+    if ((coding != DC1394_COLOR_CODING_NV12) && (coding != DC1394_COLOR_CODING_I420))
+        return DC1394_INVALID_COLOR_CODING;
+
+    // the 2x2 blocks, and the groups of 4 pixels of YUV411, must not straddle the rows
+    switch (source_coding) {
+    case DC1394_COLOR_CODING_YUV411:
+        if (width & 3)
+            return DC1394_FUNCTION_NOT_SUPPORTED;
+        row = (size_t)width * 3 / 2;
+        break;
+    case DC1394_COLOR_CODING_YUV422:
+        if ((byte_order != DC1394_BYTE_ORDER_YUYV) && (byte_order != DC1394_BYTE_ORDER_UYVY))
+            return DC1394_INVALID_BYTE_ORDER;
+        row = (size_t)width * 2;
+        break;
+    case DC1394_COLOR_CODING_YUV444:
+        row = (size_t)width * 3;
+        break;
+    default:
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    }
+    if ((width & 1) || (height & 1))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    yuv_rows_to_yuv420(src, row, source_coding, byte_order, dest, coding, width, height, width, 0, height);
+    return DC1394_SUCCESS;
+}
+
+void
+sensor_pick_row(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors)
+{
+    int i;
+
+    for (i = 0; i < pixels; i++, src += sensors)
+        dest[i] = *src;
+}
+
+/* the samples of one sensor of interleaved stereo data, with the vectorized code where there is some */
+static void
+sensor_pick(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors)
+{
+    sensor_pick_func_t pick = conversion_simd_get_sensor_pick();
+
+    if (pick != NULL)
+        pick(src, dest, pixels, sensors);
+    else
+        sensor_pick_row(src, dest, pixels, sensors);
+}
+
 // change a 16bit stereo image (8bit/channel) into two 8bit images on top
 // of each other
 dc1394error_t
 dc1394_deinterlace_stereo(uint8_t *restrict src, uint8_t *restrict dest, uint32_t width, uint32_t height)
 {
-    register int i = (width*height)-1;
-    register int j = ((width*height)>>1)-1;
-    register int k = (width*height)-1;
+    const uint32_t half = (width*height)>>1;
 
-    while (i >= 0) {
-        dest[k--] = src[i--];
-        dest[j--] = src[i--];
+    sensor_pick(src, dest, half, 2);
+    sensor_pick(src + 1, dest + half, half, 2);
+    return DC1394_SUCCESS;
+}
+
+
+/* samples in a group of a packing, and the bytes of the group */
+static void
+packing_group(dc1394packing_t packing, uint32_t *samples, uint32_t *bytes)
+{
+    if (packing == DC1394_PACKING_10BIT_MIPI) {
+        *samples = 4;
+        *bytes = 5;
+    } else {
+        *samples = 2;
+        *bytes = 3;
     }
+}
+
+uint32_t
+packed_row_bytes(uint32_t width, dc1394packing_t packing)
+{
+    uint32_t samples, bytes;
+
+    if ((packing<DC1394_PACKING_MIN)||(packing>DC1394_PACKING_MAX))
+        return 0;
+    packing_group(packing, &samples, &bytes);
+    if (width % samples)
+        return 0;
+    return width / samples * bytes;
+}
+
+void
+unpack_row(const uint8_t *restrict src, uint16_t *restrict dest, int pixels, dc1394packing_t packing)
+{
+    int i;
+
+    switch (packing) {
+    case DC1394_PACKING_12BIT:
+        for (i = 0; i < pixels; i += 2, src += 3) {
+            dest[i] = (src[0] << 4) | (src[1] & 0x0f);
+            dest[i+1] = (src[2] << 4) | (src[1] >> 4);
+        }
+        break;
+    case DC1394_PACKING_12BIT_MIPI:
+        for (i = 0; i < pixels; i += 2, src += 3) {
+            dest[i] = (src[0] << 4) | (src[2] & 0x0f);
+            dest[i+1] = (src[1] << 4) | (src[2] >> 4);
+        }
+        break;
+    case DC1394_PACKING_10BIT:
+        for (i = 0; i < pixels; i += 2, src += 3) {
+            dest[i] = (src[0] << 2) | (src[1] & 0x03);
+            dest[i+1] = (src[2] << 2) | ((src[1] >> 4) & 0x03);
+        }
+        break;
+    case DC1394_PACKING_10BIT_MIPI:
+        for (i = 0; i < pixels; i += 4, src += 5) {
+            dest[i] = (src[0] << 2) | (src[4] & 0x03);
+            dest[i+1] = (src[1] << 2) | ((src[4] >> 2) & 0x03);
+            dest[i+2] = (src[2] << 2) | ((src[4] >> 4) & 0x03);
+            dest[i+3] = (src[3] << 2) | (src[4] >> 6);
+        }
+        break;
+    }
+}
+
+dc1394error_t
+dc1394_packed_to_MONO16(const uint8_t *restrict src, uint16_t *restrict dest, uint32_t width, uint32_t height,
+                        dc1394packing_t packing)
+{
+    unpack_func_t unpack = conversion_simd_get_unpack();
+
+    if (packed_row_bytes(width, packing) == 0)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    // the rows are not padded: the image is one long row
+    if (unpack != NULL)
+        unpack(src, dest, width * height, packing);
+    else
+        unpack_row(src, dest, width * height, packing);
+
+    return DC1394_SUCCESS;
+}
+
+/**********************************************************************
+ *
+ *  16-BIT SAMPLES TO 8 BITS
+ *
+ **********************************************************************/
+
+dc1394error_t
+dc1394_convert_16bit_to_8bit(const uint8_t *restrict src, uint8_t *restrict dest, uint32_t samples, uint32_t bits,
+                             dc1394bool_t little_endian, const uint8_t *lut)
+{
+    const uint32_t mask = (1 << bits) - 1;
+    const int msb = little_endian ? 1 : 0;
+    uint32_t i = 0;
+
+    if ((bits < 8) || (bits > 16))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    if (lut == NULL) {
+        depth16_to_8(src, dest, samples, bits, little_endian);
+        return DC1394_SUCCESS;
+    }
+
+    // a table of 1 << bits entries fits in the cache, so the indices cost more
+    // than the look-ups: on little endian CPUs they are taken four at a time
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    for (; i + 4 <= samples; i += 4, src += 8) {
+        uint64_t q;
+        memcpy(&q, src, 8);
+        if (!little_endian)
+            q = ((q & 0x00ff00ff00ff00ffULL) << 8) | ((q >> 8) & 0x00ff00ff00ff00ffULL);
+        dest[i] = lut[q & mask];
+        dest[i+1] = lut[(q >> 16) & mask];
+        dest[i+2] = lut[(q >> 32) & mask];
+        dest[i+3] = lut[(q >> 48) & mask];
+    }
+#endif
+    for (; i < samples; i++, src += 2)
+        dest[i] = lut[((src[msb] << 8) | src[1-msb]) & mask];
+
     return DC1394_SUCCESS;
 }
 
+dc1394error_t
+dc1394_tone_curve(uint8_t *lut, uint32_t bits, dc1394tone_curve_t curve, double parameter)
+{
+    const uint32_t entries = 1 << bits;
+    const double max = entries - 1;
+    double x;
+    uint32_t i;
+
+    if ((bits < 8) || (bits > 16))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    if ((curve != DC1394_TONE_CURVE_LINEAR) && !(parameter > 0))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    for (i = 0; i < entries; i++) {
+        x = i / max;
+        switch (curve) {
+        case DC1394_TONE_CURVE_LINEAR:
+            lut[i] = i >> (bits-8);
+            break;
+        case DC1394_TONE_CURVE_GAMMA:
+            lut[i] = (uint8_t)(255 * pow(x, 1 / parameter) + 0.5);
+            break;
+        case DC1394_TONE_CURVE_LOG:
+            lut[i] = (uint8_t)(255 * log1p(parameter * x) / log1p(parameter) + 0.5);
+            break;
+        default:
+            return DC1394_INVALID_ARGUMENT_VALUE;
+        }
+    }
+
+    return DC1394_SUCCESS;
+}
 
 dc1394error_t
 dc1394_convert_to_YUV422(uint8_t *src, uint8_t *dest, uint32_t width, uint32_t height, uint32_t byte_order,
@@ -648,10 +1357,80 @@ dc1394_convert_to_RGB8(uint8_t *restrict src, uint8_t *restrict dest, uint32_t w
     return DC1394_SUCCESS;
 }
 
+/* the bytes of the pixels of one row of frame, without padding */
+uint32_t
+frame_packed_row(const dc1394video_frame_t *frame)
+{
+    uint32_t bpp;
+
+    // the planar codings have one byte per pixel in the rows of their first plane
+    switch (frame->color_coding) {
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
+        return frame->size[0];
+    default:
+        break;
+    }
+    if (dc1394_get_color_coding_bit_size(frame->color_coding, &bpp) != DC1394_SUCCESS)
+        return 0;
+    return (frame->size[0]*bpp)/8;
+}
+
+/* the bytes of the image of frame with rows 'row' bytes apart, all its planes included */
+static uint32_t
+frame_image_bytes(const dc1394video_frame_t *frame, uint32_t row)
+{
+    const uint32_t height = frame->size[1];
+
+    switch (frame->color_coding) {
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+        return 3*height*row;
+    case DC1394_COLOR_CODING_NV12:
+        return height*row + ((height+1)/2)*row;
+    case DC1394_COLOR_CODING_I420:
+        return height*row + 2*((height+1)/2)*(row/2);
+    default:
+        return height*row;
+    }
+}
+
+/*
+  The bytes from one row of frame to the next: its stride, or the packed row
+  if the stride is 0. Returns 0 if the stride can't hold a row.
+ */
+uint32_t
+frame_row_bytes(const dc1394video_frame_t *frame)
+{
+    uint32_t packed = frame_packed_row(frame);
+
+    if (frame->stride == 0)
+        return packed;
+    return frame->stride >= packed ? frame->stride : 0;
+}
+
+/*
+  Output frames are often copies of the input frame with another color
+  coding, whose stride is the row of the input. The stride of out is thus
+  only kept if out->image is a buffer of the caller that holds the image with
+  it and the padding bytes: the rows are then written there. Otherwise the
+  rows are packed, and the stride is set to the packed row.
+ */
+void
+frame_output_stride(dc1394video_frame_t *out)
+{
+    uint32_t packed = frame_packed_row(out);
+
+    if ((out->stride >= packed) && (out->image != NULL) &&
+        ((uint64_t)frame_image_bytes(out, out->stride) + out->padding_bytes <= out->allocated_image_bytes))
+        return;
+    out->stride = packed;
+}
+
 dc1394error_t
 Adapt_buffer_convert(dc1394video_frame_t *in, dc1394video_frame_t *out)
 {
-    uint32_t bpp;
+    uint32_t row;
 
     // conversions don't change the size of buffers or its position
     out->size[0]=in->size[0];
@@ -671,18 +1450,20 @@ Adapt_buffer_convert(dc1394video_frame_t *in, dc1394video_frame_t *out)
     // we always convert to 8bits (at this point) we can safely set this value to 8.
     out->data_depth=8;
 
-    // don't know what to do with stride... >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    // out->stride=??
-
     // the video mode should not change. Color coding and other stuff can be accessed in specific fields of this struct
     out->video_mode = in->video_mode;
 
     // padding is kept:
     out->padding_bytes = in->padding_bytes;
 
-    // image bytes changes:    >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    dc1394_get_color_coding_bit_size(out->color_coding, &bpp);
-    out->image_bytes=(out->size[0]*out->size[1]*bpp)/8;
+    // the stride of out is the caller's if its buffer holds the padded rows, else rows are packed
+    frame_output_stride(out);
+
+    // image bytes changes, with the stride of out and its planes. The stride of in must hold a row.
+    row = frame_row_bytes(out);
+    if ((row == 0) || (frame_row_bytes(in) == 0))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    out->image_bytes=frame_image_bytes(out, row);
 
     // total is image_bytes + padding_bytes
     out->total_bytes = out->image_bytes + out->padding_bytes;
@@ -697,15 +1478,8 @@ Adapt_buffer_convert(dc1394video_frame_t *in, dc1394video_frame_t *out)
     out->camera = in->camera;
     out->id = in->id;
 
-    // verify memory allocation:
-    if (out->total_bytes>out->allocated_image_bytes) {
-        free(out->image);
-        out->image=(uint8_t*)malloc(out->total_bytes*sizeof(uint8_t));
-        if (out->image)
-            out->allocated_image_bytes = out->total_bytes*sizeof(uint8_t);
-        else
-            out->allocated_image_bytes = 0;
-    }
+    // verify memory allocation. A buffer of the caller that is large enough is kept.
+    frame_image_reserve(out);
 
     // Copy padding bytes:
     if(out->image)
@@ -720,71 +1494,140 @@ Adapt_buffer_convert(dc1394video_frame_t *in, dc1394video_frame_t *out)
     return DC1394_MEMORY_ALLOCATION_FAILURE;
 }
 
-dc1394error_t
-dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out)
+/* whether dc1394_convert_frames() converts from to to */
+static int
+convert_supported(dc1394color_coding_t from, dc1394color_coding_t to)
 {
+    switch (to) {
+    case DC1394_COLOR_CODING_YUV422:
+    case DC1394_COLOR_CODING_RGB8:
+        switch (from) {
+        case DC1394_COLOR_CODING_YUV422:
+        case DC1394_COLOR_CODING_YUV411:
+        case DC1394_COLOR_CODING_YUV444:
+        case DC1394_COLOR_CODING_RGB8:
+        case DC1394_COLOR_CODING_MONO8:
+        case DC1394_COLOR_CODING_RAW8:
+        case DC1394_COLOR_CODING_MONO16:
+        case DC1394_COLOR_CODING_RAW16:
+        case DC1394_COLOR_CODING_RGB16:
+            return 1;
+        default:
+            return 0;
+        }
+    case DC1394_COLOR_CODING_MONO8:
+        return (from == DC1394_COLOR_CODING_MONO16) || (from == DC1394_COLOR_CODING_MONO8);
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
+        // made from RGB8 rows
+        return convert_supported(from, DC1394_COLOR_CODING_RGB8);
+    default:
+        return 0;
+    }
+}
+
+/*
+  The bytes of a row of in that convert_rows() swaps before converting it to
+  out: those of little endian 16-bit samples, but for the reductions to 8
+  bits, which read both byte orders. 0 if nothing is swapped.
+ */
+static size_t
+convert_swap_row(const dc1394video_frame_t *in, const dc1394video_frame_t *out)
+{
+    if (!in->little_endian)
+        return 0;
+
+    switch (in->color_coding) {
+    case DC1394_COLOR_CODING_MONO16:
+        return (out->color_coding == DC1394_COLOR_CODING_MONO8) ? 0 : (size_t)in->size[0] * 2;
+    case DC1394_COLOR_CODING_RAW16:
+        return (size_t)in->size[0] * 2;
+    case DC1394_COLOR_CODING_RGB16:
+        return (out->color_coding == DC1394_COLOR_CODING_RGB8) ? 0 : (size_t)in->size[0] * 6;
+    default:
+        return 0;
+    }
+}
+
+/*
+  Converts rows of packed pixels from src to dest, with the color codings of in and out. The conversions between
+  RGB and YUV use the look-up tables of params, unless it is NULL or has those of the macros. swap holds the
+  convert_swap_row() bytes of each row, if that is not 0, so that the callers allocate it once for many calls.
+ */
+static dc1394error_t
+convert_rows(dc1394video_frame_t *in, dc1394video_frame_t *out, uint8_t *src, uint8_t *dest, uint32_t rows,
+             const dc1394yuv_params_t *params, uint8_t *swap)
+{
+    const uint32_t width = in->size[0];
+    const size_t swap_row = convert_swap_row(in, out);
+    dc1394video_frame_t big_endian;
+    dc1394error_t err;
+
+    if ((params != NULL) && params->legacy)
+        params = NULL;
+
+    // the reductions to 8 bits read both byte orders. For the other conversions,
+    // little endian samples are swapped first.
+    if (swap_row != 0) {
+        swab(src, swap, swap_row * rows);
+        big_endian = *in;
+        big_endian.little_endian = DC1394_FALSE;
+        return convert_rows(&big_endian, out, swap, dest, rows, params, NULL);
+    }
+    if (in->little_endian) {
+        if ((out->color_coding == DC1394_COLOR_CODING_MONO8) && (in->color_coding == DC1394_COLOR_CODING_MONO16)) {
+            depth16_to_8(src, dest, width*rows, in->data_depth, 1);
+            return DC1394_SUCCESS;
+        }
+        if ((out->color_coding == DC1394_COLOR_CODING_RGB8) && (in->color_coding == DC1394_COLOR_CODING_RGB16)) {
+            depth16_to_8(src, dest, width*rows*3, in->data_depth, 1);
+            return DC1394_SUCCESS;
+        }
+    }
 
     switch(out->color_coding) {
     case DC1394_COLOR_CODING_YUV422:
+        if (params != NULL) {
+            switch(in->color_coding) {
+            case DC1394_COLOR_CODING_RGB8:
+                return yuv_params_to_yuv422(params, src, dest, width*rows, out->yuv_byte_order, 8);
+            case DC1394_COLOR_CODING_RGB16:
+                return yuv_params_to_yuv422(params, src, dest, width*rows, out->yuv_byte_order, in->data_depth);
+            case DC1394_COLOR_CODING_MONO8:
+            case DC1394_COLOR_CODING_RAW8:
+            case DC1394_COLOR_CODING_MONO16:
+            case DC1394_COLOR_CODING_RAW16:
+                // the gray levels are converted as usual, then moved to the range
+                params = (params->range == DC1394_YUV_RANGE_FULL) ? NULL : params;
+                err = convert_rows(in, out, src, dest, rows, NULL, swap);
+                if ((err == DC1394_SUCCESS) && (params != NULL))
+                    yuv_params_gray_to_yuv422(params, dest, (size_t)((width + 1) & ~1) * 2 * rows,
+                                              out->yuv_byte_order);
+                return err;
+            default:
+                break;
+            }
+        }
         switch(in->color_coding) {
         case DC1394_COLOR_CODING_YUV422:
-            
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV422_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order);
-            break;
-            
+            return dc1394_YUV422_to_YUV422(src, dest, width, rows, out->yuv_byte_order);
         case DC1394_COLOR_CODING_YUV411:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV411_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order);
-            break;
-            
+            return dc1394_YUV411_to_YUV422(src, dest, width, rows, out->yuv_byte_order);
         case DC1394_COLOR_CODING_YUV444:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV444_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order);
-            break;
-            
+            return dc1394_YUV444_to_YUV422(src, dest, width, rows, out->yuv_byte_order);
         case DC1394_COLOR_CODING_RGB8:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_RGB8_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order);
-            break;
-            
+            return dc1394_RGB8_to_YUV422(src, dest, width, rows, out->yuv_byte_order);
         case DC1394_COLOR_CODING_MONO8:
         case DC1394_COLOR_CODING_RAW8:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_MONO8_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order);
-            break;
-            
+            return dc1394_MONO8_to_YUV422(src, dest, width, rows, out->yuv_byte_order);
         case DC1394_COLOR_CODING_MONO16:
         case DC1394_COLOR_CODING_RAW16:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_MONO16_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order, in->data_depth);
-            break;
-            
+            return dc1394_MONO16_to_YUV422(src, dest, width, rows, out->yuv_byte_order, in->data_depth);
         case DC1394_COLOR_CODING_RGB16:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_RGB16_to_YUV422(in->image, out->image, in->size[0], in->size[1], out->yuv_byte_order, in->data_depth);
-            break;
-            
+            return dc1394_RGB16_to_YUV422(src, dest, width, rows, out->yuv_byte_order, in->data_depth);
         default:
             return DC1394_FUNCTION_NOT_SUPPORTED;
         }
@@ -792,85 +1635,37 @@ dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out)
     case DC1394_COLOR_CODING_MONO8:
         switch(in->color_coding) {
         case DC1394_COLOR_CODING_MONO16:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_MONO16_to_MONO8(in->image, out->image, in->size[0], in->size[1], in->data_depth);
-            break;
-            
+            return dc1394_MONO16_to_MONO8(src, dest, width, rows, in->data_depth);
         case DC1394_COLOR_CODING_MONO8:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            memcpy(out->image, in->image, in->size[0]*in->size[1]);
+            memcpy(dest, src, width*rows);
             break;
-            
         default:
             return DC1394_FUNCTION_NOT_SUPPORTED;
         }
         break;
     case DC1394_COLOR_CODING_RGB8:
+        if ((params != NULL) && ((in->color_coding == DC1394_COLOR_CODING_YUV444) ||
+                                 (in->color_coding == DC1394_COLOR_CODING_YUV422) ||
+                                 (in->color_coding == DC1394_COLOR_CODING_YUV411)))
+            return yuv_params_to_rgb8(params, src, dest, width*rows, in->color_coding, in->yuv_byte_order);
         switch(in->color_coding) {
         case DC1394_COLOR_CODING_RGB16:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_RGB16_to_RGB8 (in->image, out->image, in->size[0], in->size[1], in->data_depth);
-            break;
-            
+            return dc1394_RGB16_to_RGB8 (src, dest, width, rows, in->data_depth);
         case DC1394_COLOR_CODING_YUV444:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV444_to_RGB8 (in->image, out->image, in->size[0], in->size[1]);
-            break;
-            
+            return dc1394_YUV444_to_RGB8 (src, dest, width, rows);
         case DC1394_COLOR_CODING_YUV422:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV422_to_RGB8 (in->image, out->image, in->size[0], in->size[1], in->yuv_byte_order);
-            break;
-            
+            return dc1394_YUV422_to_RGB8 (src, dest, width, rows, in->yuv_byte_order);
         case DC1394_COLOR_CODING_YUV411:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_YUV411_to_RGB8 (in->image, out->image, in->size[0], in->size[1]);
-            break;
-            
+            return dc1394_YUV411_to_RGB8 (src, dest, width, rows);
         case DC1394_COLOR_CODING_MONO8:
         case DC1394_COLOR_CODING_RAW8:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_MONO8_to_RGB8 (in->image, out->image, in->size[0], in->size[1]);
-            break;
-            
+            return dc1394_MONO8_to_RGB8 (src, dest, width, rows);
         case DC1394_COLOR_CODING_MONO16:
         case DC1394_COLOR_CODING_RAW16:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            return dc1394_MONO16_to_RGB8 (in->image, out->image, in->size[0], in->size[1],in->data_depth);
-            break;
-            
+            return dc1394_MONO16_to_RGB8 (src, dest, width, rows, in->data_depth);
         case DC1394_COLOR_CODING_RGB8:
-
-            if(DC1394_SUCCESS != Adapt_buffer_convert(in,out))
-                return DC1394_MEMORY_ALLOCATION_FAILURE;
-                
-            memcpy(out->image, in->image, in->size[0]*in->size[1]*3);
+            memcpy(dest, src, width*rows*3);
             break;
-            
         default:
             return DC1394_FUNCTION_NOT_SUPPORTED;
         }
@@ -882,11 +1677,267 @@ dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out)
     return DC1394_SUCCESS;
 }
 
+/* bytes of RGB8 rows converted at a time to the codings made from them: they stay in the cache */
+#define CONVERT_CHUNK_BYTES (1 << 16)
+
+/*
+  Converts the rows y0 to y1-1 of in to one of the codings made from RGB8
+  rows. The rows of the other codings are first converted to RGB8 a few at a
+  time, so that the RGB8 image is never written to memory.
+ */
+static dc1394error_t
+convert_from_rgb8_rows(dc1394video_frame_t *in, dc1394video_frame_t *out, const dc1394yuv_params_t *params,
+                       uint32_t y0, uint32_t y1)
+{
+    const uint32_t width = in->size[0];
+    const uint32_t height = in->size[1];
+    const uint32_t in_row = frame_row_bytes(in);
+    const uint32_t out_row = frame_row_bytes(out);
+    dc1394video_frame_t rgb;
+    dc1394error_t err = DC1394_SUCCESS;
+    uint32_t chunk, y, n, i;
+    size_t swap_row;
+    uint8_t *buffer, *swap;
+
+    if ((in->color_coding == DC1394_COLOR_CODING_RGB8) && (in_row == width*3)) {
+        rgb8_rows_to_image(in->image + (size_t)y0*in_row, out->image, out->color_coding, width, height, out_row,
+                           y0, y1 - y0, params);
+        return DC1394_SUCCESS;
+    }
+
+    chunk = CONVERT_CHUNK_BYTES / (width*3);
+    chunk = (chunk < 2) ? 2 : chunk & ~1;
+    if (chunk > y1 - y0)
+        chunk = y1 - y0;
+    rgb = *in;
+    rgb.color_coding = DC1394_COLOR_CODING_RGB8;
+    // the RGB8 rows are followed by those swapped by convert_rows()
+    swap_row = convert_swap_row(in, &rgb);
+    buffer = (uint8_t*)malloc((size_t)chunk*(width*3 + swap_row));
+    if (buffer == NULL)
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    swap = buffer + (size_t)chunk*width*3;
+
+    for (y = y0; (y < y1) && (err == DC1394_SUCCESS); y += n) {
+        n = (y1 - y < chunk) ? y1 - y : chunk;
+        if (in_row == frame_packed_row(in))
+            err = convert_rows(in, &rgb, in->image + (size_t)y*in_row, buffer, n, params, swap);
+        else
+            for (i = 0; (i < n) && (err == DC1394_SUCCESS); i++)
+                err = convert_rows(in, &rgb, in->image + (size_t)(y+i)*in_row, buffer + (size_t)i*width*3, 1,
+                                   params, swap);
+        if (err == DC1394_SUCCESS)
+            rgb8_rows_to_image(buffer, out->image, out->color_coding, width, height, out_row, y, n, params);
+    }
+
+    free(buffer);
+    return err;
+}
+
+/* converts the rows y0 to y1-1 of in to out, whose buffer is ready */
+static dc1394error_t
+convert_frame_rows(dc1394video_frame_t *in, dc1394video_frame_t *out, const dc1394yuv_params_t *params,
+                   uint32_t y0, uint32_t y1)
+{
+    const uint32_t in_row = frame_row_bytes(in);
+    const uint32_t out_row = frame_row_bytes(out);
+    dc1394error_t err = DC1394_SUCCESS;
+    dc1394bool_t packed;
+    uint32_t chunk, y, n;
+    size_t swap_row;
+    uint8_t *swap;
+
+    // YUV to NV12 and I420 keeps the samples, as between the other YUV codings
+    if (((out->color_coding == DC1394_COLOR_CODING_NV12) || (out->color_coding == DC1394_COLOR_CODING_I420)) &&
+        ((in->color_coding == DC1394_COLOR_CODING_YUV422) || (in->color_coding == DC1394_COLOR_CODING_YUV444) ||
+         ((in->color_coding == DC1394_COLOR_CODING_YUV411) && ((in->size[0] & 3) == 0)))) {
+        if ((in->color_coding == DC1394_COLOR_CODING_YUV422) &&
+            (in->yuv_byte_order != DC1394_BYTE_ORDER_YUYV) && (in->yuv_byte_order != DC1394_BYTE_ORDER_UYVY))
+            return DC1394_INVALID_BYTE_ORDER;
+        yuv_rows_to_yuv420(in->image, in_row, in->color_coding, in->yuv_byte_order, out->image, out->color_coding,
+                           in->size[0], in->size[1], out_row, y0, y1 - y0);
+        return DC1394_SUCCESS;
+    }
+
+    if (out->color_coding >= DC1394_COLOR_CODING_CONVERTED_MIN)
+        return convert_from_rgb8_rows(in, out, params, y0, y1);
+
+    // packed frames are converted at once, padded ones row by row
+    packed = (in_row == frame_packed_row(in)) && (out_row == frame_packed_row(out));
+    swap_row = convert_swap_row(in, out);
+    if (packed && (swap_row == 0))
+        return convert_rows(in, out, in->image + (size_t)y0*in_row, out->image + (size_t)y0*out_row, y1 - y0,
+                            params, NULL);
+
+    // ...but for the swap buffer of convert_rows(), allocated once for the
+    // band, packed frames go by an even number of rows that stay in the cache
+    chunk = 1;
+    if (packed) {
+        chunk = CONVERT_CHUNK_BYTES / swap_row;
+        chunk = (chunk < 2) ? 2 : chunk & ~1;
+    }
+    if (chunk > y1 - y0)
+        chunk = y1 - y0;
+    swap = NULL;
+    if ((swap_row != 0) && (chunk != 0)) {
+        swap = (uint8_t*)malloc((size_t)chunk*swap_row);
+        if (swap == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    for (y = y0; (y < y1) && (err == DC1394_SUCCESS); y += n) {
+        n = (y1 - y < chunk) ? y1 - y : chunk;
+        err = convert_rows(in, out, in->image + (size_t)y*in_row, out->image + (size_t)y*out_row, n, params, swap);
+    }
+
+    free(swap);
+    return err;
+}
+
+/*
+  Bytes read and written by a band at the least. Below this, waking up the
+  threads of the pool costs more than they save, so that smaller frames are
+  converted by the calling thread alone.
+ */
+#define CONVERT_BAND_MIN_BYTES (1 << 20)
+
+/*
+  Converts the rows y0 to y1-1 of in to out as convert_frame_rows(), and counts them in the statistics of band
+  if stats is not NULL: the rows are then converted a chunk at a time, and counted while they are in the cache.
+ */
+static dc1394error_t
+convert_band_rows(dc1394video_frame_t *in, dc1394video_frame_t *out, const dc1394yuv_params_t *params,
+                  dc1394frame_stats_t *stats, int band, uint32_t y0, uint32_t y1)
+{
+    const uint32_t out_row = frame_row_bytes(out);
+    dc1394error_t err;
+    uint32_t chunk, y, n;
+
+    if (stats == NULL)
+        return convert_frame_rows(in, out, params, y0, y1);
+
+    // even chunks, for the 2x2 blocks of NV12 and I420
+    chunk = CONVERT_CHUNK_BYTES / out_row;
+    chunk = (chunk < 2) ? 2 : chunk & ~1;
+    for (y = y0; y < y1; y += n) {
+        n = (y1 - y < chunk) ? y1 - y : chunk;
+        err = convert_frame_rows(in, out, params, y, y + n);
+        if (err != DC1394_SUCCESS)
+            return err;
+        stats_rows(stats, band, out->image, out->size[0], out->size[1], out_row, y, n);
+    }
+
+    return DC1394_SUCCESS;
+}
+
+typedef struct {
+    dc1394video_frame_t *in;
+    dc1394video_frame_t *out;
+    const dc1394yuv_params_t *params;
+    dc1394frame_stats_t *stats;
+    uint32_t band_rows;
+    dc1394error_t err[THREAD_POOL_MAX_THREADS];
+} convert_bands_t;
+
+static void
+convert_band_task(void *arg, int band)
+{
+    convert_bands_t *b = (convert_bands_t*)arg;
+    uint32_t y0 = band * b->band_rows;
+    uint32_t y1 = y0 + b->band_rows;
+
+    if (y1 > b->in->size[1])
+        y1 = b->in->size[1];
+    b->err[band] = convert_band_rows(b->in, b->out, b->params, b->stats, band, y0, y1);
+}
+
+dc1394error_t
+dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out)
+{
+    return dc1394_convert_frames_parallel(NULL, NULL, in, out);
+}
+
+dc1394error_t
+dc1394_convert_frames_yuv(dc1394yuv_params_t *params, dc1394video_frame_t *in, dc1394video_frame_t *out)
+{
+    return dc1394_convert_frames_parallel(NULL, params, in, out);
+}
+
+dc1394error_t
+dc1394_convert_frames_parallel(dc1394debayer_context_t *ctx, dc1394yuv_params_t *params, dc1394video_frame_t *in,
+                               dc1394video_frame_t *out)
+{
+    convert_bands_t b;
+    dc1394frame_stats_t *stats;
+    uint64_t bytes;
+    uint32_t height;
+    dc1394error_t err;
+    int bands, i;
+
+    if (!convert_supported(in->color_coding, out->color_coding))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    err = Adapt_buffer_convert(in,out);
+    if (err != DC1394_SUCCESS)
+        return err;
+
+    // NV12 and I420 share the chroma of 2x2 blocks
+    height = in->size[1];
+    if (((out->color_coding == DC1394_COLOR_CODING_NV12) || (out->color_coding == DC1394_COLOR_CODING_I420)) &&
+        ((in->size[0] & 1) || (height & 1)))
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+
+    bands = 1;
+    stats = NULL;
+    if (ctx != NULL) {
+        bytes = (uint64_t)(frame_row_bytes(in) + frame_row_bytes(out)) * height;
+        bands = debayer_context_threads(ctx);
+        if ((uint64_t)bands > bytes / CONVERT_BAND_MIN_BYTES)
+            bands = bytes / CONVERT_BAND_MIN_BYTES;
+        stats = debayer_context_stats(ctx);
+    }
+    if ((bands <= 1) && (stats == NULL))
+        return convert_frame_rows(in, out, params, 0, height);
+
+    b.in = in;
+    b.out = out;
+    b.params = params;
+    b.stats = stats;
+    b.band_rows = height;
+    if (bands > 1) {
+        // the bands start on even rows, for the 2x2 blocks of NV12 and I420
+        b.band_rows = (height + bands - 1) / bands;
+        b.band_rows += b.band_rows & 1;
+        bands = (height + b.band_rows - 1) / b.band_rows;
+    } else {
+        bands = 1;
+    }
+
+    // the conversions output 8-bit samples
+    if (stats != NULL) {
+        err = stats_prepare(stats, out->color_coding, out->yuv_byte_order, 8, bands);
+        if (err != DC1394_SUCCESS)
+            return err;
+    }
+
+    if (bands <= 1)
+        b.err[0] = convert_band_rows(in, out, params, stats, 0, 0, height);
+    else
+        thread_pool_run(bands, bands, convert_band_task, &b);
+
+    for (i = 0; i < bands; i++)
+        if (b.err[i] != DC1394_SUCCESS)
+            return b.err[i];
+
+    if (stats != NULL)
+        stats_merge(stats);
+    return DC1394_SUCCESS;
+}
 
 dc1394error_t
 Adapt_buffer_stereo(dc1394video_frame_t *in, dc1394video_frame_t *out)
 {
-    uint32_t bpp;
+    uint32_t row;
 
     // buffer position is not changed. Size is boubled in Y
     out->size[0]=in->size[0];
@@ -917,18 +1968,20 @@ Adapt_buffer_stereo(dc1394video_frame_t *in, dc1394video_frame_t *out)
     // we always convert to 8bits (at this point) we can safely set this value to 8.
     out->data_depth=8;
 
-    // don't know what to do with stride... >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    // out->stride=??
-
     // the video mode should not change. Color coding and other stuff can be accessed in specific fields of this struct
     out->video_mode = in->video_mode;
 
     // padding is kept:
     out->padding_bytes = in->padding_bytes;
 
-    // image bytes changes:    >>>> TODO: STRIDE SHOULD BE TAKEN INTO ACCOUNT... <<<<
-    dc1394_get_color_coding_bit_size(out->color_coding, &bpp);
-    out->image_bytes=(out->size[0]*out->size[1]*bpp)/8;
+    // the stride of out is the caller's if its buffer holds the padded rows, else rows are packed
+    frame_output_stride(out);
+
+    // image bytes changes, with the stride of out. The stride of in must hold a row.
+    row = frame_row_bytes(out);
+    if ((row == 0) || (frame_row_bytes(in) == 0))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    out->image_bytes=out->size[1]*row;
 
     // total is image_bytes + padding_bytes
     out->total_bytes = out->image_bytes + out->padding_bytes;
@@ -943,15 +1996,8 @@ Adapt_buffer_stereo(dc1394video_frame_t *in, dc1394video_frame_t *out)
     out->camera = in->camera;
     out->id = in->id;
 
-    // verify memory allocation:
-    if (out->total_bytes>out->allocated_image_bytes) {
-        free(out->image);
-        out->image=(uint8_t*)malloc(out->total_bytes*sizeof(uint8_t));
-        if (out->image)
-            out->allocated_image_bytes = out->total_bytes*sizeof(uint8_t);
-        else
-            out->allocated_image_bytes = 0;
-    }
+    // verify memory allocation. A buffer of the caller that is large enough is kept.
+    frame_image_reserve(out);
 
     // Copy padding bytes:
     if(out->image)
@@ -971,6 +2017,8 @@ dc1394error_t
 dc1394_deinterlace_stereo_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394stereo_method_t method)
 {
     dc1394error_t err;
+    uint32_t in_row, out_row, width, y;
+    uint8_t *src;
 
     if ((in->color_coding==DC1394_COLOR_CODING_RAW16)||
         (in->color_coding==DC1394_COLOR_CODING_MONO16)||
@@ -980,16 +2028,38 @@ dc1394_deinterlace_stereo_frames(dc1394video_frame_t *in, dc1394video_frame_t *o
             err=Adapt_buffer_stereo(in,out);
             if(err != DC1394_SUCCESS)
                 return err;
-                
-            return dc1394_deinterlace_stereo(in->image, out->image, out->size[0], out->size[1]);
+
+            in_row = frame_row_bytes(in);
+            out_row = frame_row_bytes(out);
+            if ((in_row == frame_packed_row(in)) && (out_row == frame_packed_row(out)))
+                return dc1394_deinterlace_stereo(in->image, out->image, out->size[0], out->size[1]);
+
+            // the images go to the top and bottom halves, a row of each from every input row
+            width = out->size[0];
+            for (y = 0; y < in->size[1]; y++) {
+                src = in->image + (size_t)y*in_row;
+                sensor_pick(src, out->image + (size_t)y*out_row, width, 2);
+                sensor_pick(src + 1, out->image + (size_t)(y+in->size[1])*out_row, width, 2);
+            }
+            return DC1394_SUCCESS;
             break;
             
         case DC1394_STEREO_METHOD_FIELD:
             err=Adapt_buffer_stereo(in,out);
             if (err != DC1394_SUCCESS)
                 return err;
-                
-            memcpy(out->image,in->image,out->image_bytes);
+
+            in_row = frame_row_bytes(in);
+            out_row = frame_row_bytes(out);
+            if ((in_row == frame_packed_row(in)) && (out_row == frame_packed_row(out))) {
+                memcpy(out->image,in->image,out->image_bytes);
+                return DC1394_SUCCESS;
+            }
+
+            // each input row holds two output rows
+            width = out->size[0];
+            for (y = 0; y < out->size[1]; y++)
+                memcpy(out->image + (size_t)y*out_row, in->image + (size_t)(y/2)*in_row + (y%2)*width, width);
 	    return DC1394_SUCCESS;
             break;
         default:
@@ -1000,3 +2070,148 @@ dc1394_deinterlace_stereo_frames(dc1394video_frame_t *in, dc1394video_frame_t *o
     else
         return DC1394_FUNCTION_NOT_SUPPORTED;
 }
+
+/* the sensors of a stereo frame, one per byte of its pixels, or 0 if its coding can't hold them */
+int
+stereo_frame_sensors(const dc1394video_frame_t *frame)
+{
+    switch (frame->color_coding) {
+    case DC1394_COLOR_CODING_MONO16:
+    case DC1394_COLOR_CODING_RAW16:
+    case DC1394_COLOR_CODING_YUV422:
+        return 2;
+    case DC1394_COLOR_CODING_RGB8:
+        return 3;
+    case DC1394_COLOR_CODING_RGB16:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+/*
+  The frame of one sensor of a stereo frame, which keeps its image: of its
+  size, with 8-bit samples in packed rows, RAW8 for RAW16 or for the other
+  codings when they have a color filter, MONO8 otherwise.
+ */
+void
+stereo_sensor_frame(const dc1394video_frame_t *in, dc1394video_frame_t *sensor)
+{
+    *sensor = *in;
+    if ((in->color_coding == DC1394_COLOR_CODING_RAW16) ||
+        ((in->color_coding != DC1394_COLOR_CODING_MONO16) && (in->color_coding != DC1394_COLOR_CODING_YUV422) &&
+         (in->color_filter >= DC1394_COLOR_FILTER_MIN) && (in->color_filter <= DC1394_COLOR_FILTER_MAX)))
+        sensor->color_coding = DC1394_COLOR_CODING_RAW8;
+    else
+        sensor->color_coding = DC1394_COLOR_CODING_MONO8;
+    sensor->data_depth = 8;
+    sensor->stride = 0;
+    sensor->little_endian = 0;
+}
+
+/*
+  Copies n rows of a sensor of a stereo frame from row y to dest. With
+  DC1394_STEREO_METHOD_INTERLACED the bytes of the pixels of a row are those
+  of each sensor in turn; with DC1394_STEREO_METHOD_FIELD the images of the
+  sensors follow each other, and each input row holds a row of 'sensors' of
+  them.
+ */
+void
+stereo_sensor_rows(const dc1394video_frame_t *in, int sensors, int sensor, dc1394stereo_method_t method,
+                   uint32_t y, uint32_t n, uint8_t *dest, size_t stride)
+{
+    const size_t in_row = frame_row_bytes(in);
+    const uint32_t width = in->size[0];
+    uint32_t i, r;
+
+    for (i = 0; i < n; i++, y++, dest += stride) {
+        if (method == DC1394_STEREO_METHOD_FIELD) {
+            r = sensor * in->size[1] + y;
+            memcpy(dest, in->image + (r / sensors) * in_row + (size_t)(r % sensors) * width, width);
+        } else {
+            sensor_pick(in->image + y * in_row + sensor, dest, width, sensors);
+        }
+    }
+}
+
+typedef struct {
+    const dc1394video_frame_t *in;
+    dc1394video_frame_t *out;
+    int sensors;
+    dc1394stereo_method_t method;
+    uint32_t band_rows;
+} stereo_bands_t;
+
+/* the rows of a band of all the sensors, so that each input row is read once */
+static void
+stereo_band_task(void *arg, int band)
+{
+    stereo_bands_t *b = (stereo_bands_t*)arg;
+    uint32_t y0 = band * b->band_rows;
+    uint32_t y1 = y0 + b->band_rows;
+    uint32_t y;
+    int s;
+
+    if (y1 > b->in->size[1])
+        y1 = b->in->size[1];
+    for (y = y0; y < y1; y++)
+        for (s = 0; s < b->sensors; s++)
+            stereo_sensor_rows(b->in, b->sensors, s, b->method, y, 1,
+                               b->out[s].image + y * frame_row_bytes(&b->out[s]), 0);
+}
+
+dc1394error_t
+dc1394_deinterlace_stereo_frames_split(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                       dc1394video_frame_t *out, uint32_t sensors, dc1394stereo_method_t method)
+{
+    dc1394video_frame_t sensor;
+    stereo_bands_t b;
+    uint64_t bytes;
+    dc1394error_t err;
+    uint32_t s;
+    int bands;
+
+    if (stereo_frame_sensors(in) == 0)
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    if (sensors != (uint32_t)stereo_frame_sensors(in))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    if ((method < DC1394_STEREO_METHOD_MIN) || (method > DC1394_STEREO_METHOD_MAX))
+        return DC1394_INVALID_STEREO_METHOD;
+    if (frame_row_bytes(in) == 0)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    stereo_sensor_frame(in, &sensor);
+    for (s = 0; s < sensors; s++) {
+        out[s].color_coding = sensor.color_coding;
+        err = Adapt_buffer_convert(&sensor, &out[s]);
+        if (err != DC1394_SUCCESS)
+            return err;
+    }
+
+    // the bands read and write as much as those of dc1394_convert_frames_parallel()
+    bands = 1;
+    if (ctx != NULL) {
+        bytes = 2 * (uint64_t)frame_row_bytes(in) * in->size[1];
+        bands = debayer_context_threads(ctx);
+        if ((uint64_t)bands > bytes / CONVERT_BAND_MIN_BYTES)
+            bands = bytes / CONVERT_BAND_MIN_BYTES;
+        if (bands < 1)
+            bands = 1;
+    }
+
+    b.in = in;
+    b.out = out;
+    b.sensors = sensors;
+    b.method = method;
+    b.band_rows = in->size[1];
+    if (bands <= 1) {
+        stereo_band_task(&b, 0);
+        return DC1394_SUCCESS;
+    }
+
+    b.band_rows = (in->size[1] + bands - 1) / bands;
+    bands = (in->size[1] + b.band_rows - 1) / b.band_rows;
+    thread_pool_run(bands, bands, stereo_band_task, &b);
+
+    return DC1394_SUCCESS;
+}
@@ -66,6 +66,55 @@ typedef enum {
 #define DC1394_STEREO_METHOD_MAX     DC1394_STEREO_METHOD_FIELD
 #define DC1394_STEREO_METHOD_NUM    (DC1394_STEREO_METHOD_MAX-DC1394_STEREO_METHOD_MIN+1)
 
+/**
+ * A list of layouts of packed 10 and 12-bit samples. The samples of a row are grouped by two (or four), and
+ * the least significant bits of a sample come first in the byte that holds them.
+ */
+typedef enum {
+    DC1394_PACKING_12BIT=0,     /* 3 bytes: 8 MSBs of the first, 4 LSBs of both, 8 MSBs of the second (GigE Vision Mono12Packed) */
+    DC1394_PACKING_12BIT_MIPI,  /* 3 bytes: 8 MSBs of the first, 8 MSBs of the second, 4 LSBs of both (MIPI CSI-2 RAW12) */
+    DC1394_PACKING_10BIT,       /* 3 bytes: 8 MSBs of the first, 2 LSBs of both in bits 0-1 and 4-5, 8 MSBs of the second (GigE Vision Mono10Packed) */
+    DC1394_PACKING_10BIT_MIPI   /* 5 bytes: 8 MSBs of four samples, then 2 LSBs of each (MIPI CSI-2 RAW10) */
+} dc1394packing_t;
+#define DC1394_PACKING_MIN           DC1394_PACKING_12BIT
+#define DC1394_PACKING_MAX           DC1394_PACKING_10BIT_MIPI
+#define DC1394_PACKING_NUM          (DC1394_PACKING_MAX-DC1394_PACKING_MIN+1)
+
+/**
+ * A list of the matrices between RGB and YUV: those of ITU-R BT.601 (standard definition) and BT.709 (high
+ * definition).
+ */
+typedef enum {
+    DC1394_YUV_MATRIX_BT601=0,
+    DC1394_YUV_MATRIX_BT709
+} dc1394yuv_matrix_t;
+#define DC1394_YUV_MATRIX_MIN        DC1394_YUV_MATRIX_BT601
+#define DC1394_YUV_MATRIX_MAX        DC1394_YUV_MATRIX_BT709
+#define DC1394_YUV_MATRIX_NUM       (DC1394_YUV_MATRIX_MAX-DC1394_YUV_MATRIX_MIN+1)
+
+/**
+ * A list of the ranges of the YUV samples. The RGB samples always have the full range.
+ */
+typedef enum {
+    DC1394_YUV_RANGE_FULL=0,    /* Y, U and V in 0..255 (JPEG) */
+    DC1394_YUV_RANGE_LIMITED    /* Y in 16..235, U and V in 16..240 (video) */
+} dc1394yuv_range_t;
+#define DC1394_YUV_RANGE_MIN         DC1394_YUV_RANGE_FULL
+#define DC1394_YUV_RANGE_MAX         DC1394_YUV_RANGE_LIMITED
+#define DC1394_YUV_RANGE_NUM        (DC1394_YUV_RANGE_MAX-DC1394_YUV_RANGE_MIN+1)
+
+/**
+ * A list of the tone curves that reduce 16-bit samples to 8 bits
+ */
+typedef enum {
+    DC1394_TONE_CURVE_LINEAR=0,
+    DC1394_TONE_CURVE_GAMMA,
+    DC1394_TONE_CURVE_LOG
+} dc1394tone_curve_t;
+#define DC1394_TONE_CURVE_MIN        DC1394_TONE_CURVE_LINEAR
+#define DC1394_TONE_CURVE_MAX        DC1394_TONE_CURVE_LOG
+#define DC1394_TONE_CURVE_NUM       (DC1394_TONE_CURVE_MAX-DC1394_TONE_CURVE_MIN+1)
+
 
 // color conversion functions from Bart Nabbe.
 // corrected by Damien: bad coeficients in YUV2RGB
@@ -177,19 +226,90 @@ dc1394_bayer_decoding_16bit(const uint16_t *bayer, uint16_t *rgb,
                             uint32_t width, uint32_t height, dc1394color_filter_t tile,
                             dc1394bayer_method_t method, uint32_t bits);
 
+/**
+ * Perform de-mosaicing on an 8-bit image buffer and convert the result to YUV422 in the same pass
+ *
+ * The output is the same as that of dc1394_bayer_decoding_8bit() followed by a conversion from RGB8 to YUV422,
+ * but the RGB image is only kept a few rows at a time. The width must be even. All the methods but
+ * DC1394_BAYER_METHOD_DOWNSAMPLE are supported.
+ *
+ * @param byte_order is DC1394_BYTE_ORDER_UYVY or DC1394_BYTE_ORDER_YUYV
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_to_YUV422(const uint8_t *bayer, uint8_t *yuv,
+                                     uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                     dc1394bayer_method_t method, uint32_t byte_order);
+
+/**
+ * Perform de-mosaicing on a 16-bit image buffer and convert the result to YUV422 in the same pass
+ *
+ * As dc1394_bayer_decoding_8bit_to_YUV422(). The most significant 8 of the 'bits' bits of the pixels are kept.
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_to_YUV422(const uint16_t *bayer, uint8_t *yuv,
+                                      uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                      dc1394bayer_method_t method, uint32_t bits, uint32_t byte_order);
+
 
 /**********************************************************************************
  *  Frame based conversions
+ *
+ *  The frame functions honour the stride of the input: its rows are 'stride' bytes
+ *  apart, or packed if it is 0, and a stride smaller than a row is an error
+ *  (DC1394_INVALID_ARGUMENT_VALUE). The stride of the output is only honoured if
+ *  the caller supplies the buffer: when out->image is not NULL and
+ *  out->allocated_image_bytes holds the rows at that stride and the padding bytes,
+ *  the result is written there directly and out->image is never reallocated, so
+ *  a frame can describe padded memory such as rows aligned for an overlay or a
+ *  V4L2 buffer. Otherwise the output rows are packed, as in an input frame copied
+ *  to the output before its color coding is changed, out->stride is set to the
+ *  packed row, and the image is taken from out->pool, see "Frame buffer pools"
+ *  below: out->pool must be NULL, for malloc(), or a pool, as out->image must be
+ *  NULL or a buffer. The functions on raw buffers above expect packed rows.
  **********************************************************************************/
 
 /**
  * Converts the format of a video frame.
  *
- * To set the format of the output, simply set the values of the corresponding fields in the output frame
+ * To set the format of the output, simply set the values of the corresponding fields in the output frame.
+ * Besides YUV422, RGB8 and MONO8, the output can be RGBA8, BGRA8, RGB8_PLANAR, NV12 or I420 (see below).
  */
 dc1394error_t
 dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out);
 
+/**
+ * The matrix and the range of the YUV side of the conversions between RGB and YUV. YUV2RGB and RGB2YUV, which
+ * dc1394_convert_frames() uses, are BT.601 at full range. Other parameters are turned into look-up tables in
+ * fixed point when they are created, so that the conversions only add table entries. The parameters do not
+ * change once created, and can be shared by any number of threads.
+ */
+typedef struct __dc1394yuv_params dc1394yuv_params_t;
+
+/**
+ * Creates the parameters of a matrix and a range
+ *
+ * @return the new parameters, or NULL if an argument is invalid or memory could not be allocated
+ */
+dc1394yuv_params_t*
+dc1394_yuv_params_new(dc1394yuv_matrix_t matrix, dc1394yuv_range_t range);
+
+/**
+ * Frees parameters created by dc1394_yuv_params_new()
+ */
+void
+dc1394_yuv_params_free(dc1394yuv_params_t *params);
+
+/**
+ * Converts the format of a video frame as dc1394_convert_frames(), with the YUV matrix and range of params
+ *
+ * They apply to the conversions from YUV411, YUV422 and YUV444 to RGB8 and to the codings made from it, and from
+ * RGB8, RGB16, MONO8 and MONO16 to YUV422, NV12 and I420 (gray levels become the luma of the range). The
+ * conversions between YUV codings keep the samples. BT.601 at full range, or a NULL params, gives the output of
+ * dc1394_convert_frames(); the other parameters round each component to the nearest.
+ */
+dc1394error_t
+dc1394_convert_frames_yuv(dc1394yuv_params_t *params, dc1394video_frame_t *in, dc1394video_frame_t *out);
+
 /**
  * De-mosaicing of a Bayer-encoded video frame
  *
@@ -197,12 +317,22 @@ dc1394_convert_frames(dc1394video_frame_t *in, dc1394video_frame_t *out);
  * @param in is a pointer to the bayer video frame that is to be converted
  * @param out is a pointer to the frame to be converted to.  If there is memory allocated to the image field, 
  *      then it will be adjusted accordingly by this function.  If there is no memory allocated to the image
- *      field, then ensure that out->image == NULL and out->allocated_image_bytes == 0
+ *      field, then ensure that out->image == NULL and out->allocated_image_bytes == 0. out->pool must be NULL, or
+ *      the pool the image is to be taken from (see "Frame buffer pools" below).
  * @param method is the bayer method to interpolate the frame.
  */
 dc1394error_t
 dc1394_debayer_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method);
 
+/**
+ * De-mosaicing of a Bayer-encoded video frame straight to a YUV422 frame
+ *
+ * This does in one pass what dc1394_debayer_frames() followed by dc1394_convert_frames() do in two. The output
+ * byte order is taken from out->yuv_byte_order, which must be set. Memory is handled as in dc1394_debayer_frames().
+ */
+dc1394error_t
+dc1394_debayer_frames_to_YUV422(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394bayer_method_t method);
+
 /**
  * De-interlacing of stereo data for cideo frames
  *
@@ -211,6 +341,544 @@ dc1394_debayer_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394b
 dc1394error_t
 dc1394_deinterlace_stereo_frames(dc1394video_frame_t *in, dc1394video_frame_t *out, dc1394stereo_method_t method);
 
+/**********************************************************************************
+ *  Frame buffer pools
+ *
+ *  When the image of an output frame is too small, the frame functions replace it
+ *  with a buffer of malloc(), or of the pool of the frame if out->pool is set. The
+ *  buffers of a pool are aligned on 64 bytes for the vectorized conversions, and
+ *  have a few sizes per power of two, so that frames of close sizes (other ROIs or
+ *  modes) reuse the buffers given back by each other instead of allocating. A pool
+ *  can be shared by any number of frames, cameras and threads.
+ *
+ *  The buffers of the pools go back to them with dc1394_frame_pool_release()
+ *  instead of free(). It tells them from the images of malloc(), so out->pool can be
+ *  set, or changed to another pool, on a frame that already holds an image.
+ **********************************************************************************/
+
+/**
+ * Creates a pool of frame buffers
+ *
+ * @param max_cached_bytes is the most bytes that the pool keeps in buffers given back to it, the others being
+ *        freed. 0 keeps them all.
+ * @param huge_pages maps the buffers of 2 MiB or more with huge pages, where the system has them, which saves
+ *        TLB misses on large frames.
+ * @return the new pool, or NULL if memory could not be allocated
+ */
+dc1394framepool_t*
+dc1394_frame_pool_new(uint64_t max_cached_bytes, dc1394bool_t huge_pages);
+
+/**
+ * Frees a pool and the buffers it keeps. The buffers still in frames are freed when they are given back with
+ * dc1394_frame_pool_release(); the pool can not give out buffers any more.
+ */
+void
+dc1394_frame_pool_free(dc1394framepool_t *pool);
+
+/**
+ * Frees the buffers that a pool keeps, for instance after a change of mode has made them all too small. A NULL
+ * pool is ignored.
+ */
+void
+dc1394_frame_pool_trim(dc1394framepool_t *pool);
+
+/**
+ * Gives the image of a frame back to the pool it was taken from, or frees it if it was not taken from a pool,
+ * whatever frame->pool is. The image is then NULL and frame->allocated_image_bytes 0.
+ */
+void
+dc1394_frame_pool_release(dc1394video_frame_t *frame);
+
+/**********************************************************************************
+ *  Multithreaded de-mosaicing and conversions
+ **********************************************************************************/
+
+/**
+ * A de-mosaicing context: the image is split into horizontal bands that are decoded in parallel by a pool
+ * of worker threads. The pool is shared by all the contexts of the process and is kept between calls.
+ * dc1394_convert_frames_parallel() uses the threads of a context the same way.
+ * A context must not be used by two threads at the same time, but each camera can have its own.
+ *
+ * The context also keeps the working memory of the VNG and AHD methods from one frame to the next, so a
+ * context with a single thread is the way to decode a stream of frames without allocating for each of them.
+ */
+typedef struct __dc1394debayer_context dc1394debayer_context_t;
+
+/**
+ * Creates a de-mosaicing context
+ *
+ * @param threads is the number of threads that decode an image, the calling one included. 0 selects one per processor.
+ * @return the new context, or NULL if memory could not be allocated
+ */
+dc1394debayer_context_t*
+dc1394_debayer_context_new(uint32_t threads);
+
+/**
+ * Frees a de-mosaicing context and its buffers
+ */
+void
+dc1394_debayer_context_free(dc1394debayer_context_t *ctx);
+
+/**
+ * Parallel version of dc1394_bayer_decoding_8bit(). The output is identical.
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_parallel(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *rgb,
+                                    uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                    dc1394bayer_method_t method);
+
+/**
+ * Parallel version of dc1394_bayer_decoding_16bit(). The output is identical.
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_parallel(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint16_t *rgb,
+                                     uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                     dc1394bayer_method_t method, uint32_t bits);
+
+/**
+ * Parallel version of dc1394_debayer_frames(). The output is identical.
+ */
+dc1394error_t
+dc1394_debayer_frames_parallel(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                               dc1394bayer_method_t method);
+
+/**
+ * Parallel version of dc1394_debayer_frames_to_YUV422(). The output is identical.
+ */
+dc1394error_t
+dc1394_debayer_frames_to_YUV422_parallel(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                         dc1394video_frame_t *out, dc1394bayer_method_t method);
+
+/**
+ * Parallel version of dc1394_convert_frames_yuv(). The output is identical.
+ *
+ * Each band reads and writes at least a megabyte, so that small frames are converted by the calling thread
+ * alone: the threads of ctx are only woken up when the frame is large enough to gain from them. ctx may be
+ * NULL, in which case a single thread does the work. params may be NULL, as for dc1394_convert_frames().
+ */
+dc1394error_t
+dc1394_convert_frames_parallel(dc1394debayer_context_t *ctx, dc1394yuv_params_t *params, dc1394video_frame_t *in,
+                               dc1394video_frame_t *out);
+
+/**
+ * De-interlacing of stereo data straight into one frame per sensor
+ *
+ * The bytes of each pixel of in are the samples of as many sensors: 2 for MONO16, RAW16 and YUV422, 3 for RGB8
+ * and 6 for RGB16. With DC1394_STEREO_METHOD_INTERLACED, out[s] gets byte s of every pixel; with
+ * DC1394_STEREO_METHOD_FIELD the images of the sensors follow each other in the data, as in
+ * dc1394_deinterlace_stereo_frames(). Each frame of out has the size of in and 8-bit samples: RAW8 for RAW16, and
+ * for RGB8 or RGB16 if in->color_filter is set, MONO8 otherwise. Memory is handled as in dc1394_convert_frames().
+ * The input is read once, by the threads of ctx if it is large enough for them (see
+ * dc1394_convert_frames_parallel()); ctx may be NULL.
+ *
+ * @param out is an array of sensors frames
+ * @param sensors must be that of the coding of in
+ */
+dc1394error_t
+dc1394_deinterlace_stereo_frames_split(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                       dc1394video_frame_t *out, uint32_t sensors, dc1394stereo_method_t method);
+
+/**
+ * De-interlacing and de-mosaicing of stereo data in one pass
+ *
+ * As dc1394_deinterlace_stereo_frames_split(), with the mosaic of each sensor, whose color filter is
+ * in->color_filter, decoded to its frame of out without an intermediate image: the rows of a sensor are picked
+ * from in a chunk at a time by the de-mosaicing of the chunk. The coding of each frame of out must be set: RGB8,
+ * YUV422 with its yuv_byte_order, MONO8, or one made from RGB8 as in dc1394_debayer_frames_to_coding(). The
+ * sensors are decoded one after the other by all the threads of ctx, or by the calling thread if ctx is NULL.
+ */
+dc1394error_t
+dc1394_deinterlace_stereo_frames_debayer(dc1394debayer_context_t *ctx, dc1394video_frame_t *in,
+                                         dc1394video_frame_t *out, uint32_t sensors, dc1394stereo_method_t method,
+                                         dc1394bayer_method_t bayer_method);
+
+/**
+ * De-mosaicing of an 8-bit image to an RGB image of any size up to half that of the input, for previews
+ *
+ * Each output pixel is the average of the 2x2 quads of the mosaic it covers, weighted by the area it covers of
+ * each, so that 2448x2048 can become 640x480 directly. The full size RGB image is never produced. As with
+ * DC1394_BAYER_METHOD_DOWNSAMPLE, an odd last row or column of the mosaic is left out. ctx may be NULL, in which
+ * case a single thread does the work.
+ *
+ * @param width, height are the size of the output: at least 1, at most half the size of the input
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_scaled(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *rgb,
+                                  uint32_t sx, uint32_t sy, dc1394color_filter_t tile, uint32_t width,
+                                  uint32_t height);
+
+/**
+ * As dc1394_bayer_decoding_8bit_scaled(), for 16-bit images. The output has the bit depth of the input.
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_scaled(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint16_t *rgb,
+                                   uint32_t sx, uint32_t sy, dc1394color_filter_t tile, uint32_t width,
+                                   uint32_t height);
+
+/**
+ * De-mosaicing of a Bayer-encoded video frame to an RGB frame of the given size, as
+ * dc1394_bayer_decoding_8bit_scaled(). Memory is handled as in dc1394_debayer_frames(), and the position of the
+ * frame is scaled with its size.
+ */
+dc1394error_t
+dc1394_debayer_frames_scaled(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                             uint32_t width, uint32_t height);
+
+/**
+ * A rectangle of an image, in pixels
+ */
+typedef struct {
+    uint32_t left;
+    uint32_t top;
+    uint32_t width;
+    uint32_t height;
+} dc1394roi_t;
+
+/**
+ * De-mosaicing of rectangles of an 8-bit image
+ *
+ * Each of the count rectangles of rois is decoded to its own RGB image in rgb[i], of the size of the rectangle.
+ * The pixels are those that dc1394_bayer_decoding_8bit() gives for the full image: the rectangles can have any
+ * position, and the pixels around them are used as in the full image. All the methods are supported; with
+ * DC1394_BAYER_METHOD_DOWNSAMPLE the position and size of the rectangles must be even, and their images are half
+ * their size. The rectangles are shared among the threads of ctx, or decoded by a single thread if ctx is NULL.
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_roi(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint32_t sx, uint32_t sy,
+                               dc1394color_filter_t tile, dc1394bayer_method_t method, const dc1394roi_t *rois,
+                               uint8_t **rgb, uint32_t count);
+
+/**
+ * As dc1394_bayer_decoding_8bit_roi(), for 16-bit images
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_roi(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint32_t sx, uint32_t sy,
+                                dc1394color_filter_t tile, dc1394bayer_method_t method, uint32_t bits,
+                                const dc1394roi_t *rois, uint16_t **rgb, uint32_t count);
+
+/**
+ * De-mosaicing of rectangles of a Bayer-encoded video frame, into the array of count frames out. Memory is
+ * handled as in dc1394_debayer_frames(), and the position of each frame is that of its rectangle in the sensor.
+ */
+dc1394error_t
+dc1394_debayer_frames_roi(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                          const dc1394roi_t *rois, uint32_t count, dc1394bayer_method_t method);
+
+/**********************************************************************************
+ *  Color processing of de-mosaiced images
+ **********************************************************************************/
+
+/**
+ * A color processing pipeline: white balance gains, a color correction matrix and a gamma curve, applied in
+ * that order to the RGB output of the de-mosaicing. The three stages are done together on each band of rows
+ * while it is still in the cache, instead of in a pass over the whole frame each. A new pipeline does
+ * nothing; each stage is set independently. Like a context, a pipeline must not be used by two threads at the
+ * same time.
+ */
+typedef struct __dc1394isp dc1394isp_t;
+
+/**
+ * Creates a color processing pipeline that leaves the pixels unchanged
+ *
+ * @return the new pipeline, or NULL if memory could not be allocated
+ */
+dc1394isp_t*
+dc1394_isp_new(void);
+
+/**
+ * Frees a color processing pipeline
+ */
+void
+dc1394_isp_free(dc1394isp_t *isp);
+
+/**
+ * Sets the white balance gains of the red, green and blue components, between 0 and 16 (1.0 by default)
+ */
+dc1394error_t
+dc1394_isp_set_white_balance(dc1394isp_t *isp, double red, double green, double blue);
+
+/**
+ * Sets the color correction matrix, in the form of dc1394_avt_set_color_corr(): the coefficients are in
+ * thousandths, between -16000 and 16000, and red' = (Crr * red + Cgr * green + Cbr * blue) / 1000. The
+ * default is the identity.
+ */
+dc1394error_t
+dc1394_isp_set_color_corr(dc1394isp_t *isp, int32_t Crr, int32_t Cgr, int32_t Cbr, int32_t Crg, int32_t Cgg,
+                          int32_t Cbg, int32_t Crb, int32_t Cgb, int32_t Cbb);
+
+/**
+ * Sets the gamma of the output: a component x of the full range max becomes max * (x / max)^(1 / gamma).
+ * The default of 1.0 leaves the components unchanged.
+ */
+dc1394error_t
+dc1394_isp_set_gamma(dc1394isp_t *isp, double gamma);
+
+/**
+ * De-mosaicing of an 8-bit image followed by the color processing of isp
+ *
+ * The result is that of dc1394_bayer_decoding_8bit() followed by the white balance, color correction and gamma,
+ * each rounded and clipped only once. ctx may be NULL, in which case a single thread does the work.
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, const uint8_t *bayer,
+                               uint8_t *rgb, uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                               dc1394bayer_method_t method);
+
+/**
+ * De-mosaicing of a 16-bit image followed by the color processing of isp. The output keeps the 'bits' bits of
+ * the input.
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, const uint16_t *bayer,
+                                uint16_t *rgb, uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                dc1394bayer_method_t method, uint32_t bits);
+
+/**
+ * De-mosaicing of a Bayer-encoded video frame followed by the color processing of isp. Memory is handled as in
+ * dc1394_debayer_frames().
+ */
+dc1394error_t
+dc1394_debayer_frames_isp(dc1394debayer_context_t *ctx, dc1394isp_t *isp, dc1394video_frame_t *in,
+                          dc1394video_frame_t *out, dc1394bayer_method_t method);
+
+/**********************************************************************************
+ *  Statistics of the output
+ *
+ *  A context can count the samples of what the de-mosaicing and the conversions
+ *  done with it write, for auto-exposure or white balance, instead of reading the
+ *  output again: each band counts its output rows right after it has written them,
+ *  while they are still in the cache, and the counts of the bands are merged once
+ *  they are done. The statistics are those of the last call, made by:
+ *  - dc1394_convert_frames_parallel(), whose output has 8-bit samples;
+ *  - the de-mosaicing functions that take a context, but for the scaled, ROI and
+ *    stereo ones, with the bit depth of the output: 8 bits but for RGB16 and MONO16.
+ *  The channels are the luminance of MONO8 and MONO16, the red, green and blue of
+ *  RGB8, RGB16, RGBA8, BGRA8 and RGB8_PLANAR, and the Y, U and V of YUV422, NV12
+ *  and I420, whose chroma samples are each counted once. Calls with a NULL context
+ *  count nothing.
+ **********************************************************************************/
+
+/**
+ * The statistics of the samples of a channel. A sample is saturated when it has the largest value of the bit
+ * depth, 255 for 8 bits. Bin i of the histogram counts the values v such that v * bins / 2^bits is i.
+ */
+typedef struct {
+    uint64_t samples;           /* counted */
+    uint64_t sum;               /* of their values: sum / samples is the mean */
+    uint32_t min;
+    uint32_t max;
+    uint64_t saturated;
+    uint32_t bits;              /* of the samples */
+    const uint64_t *histogram;  /* the bins of the statistics, which own them */
+} dc1394channel_stats_t;
+
+typedef struct __dc1394frame_stats dc1394frame_stats_t;
+
+/**
+ * Creates statistics whose histograms have the given number of bins, from 1 to 65536
+ *
+ * @return the new statistics, or NULL if bins is invalid or memory could not be allocated
+ */
+dc1394frame_stats_t*
+dc1394_frame_stats_new(uint32_t bins);
+
+/**
+ * Frees statistics. They must not be set in a context any more.
+ */
+void
+dc1394_frame_stats_free(dc1394frame_stats_t *stats);
+
+/**
+ * Sets the statistics that the calls made with ctx fill, or none if stats is NULL. Like the context, the
+ * statistics must not be used by two threads at the same time.
+ */
+dc1394error_t
+dc1394_debayer_context_set_stats(dc1394debayer_context_t *ctx, dc1394frame_stats_t *stats);
+
+/**
+ * The number of channels of the last output counted: 1 or 3, 0 if nothing has been counted yet
+ */
+uint32_t
+dc1394_frame_stats_get_channels(const dc1394frame_stats_t *stats);
+
+/**
+ * Gets the statistics of a channel of the last output counted, after a call that succeeded. The histogram stays
+ * valid until the next call that fills the statistics.
+ */
+dc1394error_t
+dc1394_frame_stats_get(const dc1394frame_stats_t *stats, uint32_t channel, dc1394channel_stats_t *result);
+
+/**********************************************************************************
+ *  Packed 10 and 12-bit images
+ **********************************************************************************/
+
+/**
+ * Unpacks 10 or 12-bit samples to one uint16_t each, as in MONO16 and RAW16 images with a data depth of 10 or 12
+ *
+ * The rows follow each other without padding. The width must be even, and a multiple of 4 for
+ * DC1394_PACKING_10BIT_MIPI.
+ */
+dc1394error_t
+dc1394_packed_to_MONO16(const uint8_t *src, uint16_t *dest, uint32_t width, uint32_t height,
+                        dc1394packing_t packing);
+
+/**
+ * De-mosaicing of a packed 10 or 12-bit image
+ *
+ * The output is that of dc1394_bayer_decoding_16bit() on the unpacked image, with 10 or 12 bits per component,
+ * but the mosaic is unpacked a few rows at a time by each band: the unpacked image is never written to memory.
+ * The size is constrained as for dc1394_packed_to_MONO16(). ctx may be NULL, in which case a single thread does
+ * the work.
+ */
+dc1394error_t
+dc1394_bayer_decoding_packed(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint16_t *rgb, uint32_t width,
+                             uint32_t height, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                             dc1394packing_t packing);
+
+/**********************************************************************************
+ *  16-bit samples to 8 bits
+ *
+ *  The frame functions reduce MONO16 and RGB16 to 8 bits by dropping the bits
+ *  below the top 8 of the data depth, in the byte order given by in->little_endian:
+ *  all the conversions of 16-bit frames honour it. A tone curve keeps more of the
+ *  shadows of 10 to 16-bit images than this shift does.
+ **********************************************************************************/
+
+/**
+ * Reduces 16-bit samples of 'bits' bits (8 to 16) to 8 bits: MONO16 has one sample per pixel, RGB16 three
+ *
+ * @param little_endian tells the byte order of the samples; IIDC cameras send them big endian
+ * @param lut if NULL, the samples are shifted right by bits-8. Otherwise it is a table of 1 << bits entries,
+ *            such as those of dc1394_tone_curve(), and each sample is replaced by its entry.
+ */
+dc1394error_t
+dc1394_convert_16bit_to_8bit(const uint8_t *src, uint8_t *dest, uint32_t samples, uint32_t bits,
+                             dc1394bool_t little_endian, const uint8_t *lut);
+
+/**
+ * Fills the 1 << bits entries of a table for dc1394_convert_16bit_to_8bit() with a tone curve
+ *
+ * With x the sample divided by its maximum, the entries are:
+ * - DC1394_TONE_CURVE_LINEAR: the shift of dc1394_convert_16bit_to_8bit() without a table (parameter is unused);
+ * - DC1394_TONE_CURVE_GAMMA: 255 * x^(1/parameter), for instance with a gamma of 2.2;
+ * - DC1394_TONE_CURVE_LOG: 255 * log(1 + parameter * x) / log(1 + parameter), parameter setting how much the
+ *   shadows are lifted (100 to 1000 for 12-bit images).
+ * The parameter of the last two must be positive.
+ */
+dc1394error_t
+dc1394_tone_curve(uint8_t *lut, uint32_t bits, dc1394tone_curve_t curve, double parameter);
+
+/**********************************************************************************
+ *  RGBA, BGRA, planar RGB, NV12 and I420 outputs
+ *
+ *  These codings (DC1394_COLOR_CODING_CONVERTED_MIN to _MAX) are never delivered by
+ *  a camera: they are the final layouts of renderers and encoders, which the
+ *  conversions and the de-mosaicing produce in the same pass, from the RGB8 pixels
+ *  that they would otherwise output. RGBA8 and BGRA8 have 4 bytes per pixel, with
+ *  an alpha of 255. The others have planes that follow each other, the stride being
+ *  that of the rows of the first one:
+ *  - RGB8_PLANAR: the red, then the green and the blue planes, of height rows each;
+ *  - NV12: the Y plane, then height/2 rows of interleaved U and V, with the same stride;
+ *  - I420: the Y plane, then the U and the V planes of height/2 rows, with half the stride.
+ *  The chroma of NV12 and I420 is the average of that of 2x2 blocks of pixels, computed
+ *  as in dc1394_convert_to_YUV422(): their width and height must be even. From YUV411,
+ *  YUV422 and YUV444 the samples are kept instead, as between the other YUV codings:
+ *  the luma is copied and the chroma of each block is the rounded average of that of
+ *  its pixels, without going through RGB (YUV411 needs a width multiple of 4 for this).
+ *
+ *  The de-mosaicing can also output the luminance alone, as MONO8 or MONO16 (with the
+ *  bit depth of 16-bit images only), for the stages that need no color: the luma of
+ *  dc1394_convert_to_YUV422() is computed on the decoded pixels a few rows at a time,
+ *  so that the RGB image is never written to memory. With DC1394_BAYER_METHOD_DOWNSAMPLE
+ *  it is binned straight from the 2x2 blocks of the mosaic, at half the resolution.
+ **********************************************************************************/
+
+/**
+ * Converts an image buffer of YUV411, YUV422 (in byte_order) or YUV444 to NV12 or I420 (coding), with packed rows
+ */
+dc1394error_t
+dc1394_convert_to_YUV420(uint8_t *src, uint8_t *dest, uint32_t width, uint32_t height, uint32_t byte_order,
+                         dc1394color_coding_t source_coding, dc1394color_coding_t coding);
+
+/**
+ * De-mosaicing of an 8-bit image to one of the codings above, or to MONO8
+ *
+ * The output is that of dc1394_bayer_decoding_8bit() followed by a conversion to coding, but the RGB image is only
+ * kept a few rows at a time. All the methods but DC1394_BAYER_METHOD_DOWNSAMPLE are supported, which only outputs
+ * MONO8. ctx may be NULL, in which case a single thread does the work.
+ */
+dc1394error_t
+dc1394_bayer_decoding_8bit_to_coding(dc1394debayer_context_t *ctx, const uint8_t *bayer, uint8_t *dest,
+                                     uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                     dc1394bayer_method_t method, dc1394color_coding_t coding);
+
+/**
+ * As dc1394_bayer_decoding_8bit_to_coding(), for 16-bit images. The most significant 8 of the 'bits' bits of
+ * the pixels are kept, but for MONO16, whose dest holds uint16_t luminances of 'bits' bits. MONO8 keeps the most
+ * significant 8 bits of these.
+ */
+dc1394error_t
+dc1394_bayer_decoding_16bit_to_coding(dc1394debayer_context_t *ctx, const uint16_t *bayer, uint8_t *dest,
+                                      uint32_t width, uint32_t height, dc1394color_filter_t tile,
+                                      dc1394bayer_method_t method, uint32_t bits, dc1394color_coding_t coding);
+
+/**
+ * De-mosaicing of a Bayer-encoded video frame straight to one of the codings above, or to MONO8 or MONO16, set by
+ * the caller in out->color_coding. Memory is handled as in dc1394_debayer_frames(), and the output is halved by
+ * DC1394_BAYER_METHOD_DOWNSAMPLE as there. dc1394_convert_frames() converts the other frames to the codings above.
+ */
+dc1394error_t
+dc1394_debayer_frames_to_coding(dc1394debayer_context_t *ctx, dc1394video_frame_t *in, dc1394video_frame_t *out,
+                                dc1394bayer_method_t method);
+
+/**********************************************************************************
+ *  Streaming de-mosaicing
+ *
+ *  A frame can be decoded while it is being received: the stream is told how many
+ *  rows of the mosaic have landed in its buffer, and decodes the output rows that
+ *  they complete. Each output row needs the input rows of a small window around it
+ *  (2 to 6 rows below, depending on the method), so the decoding follows the
+ *  reception a few rows behind and little is left to do once the last row is in.
+ *  The output is identical to that of dc1394_bayer_decoding_8bit() or _16bit().
+ **********************************************************************************/
+
+typedef struct __dc1394debayer_stream dc1394debayer_stream_t;
+
+/**
+ * Creates a de-mosaicing stream for images of the given size, filter and method
+ *
+ * @param bits is 8 for 8-bit mosaics decoded to RGB8, or the depth (9 to 16) of 16-bit mosaics decoded to RGB16
+ * @return the new stream, or NULL if an argument is invalid or memory could not be allocated
+ */
+dc1394debayer_stream_t*
+dc1394_debayer_stream_new(uint32_t width, uint32_t height, dc1394color_filter_t tile, dc1394bayer_method_t method,
+                          uint32_t bits);
+
+/**
+ * Frees a de-mosaicing stream
+ */
+void
+dc1394_debayer_stream_free(dc1394debayer_stream_t *stream);
+
+/**
+ * Starts the decoding of a frame: bayer is where its packed rows arrive, from the top, and rgb receives the
+ * packed output rows. Nothing is read before dc1394_debayer_stream_push() says that rows are there.
+ */
+dc1394error_t
+dc1394_debayer_stream_start(dc1394debayer_stream_t *stream, const void *bayer, void *rgb);
+
+/**
+ * Tells the stream that the first 'rows' rows of the mosaic have arrived, and decodes the output rows they
+ * complete. 'rows' never decreases during a frame, and the frame is complete once it is the height of the image.
+ * The rows around each group of output rows decoded are decoded again with the next one: pushing a few dozen
+ * rows at a time rather than one keeps the cost of this low.
+ *
+ * @param done if not NULL, receives the number of output rows that are final, from the top. The rows below them
+ *             may already have been written, with values that are not.
+ */
+dc1394error_t
+dc1394_debayer_stream_push(dc1394debayer_stream_t *stream, uint32_t rows, uint32_t *done);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,789 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include "simd.h"
+
+/* pixel pairs from RGB8 to YUV422 in scalar code, for the end of the rows */
+static inline void
+rgb8_to_yuv422_pairs(const uint8_t *restrict rgb, uint8_t *restrict yuv, int pixels, uint32_t byte_order)
+{
+    int i, y0, y1, u0, u1, v0, v1;
+
+    for (i = 0; i < pixels; i += 2, rgb += 6, yuv += 4) {
+        RGB2YUV (rgb[0], rgb[1], rgb[2], y0, u0, v0);
+        RGB2YUV (rgb[3], rgb[4], rgb[5], y1, u1, v1);
+        if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+            yuv[0] = y0;
+            yuv[1] = (u0+u1) >> 1;
+            yuv[2] = y1;
+            yuv[3] = (v0+v1) >> 1;
+        } else {
+            yuv[0] = (u0+u1) >> 1;
+            yuv[1] = y0;
+            yuv[2] = (v0+v1) >> 1;
+            yuv[3] = y1;
+        }
+    }
+}
+
+/* pixel pairs, groups of 4 pixels and pixels from YUV422, YUV411 and YUV444 to RGB8 in scalar code, for the
+   end of the rows */
+static inline void
+yuv422_to_rgb8_pairs(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels, uint32_t byte_order)
+{
+    int i, y0, y1, u, v, r, g, b;
+
+    for (i = 0; i < pixels; i += 2, yuv += 4, rgb += 6) {
+        if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+            y0 = yuv[0];
+            u = yuv[1] - 128;
+            y1 = yuv[2];
+            v = yuv[3] - 128;
+        } else {
+            u = yuv[0] - 128;
+            y0 = yuv[1];
+            v = yuv[2] - 128;
+            y1 = yuv[3];
+        }
+        YUV2RGB (y0, u, v, r, g, b);
+        rgb[0] = r;
+        rgb[1] = g;
+        rgb[2] = b;
+        YUV2RGB (y1, u, v, r, g, b);
+        rgb[3] = r;
+        rgb[4] = g;
+        rgb[5] = b;
+    }
+}
+
+static inline void
+yuv411_to_rgb8_quads(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels)
+{
+    static const int luma[4] = { 1, 2, 4, 5 };
+    int i, k, u, v, r, g, b;
+
+    for (i = 0; i < pixels; i += 4, yuv += 6) {
+        u = yuv[0] - 128;
+        v = yuv[3] - 128;
+        for (k = 0; k < 4; k++, rgb += 3) {
+            YUV2RGB (yuv[luma[k]], u, v, r, g, b);
+            rgb[0] = r;
+            rgb[1] = g;
+            rgb[2] = b;
+        }
+    }
+}
+
+static inline void
+yuv444_to_rgb8_pixels(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels)
+{
+    int i, u, v, r, g, b;
+
+    for (i = 0; i < pixels; i++, yuv += 3, rgb += 3) {
+        u = yuv[0] - 128;
+        v = yuv[2] - 128;
+        YUV2RGB (yuv[1], u, v, r, g, b);
+        rgb[0] = r;
+        rgb[1] = g;
+        rgb[2] = b;
+    }
+}
+
+#ifdef DC1394_SIMD
+
+/* byte k of the loaded pixels, zero-extended to a 32-bit lane; Z is the
+   index of the first byte of the second vector, of zeros */
+#define PIX(k) (k), Z, Z, Z
+
+/* the pixel at byte k as a 32-bit word of 4 bytes, with an alpha from the
+   second vector, of 255 */
+#define RGBA_PIXEL(k) (k), (k)+1, (k)+2, Z
+#define BGRA_PIXEL(k) (k)+2, (k)+1, (k), Z
+
+/* 4 pixels per step: one 128-bit register of 32-bit words (NEON) */
+#define LANES 4
+#define VEC v4i32
+#define KERNEL(f) f##_x4
+#define Z 16
+#define LOAD_RGB(p, r, g, b)                                                                    \
+    do {                                                                                        \
+        v16u8 a_, z_ = { 0 };                                                                   \
+        SIMD_LOAD(a_, p);                                                                       \
+        r = (v4i32) SIMD_SHUFFLE(v16u8, a_, z_, PIX(0), PIX(3), PIX(6), PIX(9));                \
+        g = (v4i32) SIMD_SHUFFLE(v16u8, a_, z_, PIX(1), PIX(4), PIX(7), PIX(10));               \
+        b = (v4i32) SIMD_SHUFFLE(v16u8, a_, z_, PIX(2), PIX(5), PIX(8), PIX(11));               \
+    } while (0)
+#define SWAP_PAIRS(v) SIMD_SHUFFLE(v4i32, v, v, 1, 0, 3, 2)
+#define STORE_PAIRS(dst, lo, hi)                                                                \
+    do {                                                                                        \
+        v4u16 s_ = __builtin_convertvector((lo) | ((hi) << 8), v4u16);                          \
+        SIMD_STORE(dst, s_);                                                                    \
+    } while (0)
+#define STORE_BYTES(dst, v)                                                                     \
+    do {                                                                                        \
+        v16u8 b_ = (v16u8) (v);                                                                 \
+        b_ = SIMD_SHUFFLE(v16u8, b_, b_, 0, 4, 8, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);      \
+        memcpy(dst, &b_, 4);                                                                    \
+    } while (0)
+#define STORE_EVEN(dst, v)                                                                      \
+    do {                                                                                        \
+        v16u8 b_ = (v16u8) (v);                                                                 \
+        b_ = SIMD_SHUFFLE(v16u8, b_, b_, 0, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);       \
+        memcpy(dst, &b_, 2);                                                                    \
+    } while (0)
+#define LOAD_RGBA(p, w, PIXEL)                                                                  \
+    do {                                                                                        \
+        v16u8 a_, f_ = { 0 };                                                                   \
+        SIMD_LOAD(a_, p);                                                                       \
+        f_ = ~f_;                                                                               \
+        w = (v4i32) SIMD_SHUFFLE(v16u8, a_, f_, PIXEL(0), PIXEL(3), PIXEL(6), PIXEL(9));        \
+    } while (0)
+#include "conversions_simd_kernels.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD_RGB
+#undef SWAP_PAIRS
+#undef STORE_PAIRS
+#undef STORE_BYTES
+#undef STORE_EVEN
+#undef LOAD_RGBA
+#undef Z
+
+/* 8 pixels per step: one 256-bit register of 32-bit words (AVX2). Each
+   128-bit half gets 4 pixels, so the byte shuffles stay within the halves. */
+#define LANES 8
+#define VEC v8i32
+#define KERNEL(f) f##_x8
+#define Z 32
+#define LOAD_RGB(p, r, g, b)                                                                    \
+    do {                                                                                        \
+        v16u8 a_, b_;                                                                           \
+        v32u8 l_, z_ = { 0 };                                                                   \
+        SIMD_LOAD(a_, p);                                                                       \
+        SIMD_LOAD(b_, (p) + 12);                                                                \
+        l_ = SIMD_SHUFFLE(v32u8, a_, b_, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,  \
+                          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);      \
+        r = (v8i32) SIMD_SHUFFLE(v32u8, l_, z_, PIX(0), PIX(3), PIX(6), PIX(9),                 \
+                                 PIX(16), PIX(19), PIX(22), PIX(25));                           \
+        g = (v8i32) SIMD_SHUFFLE(v32u8, l_, z_, PIX(1), PIX(4), PIX(7), PIX(10),                \
+                                 PIX(17), PIX(20), PIX(23), PIX(26));                           \
+        b = (v8i32) SIMD_SHUFFLE(v32u8, l_, z_, PIX(2), PIX(5), PIX(8), PIX(11),                \
+                                 PIX(18), PIX(21), PIX(24), PIX(27));                           \
+    } while (0)
+#define SWAP_PAIRS(v) SIMD_SHUFFLE(v8i32, v, v, 1, 0, 3, 2, 5, 4, 7, 6)
+#define STORE_PAIRS(dst, lo, hi)                                                                \
+    do {                                                                                        \
+        v8u16 s_ = __builtin_convertvector((lo) | ((hi) << 8), v8u16);                          \
+        SIMD_STORE(dst, s_);                                                                    \
+    } while (0)
+#define STORE_BYTES(dst, v)                                                                     \
+    do {                                                                                        \
+        v32u8 b_ = (v32u8) (v);                                                                 \
+        b_ = SIMD_SHUFFLE(v32u8, b_, b_, 0, 4, 8, 12, 16, 20, 24, 28, 0, 0, 0, 0, 0, 0, 0, 0,   \
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);                      \
+        memcpy(dst, &b_, 8);                                                                    \
+    } while (0)
+#define STORE_EVEN(dst, v)                                                                      \
+    do {                                                                                        \
+        v32u8 b_ = (v32u8) (v);                                                                 \
+        b_ = SIMD_SHUFFLE(v32u8, b_, b_, 0, 8, 16, 24, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,      \
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);                      \
+        memcpy(dst, &b_, 4);                                                                    \
+    } while (0)
+#define LOAD_RGBA(p, w, PIXEL)                                                                  \
+    do {                                                                                        \
+        v16u8 a_, b_;                                                                           \
+        v32u8 l_, f_ = { 0 };                                                                   \
+        SIMD_LOAD(a_, p);                                                                       \
+        SIMD_LOAD(b_, (p) + 12);                                                                \
+        f_ = ~f_;                                                                               \
+        l_ = SIMD_SHUFFLE(v32u8, a_, b_, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,  \
+                          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);      \
+        w = (v8i32) SIMD_SHUFFLE(v32u8, l_, f_, PIXEL(0), PIXEL(3), PIXEL(6), PIXEL(9),         \
+                                 PIXEL(16), PIXEL(19), PIXEL(22), PIXEL(25));                   \
+    } while (0)
+#include "conversions_simd_kernels.h"
+#undef LANES
+#undef VEC
+#undef KERNEL
+#undef LOAD_RGB
+#undef SWAP_PAIRS
+#undef STORE_PAIRS
+#undef STORE_BYTES
+#undef STORE_EVEN
+#undef LOAD_RGBA
+#undef Z
+
+#undef PIX
+#undef RGBA_PIXEL
+#undef BGRA_PIXEL
+
+/*
+  YUV to RGB8: the bytes of the luma and of the chroma of the pixel pair k
+  (UYVY, YUYV), of the group of 4 pixels k (UYYVYY, that is YUV411) or of
+  the pixel k (UYV, that is YUV444).
+ */
+#define UYVY_Y(k)   4*(k)+1, 4*(k)+3
+#define UYVY_U(k)   4*(k), 4*(k)
+#define UYVY_V(k)   4*(k)+2, 4*(k)+2
+#define YUYV_Y(k)   4*(k), 4*(k)+2
+#define YUYV_U(k)   4*(k)+1, 4*(k)+1
+#define YUYV_V(k)   4*(k)+3, 4*(k)+3
+#define UYYVYY_Y(k) 6*(k)+1, 6*(k)+2, 6*(k)+4, 6*(k)+5
+#define UYYVYY_U(k) 6*(k), 6*(k), 6*(k), 6*(k)
+#define UYYVYY_V(k) 6*(k)+3, 6*(k)+3, 6*(k)+3, 6*(k)+3
+#define UYV_Y(k)    3*(k)+1
+#define UYV_U(k)    3*(k)
+#define UYV_V(k)    3*(k)+2
+
+/* the bytes of the RGB8 pixel k in the red bytes of a step, followed by the green ones and the blue ones */
+#define RGB(k) (k), LANES+(k), 2*LANES+(k)
+
+#define GROUPS_2(m)  m(0), m(1)
+#define GROUPS_4(m)  GROUPS_2(m), m(2), m(3)
+#define GROUPS_8(m)  GROUPS_4(m), m(4), m(5), m(6), m(7)
+#define GROUPS_16(m) GROUPS_8(m), m(8), m(9), m(10), m(11), m(12), m(13), m(14), m(15)
+
+/* 8 pixels per step: one 128-bit register of 16-bit words (SSSE3, NEON) */
+#define LANES 8
+#define VEC v8i16
+#define HALF_VEC v4i16
+#define BYTES v8u8
+#define WIDE_BYTES v16u8
+#define HALF_BYTES v4u8
+#define KERNEL(f) f##_x8
+#define PAIRS GROUPS_4
+#define QUADS GROUPS_2
+#define PIXELS GROUPS_8
+#define STORE_RGB(p, r, g, b)                                                                   \
+    do {                                                                                        \
+        v16u8 rg_ = SIMD_SHUFFLE(v16u8, r, g, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); \
+        v16u8 bb_ = SIMD_SHUFFLE(v16u8, b, b, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); \
+        v16u8 s0_ = SIMD_SHUFFLE(v16u8, rg_, bb_, RGB(0), RGB(1), RGB(2), RGB(3), RGB(4), 5);   \
+        v8u8 s1_ = SIMD_SHUFFLE(v8u8, rg_, bb_, LANES+5, 2*LANES+5, RGB(6), RGB(7));            \
+        SIMD_STORE(p, s0_);                                                                     \
+        SIMD_STORE((p) + 16, s1_);                                                              \
+    } while (0)
+#include "conversions_simd_kernels_yuv.h"
+#undef LANES
+#undef VEC
+#undef HALF_VEC
+#undef BYTES
+#undef WIDE_BYTES
+#undef HALF_BYTES
+#undef KERNEL
+#undef PAIRS
+#undef QUADS
+#undef PIXELS
+#undef STORE_RGB
+
+/* 16 pixels per step: one 256-bit register of 16-bit words (AVX2) */
+#define LANES 16
+#define VEC v16i16
+#define HALF_VEC v8i16
+#define BYTES v16u8
+#define WIDE_BYTES v32u8
+#define HALF_BYTES v8u8
+#define KERNEL(f) f##_x16
+#define PAIRS GROUPS_8
+#define QUADS GROUPS_4
+#define PIXELS GROUPS_16
+#define STORE_RGB(p, r, g, b)                                                                   \
+    do {                                                                                        \
+        v32u8 rg_ = SIMD_SHUFFLE(v32u8, r, g, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, \
+                                 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31); \
+        v32u8 bb_ = SIMD_SHUFFLE(v32u8, b, b, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, \
+                                 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31); \
+        v32u8 s0_ = SIMD_SHUFFLE(v32u8, rg_, bb_, RGB(0), RGB(1), RGB(2), RGB(3), RGB(4), RGB(5), \
+                                 RGB(6), RGB(7), RGB(8), RGB(9), 10, LANES+10);                 \
+        v16u8 s1_ = SIMD_SHUFFLE(v16u8, rg_, bb_, 2*LANES+10, RGB(11), RGB(12), RGB(13), RGB(14), RGB(15)); \
+        SIMD_STORE(p, s0_);                                                                     \
+        SIMD_STORE((p) + 32, s1_);                                                              \
+    } while (0)
+#include "conversions_simd_kernels_yuv.h"
+#undef LANES
+#undef VEC
+#undef HALF_VEC
+#undef BYTES
+#undef WIDE_BYTES
+#undef HALF_BYTES
+#undef KERNEL
+#undef PAIRS
+#undef QUADS
+#undef PIXELS
+#undef STORE_RGB
+
+#undef UYVY_Y
+#undef UYVY_U
+#undef UYVY_V
+#undef YUYV_Y
+#undef YUYV_U
+#undef YUYV_V
+#undef UYYVYY_Y
+#undef UYYVYY_U
+#undef UYYVYY_V
+#undef UYV_Y
+#undef UYV_U
+#undef UYV_V
+#undef RGB
+#undef GROUPS_2
+#undef GROUPS_4
+#undef GROUPS_8
+#undef GROUPS_16
+
+/*
+  Unpacking: the bytes of 8 samples, starting at byte o of the loaded
+  vector, for each packing. B(k) zero-extends byte k to a 16-bit lane.
+ */
+#define B(k) (k), Z
+#define MSB_2IN3(o)  B(o), B(o+2), B(o+3), B(o+5), B(o+6), B(o+8), B(o+9), B(o+11)
+#define LSB_2IN3(o)  B(o+1), B(o+1), B(o+4), B(o+4), B(o+7), B(o+7), B(o+10), B(o+10)
+#define MSB_MIPI12(o) B(o), B(o+1), B(o+3), B(o+4), B(o+6), B(o+7), B(o+9), B(o+10)
+#define LSB_MIPI12(o) B(o+2), B(o+2), B(o+5), B(o+5), B(o+8), B(o+8), B(o+11), B(o+11)
+#define MSB_MIPI10(o) B(o), B(o+1), B(o+2), B(o+3), B(o+5), B(o+6), B(o+7), B(o+8)
+#define LSB_MIPI10(o) B(o+4), B(o+4), B(o+4), B(o+4), B(o+9), B(o+9), B(o+9), B(o+9)
+
+/* the shuffles of the packing: x is the vector of the bytes, z that of zeros,
+   and at(m) gives the indices m(o) of each group of 8 samples */
+#define UNPACK_SHUFFLES(type, uvec, x, z, packing, msb, lsb, at)                               \
+    do {                                                                                       \
+        switch (packing) {                                                                     \
+        case DC1394_PACKING_12BIT:                                                             \
+        case DC1394_PACKING_10BIT:                                                             \
+            msb = (uvec) SIMD_SHUFFLE(type, x, z, at(MSB_2IN3));                               \
+            lsb = (uvec) SIMD_SHUFFLE(type, x, z, at(LSB_2IN3));                               \
+            break;                                                                             \
+        case DC1394_PACKING_12BIT_MIPI:                                                        \
+            msb = (uvec) SIMD_SHUFFLE(type, x, z, at(MSB_MIPI12));                             \
+            lsb = (uvec) SIMD_SHUFFLE(type, x, z, at(LSB_MIPI12));                             \
+            break;                                                                             \
+        default:                                                                               \
+            msb = (uvec) SIMD_SHUFFLE(type, x, z, at(MSB_MIPI10));                             \
+            lsb = (uvec) SIMD_SHUFFLE(type, x, z, at(LSB_MIPI10));                             \
+            break;                                                                             \
+        }                                                                                      \
+    } while (0)
+
+/* 8 samples per step: one 128-bit register of 16-bit words (SSSE3, NEON) */
+#define LANES 8
+#define UVEC v8u16
+#define KERNEL(f) f##_x8
+#define Z 16
+#define HALF(m) m(0)
+#define LOAD_UNPACK(p, packing, msb, lsb)                                                      \
+    do {                                                                                       \
+        v16u8 a_, z_ = { 0 };                                                                  \
+        SIMD_LOAD(a_, p);                                                                      \
+        UNPACK_SHUFFLES(v16u8, v8u16, a_, z_, packing, msb, lsb, HALF);                        \
+    } while (0)
+#define LOAD_BYTES(step) 16
+#include "conversions_simd_kernels_unpack.h"
+#undef LANES
+#undef UVEC
+#undef KERNEL
+#undef Z
+#undef HALF
+#undef LOAD_UNPACK
+#undef LOAD_BYTES
+
+/* 16 samples per step: one 256-bit register of 16-bit words (AVX2). Each
+   128-bit half gets 8 samples, so the byte shuffles stay within the halves. */
+#define LANES 16
+#define UVEC v16u16
+#define KERNEL(f) f##_x16
+#define Z 32
+#define HALVES(m) m(0), m(16)
+#define LOAD_UNPACK(p, packing, msb, lsb)                                                      \
+    do {                                                                                       \
+        v16u8 a_, b_;                                                                          \
+        v32u8 l_, z_ = { 0 };                                                                  \
+        SIMD_LOAD(a_, p);                                                                      \
+        SIMD_LOAD(b_, (p) + ((packing) == DC1394_PACKING_10BIT_MIPI ? 10 : 12));               \
+        l_ = SIMD_SHUFFLE(v32u8, a_, b_, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, \
+                          16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);     \
+        UNPACK_SHUFFLES(v32u8, v16u16, l_, z_, packing, msb, lsb, HALVES);                     \
+    } while (0)
+#define LOAD_BYTES(step) ((step) + 16)
+#include "conversions_simd_kernels_unpack.h"
+#undef LANES
+#undef UVEC
+#undef KERNEL
+#undef Z
+#undef HALVES
+#undef LOAD_UNPACK
+#undef LOAD_BYTES
+
+#undef UNPACK_SHUFFLES
+#undef MSB_2IN3
+#undef LSB_2IN3
+#undef MSB_MIPI12
+#undef LSB_MIPI12
+#undef MSB_MIPI10
+#undef LSB_MIPI10
+#undef B
+
+/* 8 samples per step: one 128-bit register of 16-bit words (SSE2, NEON) */
+#define LANES 8
+#define UVEC v8u16
+#define BYTES v8u8
+#define KERNEL(f) f##_x8
+#include "conversions_simd_kernels_depth.h"
+#undef LANES
+#undef UVEC
+#undef BYTES
+#undef KERNEL
+
+/* 16 samples per step: one 256-bit register of 16-bit words (AVX2) */
+#define LANES 16
+#define UVEC v16u16
+#define BYTES v16u8
+#define KERNEL(f) f##_x16
+#include "conversions_simd_kernels_depth.h"
+#undef LANES
+#undef UVEC
+#undef BYTES
+#undef KERNEL
+
+#define SAMPLES_16(m) m(0), m(1), m(2), m(3), m(4), m(5), m(6), m(7), m(8), m(9), m(10), m(11), m(12), m(13), \
+                      m(14), m(15)
+#define SAMPLES_32(m) SAMPLES_16(m), m(16), m(17), m(18), m(19), m(20), m(21), m(22), m(23), m(24), m(25), \
+                      m(26), m(27), m(28), m(29), m(30), m(31)
+
+/* 16 samples per step: one 128-bit register (SSSE3, NEON) */
+#define LANES 16
+#define BYTES v16u8
+#define KERNEL(f) f##_x16
+#define SAMPLES SAMPLES_16
+#include "conversions_simd_kernels_stereo.h"
+#undef LANES
+#undef BYTES
+#undef KERNEL
+#undef SAMPLES
+
+/* 32 samples per step: one 256-bit register (AVX2) */
+#define LANES 32
+#define BYTES v32u8
+#define KERNEL(f) f##_x32
+#define SAMPLES SAMPLES_32
+#include "conversions_simd_kernels_stereo.h"
+#undef LANES
+#undef BYTES
+#undef KERNEL
+#undef SAMPLES
+
+#undef SAMPLES_16
+#undef SAMPLES_32
+
+/* one copy of each conversion per instruction set */
+#define CONVERSION_CLONE(kernel, width, isa, target)                                          \
+    target static void                                                                        \
+    kernel##_##isa(const uint8_t *restrict src, uint8_t *restrict dst, int pixels, uint32_t byte_order) \
+    {                                                                                         \
+        kernel##_##width(src, dst, pixels, byte_order);                                       \
+    }
+
+#define RGBA_CLONE(width, isa, target)                                                        \
+    target static void                                                                        \
+    rgb8_to_rgba_##isa(const uint8_t *restrict src, uint8_t *restrict dest, int pixels,        \
+                       dc1394color_coding_t coding)                                           \
+    {                                                                                         \
+        rgb8_to_rgba_##width(src, dest, pixels, coding);                                      \
+    }
+
+#define PLANAR_CLONE(width, isa, target)                                                      \
+    target static void                                                                        \
+    rgb8_to_planar_##isa(const uint8_t *restrict src, uint8_t *restrict r, uint8_t *restrict g, \
+                         uint8_t *restrict b, int pixels)                                     \
+    {                                                                                         \
+        rgb8_to_planar_##width(src, r, g, b, pixels);                                         \
+    }
+
+#define YUV420_CLONE(width, isa, target)                                                      \
+    target static void                                                                        \
+    rgb8_to_yuv420_##isa(const uint8_t *restrict src0, const uint8_t *restrict src1,           \
+                         uint8_t *restrict y0, uint8_t *restrict y1, uint8_t *restrict u,     \
+                         uint8_t *restrict v, int pixels, dc1394color_coding_t coding)        \
+    {                                                                                         \
+        rgb8_to_yuv420_##width(src0, src1, y0, y1, u, v, pixels, coding);                     \
+    }
+
+#define YUV_YUV420_CLONE(kernel, width, isa, target)                                          \
+    target static void                                                                        \
+    kernel##_##isa(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0, \
+                   uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels, \
+                   uint32_t byte_order, dc1394color_coding_t coding)                          \
+    {                                                                                         \
+        kernel##_##width(src0, src1, y0, y1, u, v, pixels, byte_order, coding);               \
+    }
+
+/* one copy of the unpacking per instruction set and packing, so that the shuffles are constants */
+#define UNPACK_CLONE(width, isa, target)                                                      \
+    target static void                                                                        \
+    unpack_##isa(const uint8_t *restrict src, uint16_t *restrict dest, int pixels, dc1394packing_t packing) \
+    {                                                                                         \
+        switch (packing) {                                                                    \
+        case DC1394_PACKING_12BIT:                                                            \
+            unpack_##width(src, dest, pixels, DC1394_PACKING_12BIT);                          \
+            break;                                                                            \
+        case DC1394_PACKING_12BIT_MIPI:                                                       \
+            unpack_##width(src, dest, pixels, DC1394_PACKING_12BIT_MIPI);                     \
+            break;                                                                            \
+        case DC1394_PACKING_10BIT:                                                            \
+            unpack_##width(src, dest, pixels, DC1394_PACKING_10BIT);                          \
+            break;                                                                            \
+        case DC1394_PACKING_10BIT_MIPI:                                                       \
+            unpack_##width(src, dest, pixels, DC1394_PACKING_10BIT_MIPI);                     \
+            break;                                                                            \
+        }                                                                                     \
+    }
+
+#define DEPTH_CLONE(width, isa, target)                                                       \
+    target static void                                                                        \
+    depth16_to_8_##isa(const uint8_t *restrict src, uint8_t *restrict dest, int samples, uint32_t shift, \
+                       int little_endian)                                                     \
+    {                                                                                         \
+        depth16_to_8_##width(src, dest, samples, shift, little_endian);                       \
+    }
+
+#define STEREO_CLONE(width, isa, target)                                                      \
+    target static void                                                                        \
+    sensor_pick_##isa(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors) \
+    {                                                                                         \
+        sensor_pick_##width(src, dest, pixels, sensors);                                      \
+    }
+
+#ifdef DC1394_SIMD_X86
+CONVERSION_CLONE(rgb8_to_yuv422, x8, avx2, SIMD_TARGET_AVX2)
+CONVERSION_CLONE(yuv422_to_rgb8, x16, avx2, SIMD_TARGET_AVX2)
+CONVERSION_CLONE(yuv422_to_rgb8, x8, ssse3, SIMD_TARGET_SSSE3)
+CONVERSION_CLONE(yuv411_to_rgb8, x16, avx2, SIMD_TARGET_AVX2)
+CONVERSION_CLONE(yuv411_to_rgb8, x8, ssse3, SIMD_TARGET_SSSE3)
+CONVERSION_CLONE(yuv444_to_rgb8, x16, avx2, SIMD_TARGET_AVX2)
+CONVERSION_CLONE(yuv444_to_rgb8, x8, ssse3, SIMD_TARGET_SSSE3)
+YUV420_CLONE(x8, avx2, SIMD_TARGET_AVX2)
+YUV_YUV420_CLONE(yuv422_to_yuv420, x16, avx2, SIMD_TARGET_AVX2)
+YUV_YUV420_CLONE(yuv422_to_yuv420, x8, ssse3, SIMD_TARGET_SSSE3)
+YUV_YUV420_CLONE(yuv411_to_yuv420, x16, avx2, SIMD_TARGET_AVX2)
+YUV_YUV420_CLONE(yuv411_to_yuv420, x8, ssse3, SIMD_TARGET_SSSE3)
+YUV_YUV420_CLONE(yuv444_to_yuv420, x16, avx2, SIMD_TARGET_AVX2)
+YUV_YUV420_CLONE(yuv444_to_yuv420, x8, ssse3, SIMD_TARGET_SSSE3)
+RGBA_CLONE(x8, avx2, SIMD_TARGET_AVX2)
+RGBA_CLONE(x4, ssse3, SIMD_TARGET_SSSE3)
+PLANAR_CLONE(x8, avx2, SIMD_TARGET_AVX2)
+PLANAR_CLONE(x4, ssse3, SIMD_TARGET_SSSE3)
+UNPACK_CLONE(x16, avx2, SIMD_TARGET_AVX2)
+UNPACK_CLONE(x8, ssse3, SIMD_TARGET_SSSE3)
+DEPTH_CLONE(x16, avx2, SIMD_TARGET_AVX2)
+DEPTH_CLONE(x8, sse2, SIMD_TARGET_SSE2)
+STEREO_CLONE(x32, avx2, SIMD_TARGET_AVX2)
+STEREO_CLONE(x16, ssse3, SIMD_TARGET_SSSE3)
+
+/* the 32-bit products need AVX2 (or SSE4.1) to beat the scalar code */
+#define CONVERSION_SIMD_PICK_WIDE(kernel)                        \
+    ((features & SIMD_FEATURE_AVX2) ? kernel##_avx2 : NULL)
+
+/* the byte shuffles need SSSE3 */
+#define UNPACK_SIMD_PICK()                                       \
+    ((features & SIMD_FEATURE_AVX2) ? unpack_avx2 :              \
+     (features & SIMD_FEATURE_SSSE3) ? unpack_ssse3 : NULL)
+#define CONVERSION_SIMD_PICK_SHUFFLE(kernel)                     \
+    ((features & SIMD_FEATURE_AVX2) ? kernel##_avx2 :            \
+     (features & SIMD_FEATURE_SSSE3) ? kernel##_ssse3 : NULL)
+#define STEREO_SIMD_PICK()                                       \
+    ((features & SIMD_FEATURE_AVX2) ? sensor_pick_avx2 :         \
+     (features & SIMD_FEATURE_SSSE3) ? sensor_pick_ssse3 : NULL)
+
+/* shifts and narrowing only: SSE2 is enough */
+#define DEPTH_SIMD_PICK()                                        \
+    ((features & SIMD_FEATURE_AVX2) ? depth16_to_8_avx2 :        \
+     (features & SIMD_FEATURE_SSE2) ? depth16_to_8_sse2 : NULL)
+#else
+CONVERSION_CLONE(rgb8_to_yuv422, x4, neon, )
+CONVERSION_CLONE(yuv422_to_rgb8, x8, neon, )
+CONVERSION_CLONE(yuv411_to_rgb8, x8, neon, )
+CONVERSION_CLONE(yuv444_to_rgb8, x8, neon, )
+YUV420_CLONE(x4, neon, )
+YUV_YUV420_CLONE(yuv422_to_yuv420, x8, neon, )
+YUV_YUV420_CLONE(yuv411_to_yuv420, x8, neon, )
+YUV_YUV420_CLONE(yuv444_to_yuv420, x8, neon, )
+RGBA_CLONE(x4, neon, )
+PLANAR_CLONE(x4, neon, )
+UNPACK_CLONE(x8, neon, )
+DEPTH_CLONE(x8, neon, )
+STEREO_CLONE(x16, neon, )
+
+#define CONVERSION_SIMD_PICK_WIDE(kernel)                        \
+    ((features & SIMD_FEATURE_NEON) ? kernel##_neon : NULL)
+#define CONVERSION_SIMD_PICK_SHUFFLE(kernel)                     \
+    ((features & SIMD_FEATURE_NEON) ? kernel##_neon : NULL)
+
+#define UNPACK_SIMD_PICK()                                       \
+    ((features & SIMD_FEATURE_NEON) ? unpack_neon : NULL)
+#define DEPTH_SIMD_PICK()                                        \
+    ((features & SIMD_FEATURE_NEON) ? depth16_to_8_neon : NULL)
+#define STEREO_SIMD_PICK()                                       \
+    ((features & SIMD_FEATURE_NEON) ? sensor_pick_neon : NULL)
+#endif
+
+#endif /* DC1394_SIMD */
+
+conversion_8bit_func_t
+conversion_simd_get_rgb8_to_yuv422(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_WIDE(rgb8_to_yuv422);
+#else
+    return NULL;
+#endif
+}
+
+conversion_8bit_func_t
+conversion_simd_get_yuv422_to_rgb8(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_SHUFFLE(yuv422_to_rgb8);
+#else
+    return NULL;
+#endif
+}
+
+conversion_8bit_func_t
+conversion_simd_get_yuv411_to_rgb8(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_SHUFFLE(yuv411_to_rgb8);
+#else
+    return NULL;
+#endif
+}
+
+conversion_8bit_func_t
+conversion_simd_get_yuv444_to_rgb8(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_SHUFFLE(yuv444_to_rgb8);
+#else
+    return NULL;
+#endif
+}
+
+conversion_yuv420_func_t
+conversion_simd_get_rgb8_to_yuv420(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_WIDE(rgb8_to_yuv420);
+#else
+    return NULL;
+#endif
+}
+
+conversion_yuv_to_yuv420_func_t
+conversion_simd_get_yuv_to_yuv420(dc1394color_coding_t from)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    switch (from) {
+    case DC1394_COLOR_CODING_YUV422:
+        return CONVERSION_SIMD_PICK_SHUFFLE(yuv422_to_yuv420);
+    case DC1394_COLOR_CODING_YUV411:
+        return CONVERSION_SIMD_PICK_SHUFFLE(yuv411_to_yuv420);
+    case DC1394_COLOR_CODING_YUV444:
+        return CONVERSION_SIMD_PICK_SHUFFLE(yuv444_to_yuv420);
+    default:
+        return NULL;
+    }
+#else
+    (void)from;
+    return NULL;
+#endif
+}
+
+conversion_rgba_func_t
+conversion_simd_get_rgb8_to_rgba(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_SHUFFLE(rgb8_to_rgba);
+#else
+    return NULL;
+#endif
+}
+
+conversion_planar_func_t
+conversion_simd_get_rgb8_to_planar(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return CONVERSION_SIMD_PICK_SHUFFLE(rgb8_to_planar);
+#else
+    return NULL;
+#endif
+}
+
+unpack_func_t
+conversion_simd_get_unpack(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return UNPACK_SIMD_PICK();
+#else
+    return NULL;
+#endif
+}
+
+depth_func_t
+conversion_simd_get_depth16_to_8(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return DEPTH_SIMD_PICK();
+#else
+    return NULL;
+#endif
+}
+
+sensor_pick_func_t
+conversion_simd_get_sensor_pick(void)
+{
+#ifdef DC1394_SIMD
+    uint32_t features = simd_get_features();
+
+    return STEREO_SIMD_PICK();
+#else
+    return NULL;
+#endif
+}
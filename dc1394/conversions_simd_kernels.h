@@ -0,0 +1,157 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions: kernel bodies
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by conversions_simd.c once per vector width, with:
+
+    LANES                      pixels per step (even)
+    VEC                        vector of LANES signed 32-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD_RGB(p, r, g, b)       LANES RGB8 pixels at p as three VEC; may read
+                               up to 4 bytes beyond them
+    SWAP_PAIRS(v)              v with its lanes 2k and 2k+1 exchanged
+    STORE_PAIRS(dst, lo, hi)   stores lo and hi (in 0..255) as LANES byte
+                               pairs: lo[0], hi[0], lo[1], hi[1]...
+    STORE_BYTES(dst, v)        stores the LANES lanes of v (in 0..255) as bytes
+    STORE_EVEN(dst, v)         stores the even lanes of v (in 0..255) as
+                               LANES/2 bytes
+    LOAD_RGBA(p, w, PIXEL)     LANES RGB8 pixels at p as the words of w, their
+                               bytes in the order of PIXEL (RGBA_PIXEL or
+                               BGRA_PIXEL) with an alpha of 255; may read up
+                               to 4 bytes beyond them
+
+  The arithmetic is that of RGB2YUV in 32 bits, so the output is exactly
+  that of the scalar code. Each lane computes the Y, U and V of its pixel;
+  a YUV422 pixel then takes its luma and the average of the U (on even
+  pixels) or V (on odd pixels) of its pair, and a YUV420 block the average
+  of those of its four pixels.
+ */
+
+#define CLAMP_255(v)                                    \
+    ({                                                  \
+        VEC v_ = (v);                                   \
+        v_ = SIMD_SELECT(v_ > 0, v_, 0);                \
+        SIMD_SELECT(v_ > 255, 255, v_);                 \
+    })
+
+SIMD_INLINE void
+KERNEL(rgb8_to_yuv422)(const uint8_t *restrict rgb, uint8_t *restrict yuv, int pixels, uint32_t byte_order)
+{
+    VEC r, g, b, y, u, v, c, even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+
+    // two more pixels cover the bytes read beyond the last ones
+    for (i = 0; i + LANES + 2 <= pixels; i += LANES, rgb += 3 * LANES, yuv += 2 * LANES) {
+        LOAD_RGB(rgb, r, g, b);
+        y = CLAMP_255((306 * r + 601 * g + 117 * b) >> 10);
+        u = CLAMP_255(((-172 * r - 340 * g + 512 * b) >> 10) + 128);
+        v = CLAMP_255(((512 * r - 429 * g - 83 * b) >> 10) + 128);
+        c = SIMD_SELECT(even, u + SWAP_PAIRS(u), v + SWAP_PAIRS(v)) >> 1;
+        if (byte_order == DC1394_BYTE_ORDER_YUYV)
+            STORE_PAIRS(yuv, y, c);
+        else
+            STORE_PAIRS(yuv, c, y);
+    }
+
+    rgb8_to_yuv422_pairs(rgb, yuv, pixels - i, byte_order);
+}
+
+SIMD_INLINE void
+KERNEL(rgb8_to_yuv420)(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                       uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                       dc1394color_coding_t coding)
+{
+    VEC r, g, b, y, us, vs, c, even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+
+    for (i = 0; i + LANES + 2 <= pixels; i += LANES) {
+        LOAD_RGB(src0 + 3 * i, r, g, b);
+        y = CLAMP_255((306 * r + 601 * g + 117 * b) >> 10);
+        STORE_BYTES(y0 + i, y);
+        us = CLAMP_255(((-172 * r - 340 * g + 512 * b) >> 10) + 128);
+        vs = CLAMP_255(((512 * r - 429 * g - 83 * b) >> 10) + 128);
+        LOAD_RGB(src1 + 3 * i, r, g, b);
+        y = CLAMP_255((306 * r + 601 * g + 117 * b) >> 10);
+        STORE_BYTES(y1 + i, y);
+        us += CLAMP_255(((-172 * r - 340 * g + 512 * b) >> 10) + 128);
+        vs += CLAMP_255(((512 * r - 429 * g - 83 * b) >> 10) + 128);
+        // both lanes of a pair get the sum of the block
+        us = (us + SWAP_PAIRS(us)) >> 2;
+        vs = (vs + SWAP_PAIRS(vs)) >> 2;
+        if (coding == DC1394_COLOR_CODING_NV12) {
+            c = SIMD_SELECT(even, us, vs);
+            STORE_BYTES(u + i, c);
+        } else {
+            STORE_EVEN(u + i / 2, us);
+            STORE_EVEN(v + i / 2, vs);
+        }
+    }
+
+    if (coding == DC1394_COLOR_CODING_NV12)
+        rgb8_to_yuv420_rows(src0 + 3 * i, src1 + 3 * i, y0 + i, y1 + i, u + i, NULL, pixels - i, coding);
+    else
+        rgb8_to_yuv420_rows(src0 + 3 * i, src1 + 3 * i, y0 + i, y1 + i, u + i / 2, v + i / 2, pixels - i, coding);
+}
+
+#undef CLAMP_255
+
+SIMD_INLINE void
+KERNEL(rgb8_to_planar)(const uint8_t *restrict rgb, uint8_t *restrict r, uint8_t *restrict g, uint8_t *restrict b,
+                       int pixels)
+{
+    VEC vr, vg, vb;
+    int i;
+
+    for (i = 0; i + LANES + 2 <= pixels; i += LANES) {
+        LOAD_RGB(rgb + 3 * i, vr, vg, vb);
+        STORE_BYTES(r + i, vr);
+        STORE_BYTES(g + i, vg);
+        STORE_BYTES(b + i, vb);
+    }
+
+    rgb8_to_planar_row(rgb + 3 * i, r + i, g + i, b + i, pixels - i);
+}
+
+SIMD_INLINE void
+KERNEL(rgb8_to_rgba)(const uint8_t *restrict rgb, uint8_t *restrict dest, int pixels, dc1394color_coding_t coding)
+{
+    VEC w;
+    int i;
+
+    if (coding == DC1394_COLOR_CODING_BGRA8) {
+        for (i = 0; i + LANES + 2 <= pixels; i += LANES) {
+            LOAD_RGBA(rgb + 3 * i, w, BGRA_PIXEL);
+            SIMD_STORE(dest + 4 * i, w);
+        }
+    } else {
+        for (i = 0; i + LANES + 2 <= pixels; i += LANES) {
+            LOAD_RGBA(rgb + 3 * i, w, RGBA_PIXEL);
+            SIMD_STORE(dest + 4 * i, w);
+        }
+    }
+
+    rgb8_to_rgba_row(rgb + 3 * i, dest + 4 * i, pixels - i, coding);
+}
@@ -0,0 +1,58 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions: 16-bit samples to 8 bits
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by conversions_simd.c once per vector width, with:
+
+    LANES                      samples per step
+    UVEC                       vector of LANES unsigned 16-bit words
+    BYTES                      vector of LANES bytes
+    KERNEL(f)                  name of the instance of kernel f
+
+  The vectorized code only exists for little endian CPUs: the samples are
+  loaded as they are, and swapped if they are big endian. As in
+  depth16_to_8_row(), the shifted samples keep their 8 low bits.
+ */
+
+SIMD_INLINE void
+KERNEL(depth16_to_8)(const uint8_t *restrict src, uint8_t *restrict dest, int samples, uint32_t shift,
+                     int little_endian)
+{
+    UVEC w;
+    BYTES b;
+    int i;
+
+    if (little_endian) {
+        for (i = 0; i + LANES <= samples; i += LANES) {
+            SIMD_LOAD(w, src + 2 * i);
+            b = __builtin_convertvector(w >> shift, BYTES);
+            SIMD_STORE(dest + i, b);
+        }
+    } else {
+        for (i = 0; i + LANES <= samples; i += LANES) {
+            SIMD_LOAD(w, src + 2 * i);
+            w = (w << 8) | (w >> 8);
+            b = __builtin_convertvector(w >> shift, BYTES);
+            SIMD_STORE(dest + i, b);
+        }
+    }
+
+    depth16_to_8_row(src + 2 * i, dest + i, samples - i, shift, little_endian);
+}
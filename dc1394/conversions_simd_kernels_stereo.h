@@ -0,0 +1,69 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions: samples of interleaved sensors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by conversions_simd.c once per vector width, with:
+
+    LANES                      samples per step
+    BYTES                      vector of LANES bytes
+    KERNEL(f)                  name of the instance of kernel f
+    SAMPLES(m)                 m(0), m(1)... m(LANES-1)
+
+  A step reads the sensors*LANES bytes from src, which starts on the byte of
+  the sensor and not on that of the pixel: each loop keeps a pixel after the
+  step so as not to read past the row. Other numbers of sensors than 2 and 3
+  are left to the scalar code.
+ */
+
+/* the byte of sample k among two vectors, and among the first two of three (any byte past them) */
+#define PICK_2(k) 2*(k)
+#define PICK_3_AB(k) (3*(k) < 2*LANES ? 3*(k) : 0)
+#define PICK_3_C(k) (3*(k) < 2*LANES ? (k) : LANES + 3*(k) - 2*LANES)
+
+SIMD_INLINE void
+KERNEL(sensor_pick)(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors)
+{
+    BYTES a, b, c, v;
+    int i = 0;
+
+    if (sensors == 2) {
+        for (; i + LANES < pixels; i += LANES) {
+            SIMD_LOAD(a, src + 2 * i);
+            SIMD_LOAD(b, src + 2 * i + LANES);
+            v = SIMD_SHUFFLE(BYTES, a, b, SAMPLES(PICK_2));
+            SIMD_STORE(dest + i, v);
+        }
+    } else if (sensors == 3) {
+        for (; i + LANES < pixels; i += LANES) {
+            SIMD_LOAD(a, src + 3 * i);
+            SIMD_LOAD(b, src + 3 * i + LANES);
+            SIMD_LOAD(c, src + 3 * i + 2 * LANES);
+            v = SIMD_SHUFFLE(BYTES, a, b, SAMPLES(PICK_3_AB));
+            v = SIMD_SHUFFLE(BYTES, v, c, SAMPLES(PICK_3_C));
+            SIMD_STORE(dest + i, v);
+        }
+    }
+
+    sensor_pick_row(src + sensors * i, dest + i, pixels - i, sensors);
+}
+
+#undef PICK_2
+#undef PICK_3_AB
+#undef PICK_3_C
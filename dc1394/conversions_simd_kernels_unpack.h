@@ -0,0 +1,61 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions: unpacking of 10 and 12-bit samples
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by conversions_simd.c once per vector width, with:
+
+    LANES                      samples per step, a multiple of 8
+    UVEC                       vector of LANES unsigned 16-bit words
+    KERNEL(f)                  name of the instance of kernel f
+    LOAD_UNPACK(p, packing, msb, lsb)
+                               the bytes of LANES samples at p: msb gets
+                               the byte of their 8 MSBs, lsb the byte that
+                               holds their LSBs, each widened to UVEC
+    LOAD_BYTES(step)           bytes read by LOAD_UNPACK, which may go
+                               beyond the 'step' bytes of every 8 samples
+
+  packing is a constant in each instance, so that the shuffles of
+  LOAD_UNPACK are constants too. The LSBs of a sample are shifted to the
+  top of their byte by a multiplication, which does a different shift in
+  each lane, then down to the bottom.
+ */
+
+SIMD_INLINE void
+KERNEL(unpack)(const uint8_t *restrict src, uint16_t *restrict dest, int pixels, dc1394packing_t packing)
+{
+    const int mipi10 = (packing == DC1394_PACKING_10BIT_MIPI);
+    const int lsbs = ((packing == DC1394_PACKING_12BIT) || (packing == DC1394_PACKING_12BIT_MIPI)) ? 4 : 2;
+    const int step = mipi10 ? 10 : 12;
+    const int bytes = mipi10 ? pixels / 4 * 5 : pixels / 2 * 3;
+    UVEC msb, lsb, mul, v;
+    int i, k;
+
+    // brings the LSBs of each sample, at bit 0, 2, 4 or 6 of their byte, to its top
+    for (i = 0; i < LANES; i++)
+        mul[i] = 1 << (8 - lsbs - (mipi10 ? 2 * (i & 3) : 4 * (i & 1)));
+
+    for (i = 0, k = 0; k + LOAD_BYTES(step) <= bytes; i += LANES, k += LANES / 8 * step) {
+        LOAD_UNPACK(src + k, packing, msb, lsb);
+        v = (msb << lsbs) | (((lsb * mul) & 0xff) >> (8 - lsbs));
+        SIMD_STORE(dest + i, v);
+    }
+
+    unpack_row(src + k, dest + i, pixels - i, packing);
+}
@@ -0,0 +1,243 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vectorized color conversion functions: YUV to RGB8, NV12 and I420
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  This file is included by conversions_simd.c once per vector width, with:
+
+    LANES                      pixels per step (a multiple of 4)
+    VEC, HALF_VEC              vectors of LANES and of LANES/2 signed 16-bit
+                               words
+    BYTES, WIDE_BYTES,         vectors of LANES, of 2*LANES and of LANES/2
+    HALF_BYTES                 bytes
+    KERNEL(f)                  name of the instance of kernel f
+    PAIRS(m), QUADS(m),        m(0), m(1)... for the pixel pairs, the groups
+    PIXELS(m)                  of 4 pixels and the pixels of a step
+    STORE_RGB(p, r, g, b)      stores the LANES bytes of r, g and b as RGB8
+                               pixels at p
+
+  The samples of a step are picked from the 4*LANES bytes at its start, so
+  each loop keeps enough pixels after the step to cover them.
+
+  YUV2RGB is computed in 16 bits without changing its result: with u and v
+  in -128..127, (1436*v) >> 10 is v + ((103*v) >> 8), (1814*u) >> 10 is
+  2*u + ((-117*u) >> 9), and (352*u + 731*v) >> 10 is
+  (u + 3*v + ((96*u - 37*v) >> 8)) >> 2, whose terms all fit in 16 bits.
+
+  To NV12 and I420, the chroma of the pixels is summed over the 2x2 blocks
+  while it is still centered: the sum is off by 4*128, so that adding 128
+  after the division by 4 gives the rounded average exactly.
+ */
+
+#define CLAMP_255(v)                                    \
+    ({                                                  \
+        VEC v_ = (v);                                   \
+        v_ = SIMD_SELECT(v_ > 0, v_, 0);                \
+        SIMD_SELECT(v_ > 255, 255, v_);                 \
+    })
+
+/* the luma and the centered chroma of each pixel of a step at p, with the byte indices groups(layout##_Y)... */
+#define LOAD_YUV(p, y, u, v, groups, layout)                                                    \
+    do {                                                                                        \
+        WIDE_BYTES a_, b_;                                                                      \
+        BYTES y_, u_, v_;                                                                       \
+        SIMD_LOAD(a_, p);                                                                       \
+        SIMD_LOAD(b_, (p) + 2 * LANES);                                                         \
+        y_ = SIMD_SHUFFLE(BYTES, a_, b_, groups(layout##_Y));                                   \
+        u_ = SIMD_SHUFFLE(BYTES, a_, b_, groups(layout##_U));                                   \
+        v_ = SIMD_SHUFFLE(BYTES, a_, b_, groups(layout##_V));                                   \
+        y = __builtin_convertvector(y_, VEC);                                                   \
+        u = __builtin_convertvector(u_, VEC) - 128;                                             \
+        v = __builtin_convertvector(v_, VEC) - 128;                                             \
+    } while (0)
+
+#define YUV_TO_RGB(p, y, u, v)                                                                  \
+    do {                                                                                        \
+        VEC r_, g_, b_;                                                                         \
+        r_ = CLAMP_255(y + v + ((103 * v) >> 8));                                               \
+        g_ = CLAMP_255(y - ((u + 3 * v + ((96 * u - 37 * v) >> 8)) >> 2));                      \
+        b_ = CLAMP_255(y + 2 * u + ((-117 * u) >> 9));                                          \
+        STORE_RGB(p, __builtin_convertvector(r_, BYTES), __builtin_convertvector(g_, BYTES),    \
+                  __builtin_convertvector(b_, BYTES));                                          \
+    } while (0)
+
+SIMD_INLINE void
+KERNEL(yuv422_to_rgb8)(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels, uint32_t byte_order)
+{
+    VEC y, u, v;
+    int i;
+
+    if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+        for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+            LOAD_YUV(yuv + 2 * i, y, u, v, PAIRS, YUYV);
+            YUV_TO_RGB(rgb + 3 * i, y, u, v);
+        }
+    } else {
+        for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+            LOAD_YUV(yuv + 2 * i, y, u, v, PAIRS, UYVY);
+            YUV_TO_RGB(rgb + 3 * i, y, u, v);
+        }
+    }
+
+    yuv422_to_rgb8_pairs(yuv + 2 * i, rgb + 3 * i, pixels - i, byte_order);
+}
+
+SIMD_INLINE void
+KERNEL(yuv411_to_rgb8)(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels, uint32_t byte_order)
+{
+    VEC y, u, v;
+    int i;
+
+    (void)byte_order;
+    for (i = 0; i + 3 * LANES <= pixels; i += LANES) {
+        LOAD_YUV(yuv + 3 * i / 2, y, u, v, QUADS, UYYVYY);
+        YUV_TO_RGB(rgb + 3 * i, y, u, v);
+    }
+
+    yuv411_to_rgb8_quads(yuv + 3 * i / 2, rgb + 3 * i, pixels - i);
+}
+
+SIMD_INLINE void
+KERNEL(yuv444_to_rgb8)(const uint8_t *restrict yuv, uint8_t *restrict rgb, int pixels, uint32_t byte_order)
+{
+    VEC y, u, v;
+    int i;
+
+    (void)byte_order;
+    for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+        LOAD_YUV(yuv + 3 * i, y, u, v, PIXELS, UYV);
+        YUV_TO_RGB(rgb + 3 * i, y, u, v);
+    }
+
+    yuv444_to_rgb8_pixels(yuv + 3 * i, rgb + 3 * i, pixels - i);
+}
+
+/* the luma of the two rows of a step at pixel i of y0 and y1, and the chroma of its 2x2 blocks at u (and v) */
+#define STORE_YUV420(i, ya, yb, ua, ub, va, vb)                                                 \
+    do {                                                                                        \
+        VEC us_ = (ua) + (ub), vs_ = (va) + (vb);                                               \
+        BYTES l_;                                                                               \
+        HALF_BYTES h_;                                                                          \
+        l_ = __builtin_convertvector(ya, BYTES);                                                \
+        SIMD_STORE(y0 + (i), l_);                                                               \
+        l_ = __builtin_convertvector(yb, BYTES);                                                \
+        SIMD_STORE(y1 + (i), l_);                                                               \
+        /* both lanes of a pair get the average of the block */                                 \
+        us_ = ((us_ + SIMD_SHUFFLE(VEC, us_, us_, PIXELS(SWAP)) + 2) >> 2) + 128;               \
+        vs_ = ((vs_ + SIMD_SHUFFLE(VEC, vs_, vs_, PIXELS(SWAP)) + 2) >> 2) + 128;               \
+        if (coding == DC1394_COLOR_CODING_NV12) {                                               \
+            l_ = __builtin_convertvector(SIMD_SELECT(even, us_, vs_), BYTES);                   \
+            SIMD_STORE(u + (i), l_);                                                            \
+        } else {                                                                                \
+            h_ = __builtin_convertvector(SIMD_SHUFFLE(HALF_VEC, us_, us_, PAIRS(EVEN)), HALF_BYTES); \
+            SIMD_STORE(u + (i) / 2, h_);                                                        \
+            h_ = __builtin_convertvector(SIMD_SHUFFLE(HALF_VEC, vs_, vs_, PAIRS(EVEN)), HALF_BYTES); \
+            SIMD_STORE(v + (i) / 2, h_);                                                        \
+        }                                                                                       \
+    } while (0)
+
+/* the end of the rows from pixel i, bytes bytes into them, in scalar code */
+#define YUV420_TAIL(from, i, bytes)                                                             \
+    do {                                                                                        \
+        if (coding == DC1394_COLOR_CODING_NV12)                                                 \
+            yuv_to_yuv420_rows(src0 + (bytes), src1 + (bytes), y0 + (i), y1 + (i), u + (i), NULL, \
+                               pixels - (i), from, byte_order, coding);                         \
+        else                                                                                    \
+            yuv_to_yuv420_rows(src0 + (bytes), src1 + (bytes), y0 + (i), y1 + (i), u + (i) / 2, \
+                               v + (i) / 2, pixels - (i), from, byte_order, coding);            \
+    } while (0)
+
+#define SWAP(k) (k)^1
+#define EVEN(k) 2*(k)
+
+SIMD_INLINE void
+KERNEL(yuv422_to_yuv420)(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                         uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                         uint32_t byte_order, dc1394color_coding_t coding)
+{
+    VEC ya, ua, va, yb, ub, vb, even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+
+    if (byte_order == DC1394_BYTE_ORDER_YUYV) {
+        for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+            LOAD_YUV(src0 + 2 * i, ya, ua, va, PAIRS, YUYV);
+            LOAD_YUV(src1 + 2 * i, yb, ub, vb, PAIRS, YUYV);
+            STORE_YUV420(i, ya, yb, ua, ub, va, vb);
+        }
+    } else {
+        for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+            LOAD_YUV(src0 + 2 * i, ya, ua, va, PAIRS, UYVY);
+            LOAD_YUV(src1 + 2 * i, yb, ub, vb, PAIRS, UYVY);
+            STORE_YUV420(i, ya, yb, ua, ub, va, vb);
+        }
+    }
+
+    YUV420_TAIL(DC1394_COLOR_CODING_YUV422, i, 2 * i);
+}
+
+SIMD_INLINE void
+KERNEL(yuv411_to_yuv420)(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                         uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                         uint32_t byte_order, dc1394color_coding_t coding)
+{
+    VEC ya, ua, va, yb, ub, vb, even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+
+    for (i = 0; i + 3 * LANES <= pixels; i += LANES) {
+        LOAD_YUV(src0 + 3 * i / 2, ya, ua, va, QUADS, UYYVYY);
+        LOAD_YUV(src1 + 3 * i / 2, yb, ub, vb, QUADS, UYYVYY);
+        STORE_YUV420(i, ya, yb, ua, ub, va, vb);
+    }
+
+    YUV420_TAIL(DC1394_COLOR_CODING_YUV411, i, 3 * i / 2);
+}
+
+SIMD_INLINE void
+KERNEL(yuv444_to_yuv420)(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                         uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                         uint32_t byte_order, dc1394color_coding_t coding)
+{
+    VEC ya, ua, va, yb, ub, vb, even;
+    int i;
+
+    for (i = 0; i < LANES; i++)
+        even[i] = (i & 1) ? 0 : -1;
+
+    for (i = 0; i + 2 * LANES <= pixels; i += LANES) {
+        LOAD_YUV(src0 + 3 * i, ya, ua, va, PIXELS, UYV);
+        LOAD_YUV(src1 + 3 * i, yb, ub, vb, PIXELS, UYV);
+        STORE_YUV420(i, ya, yb, ua, ub, va, vb);
+    }
+
+    YUV420_TAIL(DC1394_COLOR_CODING_YUV444, i, 3 * i);
+}
+
+#undef CLAMP_255
+#undef LOAD_YUV
+#undef YUV_TO_RGB
+#undef STORE_YUV420
+#undef YUV420_TAIL
+#undef SWAP
+#undef EVEN
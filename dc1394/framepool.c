@@ -0,0 +1,420 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Pools of frame buffers for the image conversions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <stdint.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#include "conversions.h"
+
+/*
+  Each buffer starts with a header of FRAME_POOL_ALIGN bytes, so that the
+  image after it keeps the alignment of the buffer and can be given back
+  without asking the caller for its size. The sizes of the buffers are
+  classes of four per power of two from 4 KiB up, which wastes at most a
+  quarter of a buffer and lets frames of close sizes share them.
+ */
+#define FRAME_POOL_ALIGN 64
+#define FRAME_POOL_CLASSES 160
+
+/* the classes above that of a request whose free buffers it can take: up to twice its size */
+#define FRAME_POOL_REUSE_CLASSES 3
+
+/* buffers of this size at least are mapped with huge pages, when asked for */
+#define FRAME_POOL_HUGE_PAGE (2 << 20)
+
+typedef struct _frame_buffer_t {
+    void *raw;                        /* what malloc() or mmap() returned */
+    size_t mapped;                    /* bytes mapped by mmap(), or 0 */
+    uint64_t bytes;                   /* bytes of the image */
+    int size_class;
+    dc1394framepool_t *pool;
+    struct _frame_buffer_t *next;     /* in the list of the free buffers of its class, or of its bucket of handed_out */
+} frame_buffer_t;
+
+struct __dc1394framepool {
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t mutex;
+#endif
+    frame_buffer_t *free_buffers[FRAME_POOL_CLASSES];
+    uint64_t cached_bytes;            /* in the free buffers */
+    uint64_t max_cached_bytes;        /* 0: no limit */
+    dc1394bool_t huge_pages;
+    uint32_t buffers;                 /* handed out and not given back yet */
+    int closed;                       /* dc1394_frame_pool_free() was called */
+};
+
+/*
+  The buffers that the pools have handed out, whichever the pool. An image is
+  only given back to a pool if it is one of them: the pool of a frame may have
+  been set, or changed, after its image was taken from malloc() or from
+  another pool, and the memory before such an image is not a header. They are
+  kept in buckets by the address of their image, each with its own lock, so
+  that the threads that give images back seldom wait for one another.
+ */
+#define HANDED_OUT_BITS 6
+#define HANDED_OUT_BUCKETS (1 << HANDED_OUT_BITS)
+
+typedef struct {
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t mutex;
+#endif
+    frame_buffer_t *buffers;
+} handed_out_bucket_t;
+
+#ifdef HAVE_PTHREAD
+#define HANDED_OUT_BUCKET { PTHREAD_MUTEX_INITIALIZER, NULL }
+#else
+#define HANDED_OUT_BUCKET { NULL }
+#endif
+#define HANDED_OUT_BUCKETS_4 HANDED_OUT_BUCKET, HANDED_OUT_BUCKET, HANDED_OUT_BUCKET, HANDED_OUT_BUCKET
+#define HANDED_OUT_BUCKETS_16 HANDED_OUT_BUCKETS_4, HANDED_OUT_BUCKETS_4, HANDED_OUT_BUCKETS_4, HANDED_OUT_BUCKETS_4
+
+static handed_out_bucket_t handed_out[HANDED_OUT_BUCKETS] = {
+    HANDED_OUT_BUCKETS_16, HANDED_OUT_BUCKETS_16, HANDED_OUT_BUCKETS_16, HANDED_OUT_BUCKETS_16
+};
+
+/* the image bytes of a class */
+static uint64_t
+class_bytes(int size_class)
+{
+    return (uint64_t)(4 + (size_class & 3)) << (10 + (size_class >> 2));
+}
+
+static frame_buffer_t *
+buffer_header(uint8_t *image)
+{
+    return (frame_buffer_t*)(image - FRAME_POOL_ALIGN);
+}
+
+static void
+pool_lock(dc1394framepool_t *pool)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&pool->mutex);
+#endif
+}
+
+static void
+pool_unlock(dc1394framepool_t *pool)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+}
+
+/* the bucket of handed_out of an image: a multiplicative hash of its address, which is aligned */
+static handed_out_bucket_t *
+handed_out_bucket(const uint8_t *image)
+{
+    uint32_t key = (uint32_t)((uintptr_t)image / FRAME_POOL_ALIGN);
+
+    return &handed_out[(key * 2654435761u) >> (32 - HANDED_OUT_BITS)];
+}
+
+static void
+handed_out_lock(handed_out_bucket_t *bucket)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&bucket->mutex);
+#endif
+}
+
+static void
+handed_out_unlock(handed_out_bucket_t *bucket)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&bucket->mutex);
+#endif
+}
+
+static void
+handed_out_add(frame_buffer_t *buffer)
+{
+    handed_out_bucket_t *bucket = handed_out_bucket((uint8_t*)buffer + FRAME_POOL_ALIGN);
+
+    handed_out_lock(bucket);
+    buffer->next = bucket->buffers;
+    bucket->buffers = buffer;
+    handed_out_unlock(bucket);
+}
+
+/* removes from handed_out the buffer of an image, and returns it, or NULL if the image is not one of them */
+static frame_buffer_t *
+handed_out_remove(uint8_t *image)
+{
+    handed_out_bucket_t *bucket = handed_out_bucket(image);
+    frame_buffer_t **p, *buffer = NULL;
+
+    handed_out_lock(bucket);
+    for (p = &bucket->buffers; *p != NULL; p = &(*p)->next) {
+        if ((uint8_t*)*p + FRAME_POOL_ALIGN == image) {
+            buffer = *p;
+            *p = buffer->next;
+            buffer->next = NULL;
+            break;
+        }
+    }
+    handed_out_unlock(bucket);
+    return buffer;
+}
+
+/* a new buffer of a class, whose image follows the header */
+static frame_buffer_t *
+buffer_new(dc1394framepool_t *pool, int size_class)
+{
+    const uint64_t bytes = class_bytes(size_class);
+    frame_buffer_t *buffer;
+    size_t mapped = 0;
+    uint8_t *raw = NULL, *image;
+
+    if (bytes + 2 * FRAME_POOL_ALIGN > SIZE_MAX)
+        return NULL;
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    // the mapping is aligned on a page, and a whole number of huge pages
+    if (pool->huge_pages && (bytes >= FRAME_POOL_HUGE_PAGE)) {
+        mapped = (bytes + FRAME_POOL_ALIGN + FRAME_POOL_HUGE_PAGE - 1) & ~(uint64_t)(FRAME_POOL_HUGE_PAGE - 1);
+        raw = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            raw = NULL;
+            mapped = 0;
+        } else {
+            madvise(raw, mapped, MADV_HUGEPAGE);
+        }
+    }
+#endif
+    if (raw == NULL) {
+        raw = (uint8_t*)malloc(bytes + 2 * FRAME_POOL_ALIGN);
+        if (raw == NULL)
+            return NULL;
+    }
+
+    image = (uint8_t*)(((uintptr_t)raw + 2 * FRAME_POOL_ALIGN - 1) & ~(uintptr_t)(FRAME_POOL_ALIGN - 1));
+    buffer = buffer_header(image);
+    buffer->raw = raw;
+    buffer->mapped = mapped;
+    buffer->bytes = bytes;
+    buffer->size_class = size_class;
+    buffer->pool = pool;
+    buffer->next = NULL;
+    return buffer;
+}
+
+static void
+buffer_free(frame_buffer_t *buffer)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    if (buffer->mapped != 0) {
+        munmap(buffer->raw, buffer->mapped);
+        return;
+    }
+#endif
+    free(buffer->raw);
+}
+
+/* frees the free buffers of a pool; called with the mutex held */
+static void
+pool_drain(dc1394framepool_t *pool)
+{
+    frame_buffer_t *buffer;
+    int i;
+
+    for (i = 0; i < FRAME_POOL_CLASSES; i++) {
+        while ((buffer = pool->free_buffers[i]) != NULL) {
+            pool->free_buffers[i] = buffer->next;
+            buffer_free(buffer);
+        }
+    }
+    pool->cached_bytes = 0;
+}
+
+static void
+pool_destroy(dc1394framepool_t *pool)
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&pool->mutex);
+#endif
+    free(pool);
+}
+
+dc1394framepool_t*
+dc1394_frame_pool_new(uint64_t max_cached_bytes, dc1394bool_t huge_pages)
+{
+    dc1394framepool_t *pool;
+
+    pool = (dc1394framepool_t*)calloc(1, sizeof(dc1394framepool_t));
+    if (pool == NULL)
+        return NULL;
+#ifdef HAVE_PTHREAD
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+#endif
+    pool->max_cached_bytes = max_cached_bytes;
+    pool->huge_pages = huge_pages;
+
+    return pool;
+}
+
+void
+dc1394_frame_pool_free(dc1394framepool_t *pool)
+{
+    uint32_t buffers;
+
+    if (pool == NULL)
+        return;
+
+    // the buffers still in frames keep the pool until they are given back
+    pool_lock(pool);
+    pool_drain(pool);
+    pool->closed = 1;
+    buffers = pool->buffers;
+    pool_unlock(pool);
+    if (buffers == 0)
+        pool_destroy(pool);
+}
+
+void
+dc1394_frame_pool_trim(dc1394framepool_t *pool)
+{
+    if (pool == NULL)
+        return;
+
+    pool_lock(pool);
+    pool_drain(pool);
+    pool_unlock(pool);
+}
+
+/*
+  A buffer of 'bytes' image bytes at least: a free one of its class or of the
+  FRAME_POOL_REUSE_CLASSES above, so that a smaller ROI takes the buffer of a
+  larger one, or a new one.
+ */
+static frame_buffer_t *
+pool_get(dc1394framepool_t *pool, uint64_t bytes)
+{
+    frame_buffer_t *buffer = NULL;
+    int size_class = 0;
+    int i;
+
+    while ((size_class < FRAME_POOL_CLASSES) && (class_bytes(size_class) < bytes))
+        size_class++;
+    if (size_class == FRAME_POOL_CLASSES)
+        return NULL;
+
+    pool_lock(pool);
+    for (i = size_class; (i <= size_class + FRAME_POOL_REUSE_CLASSES) && (i < FRAME_POOL_CLASSES); i++) {
+        buffer = pool->free_buffers[i];
+        if (buffer != NULL) {
+            pool->free_buffers[i] = buffer->next;
+            pool->cached_bytes -= buffer->bytes;
+            break;
+        }
+    }
+    pool_unlock(pool);
+
+    if (buffer == NULL)
+        buffer = buffer_new(pool, size_class);
+    if (buffer == NULL)
+        return NULL;
+
+    pool_lock(pool);
+    pool->buffers++;
+    pool_unlock(pool);
+    handed_out_add(buffer);
+    return buffer;
+}
+
+/* gives a buffer back to its pool, which keeps it unless it would hold too many bytes */
+static void
+pool_put(frame_buffer_t *buffer)
+{
+    dc1394framepool_t *pool = buffer->pool;
+    int destroy;
+
+    pool_lock(pool);
+    pool->buffers--;
+    if (!pool->closed &&
+        ((pool->max_cached_bytes == 0) || (pool->cached_bytes + buffer->bytes <= pool->max_cached_bytes))) {
+        buffer->next = pool->free_buffers[buffer->size_class];
+        pool->free_buffers[buffer->size_class] = buffer;
+        pool->cached_bytes += buffer->bytes;
+        buffer = NULL;
+    }
+    destroy = pool->closed && (pool->buffers == 0);
+    pool_unlock(pool);
+
+    if (buffer != NULL)
+        buffer_free(buffer);
+    if (destroy)
+        pool_destroy(pool);
+}
+
+void
+dc1394_frame_pool_release(dc1394video_frame_t *frame)
+{
+    frame_buffer_t *buffer;
+
+    // the image goes back to where it was taken from, whatever the pool of the frame is now
+    if (frame->image != NULL) {
+        buffer = handed_out_remove(frame->image);
+        if (buffer != NULL)
+            pool_put(buffer);
+        else
+            free(frame->image);
+    }
+    frame->image = NULL;
+    frame->allocated_image_bytes = 0;
+}
+
+/*
+  Makes the image of an output frame hold its total_bytes: a buffer that is
+  large enough is kept, otherwise it is replaced by one of the pool of the
+  frame, or by one of malloc() without a pool. On failure the image is NULL.
+ */
+void
+frame_image_reserve(dc1394video_frame_t *frame)
+{
+    frame_buffer_t *buffer;
+
+    if (frame->total_bytes <= frame->allocated_image_bytes)
+        return;
+
+    dc1394_frame_pool_release(frame);
+    if (frame->pool == NULL) {
+        frame->image = (uint8_t*)malloc(frame->total_bytes);
+        if (frame->image != NULL)
+            frame->allocated_image_bytes = frame->total_bytes;
+        return;
+    }
+
+    buffer = pool_get(frame->pool, frame->total_bytes);
+    if (buffer != NULL) {
+        frame->image = (uint8_t*)buffer + FRAME_POOL_ALIGN;
+        frame->allocated_image_bytes = buffer->bytes;
+    }
+}
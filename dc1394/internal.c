@@ -285,6 +285,9 @@ capture_basic_setup (dc1394camera_t * camera, dc1394video_frame_t * frame)
     frame->little_endian=0;   // not used before 1.32 is out.
     frame->data_in_padding=0; // not used before 1.32 is out.
 
+    // the image is that of the capture, never taken from a pool of the conversions
+    frame->pool=NULL;
+
     return DC1394_SUCCESS;
 }
 
@@ -0,0 +1,225 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Color processing of de-mosaiced images: white balance, color correction and gamma
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "isp.h"
+
+/* largest white balance gain and color correction coefficient (in thousandths) accepted */
+#define ISP_MAX_GAIN 16.0
+#define ISP_MAX_CORR 16000
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+dc1394isp_t*
+dc1394_isp_new(void)
+{
+    dc1394isp_t *isp;
+
+    isp = (dc1394isp_t*)calloc(1, sizeof(dc1394isp_t));
+    if (isp == NULL)
+        return NULL;
+
+    isp->gain[0] = isp->gain[1] = isp->gain[2] = 1.0;
+    isp->corr[0][0] = isp->corr[1][1] = isp->corr[2][2] = 1000;
+    isp->gamma = 1.0;
+
+    return isp;
+}
+
+void
+dc1394_isp_free(dc1394isp_t *isp)
+{
+    if (isp == NULL)
+        return;
+    free(isp->lut);
+    free(isp);
+}
+
+dc1394error_t
+dc1394_isp_set_white_balance(dc1394isp_t *isp, double red, double green, double blue)
+{
+    if ((isp == NULL) || !(red >= 0) || !(green >= 0) || !(blue >= 0) ||
+        (red > ISP_MAX_GAIN) || (green > ISP_MAX_GAIN) || (blue > ISP_MAX_GAIN))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    isp->gain[0] = red;
+    isp->gain[1] = green;
+    isp->gain[2] = blue;
+    isp->bits = 0;
+
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+dc1394_isp_set_color_corr(dc1394isp_t *isp, int32_t Crr, int32_t Cgr, int32_t Cbr, int32_t Crg, int32_t Cgg,
+                          int32_t Cbg, int32_t Crb, int32_t Cgb, int32_t Cbb)
+{
+    const int32_t c[3][3] = { { Crr, Cgr, Cbr }, { Crg, Cgg, Cbg }, { Crb, Cgb, Cbb } };
+    int i, j;
+
+    if (isp == NULL)
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++)
+            if ((c[i][j] < -ISP_MAX_CORR) || (c[i][j] > ISP_MAX_CORR))
+                return DC1394_INVALID_ARGUMENT_VALUE;
+
+    memcpy(isp->corr, c, sizeof(c));
+    isp->bits = 0;
+
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+dc1394_isp_set_gamma(dc1394isp_t *isp, double gamma)
+{
+    if ((isp == NULL) || !(gamma > 0))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    isp->gamma = gamma;
+    isp->bits = 0;
+
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+isp_prepare(dc1394isp_t *isp, uint32_t bits)
+{
+    const uint32_t max = (1 << bits) - 1;
+    double m[3][3], largest = 0, v;
+    int i, j, magnitude;
+    uint8_t *lut8;
+    uint16_t *lut16;
+
+    if ((bits < 8) || (bits > 16))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+    if (isp->bits == bits)
+        return DC1394_SUCCESS;
+
+    // white balance first, then the color correction
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++) {
+            m[i][j] = isp->corr[i][j] * isp->gain[j] / 1000.0;
+            largest = fabs(m[i][j]) > largest ? fabs(m[i][j]) : largest;
+        }
+
+    // as many fractional bits as the 32-bit sum of three products can hold
+    for (magnitude = 0; (1 << magnitude) <= largest; magnitude++)
+        ;
+    isp->shift = 28 - bits - magnitude;
+    if (isp->shift > 16)
+        isp->shift = 16;
+    if (isp->shift < 1)
+        isp->shift = 1;
+
+    isp->identity = (isp->gamma == 1.0);
+    for (i = 0; i < 3; i++)
+        for (j = 0; j < 3; j++) {
+            isp->matrix[i][j] = (int32_t) lrint(m[i][j] * (1 << isp->shift));
+            if (isp->matrix[i][j] != (i == j ? 1 << isp->shift : 0))
+                isp->identity = 0;
+        }
+
+    free(isp->lut);
+    isp->lut = malloc((max + 1) * (bits == 8 ? sizeof(uint8_t) : sizeof(uint16_t)));
+    if (isp->lut == NULL) {
+        isp->bits = 0;
+        return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    lut8 = (uint8_t*)isp->lut;
+    lut16 = (uint16_t*)isp->lut;
+    for (i = 0; i <= (int)max; i++) {
+        v = floor(max * pow((double)i / max, 1.0 / isp->gamma) + 0.5);
+        if (bits == 8)
+            lut8[i] = (uint8_t) v;
+        else
+            lut16[i] = (uint16_t) v;
+    }
+
+    isp->bits = bits;
+    return DC1394_SUCCESS;
+}
+
+/* the matrix in locals, which the stores to the output could otherwise alias */
+#define ISP_LOAD_MATRIX(isp)                                                             \
+    const int32_t m00 = (isp)->matrix[0][0], m01 = (isp)->matrix[0][1], m02 = (isp)->matrix[0][2]; \
+    const int32_t m10 = (isp)->matrix[1][0], m11 = (isp)->matrix[1][1], m12 = (isp)->matrix[1][2]; \
+    const int32_t m20 = (isp)->matrix[2][0], m21 = (isp)->matrix[2][1], m22 = (isp)->matrix[2][2]; \
+    const int shift = (isp)->shift;                                                      \
+    const int32_t round = 1 << (shift - 1)
+
+/* one output component from a row of the matrix, rounded and clipped to 0..max */
+#define ISP_COMPONENT(c0, c1, c2, r, g, b, max)                                          \
+    ({                                                                                   \
+        int32_t v_ = ((c0) * (r) + (c1) * (g) + (c2) * (b) + round) >> shift;            \
+        v_ < 0 ? 0 : (v_ > (max) ? (max) : v_);                                          \
+    })
+
+void
+isp_apply_8bit(const dc1394isp_t *isp, const uint8_t *src, uint8_t *dst, int pixels)
+{
+    const uint8_t *lut = (const uint8_t*)isp->lut;
+    ISP_LOAD_MATRIX(isp);
+    int i, r, g, b;
+
+    if (isp->identity) {
+        if (src != dst)
+            memcpy(dst, src, pixels * 3);
+        return;
+    }
+
+    for (i = 0; i < pixels; i++, src += 3, dst += 3) {
+        r = src[0];
+        g = src[1];
+        b = src[2];
+        dst[0] = lut[ISP_COMPONENT(m00, m01, m02, r, g, b, 255)];
+        dst[1] = lut[ISP_COMPONENT(m10, m11, m12, r, g, b, 255)];
+        dst[2] = lut[ISP_COMPONENT(m20, m21, m22, r, g, b, 255)];
+    }
+}
+
+void
+isp_apply_16bit(const dc1394isp_t *isp, const uint16_t *src, uint16_t *dst, int pixels)
+{
+    const uint16_t *lut = (const uint16_t*)isp->lut;
+    const int32_t max = (1 << isp->bits) - 1;
+    ISP_LOAD_MATRIX(isp);
+    int i, r, g, b;
+
+    if (isp->identity) {
+        if (src != dst)
+            memcpy(dst, src, pixels * 3 * sizeof(uint16_t));
+        return;
+    }
+
+    // the input is clipped to the bit depth, for which the precision of the matrix was chosen
+    for (i = 0; i < pixels; i++, src += 3, dst += 3) {
+        r = MIN(src[0], max);
+        g = MIN(src[1], max);
+        b = MIN(src[2], max);
+        dst[0] = lut[ISP_COMPONENT(m00, m01, m02, r, g, b, max)];
+        dst[1] = lut[ISP_COMPONENT(m10, m11, m12, r, g, b, max)];
+        dst[2] = lut[ISP_COMPONENT(m20, m21, m22, r, g, b, max)];
+    }
+}
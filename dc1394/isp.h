@@ -0,0 +1,54 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Color processing of de-mosaiced images: white balance, color correction and gamma
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __DC1394_ISP_H__
+#define __DC1394_ISP_H__
+
+#include <stdint.h>
+#include "conversions.h"
+
+/*
+  The white balance gains and the color correction matrix are folded into
+  a single fixed point matrix, which is followed by a look-up table for the
+  gamma curve. Both are built by isp_prepare() for the bit depth of the
+  image, before the bands are decoded, so that the decoding threads only
+  read them.
+ */
+struct __dc1394isp {
+    double gain[3];            /* white balance of red, green and blue */
+    int32_t corr[3][3];        /* color correction, corr[out][in], 1000 is 1.0 */
+    double gamma;
+
+    /* derived from the above for 'bits' bits per component, 0 if not built yet */
+    uint32_t bits;
+    int identity;              /* nothing to do: the pixels are copied */
+    int shift;                 /* fractional bits of matrix */
+    int32_t matrix[3][3];
+    void *lut;                 /* 1<<bits entries of uint8_t (8 bits) or uint16_t */
+};
+
+/* Builds the matrix and the look-up table for 'bits' bits per component if needed */
+dc1394error_t isp_prepare(dc1394isp_t *isp, uint32_t bits);
+
+/* Processes RGB pixels from src to dst, which may be the same buffer. isp_prepare() must have been called. */
+void isp_apply_8bit(const dc1394isp_t *isp, const uint8_t *src, uint8_t *dst, int pixels);
+void isp_apply_16bit(const dc1394isp_t *isp, const uint16_t *src, uint16_t *dst, int pixels);
+
+#endif /* __DC1394_ISP_H__ */
@@ -0,0 +1,88 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Run-time detection of the vector instruction sets
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include "simd.h"
+
+#define SIMD_FEATURES_UNKNOWN 0x80000000
+
+static uint32_t
+detect_features(void)
+{
+    uint32_t features = 0;
+
+    // setting DC1394_NO_SIMD in the environment forces the scalar code (useful for comparisons)
+    if (getenv("DC1394_NO_SIMD") != NULL)
+        return 0;
+
+#if defined(DC1394_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        features |= SIMD_FEATURE_SSE2;
+    if (__builtin_cpu_supports("ssse3"))
+        features |= SIMD_FEATURE_SSSE3;
+    if (__builtin_cpu_supports("avx2"))
+        features |= SIMD_FEATURE_AVX2;
+#elif defined(DC1394_SIMD_NEON)
+    features |= SIMD_FEATURE_NEON;
+#endif
+
+    return features;
+}
+
+uint32_t
+simd_get_features(void)
+{
+    /* the detection is idempotent and the result is a single word, so a race
+       between two first callers is harmless */
+    static volatile uint32_t features = SIMD_FEATURES_UNKNOWN;
+
+    if (features == SIMD_FEATURES_UNKNOWN)
+        features = detect_features();
+
+    return features;
+}
+
+void *
+simd_malloc(size_t size)
+{
+    uint8_t *block, *ptr;
+
+    // the pointer returned by malloc() is kept just before the aligned one
+    block = (uint8_t*)malloc(size + SIMD_ALIGNMENT + sizeof(void*));
+    if (block == NULL)
+        return NULL;
+    ptr = block + sizeof(void*);
+    ptr += (SIMD_ALIGNMENT - (uintptr_t)ptr % SIMD_ALIGNMENT) % SIMD_ALIGNMENT;
+    memcpy(ptr - sizeof(void*), &block, sizeof(void*));
+
+    return ptr;
+}
+
+void
+simd_free(void *ptr)
+{
+    void *block;
+
+    if (ptr == NULL)
+        return;
+    memcpy(&block, (uint8_t*)ptr - sizeof(void*), sizeof(void*));
+    free(block);
+}
@@ -0,0 +1,272 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Vector kernels for the conversion and Bayer decoding functions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __DC1394_SIMD_H__
+#define __DC1394_SIMD_H__
+
+#include <stdint.h>
+#include <string.h>
+#include "conversions.h"
+
+/*
+  The kernels are written once with the GCC/clang vector extensions and
+  compiled for several instruction sets (SSE2, SSSE3 and AVX2 on x86, NEON
+  on ARM). The best one is chosen at run time with simd_get_features().
+  Compilers that lack the extensions only get the scalar code.
+ */
+#if (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 9))) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define DC1394_SIMD
+#if defined(__x86_64__) || defined(__i386__)
+#define DC1394_SIMD_X86
+#else
+#define DC1394_SIMD_NEON
+#endif
+#endif
+
+#define SIMD_FEATURE_SSE2    0x01
+#define SIMD_FEATURE_SSSE3   0x02
+#define SIMD_FEATURE_AVX2    0x04
+#define SIMD_FEATURE_NEON    0x08
+
+/* Returns the SIMD_FEATURE_* flags usable on this CPU. Cached after the first call. */
+uint32_t simd_get_features(void);
+
+/* the buffers of simd_malloc() start on a cache line, which suits any vector width */
+#define SIMD_ALIGNMENT 64
+
+/* Allocates size bytes aligned on SIMD_ALIGNMENT, or returns NULL. Free with simd_free(). */
+void *simd_malloc(size_t size);
+void simd_free(void *ptr);
+
+#ifdef DC1394_SIMD
+
+typedef int8_t   v4i8   __attribute__ ((vector_size (4)));
+typedef int8_t   v8i8   __attribute__ ((vector_size (8)));
+typedef uint8_t  v4u8   __attribute__ ((vector_size (4)));
+typedef uint8_t  v8u8   __attribute__ ((vector_size (8)));
+typedef uint8_t  v16u8  __attribute__ ((vector_size (16)));
+typedef uint8_t  v32u8  __attribute__ ((vector_size (32)));
+typedef int16_t  v8i16  __attribute__ ((vector_size (16)));
+typedef int16_t  v16i16 __attribute__ ((vector_size (32)));
+typedef int16_t  v4i16  __attribute__ ((vector_size (8)));
+typedef uint16_t v4u16  __attribute__ ((vector_size (8)));
+typedef uint16_t v8u16  __attribute__ ((vector_size (16)));
+typedef uint16_t v16u16 __attribute__ ((vector_size (32)));
+typedef int32_t  v4i32  __attribute__ ((vector_size (16)));
+typedef int32_t  v8i32  __attribute__ ((vector_size (32)));
+typedef uint32_t v4u32  __attribute__ ((vector_size (16)));
+typedef uint32_t v8u32  __attribute__ ((vector_size (32)));
+
+#define SIMD_INLINE static inline __attribute__ ((always_inline))
+
+/*
+  The helpers are always inlined, so returning wide vectors never touches the
+  ABI. Helpers that take wide vectors are macros: GCC ignores the pragma for
+  the note it emits on such parameters.
+ */
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#ifdef DC1394_SIMD_X86
+#define SIMD_TARGET_SSE2  __attribute__ ((target ("sse2")))
+#define SIMD_TARGET_SSSE3 __attribute__ ((target ("ssse3")))
+#define SIMD_TARGET_AVX2  __attribute__ ((target ("avx2")))
+#endif
+
+/* constant-index shuffle of the lanes of a and b (indices >= lanes pick from b) */
+#if defined(__clang__) || (__GNUC__ >= 12)
+#define SIMD_SHUFFLE(type, a, b, ...) __builtin_shufflevector(a, b, __VA_ARGS__)
+#else
+#define SIMD_SHUFFLE(type, a, b, ...) __builtin_shuffle(a, b, (type){ __VA_ARGS__ })
+#endif
+
+#define SIMD_LOAD(v, p)   memcpy(&(v), (p), sizeof(v))
+#define SIMD_STORE(p, v)  memcpy((p), &(v), sizeof(v))
+
+/* lane select: m is all-ones where a is taken, zero where b is taken */
+#define SIMD_SELECT(m, a, b) (((a) & (m)) | ((b) & ~(m)))
+
+#endif /* DC1394_SIMD */
+
+typedef dc1394error_t (*bayer_8bit_func_t)(const uint8_t *restrict bayer, uint8_t *restrict rgb,
+                                           int sx, int sy, int tile);
+
+/* Vectorized 8-bit Bayer decoder for this CPU, or NULL if only the scalar one exists */
+bayer_8bit_func_t bayer_simd_get_8bit(dc1394bayer_method_t method);
+
+typedef dc1394error_t (*bayer_16bit_func_t)(const uint16_t *restrict bayer, uint16_t *restrict rgb,
+                                            int sx, int sy, int tile, int bits);
+
+/* Vectorized 16-bit Bayer decoder for this CPU, or NULL if only the scalar one exists */
+bayer_16bit_func_t bayer_simd_get_16bit(dc1394bayer_method_t method);
+
+/*
+  Phase of a tile: whether its first row starts with a green pixel, and whether
+  the other pixels of that row are red. Both are swapped from one row to the
+  next. The scalar decoders and the vectorized ones derive their row layouts
+  from these alone.
+ */
+#define BAYER_FIRST_GREEN(tile) (((tile) == DC1394_COLOR_FILTER_GBRG) || ((tile) == DC1394_COLOR_FILTER_GRBG))
+#define BAYER_FIRST_RED(tile)   (((tile) == DC1394_COLOR_FILTER_RGGB) || ((tile) == DC1394_COLOR_FILTER_GRBG))
+
+/*
+  AHD works on tiles of AHD_TILE x AHD_TILE pixels. Its CIELab tiles are
+  stored as int16_t lab[direction][channel][row][column] and its homogeneity
+  maps as int8_t homo[direction][row][column].
+ */
+#define AHD_TILE  256
+#define AHD_PLANE (AHD_TILE * AHD_TILE)
+
+/* Homogeneity maps of n consecutive pixels of a tile row: lab and homo point
+   to the first pixel in the tiles of the first direction. */
+typedef void (*ahd_homogeneity_func_t)(const int16_t *lab, int8_t *homo, int n);
+
+/* the scalar version, in bayer.c */
+void ahd_homogeneity(const int16_t *lab, int8_t *homo, int n);
+
+/* Vectorized ahd_homogeneity() for this CPU, or NULL if only the scalar one exists */
+ahd_homogeneity_func_t ahd_simd_get_homogeneity(void);
+
+/* Adds weight times each of the n samples of a Bayer row to acc (the vertical filter of the scaled decoding) */
+typedef void (*bayer_accumulate_8bit_func_t)(uint32_t *restrict acc, const uint8_t *restrict src, int n,
+                                             uint32_t weight);
+typedef void (*bayer_accumulate_16bit_func_t)(uint32_t *restrict acc, const uint16_t *restrict src, int n,
+                                              uint32_t weight);
+
+/* the scalar versions, in bayer.c */
+void bayer_accumulate_8bit(uint32_t *restrict acc, const uint8_t *restrict src, int n, uint32_t weight);
+void bayer_accumulate_16bit(uint32_t *restrict acc, const uint16_t *restrict src, int n, uint32_t weight);
+
+/* Vectorized accumulations for this CPU, or NULL if only the scalar ones exist */
+bayer_accumulate_8bit_func_t bayer_simd_get_accumulate_8bit(void);
+bayer_accumulate_16bit_func_t bayer_simd_get_accumulate_16bit(void);
+
+/*
+  Luminance of the MONO8 and MONO16 outputs of the de-mosaicing, with the luma of RGB2YUV: of RGB rows (in
+  place for 16 bits, dest being rgb), or of the 2x2 blocks of two mosaic rows as DOWNSAMPLE would decode them.
+  first_green and first_red are the phase of row0, as BAYER_FIRST_GREEN() and BAYER_FIRST_RED() give it.
+ */
+typedef void (*bayer_luma_8bit_func_t)(const uint8_t *restrict rgb, uint8_t *restrict dest, int pixels);
+typedef void (*bayer_luma_16bit_func_t)(const uint16_t *rgb, uint16_t *dest, int pixels);
+typedef void (*bayer_bin_luma_8bit_func_t)(const uint8_t *restrict row0, const uint8_t *restrict row1,
+                                           uint8_t *restrict dest, int pixels, int first_green, int first_red);
+typedef void (*bayer_bin_luma_16bit_func_t)(const uint16_t *restrict row0, const uint16_t *restrict row1,
+                                            uint16_t *restrict dest, int pixels, int first_green, int first_red);
+
+/* the scalar versions, in bayer.c */
+void bayer_luma_8bit(const uint8_t *restrict rgb, uint8_t *restrict dest, int pixels);
+void bayer_luma_16bit(const uint16_t *rgb, uint16_t *dest, int pixels);
+void bayer_bin_luma_8bit(const uint8_t *restrict row0, const uint8_t *restrict row1, uint8_t *restrict dest,
+                         int pixels, int first_green, int first_red);
+void bayer_bin_luma_16bit(const uint16_t *restrict row0, const uint16_t *restrict row1, uint16_t *restrict dest,
+                          int pixels, int first_green, int first_red);
+
+/* Vectorized luminances for this CPU, or NULL if only the scalar ones exist */
+bayer_luma_8bit_func_t bayer_simd_get_luma_8bit(void);
+bayer_luma_16bit_func_t bayer_simd_get_luma_16bit(void);
+bayer_bin_luma_8bit_func_t bayer_simd_get_bin_luma_8bit(void);
+bayer_bin_luma_16bit_func_t bayer_simd_get_bin_luma_16bit(void);
+
+typedef void (*conversion_8bit_func_t)(const uint8_t *restrict src, uint8_t *restrict dst, int pixels,
+                                       uint32_t byte_order);
+
+/* Vectorized conversion of an even number of RGB8 pixels to YUV422 for this CPU, or NULL */
+conversion_8bit_func_t conversion_simd_get_rgb8_to_yuv422(void);
+
+/* Vectorized conversions to RGB8 of YUV422 (an even number of pixels, in byte_order), YUV411 (a multiple of 4)
+   and YUV444 for this CPU, or NULL. The last two ignore byte_order. */
+conversion_8bit_func_t conversion_simd_get_yuv422_to_rgb8(void);
+conversion_8bit_func_t conversion_simd_get_yuv411_to_rgb8(void);
+conversion_8bit_func_t conversion_simd_get_yuv444_to_rgb8(void);
+
+/* Unpacks pixels (whole groups of packing) of 10 or 12 bits to one uint16_t each */
+typedef void (*unpack_func_t)(const uint8_t *restrict src, uint16_t *restrict dest, int pixels,
+                              dc1394packing_t packing);
+
+/* the scalar version, in conversions.c */
+void unpack_row(const uint8_t *restrict src, uint16_t *restrict dest, int pixels, dc1394packing_t packing);
+
+/* Vectorized unpacking for this CPU, or NULL if only the scalar one exists */
+unpack_func_t conversion_simd_get_unpack(void);
+
+/* 16-bit samples, big or little endian, to 8 bits by a right shift */
+typedef void (*depth_func_t)(const uint8_t *restrict src, uint8_t *restrict dest, int samples, uint32_t shift,
+                             int little_endian);
+
+/* the scalar version, in conversions.c */
+void depth16_to_8_row(const uint8_t *restrict src, uint8_t *restrict dest, int samples, uint32_t shift,
+                      int little_endian);
+
+/* Vectorized reduction for this CPU, or NULL if only the scalar one exists */
+depth_func_t conversion_simd_get_depth16_to_8(void);
+
+/* The samples of one of the sensors whose bytes are interleaved in src, which starts on its first byte */
+typedef void (*sensor_pick_func_t)(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors);
+
+/* the scalar version, in conversions.c */
+void sensor_pick_row(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, int sensors);
+
+/* Vectorized picking for this CPU, or NULL if only the scalar one exists */
+sensor_pick_func_t conversion_simd_get_sensor_pick(void);
+
+/* RGB8 pixels to RGBA8 or BGRA8 (coding), with an opaque alpha */
+typedef void (*conversion_rgba_func_t)(const uint8_t *restrict src, uint8_t *restrict dest, int pixels,
+                                       dc1394color_coding_t coding);
+
+/* RGB8 pixels to three planes */
+typedef void (*conversion_planar_func_t)(const uint8_t *restrict src, uint8_t *restrict r, uint8_t *restrict g,
+                                         uint8_t *restrict b, int pixels);
+
+/* Two rows of an even number of RGB8 pixels to their two luma rows and their chroma row: interleaved U and V
+   in u for NV12 (coding), or U in u and V in v for I420 */
+typedef void (*conversion_yuv420_func_t)(const uint8_t *restrict src0, const uint8_t *restrict src1,
+                                         uint8_t *restrict y0, uint8_t *restrict y1, uint8_t *restrict u,
+                                         uint8_t *restrict v, int pixels, dc1394color_coding_t coding);
+
+/* the scalar versions, in conversions.c */
+void rgb8_to_rgba_row(const uint8_t *restrict src, uint8_t *restrict dest, int pixels, dc1394color_coding_t coding);
+void rgb8_to_planar_row(const uint8_t *restrict src, uint8_t *restrict r, uint8_t *restrict g, uint8_t *restrict b,
+                        int pixels);
+void rgb8_to_yuv420_rows(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                         uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                         dc1394color_coding_t coding);
+
+/* Vectorized conversions of RGB8 rows for this CPU, or NULL if only the scalar ones exist */
+conversion_rgba_func_t conversion_simd_get_rgb8_to_rgba(void);
+conversion_planar_func_t conversion_simd_get_rgb8_to_planar(void);
+conversion_yuv420_func_t conversion_simd_get_rgb8_to_yuv420(void);
+
+/* Two rows of YUV411 (a multiple of 4 pixels), YUV422 (an even number, in byte_order) or YUV444 pixels to NV12 or
+   I420 rows, as conversion_yuv420_func_t, with the rounded average of the chroma of the 2x2 blocks */
+typedef void (*conversion_yuv_to_yuv420_func_t)(const uint8_t *restrict src0, const uint8_t *restrict src1,
+                                                uint8_t *restrict y0, uint8_t *restrict y1, uint8_t *restrict u,
+                                                uint8_t *restrict v, int pixels, uint32_t byte_order,
+                                                dc1394color_coding_t coding);
+
+/* the scalar version, in conversions.c, for the codings from */
+void yuv_to_yuv420_rows(const uint8_t *restrict src0, const uint8_t *restrict src1, uint8_t *restrict y0,
+                        uint8_t *restrict y1, uint8_t *restrict u, uint8_t *restrict v, int pixels,
+                        dc1394color_coding_t from, uint32_t byte_order, dc1394color_coding_t coding);
+
+/* Vectorized conversion from the YUV coding from for this CPU, or NULL if only the scalar one exists */
+conversion_yuv_to_yuv420_func_t conversion_simd_get_yuv_to_yuv420(dc1394color_coding_t from);
+
+#endif /* __DC1394_SIMD_H__ */
@@ -0,0 +1,297 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Statistics of the output of the de-mosaicing and of the conversions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+
+/* most bins of a histogram: one per value of 16-bit samples */
+#define STATS_MAX_BINS 65536
+
+/* tables of counts of each channel of a band, for samples of up to STATS_LANES_BITS bits */
+#define STATS_LANES      4
+#define STATS_LANES_BITS 12
+
+dc1394frame_stats_t*
+dc1394_frame_stats_new(uint32_t bins)
+{
+    dc1394frame_stats_t *stats;
+
+    if ((bins == 0) || (bins > STATS_MAX_BINS))
+        return NULL;
+
+    stats = (dc1394frame_stats_t*)calloc(1, sizeof(dc1394frame_stats_t));
+    if (stats == NULL)
+        return NULL;
+
+    stats->bins = bins;
+    stats->histogram = (uint64_t*)calloc(3 * bins, sizeof(uint64_t));
+    if (stats->histogram == NULL) {
+        free(stats);
+        return NULL;
+    }
+
+    return stats;
+}
+
+void
+dc1394_frame_stats_free(dc1394frame_stats_t *stats)
+{
+    if (stats == NULL)
+        return;
+    free(stats->counts);
+    free(stats->histogram);
+    free(stats);
+}
+
+uint32_t
+dc1394_frame_stats_get_channels(const dc1394frame_stats_t *stats)
+{
+    return (stats != NULL) ? stats->channels : 0;
+}
+
+dc1394error_t
+dc1394_frame_stats_get(const dc1394frame_stats_t *stats, uint32_t channel, dc1394channel_stats_t *result)
+{
+    if ((stats == NULL) || (result == NULL) || (channel >= stats->channels))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    *result = stats->channel[channel];
+    return DC1394_SUCCESS;
+}
+
+dc1394error_t
+stats_prepare(dc1394frame_stats_t *stats, dc1394color_coding_t coding, uint32_t byte_order, uint32_t bits,
+              int bands)
+{
+    uint32_t channels;
+    size_t size;
+    int lanes;
+
+    switch (coding) {
+    case DC1394_COLOR_CODING_MONO8:
+    case DC1394_COLOR_CODING_RAW8:
+        channels = 1;
+        bits = 8;
+        break;
+    case DC1394_COLOR_CODING_MONO16:
+    case DC1394_COLOR_CODING_RAW16:
+        channels = 1;
+        break;
+    case DC1394_COLOR_CODING_RGB16:
+        channels = 3;
+        break;
+    case DC1394_COLOR_CODING_RGB8:
+    case DC1394_COLOR_CODING_YUV422:
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
+        channels = 3;
+        bits = 8;
+        break;
+    default:
+        return DC1394_FUNCTION_NOT_SUPPORTED;
+    }
+    if ((bits < 8) || (bits > 16) || (bands < 1))
+        return DC1394_INVALID_ARGUMENT_VALUE;
+
+    lanes = (bits <= STATS_LANES_BITS) ? STATS_LANES : 1;
+    size = ((size_t)bands * lanes * channels) << bits;
+    if (size > stats->counts_size) {
+        free(stats->counts);
+        stats->counts = (uint32_t*)malloc(size * sizeof(uint32_t));
+        stats->counts_size = stats->counts ? size : 0;
+        if (stats->counts == NULL)
+            return DC1394_MEMORY_ALLOCATION_FAILURE;
+    }
+    memset(stats->counts, 0, size * sizeof(uint32_t));
+
+    stats->coding = coding;
+    stats->byte_order = byte_order;
+    stats->bits = bits;
+    stats->bands = bands;
+    stats->lanes = lanes;
+    stats->channels = channels;
+
+    return DC1394_SUCCESS;
+}
+
+/*
+  The samples of a row of 8-bit samples, step bytes apart, counted in turn in
+  the four tables of a channel, lane entries apart, so that a run of equal
+  samples does not wait on the same count.
+ */
+static void
+count_8bit(uint32_t *restrict counts, size_t lane, const uint8_t *restrict p, uint32_t samples, int step)
+{
+    uint32_t *restrict c1 = counts + lane;
+    uint32_t *restrict c2 = counts + 2 * lane;
+    uint32_t *restrict c3 = counts + 3 * lane;
+    uint32_t i;
+
+    for (i = 0; i + 3 < samples; i += 4, p += 4 * step) {
+        counts[p[0]]++;
+        c1[p[step]]++;
+        c2[p[2 * step]]++;
+        c3[p[3 * step]]++;
+    }
+    for (; i < samples; i++, p += step)
+        counts[*p]++;
+}
+
+/*
+  The same for 16-bit samples, step samples apart, in one table when lanes is
+  1. Those above max are counted as max.
+ */
+static void
+count_16bit(uint32_t *restrict counts, size_t lane, int lanes, const uint16_t *restrict p, uint32_t samples, int step,
+            uint32_t max)
+{
+    uint32_t *restrict c1 = counts + lane;
+    uint32_t *restrict c2 = counts + 2 * lane;
+    uint32_t *restrict c3 = counts + 3 * lane;
+    uint32_t i = 0, v0, v1, v2, v3;
+
+    if (lanes == STATS_LANES) {
+        for (; i + 3 < samples; i += 4, p += 4 * step) {
+            v0 = p[0];
+            v1 = p[step];
+            v2 = p[2 * step];
+            v3 = p[3 * step];
+            counts[v0 > max ? max : v0]++;
+            c1[v1 > max ? max : v1]++;
+            c2[v2 > max ? max : v2]++;
+            c3[v3 > max ? max : v3]++;
+        }
+    }
+    for (; i < samples; i++, p += step) {
+        v0 = *p;
+        counts[v0 > max ? max : v0]++;
+    }
+}
+
+void
+stats_rows(dc1394frame_stats_t *stats, int band, const uint8_t *image, uint32_t width, uint32_t height,
+           size_t stride, uint32_t y, uint32_t n)
+{
+    const uint32_t values = 1 << stats->bits;
+    const size_t lane = (stats->lanes > 1) ? (size_t)stats->channels * values : 0;
+    uint32_t *counts = stats->counts + (size_t)band * stats->lanes * stats->channels * values;
+    const uint8_t *row, *chroma;
+    uint32_t i, k, l;
+
+    for (i = 0; i < n; i++) {
+        row = image + (y + i) * stride;
+        switch (stats->coding) {
+        case DC1394_COLOR_CODING_MONO8:
+        case DC1394_COLOR_CODING_RAW8:
+        case DC1394_COLOR_CODING_NV12:
+        case DC1394_COLOR_CODING_I420:
+            count_8bit(counts, lane, row, width, 1);
+            break;
+        case DC1394_COLOR_CODING_MONO16:
+        case DC1394_COLOR_CODING_RAW16:
+            count_16bit(counts, lane, stats->lanes, (const uint16_t*)row, width, 1, values - 1);
+            break;
+        case DC1394_COLOR_CODING_RGB8:
+            for (k = 0; k < 3; k++)
+                count_8bit(counts + k * 256, lane, row + k, width, 3);
+            break;
+        case DC1394_COLOR_CODING_RGB16:
+            for (k = 0; k < 3; k++)
+                count_16bit(counts + k * values, lane, stats->lanes, (const uint16_t*)row + k, width, 3, values - 1);
+            break;
+        case DC1394_COLOR_CODING_RGBA8:
+            for (k = 0; k < 3; k++)
+                count_8bit(counts + k * 256, lane, row + k, width, 4);
+            break;
+        case DC1394_COLOR_CODING_BGRA8:
+            for (k = 0; k < 3; k++)
+                count_8bit(counts + k * 256, lane, row + 2 - k, width, 4);
+            break;
+        case DC1394_COLOR_CODING_RGB8_PLANAR:
+            // three planes of height rows
+            for (k = 0; k < 3; k++)
+                count_8bit(counts + k * 256, lane, row + k * height * stride, width, 1);
+            break;
+        case DC1394_COLOR_CODING_YUV422:
+            // the luma is at 0 and 2 of the pixel pairs for YUYV, at 1 and 3 for UYVY
+            l = (stats->byte_order == DC1394_BYTE_ORDER_YUYV) ? 0 : 1;
+            count_8bit(counts, lane, row + l, width & ~1, 2);
+            count_8bit(counts + 256, lane, row + 1 - l, width / 2, 4);
+            count_8bit(counts + 512, lane, row + 3 - l, width / 2, 4);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // the chroma rows of the 2x2 blocks of NV12 and I420, laid out as in rgb8_rows_to_image()
+    chroma = image + height * stride;
+    for (i = y / 2; i < (y + n) / 2; i++) {
+        if (stats->coding == DC1394_COLOR_CODING_NV12) {
+            row = chroma + i * stride;
+            count_8bit(counts + 256, lane, row, width / 2, 2);
+            count_8bit(counts + 512, lane, row + 1, width / 2, 2);
+        } else if (stats->coding == DC1394_COLOR_CODING_I420) {
+            count_8bit(counts + 256, lane, chroma + i * (stride / 2), width / 2, 1);
+            count_8bit(counts + 512, lane, chroma + ((height + 1) / 2 + i) * (stride / 2), width / 2, 1);
+        }
+    }
+}
+
+void
+stats_merge(dc1394frame_stats_t *stats)
+{
+    const uint32_t values = 1 << stats->bits;
+    const size_t table_counts = (size_t)stats->channels * values;
+    const int tables = stats->bands * stats->lanes;
+    dc1394channel_stats_t *s;
+    const uint32_t *counts;
+    uint64_t n;
+    uint32_t c, v;
+    int t;
+
+    memset(stats->histogram, 0, 3 * stats->bins * sizeof(uint64_t));
+    for (c = 0; c < stats->channels; c++) {
+        s = &stats->channel[c];
+        memset(s, 0, sizeof(dc1394channel_stats_t));
+        s->bits = stats->bits;
+        s->histogram = stats->histogram + c * stats->bins;
+        counts = stats->counts + c * values;
+        for (v = 0; v < values; v++) {
+            n = 0;
+            for (t = 0; t < tables; t++)
+                n += counts[t * table_counts + v];
+            if (n == 0)
+                continue;
+            if (s->samples == 0)
+                s->min = v;
+            s->max = v;
+            s->samples += n;
+            s->sum += n * v;
+            stats->histogram[c * stats->bins + (((uint64_t)v * stats->bins) >> stats->bits)] += n;
+            if (v == values - 1)
+                s->saturated = n;
+        }
+    }
+}
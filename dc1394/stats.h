@@ -0,0 +1,69 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Statistics of the output of the de-mosaicing and of the conversions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __DC1394_STATS_H__
+#define __DC1394_STATS_H__
+
+#include <stdint.h>
+#include "conversions.h"
+
+/*
+  Each band counts the samples of each value of each channel in counts of
+  its own, so that the bands never write to the same memory, and for samples
+  of up to 12 bits in four tables of them (lanes) that take the samples in
+  turn. The sums, the extremes and the histograms are only computed from
+  these counts once all the bands are done, by stats_merge().
+ */
+struct __dc1394frame_stats {
+    uint32_t bins;
+    uint64_t *histogram;       /* 3*bins, the bins of each channel of the last output */
+    dc1394channel_stats_t channel[3];
+    uint32_t channels;         /* of the last output, 0 before the first */
+
+    /* the output being counted */
+    dc1394color_coding_t coding;
+    uint32_t byte_order;       /* of YUV422 */
+    uint32_t bits;             /* 8, or the depth of the 16-bit samples of MONO16 and RGB16 */
+    int bands;
+    int lanes;                 /* tables of counts of each channel of a band */
+    uint32_t *counts;          /* bands*lanes*channels*(1<<bits) */
+    size_t counts_size;        /* entries allocated */
+};
+
+/*
+  Clears the counts of 'bands' bands for an output of coding (with byte_order
+  for YUV422) whose samples have 'bits' bits, 8 but for MONO16 and RGB16.
+ */
+dc1394error_t stats_prepare(dc1394frame_stats_t *stats, dc1394color_coding_t coding, uint32_t byte_order,
+                            uint32_t bits, int bands);
+
+/*
+  Counts in those of band the samples of the rows y to y+n-1 of the output
+  image, of height rows of width pixels, stride bytes apart (those of its
+  first plane). y and n are even for NV12 and I420. The 16-bit samples are in
+  the byte order of the CPU.
+ */
+void stats_rows(dc1394frame_stats_t *stats, int band, const uint8_t *image, uint32_t width, uint32_t height,
+                size_t stride, uint32_t y, uint32_t n);
+
+/* Merges the counts of the bands into the statistics of each channel */
+void stats_merge(dc1394frame_stats_t *stats);
+
+#endif /* __DC1394_STATS_H__ */
@@ -0,0 +1,195 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Worker threads for the image conversions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "threads.h"
+
+#ifdef HAVE_PTHREAD
+
+typedef struct _thread_job_t {
+    thread_task_t task;
+    void *arg;
+    int count;         /* number of tasks */
+    int next;          /* next task to hand out */
+    int done;          /* tasks finished */
+    int helpers;       /* pool threads working on this job */
+    int max_helpers;
+    struct _thread_job_t *next_job;
+} thread_job_t;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;   /* a job was queued */
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;   /* a job finished */
+static thread_job_t *pool_jobs = NULL;                         /* jobs with tasks left to hand out */
+static int pool_threads = 0;
+static pthread_mutex_t once_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* runs the remaining tasks of a job; called and returns with the mutex held */
+static void
+run_tasks(thread_job_t *job)
+{
+    thread_job_t **j;
+    int index;
+
+    while (job->next < job->count) {
+        index = job->next++;
+        if (job->next == job->count) {
+            // nothing left to hand out: take the job off the queue
+            for (j = &pool_jobs; *j != job; j = &(*j)->next_job)
+                ;
+            *j = job->next_job;
+        }
+        pthread_mutex_unlock(&pool_mutex);
+        job->task(job->arg, index);
+        pthread_mutex_lock(&pool_mutex);
+        job->done++;
+    }
+}
+
+static void *
+pool_thread(void *unused)
+{
+    thread_job_t *job;
+
+    (void)unused;
+    pthread_mutex_lock(&pool_mutex);
+    for (;;) {
+        for (job = pool_jobs; job != NULL; job = job->next_job)
+            if (job->helpers < job->max_helpers)
+                break;
+        if (job == NULL) {
+            pthread_cond_wait(&pool_work, &pool_mutex);
+            continue;
+        }
+        job->helpers++;
+        run_tasks(job);
+        job->helpers--;
+        if (job->done == job->count)
+            pthread_cond_broadcast(&pool_done);
+    }
+    return NULL;
+}
+
+void
+thread_pool_run(int threads, int count, thread_task_t task, void *arg)
+{
+    thread_job_t job;
+    pthread_t thread;
+    pthread_attr_t attr;
+    int i;
+
+    if (threads > THREAD_POOL_MAX_THREADS)
+        threads = THREAD_POOL_MAX_THREADS;
+    if (threads > count)
+        threads = count;
+    if (threads <= 1) {
+        for (i = 0; i < count; i++)
+            task(arg, i);
+        return;
+    }
+
+    job.task = task;
+    job.arg = arg;
+    job.count = count;
+    job.next = 0;
+    job.done = 0;
+    job.helpers = 0;
+    job.max_helpers = threads - 1;
+
+    pthread_mutex_lock(&pool_mutex);
+
+    // grow the pool if needed. If a thread can't be started we simply do with fewer.
+    if (pool_threads < threads - 1) {
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        while (pool_threads < threads - 1) {
+            if (pthread_create(&thread, &attr, pool_thread, NULL) != 0)
+                break;
+            pool_threads++;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    job.next_job = pool_jobs;
+    pool_jobs = &job;
+    pthread_cond_broadcast(&pool_work);
+
+    // the caller works too, then waits for the tasks still running elsewhere
+    run_tasks(&job);
+    while (job.done < job.count)
+        pthread_cond_wait(&pool_done, &pool_mutex);
+
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+void
+thread_once(int *done, void (*init)(void))
+{
+    pthread_mutex_lock(&once_mutex);
+    if (*done == 0) {
+        init();
+        *done = 1;
+    }
+    pthread_mutex_unlock(&once_mutex);
+}
+
+#else /* HAVE_PTHREAD */
+
+void
+thread_pool_run(int threads, int count, thread_task_t task, void *arg)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        task(arg, i);
+}
+
+void
+thread_once(int *done, void (*init)(void))
+{
+    if (*done == 0) {
+        init();
+        *done = 1;
+    }
+}
+
+#endif /* HAVE_PTHREAD */
+
+int
+thread_pool_cpu_count(void)
+{
+    long n = 1;
+
+#if defined(HAVE_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1)
+        return 1;
+    if (n > THREAD_POOL_MAX_THREADS)
+        return THREAD_POOL_MAX_THREADS;
+    return (int) n;
+}
@@ -0,0 +1,48 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Worker threads for the image conversions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __DC1394_THREADS_H__
+#define __DC1394_THREADS_H__
+
+/*
+  A single pool of worker threads is shared by all the cameras and all the
+  callers of the library. The threads are started on first use, grow with
+  the largest request seen so far, and live until the process exits.
+  Several callers can submit work at the same time.
+ */
+
+/* the pool never grows past this many threads */
+#define THREAD_POOL_MAX_THREADS 64
+
+typedef void (*thread_task_t)(void *arg, int index);
+
+/* Runs task(arg, i) for i = 0..count-1 on up to 'threads' threads, the
+   calling thread included, and returns when all of them are done. Without
+   thread support everything runs in the calling thread. */
+void thread_pool_run(int threads, int count, thread_task_t task, void *arg);
+
+/* Number of processors available, at least 1 */
+int thread_pool_cpu_count(void);
+
+/* Calls init() if *done is still 0 and then sets it, so that init() runs
+   only once even when several threads get there at the same time. */
+void thread_once(int *done, void (*init)(void));
+
+#endif /* __DC1394_THREADS_H__ */
@@ -91,11 +91,19 @@ typedef enum {
     DC1394_COLOR_CODING_MONO16S,
     DC1394_COLOR_CODING_RGB16S,
     DC1394_COLOR_CODING_RAW8,
-    DC1394_COLOR_CODING_RAW16
+    DC1394_COLOR_CODING_RAW16,
+    /* codings of converted images only, which no camera delivers: see conversions.h */
+    DC1394_COLOR_CODING_RGBA8= 384,
+    DC1394_COLOR_CODING_BGRA8,
+    DC1394_COLOR_CODING_RGB8_PLANAR,
+    DC1394_COLOR_CODING_NV12,
+    DC1394_COLOR_CODING_I420
 } dc1394color_coding_t;
 #define DC1394_COLOR_CODING_MIN     DC1394_COLOR_CODING_MONO8
 #define DC1394_COLOR_CODING_MAX     DC1394_COLOR_CODING_RAW16
 #define DC1394_COLOR_CODING_NUM    (DC1394_COLOR_CODING_MAX - DC1394_COLOR_CODING_MIN + 1)
+#define DC1394_COLOR_CODING_CONVERTED_MIN     DC1394_COLOR_CODING_RGBA8
+#define DC1394_COLOR_CODING_CONVERTED_MAX     DC1394_COLOR_CODING_I420
 
 /**
  * RAW sensor filters. These elementary tiles tesselate the image plane in RAW modes. RGGB should be interpreted in 2D as
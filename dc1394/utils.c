@@ -209,6 +209,11 @@ dc1394_is_color(dc1394color_coding_t color_coding, dc1394bool_t *is_color)
     case DC1394_COLOR_CODING_RGB8:
     case DC1394_COLOR_CODING_RGB16:
     case DC1394_COLOR_CODING_RGB16S:
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
         *is_color=DC1394_TRUE;
         return DC1394_SUCCESS;
     }
@@ -225,6 +230,11 @@ dc1394_get_color_coding_data_depth(dc1394color_coding_t color_coding, uint32_t *
     case DC1394_COLOR_CODING_YUV444:
     case DC1394_COLOR_CODING_RGB8:
     case DC1394_COLOR_CODING_RAW8:
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
         *bits = 8;
         return DC1394_SUCCESS;
     case DC1394_COLOR_CODING_MONO16:
@@ -248,6 +258,8 @@ dc1394_get_color_coding_bit_size(dc1394color_coding_t color_coding, uint32_t* bi
         *bits=8;
         return DC1394_SUCCESS;
     case DC1394_COLOR_CODING_YUV411:
+    case DC1394_COLOR_CODING_NV12:
+    case DC1394_COLOR_CODING_I420:
         *bits=12;
         return DC1394_SUCCESS;
     case DC1394_COLOR_CODING_MONO16:
@@ -258,8 +270,13 @@ dc1394_get_color_coding_bit_size(dc1394color_coding_t color_coding, uint32_t* bi
         return DC1394_SUCCESS;
     case DC1394_COLOR_CODING_YUV444:
     case DC1394_COLOR_CODING_RGB8:
+    case DC1394_COLOR_CODING_RGB8_PLANAR:
         *bits=24;
         return DC1394_SUCCESS;
+    case DC1394_COLOR_CODING_RGBA8:
+    case DC1394_COLOR_CODING_BGRA8:
+        *bits=32;
+        return DC1394_SUCCESS;
     case DC1394_COLOR_CODING_RGB16:
     case DC1394_COLOR_CODING_RGB16S:
         *bits=48;
@@ -95,6 +95,11 @@ typedef struct {
     dc1394framerate_t       framerates[DC1394_FRAMERATE_NUM];
 } dc1394framerates_t;
 
+/**
+ * A pool of frame buffers, see conversions.h
+ */
+typedef struct __dc1394framepool dc1394framepool_t;
+
 /**
  * Video frame structure.
  *
@@ -102,7 +107,7 @@ typedef struct {
  * information. 
  *
  * In general this structure should be calloc'ed so that members such as "allocated size"
- * are properly set to zero. Don't forget to free the "image" member before freeing the struct itself.
+ * are properly set to zero, and "pool" to NULL. Don't forget to free the "image" member before freeing the struct itself.
  */
 typedef struct __dc1394_video_frame
 {
@@ -133,6 +138,9 @@ typedef struct __dc1394_video_frame
                                                        DC1394_FALSE otherwise */
     dc1394bool_t             data_in_padding;       /* DC1394_TRUE if data is present in the padding bytes in IIDC 1.32 format,
                                                        DC1394_FALSE otherwise */
+    dc1394framepool_t        *pool;                 /* if not NULL, the pool from which the conversions take the image of an
+                                                       output frame. Set by the caller, who must set it to NULL
+                                                       for malloc(); NULL in the frames of the capture. */
 } dc1394video_frame_t;
 
 #ifdef __cplusplus
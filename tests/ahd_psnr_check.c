@@ -0,0 +1,388 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Check that the fixed-point AHD de-mosaicing stays close to the float one
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  The library computes the CIELab images of AHD from integer tables. The
+  float AHD it replaced is kept here as the reference: a scene of colored
+  shapes with sharp edges over smooth gradients is mosaiced with each of the
+  four color filters, at 8 and 12 bits, and the output of the library must
+  have a PSNR of at least MIN_PSNR dB against that of the reference. The two
+  only differ where the fixed-point Lab flips the choice between two
+  directions that are nearly as homogeneous: about 67 dB at 8 bits.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dc1394/dc1394.h>
+
+#define MIN_PSNR 50.0
+
+#define WIDTH  640
+#define HEIGHT 480
+
+/*-----------------------------------------------------------------------
+ *  The float AHD of dcraw, as ported to libdc1394 by Samuel Audet
+ *-----------------------------------------------------------------------*/
+
+#define FORC3 for (c=0; c < 3; c++)
+#define SQR(x) ((x)*(x))
+#define ABS(x) (((int)(x) ^ ((int)(x) >> 31)) - ((int)(x) >> 31))
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#define LIM(x,min,max) MAX(min,MIN(x,max))
+#define ULIM(x,y,z) ((y) < (z) ? LIM(x,y,z) : LIM(x,z,y))
+#define CLIPOUT16(x,bits) LIM(x,0,((1<<bits)-1))
+#define FC(row,col) \
+        (filters >> ((((row) << 1 & 14) + ((col) & 1)) << 1) & 3)
+
+#define TS 256                /* Tile Size */
+
+static const double xyz_rgb[3][3] = {                        /* XYZ from RGB */
+  { 0.412453, 0.357580, 0.180423 },
+  { 0.212671, 0.715160, 0.072169 },
+  { 0.019334, 0.119193, 0.950227 } };
+static const float d65_white[3] = { 0.950456, 1, 1.088754 };
+
+static float cbrt_table[0x10000], xyz_cam[3][4];
+
+static void
+cam_to_cielab_init(void)
+{
+    float r;
+    int i, j;
+
+    for (i=0; i < 0x10000; i++) {
+        r = i / 65535.0;
+        cbrt_table[i] = r > 0.008856 ? pow(r,1/3.0) : 7.787*r + 16/116.0;
+    }
+    for (i=0; i < 3; i++)
+        for (j=0; j < 3; j++)
+            xyz_cam[i][j] = xyz_rgb[i][j] / d65_white[i];
+}
+
+static void
+cam_to_cielab(uint16_t cam[3], float lab[3])
+{
+    float xyz[3];
+    int c;
+
+    xyz[0] = xyz[1] = xyz[2] = 0.5;
+    FORC3 {
+        xyz[0] += xyz_cam[0][c] * cam[c];
+        xyz[1] += xyz_cam[1][c] * cam[c];
+        xyz[2] += xyz_cam[2][c] * cam[c];
+    }
+    xyz[0] = cbrt_table[CLIPOUT16((int) xyz[0],16)];
+    xyz[1] = cbrt_table[CLIPOUT16((int) xyz[1],16)];
+    xyz[2] = cbrt_table[CLIPOUT16((int) xyz[2],16)];
+    lab[0] = 116 * xyz[1] - 16;
+    lab[1] = 500 * (xyz[0] - xyz[1]);
+    lab[2] = 200 * (xyz[1] - xyz[2]);
+}
+
+/* the 8-bit version of the library gave the same as this one with bits 8 */
+static void
+reference_ahd(const uint16_t *bayer, uint16_t *dst, int sx, int sy, dc1394color_filter_t pattern, int bits)
+{
+    int i, j, top, left, row, col, tr, tc, fc, c, d, val, hm[2];
+    uint16_t (*pix)[3], (*rix)[3];
+    static const int dir[4] = { -1, 1, -TS, TS };
+    unsigned ldiff[2][4], abdiff[2][4], leps, abeps;
+    float flab[3];
+    uint16_t (*rgb)[TS][TS][3];
+    short (*lab)[TS][TS][3];
+    char (*homo)[TS][TS], *buffer;
+    uint32_t filters = 0;
+    const int height = sy, width = sx;
+    int x, y;
+
+    switch(pattern) {
+    case DC1394_COLOR_FILTER_BGGR:
+        filters = 0x16161616;
+        break;
+    case DC1394_COLOR_FILTER_GRBG:
+        filters = 0x61616161;
+        break;
+    case DC1394_COLOR_FILTER_RGGB:
+        filters = 0x94949494;
+        break;
+    case DC1394_COLOR_FILTER_GBRG:
+        filters = 0x49494949;
+        break;
+    }
+
+    for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+            dst[(y*width+x)*3 + FC(y,x)] = bayer[y*width+x];
+
+    /* border_interpolate(3) */
+    {
+        const unsigned border = 3, w = width, h = height;
+        unsigned row, col, y, x, f, c, sum[8];
+
+        for (row=0; row < h; row++)
+            for (col=0; col < w; col++) {
+                if (col==border && row >= border && row < h-border)
+                    col = w-border;
+                memset (sum, 0, sizeof sum);
+                for (y=row-1; y != row+2; y++)
+                    for (x=col-1; x != col+2; x++)
+                        if (y < h && x < w) {
+                            f = FC(y,x);
+                            sum[f] += dst[(y*width+x)*3 + f];
+                            sum[f+4]++;
+                        }
+                f = FC(row,col);
+                FORC3 if (c != f && sum[c+4])
+                    dst[(row*width+col)*3 + c] = sum[c] / sum[c+4];
+            }
+    }
+
+    buffer = (char *) malloc (26*TS*TS);
+    if (buffer == NULL)
+        exit(1);
+    rgb  = (uint16_t(*)[TS][TS][3]) buffer;
+    lab  = (short (*)[TS][TS][3])(buffer + 12*TS*TS);
+    homo = (char  (*)[TS][TS])   (buffer + 24*TS*TS);
+
+    for (top=0; top < height; top += TS-6)
+        for (left=0; left < width; left += TS-6) {
+            memset (rgb, 0, 12*TS*TS);
+
+            /*  Interpolate green horizontally and vertically:                */
+            for (row = top < 2 ? 2:top; row < top+TS && row < height-2; row++) {
+                col = left + (FC(row,left) == 1);
+                if (col < 2) col += 2;
+                for (fc = FC(row,col); col < left+TS && col < width-2; col+=2) {
+                    pix = (uint16_t (*)[3])dst + (row*width+col);
+                    val = ((pix[-1][1] + pix[0][fc] + pix[1][1]) * 2
+                           - pix[-2][fc] - pix[2][fc]) >> 2;
+                    rgb[0][row-top][col-left][1] = ULIM(val,pix[-1][1],pix[1][1]);
+                    val = ((pix[-width][1] + pix[0][fc] + pix[width][1]) * 2
+                           - pix[-2*width][fc] - pix[2*width][fc]) >> 2;
+                    rgb[1][row-top][col-left][1] = ULIM(val,pix[-width][1],pix[width][1]);
+                }
+            }
+            /*  Interpolate red and blue, and convert to CIELab:                */
+            for (d=0; d < 2; d++)
+                for (row=top+1; row < top+TS-1 && row < height-1; row++)
+                    for (col=left+1; col < left+TS-1 && col < width-1; col++) {
+                        pix = (uint16_t (*)[3])dst + (row*width+col);
+                        rix = &rgb[d][row-top][col-left];
+                        if ((c = 2 - FC(row,col)) == 1) {
+                            c = FC(row+1,col);
+                            val = pix[0][1] + (( pix[-1][2-c] + pix[1][2-c]
+                                                 - rix[-1][1] - rix[1][1] ) >> 1);
+                            rix[0][2-c] = CLIPOUT16(val, bits);
+                            val = pix[0][1] + (( pix[-width][c] + pix[width][c]
+                                                 - rix[-TS][1] - rix[TS][1] ) >> 1);
+                        } else
+                            val = rix[0][1] + (( pix[-width-1][c] + pix[-width+1][c]
+                                                 + pix[+width-1][c] + pix[+width+1][c]
+                                                 - rix[-TS-1][1] - rix[-TS+1][1]
+                                                 - rix[+TS-1][1] - rix[+TS+1][1] + 1) >> 2);
+                        rix[0][c] = CLIPOUT16(val, bits);
+                        c = FC(row,col);
+                        rix[0][c] = pix[0][c];
+                        cam_to_cielab (rix[0], flab);
+                        FORC3 lab[d][row-top][col-left][c] = 64*flab[c];
+                    }
+            /*  Build homogeneity maps from the CIELab images:                */
+            memset (homo, 0, 2*TS*TS);
+            for (row=top+2; row < top+TS-2 && row < height; row++) {
+                tr = row-top;
+                for (col=left+2; col < left+TS-2 && col < width; col++) {
+                    tc = col-left;
+                    for (d=0; d < 2; d++)
+                        for (i=0; i < 4; i++)
+                            ldiff[d][i] = ABS(lab[d][tr][tc][0]-lab[d][tr][tc+dir[i]][0]);
+                    leps = MIN(MAX(ldiff[0][0],ldiff[0][1]),
+                               MAX(ldiff[1][2],ldiff[1][3]));
+                    for (d=0; d < 2; d++)
+                        for (i=0; i < 4; i++)
+                            if (i >> 1 == d || ldiff[d][i] <= leps)
+                                abdiff[d][i] = SQR(lab[d][tr][tc][1]-lab[d][tr][tc+dir[i]][1])
+                                    + SQR(lab[d][tr][tc][2]-lab[d][tr][tc+dir[i]][2]);
+                    abeps = MIN(MAX(abdiff[0][0],abdiff[0][1]),
+                                MAX(abdiff[1][2],abdiff[1][3]));
+                    for (d=0; d < 2; d++)
+                        for (i=0; i < 4; i++)
+                            if (ldiff[d][i] <= leps && abdiff[d][i] <= abeps)
+                                homo[d][tr][tc]++;
+                }
+            }
+            /*  Combine the most homogenous pixels for the final result:        */
+            for (row=top+3; row < top+TS-3 && row < height-3; row++) {
+                tr = row-top;
+                for (col=left+3; col < left+TS-3 && col < width-3; col++) {
+                    tc = col-left;
+                    for (d=0; d < 2; d++)
+                        for (hm[d]=0, i=tr-1; i <= tr+1; i++)
+                            for (j=tc-1; j <= tc+1; j++)
+                                hm[d] += homo[d][i][j];
+                    if (hm[0] != hm[1])
+                        FORC3 dst[(row*width+col)*3 + c] = CLIPOUT16(rgb[hm[1] > hm[0]][tr][tc][c], bits);
+                    else
+                        FORC3 dst[(row*width+col)*3 + c] =
+                            CLIPOUT16((rgb[0][tr][tc][c] + rgb[1][tr][tc][c]) >> 1, bits);
+                }
+            }
+        }
+    free (buffer);
+}
+
+/*-----------------------------------------------------------------------
+ *  The scene
+ *-----------------------------------------------------------------------*/
+
+/* the color of the scene at x, y, in 0..1 */
+static void
+scene(int x, int y, double rgb[3])
+{
+    double u = (double)x / WIDTH, v = (double)y / HEIGHT, dx, dy;
+    int c;
+
+    // smooth gradients
+    rgb[0] = 0.2 + 0.6 * u;
+    rgb[1] = 0.3 + 0.4 * v;
+    rgb[2] = 0.8 - 0.5 * u * v;
+
+    // a saturated red disc, a blue rectangle and a yellow stripe, with sharp edges
+    dx = x - 0.3 * WIDTH;
+    dy = y - 0.4 * HEIGHT;
+    if (dx * dx + dy * dy < 0.04 * WIDTH * WIDTH) {
+        rgb[0] = 0.95;
+        rgb[1] = 0.1;
+        rgb[2] = 0.15;
+    }
+    if ((x > 0.55 * WIDTH) && (x < 0.85 * WIDTH) && (y > 0.15 * HEIGHT) && (y < 0.5 * HEIGHT)) {
+        rgb[0] = 0.1;
+        rgb[1] = 0.2;
+        rgb[2] = 0.9;
+    }
+    if (abs(x - y - WIDTH / 4) < 12) {
+        rgb[0] = 0.9;
+        rgb[1] = 0.85;
+        rgb[2] = 0.1;
+    }
+    // thin dark lines, vertical and horizontal
+    if ((x % 97 < 2) || (y % 83 < 2))
+        for (c = 0; c < 3; c++)
+            rgb[c] *= 0.2;
+}
+
+/* the mosaic of the scene for a color filter, with samples of 'bits' bits */
+static void
+mosaic(uint16_t *bayer, dc1394color_filter_t tile, int bits)
+{
+    // the channel of each position of the 2x2 pattern
+    static const int channels[4][4] = {
+        { 0, 1, 1, 2 },        // RGGB
+        { 1, 2, 0, 1 },        // GBRG
+        { 1, 0, 2, 1 },        // GRBG
+        { 2, 1, 1, 0 }         // BGGR
+    };
+    const int *ch = channels[tile - DC1394_COLOR_FILTER_MIN];
+    const double max = (1 << bits) - 1;
+    double rgb[3];
+    int x, y;
+
+    for (y = 0; y < HEIGHT; y++)
+        for (x = 0; x < WIDTH; x++) {
+            scene(x, y, rgb);
+            bayer[y * WIDTH + x] = (uint16_t)(rgb[ch[(y & 1) * 2 + (x & 1)]] * max + 0.5);
+        }
+}
+
+static double
+psnr(const uint16_t *a, const uint16_t *b, size_t n, int bits)
+{
+    const double max = (1 << bits) - 1;
+    double se = 0, e;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        e = (double)a[i] - b[i];
+        se += e * e;
+    }
+    if (se == 0)
+        return INFINITY;
+    return 10 * log10(max * max * n / se);
+}
+
+int
+main(void)
+{
+    const size_t n = (size_t)WIDTH * HEIGHT;
+    uint16_t *bayer, *ref, *out;
+    uint8_t *bayer8, *out8;
+    dc1394color_filter_t tile;
+    int bits, failures = 0;
+    double p;
+    size_t i;
+
+    bayer = (uint16_t*)malloc(n * sizeof(uint16_t));
+    ref = (uint16_t*)malloc(3 * n * sizeof(uint16_t));
+    out = (uint16_t*)malloc(3 * n * sizeof(uint16_t));
+    bayer8 = (uint8_t*)malloc(n);
+    out8 = (uint8_t*)malloc(3 * n);
+    if ((bayer == NULL) || (ref == NULL) || (out == NULL) || (bayer8 == NULL) || (out8 == NULL))
+        return 1;
+    cam_to_cielab_init();
+
+    for (tile = DC1394_COLOR_FILTER_MIN; tile <= DC1394_COLOR_FILTER_MAX; tile++) {
+        for (bits = 8; bits <= 12; bits += 4) {
+            mosaic(bayer, tile, bits);
+            memset(ref, 0, 3 * n * sizeof(uint16_t));
+            reference_ahd(bayer, ref, WIDTH, HEIGHT, tile, bits);
+
+            if (bits == 8) {
+                for (i = 0; i < n; i++)
+                    bayer8[i] = (uint8_t)bayer[i];
+                memset(out8, 0, 3 * n);
+                if (dc1394_bayer_decoding_8bit(bayer8, out8, WIDTH, HEIGHT, tile, DC1394_BAYER_METHOD_AHD)
+                    != DC1394_SUCCESS)
+                    return 1;
+                for (i = 0; i < 3 * n; i++)
+                    out[i] = out8[i];
+            } else {
+                memset(out, 0, 3 * n * sizeof(uint16_t));
+                if (dc1394_bayer_decoding_16bit(bayer, out, WIDTH, HEIGHT, tile, DC1394_BAYER_METHOD_AHD, bits)
+                    != DC1394_SUCCESS)
+                    return 1;
+            }
+
+            p = psnr(out, ref, 3 * n, bits);
+            printf("%s filter %d, %d bits: PSNR %.1f dB against the float AHD\n", (p >= MIN_PSNR) ? "PASS" : "FAIL",
+                   tile, bits, p);
+            if (p < MIN_PSNR)
+                failures++;
+        }
+    }
+
+    free(bayer);
+    free(ref);
+    free(out);
+    free(bayer8);
+    free(out8);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Check that the threads of a context de-mosaic as the calling thread alone
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  Every method de-mosaics random mosaics of each of the four color filters,
+  of 8 and of 12 bits, with contexts of 1, 2, 3 and 8 threads. The heights
+  give 1 to 8 bands, the last of them shorter, so that the halos of the bands
+  are read across all their borders. The output must be the same to the bit
+  as that of dc1394_bayer_decoding_8bit() and dc1394_bayer_decoding_16bit().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dc1394/dc1394.h>
+#include "simd_check.h"
+
+static const uint32_t sizes[][2] = { { 70, 46 }, { 134, 130 }, { 96, 202 }, { 262, 520 } };
+
+static const uint32_t threads[] = { 1, 2, 3, 8 };
+
+#define THREADS_NUM (sizeof(threads) / sizeof(threads[0]))
+
+static void
+cases(simd_check_t *check)
+{
+    dc1394debayer_context_t *ctx[THREADS_NUM];
+    dc1394color_filter_t tile;
+    dc1394bayer_method_t method;
+    uint32_t s, t, i, n, state = 2463534242u;
+    uint16_t *bayer16, *rgb16, *serial16;
+    uint8_t *bayer, *rgb, *serial;
+    char name[128];
+    dc1394error_t err, serial_err;
+
+    for (t = 0; t < THREADS_NUM; t++) {
+        ctx[t] = dc1394_debayer_context_new(threads[t]);
+        if (ctx[t] == NULL)
+            exit(1);
+    }
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        n = sizes[s][0] * sizes[s][1];
+        bayer = (uint8_t*)malloc(n);
+        rgb = (uint8_t*)malloc(3 * n);
+        serial = (uint8_t*)malloc(3 * n);
+        bayer16 = (uint16_t*)malloc(2 * n);
+        rgb16 = (uint16_t*)malloc(6 * n);
+        serial16 = (uint16_t*)malloc(6 * n);
+        if ((bayer == NULL) || (rgb == NULL) || (serial == NULL) || (bayer16 == NULL) || (rgb16 == NULL) ||
+            (serial16 == NULL))
+            exit(1);
+
+        for (tile = DC1394_COLOR_FILTER_MIN; tile <= DC1394_COLOR_FILTER_MAX; tile++) {
+            for (method = DC1394_BAYER_METHOD_MIN; method <= DC1394_BAYER_METHOD_MAX; method++) {
+                for (i = 0; i < n; i++) {
+                    bayer[i] = (uint8_t)simd_check_random(&state);
+                    bayer16[i] = (uint16_t)(simd_check_random(&state) & 0x0fff);
+                }
+                memset(serial, 0, 3 * n);
+                memset(serial16, 0, 6 * n);
+                serial_err = dc1394_bayer_decoding_8bit(bayer, serial, sizes[s][0], sizes[s][1], tile, method);
+                for (t = 0; t < THREADS_NUM; t++) {
+                    memset(rgb, 0, 3 * n);
+                    err = dc1394_bayer_decoding_8bit_parallel(ctx[t], bayer, rgb, sizes[s][0], sizes[s][1], tile,
+                                                              method);
+                    snprintf(name, sizeof(name), "8-bit %ux%u filter %d method %d, %u threads", sizes[s][0],
+                             sizes[s][1], tile, method, threads[t]);
+                    simd_check_same(check, name, &err, &serial_err, sizeof(err));
+                    simd_check_same(check, name, rgb, serial, 3 * n);
+                }
+
+                serial_err = dc1394_bayer_decoding_16bit(bayer16, serial16, sizes[s][0], sizes[s][1], tile, method,
+                                                         12);
+                for (t = 0; t < THREADS_NUM; t++) {
+                    memset(rgb16, 0, 6 * n);
+                    err = dc1394_bayer_decoding_16bit_parallel(ctx[t], bayer16, rgb16, sizes[s][0], sizes[s][1],
+                                                               tile, method, 12);
+                    snprintf(name, sizeof(name), "12-bit %ux%u filter %d method %d, %u threads", sizes[s][0],
+                             sizes[s][1], tile, method, threads[t]);
+                    simd_check_same(check, name, &err, &serial_err, sizeof(err));
+                    simd_check_same(check, name, rgb16, serial16, 6 * n);
+                }
+            }
+        }
+
+        free(bayer);
+        free(rgb);
+        free(serial);
+        free(bayer16);
+        free(rgb16);
+        free(serial16);
+    }
+
+    for (t = 0; t < THREADS_NUM; t++)
+        dc1394_debayer_context_free(ctx[t]);
+}
+
+int
+main(void)
+{
+    return simd_check_run(cases);
+}
@@ -0,0 +1,90 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Check that the SIMD de-mosaicing kernels give the output of the scalar code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  Every method de-mosaics random mosaics of each of the four color filters,
+  of 8 bits and of 8, 10, 12, 14 and 16 bits in 16-bit samples, whose
+  widths leave a tail after the last vector of each kernel. The output must
+  be the same to the bit as that of the scalar code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dc1394/dc1394.h>
+#include "simd_check.h"
+
+static const uint32_t sizes[][2] = { { 70, 46 }, { 134, 34 }, { 262, 18 }, { 1030, 12 } };
+
+static void
+cases(simd_check_t *check)
+{
+    dc1394color_filter_t tile;
+    dc1394bayer_method_t method;
+    uint32_t s, i, n, bits, state = 2463534242u;
+    uint16_t *bayer16, *rgb16;
+    uint8_t *bayer, *rgb;
+    char name[128];
+    dc1394error_t err;
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        n = sizes[s][0] * sizes[s][1];
+        bayer = (uint8_t*)malloc(n);
+        rgb = (uint8_t*)malloc(3 * n);
+        bayer16 = (uint16_t*)malloc(2 * n);
+        rgb16 = (uint16_t*)malloc(6 * n);
+        if ((bayer == NULL) || (rgb == NULL) || (bayer16 == NULL) || (rgb16 == NULL))
+            exit(1);
+
+        for (tile = DC1394_COLOR_FILTER_MIN; tile <= DC1394_COLOR_FILTER_MAX; tile++) {
+            for (method = DC1394_BAYER_METHOD_MIN; method <= DC1394_BAYER_METHOD_MAX; method++) {
+                for (i = 0; i < n; i++)
+                    bayer[i] = (uint8_t)simd_check_random(&state);
+                memset(rgb, 0, 3 * n);
+                err = dc1394_bayer_decoding_8bit(bayer, rgb, sizes[s][0], sizes[s][1], tile, method);
+                snprintf(name, sizeof(name), "8-bit %ux%u filter %d method %d", sizes[s][0], sizes[s][1], tile, method);
+                simd_check_output(check, name, &err, sizeof(err), 0);
+                simd_check_output(check, name, rgb, 3 * n, 0);
+
+                for (bits = 8; bits <= 16; bits += 2) {
+                    for (i = 0; i < n; i++)
+                        bayer16[i] = (uint16_t)(simd_check_random(&state) & ((1 << bits) - 1));
+                    memset(rgb16, 0, 6 * n);
+                    err = dc1394_bayer_decoding_16bit(bayer16, rgb16, sizes[s][0], sizes[s][1], tile, method, bits);
+                    snprintf(name, sizeof(name), "%u-bit %ux%u filter %d method %d", bits, sizes[s][0], sizes[s][1],
+                             tile, method);
+                    simd_check_output(check, name, &err, sizeof(err), 0);
+                    simd_check_output(check, name, rgb16, 6 * n, 0);
+                }
+            }
+        }
+
+        free(bayer);
+        free(rgb);
+        free(bayer16);
+        free(rgb16);
+    }
+}
+
+int
+main(void)
+{
+    return simd_check_run(cases);
+}
@@ -0,0 +1,144 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Check that the threads of a context convert frames as the calling thread alone
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  Random frames of each input coding are converted to each output coding,
+  with the look-up tables of the macros and with those of two matrices and
+  ranges, by dc1394_convert_frames_parallel() with a context of 4 threads and
+  without a context. The small frame is below the size at which the threads
+  are woken up, the large one gives a band to each thread. The output must
+  be the same to the bit, as must the error and the size of the image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dc1394/dc1394.h>
+#include "simd_check.h"
+
+static const uint32_t sizes[][2] = { { 64, 48 }, { 1920, 1088 } };
+
+static const struct {
+    dc1394color_coding_t coding;
+    uint32_t byte_order;
+    dc1394bool_t little_endian;
+} inputs[] = {
+    { DC1394_COLOR_CODING_YUV444, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_YUYV, DC1394_FALSE },
+    { DC1394_COLOR_CODING_YUV411, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_RGB8, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_MONO8, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_RAW8, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_MONO16, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_MONO16, DC1394_BYTE_ORDER_UYVY, DC1394_TRUE },
+    { DC1394_COLOR_CODING_RAW16, DC1394_BYTE_ORDER_UYVY, DC1394_FALSE },
+    { DC1394_COLOR_CODING_RGB16, DC1394_BYTE_ORDER_UYVY, DC1394_TRUE }
+};
+
+static const struct {
+    dc1394color_coding_t coding;
+    uint32_t byte_order;
+} outputs[] = {
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_YUYV },
+    { DC1394_COLOR_CODING_RGB8, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_MONO8, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_RGBA8, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_BGRA8, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_RGB8_PLANAR, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_NV12, DC1394_BYTE_ORDER_UYVY },
+    { DC1394_COLOR_CODING_I420, DC1394_BYTE_ORDER_UYVY }
+};
+
+#define PARAMS_NUM 3
+
+static void
+cases(simd_check_t *check)
+{
+    dc1394debayer_context_t *ctx;
+    dc1394yuv_params_t *params[PARAMS_NUM];
+    dc1394video_frame_t in, out, serial;
+    dc1394error_t err, serial_err;
+    uint32_t s, k, o, p, i, bits, state = 2463534242u;
+    char name[160];
+
+    ctx = dc1394_debayer_context_new(4);
+    params[0] = NULL;
+    params[1] = dc1394_yuv_params_new(DC1394_YUV_MATRIX_BT601, DC1394_YUV_RANGE_LIMITED);
+    params[2] = dc1394_yuv_params_new(DC1394_YUV_MATRIX_BT709, DC1394_YUV_RANGE_FULL);
+    if ((ctx == NULL) || (params[1] == NULL) || (params[2] == NULL))
+        exit(1);
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+            memset(&in, 0, sizeof(in));
+            in.size[0] = sizes[s][0];
+            in.size[1] = sizes[s][1];
+            in.color_coding = inputs[k].coding;
+            in.yuv_byte_order = inputs[k].byte_order;
+            in.little_endian = inputs[k].little_endian;
+            in.color_filter = DC1394_COLOR_FILTER_RGGB;
+            in.data_depth = 16;
+            if (dc1394_get_color_coding_bit_size(in.color_coding, &bits) != DC1394_SUCCESS)
+                exit(1);
+            in.image_bytes = (uint64_t)in.size[0] * in.size[1] * bits / 8;
+            in.image = (uint8_t*)malloc(in.image_bytes);
+            if (in.image == NULL)
+                exit(1);
+            for (i = 0; i < in.image_bytes; i++)
+                in.image[i] = (uint8_t)simd_check_random(&state);
+
+            for (o = 0; o < sizeof(outputs) / sizeof(outputs[0]); o++) {
+                for (p = 0; p < PARAMS_NUM; p++) {
+                    memset(&serial, 0, sizeof(serial));
+                    serial.color_coding = outputs[o].coding;
+                    serial.yuv_byte_order = outputs[o].byte_order;
+                    out = serial;
+                    serial_err = dc1394_convert_frames_parallel(NULL, params[p], &in, &serial);
+                    err = dc1394_convert_frames_parallel(ctx, params[p], &in, &out);
+
+                    snprintf(name, sizeof(name), "coding %d%s byte order %u to coding %d byte order %u, params %u, "
+                             "%ux%u", in.color_coding, in.little_endian ? " little endian" : "", in.yuv_byte_order,
+                             out.color_coding, out.yuv_byte_order, p, in.size[0], in.size[1]);
+                    simd_check_same(check, name, &err, &serial_err, sizeof(err));
+                    if ((err == DC1394_SUCCESS) && (serial_err == DC1394_SUCCESS)) {
+                        simd_check_same(check, name, &out.image_bytes, &serial.image_bytes, sizeof(out.image_bytes));
+                        if (out.image_bytes == serial.image_bytes)
+                            simd_check_same(check, name, out.image, serial.image, out.image_bytes);
+                    }
+                    free(out.image);
+                    free(serial.image);
+                }
+            }
+            free(in.image);
+        }
+    }
+
+    dc1394_yuv_params_free(params[1]);
+    dc1394_yuv_params_free(params[2]);
+    dc1394_debayer_context_free(ctx);
+}
+
+int
+main(void)
+{
+    return simd_check_run(cases);
+}
@@ -0,0 +1,225 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Comparison of the SIMD kernels with the scalar code, and of the threads with
+ * the calling thread alone, for the tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd_check.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+/* exit status of a skipped test, for automake */
+#define SIMD_CHECK_SKIP 77
+
+struct simd_check {
+    int scalar;                /* whether this is the child, which runs the scalar code */
+    int fd;                    /* the pipe, -1 once the child has stopped sending */
+    uint8_t *buffer;           /* an output of the child */
+    size_t buffer_size;
+    int outputs;
+    int failures;
+};
+
+uint32_t
+simd_check_random(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+#ifndef _WIN32
+
+static int
+write_all(int fd, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    ssize_t n;
+
+    while (size > 0) {
+        n = write(fd, p, size);
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static int
+read_all(int fd, void *data, size_t size)
+{
+    uint8_t *p = (uint8_t*)data;
+    ssize_t n;
+
+    while (size > 0) {
+        n = read(fd, p, size);
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+void
+simd_check_output(simd_check_t *check, const char *name, const void *data, size_t size, int tolerance)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    uint64_t scalar_size, s = size;
+    size_t i;
+
+    if (check->scalar) {
+        if ((write_all(check->fd, &s, sizeof(s)) != 0) || (write_all(check->fd, data, size) != 0))
+            exit(1);
+        return;
+    }
+
+    check->outputs++;
+    if ((check->fd < 0) || (read_all(check->fd, &scalar_size, sizeof(scalar_size)) != 0)) {
+        if (check->fd >= 0)
+            printf("FAIL %s: the scalar run stopped\n", name);
+        check->fd = -1;
+        check->failures++;
+        return;
+    }
+    if (scalar_size > check->buffer_size) {
+        free(check->buffer);
+        check->buffer = (uint8_t*)malloc(scalar_size);
+        check->buffer_size = (check->buffer != NULL) ? scalar_size : 0;
+    }
+    if ((check->buffer == NULL) || (read_all(check->fd, check->buffer, scalar_size) != 0)) {
+        printf("FAIL %s: the output of the scalar run could not be read\n", name);
+        check->fd = -1;
+        check->failures++;
+        return;
+    }
+
+    if (scalar_size != s) {
+        printf("FAIL %s: %llu bytes, %llu from the scalar code\n", name, (unsigned long long)s,
+               (unsigned long long)scalar_size);
+        check->failures++;
+        return;
+    }
+    for (i = 0; i < size; i++) {
+        if (abs((int)p[i] - (int)check->buffer[i]) > tolerance) {
+            printf("FAIL %s: byte %zu is %d, %d from the scalar code\n", name, i, p[i], check->buffer[i]);
+            check->failures++;
+            return;
+        }
+    }
+}
+
+void
+simd_check_same(simd_check_t *check, const char *name, const void *data, const void *expected, size_t size)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    const uint8_t *q = (const uint8_t*)expected;
+    size_t i;
+
+    // the failures of the child make it exit with an error
+    if (!check->scalar)
+        check->outputs++;
+    for (i = 0; i < size; i++) {
+        if (p[i] != q[i]) {
+            printf("FAIL %s%s: byte %zu is %d, %d expected\n", name, check->scalar ? " (scalar code)" : "", i, p[i],
+                   q[i]);
+            check->failures++;
+            return;
+        }
+    }
+}
+
+int
+simd_check_run(simd_check_cases_t cases)
+{
+    simd_check_t check;
+    int fds[2], status;
+    pid_t pid;
+    uint8_t extra;
+
+    memset(&check, 0, sizeof(check));
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        setenv("DC1394_NO_SIMD", "1", 1);
+        check.scalar = 1;
+        check.fd = fds[1];
+        cases(&check);
+        close(fds[1]);
+        fflush(stdout);
+        _exit((check.failures == 0) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    check.fd = fds[0];
+    cases(&check);
+    if ((check.fd >= 0) && (read(check.fd, &extra, 1) != 0)) {
+        printf("FAIL the scalar run has more outputs\n");
+        check.failures++;
+    }
+    close(fds[0]);
+    if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        printf("FAIL the scalar run did not end normally\n");
+        check.failures++;
+    }
+    free(check.buffer);
+
+    printf("%d outputs compared, %d failures\n", check.outputs, check.failures);
+    return (check.failures == 0) ? 0 : 1;
+}
+
+#else
+
+void
+simd_check_output(simd_check_t *check, const char *name, const void *data, size_t size, int tolerance)
+{
+}
+
+void
+simd_check_same(simd_check_t *check, const char *name, const void *data, const void *expected, size_t size)
+{
+}
+
+int
+simd_check_run(simd_check_cases_t cases)
+{
+    // there is no fork() to run the scalar code in a process of its own
+    return SIMD_CHECK_SKIP;
+}
+
+#endif
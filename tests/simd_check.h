@@ -0,0 +1,54 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Comparison of the SIMD kernels with the scalar code, and of the threads with
+ * the calling thread alone, for the tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __DC1394_SIMD_CHECK_H__
+#define __DC1394_SIMD_CHECK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  The library picks its kernels once per process, and DC1394_NO_SIMD in the
+  environment makes it pick the scalar code. The cases of a test are thus run
+  twice: in a child process with DC1394_NO_SIMD set, which sends each of its
+  outputs through a pipe, and in the test itself, which compares its outputs
+  with those of the child in the same order. The test must not convert or
+  de-mosaic anything before simd_check_run(). Outputs that must be the same
+  as others of the same run, such as those of the threads against those of
+  the calling thread alone, are compared in both processes.
+ */
+typedef struct simd_check simd_check_t;
+
+typedef void (*simd_check_cases_t)(simd_check_t *check);
+
+/* Runs the cases both ways. Returns the exit status of the test: 0 if all the outputs matched, 1 otherwise. */
+int simd_check_run(simd_check_cases_t cases);
+
+/* Compares an output with that of the scalar code, whose bytes may each differ from it by up to tolerance */
+void simd_check_output(simd_check_t *check, const char *name, const void *data, size_t size, int tolerance);
+
+/* Compares an output with the expected one of the same run, to the byte */
+void simd_check_same(simd_check_t *check, const char *name, const void *data, const void *expected, size_t size);
+
+/* A pseudo-random number, the same in both runs */
+uint32_t simd_check_random(uint32_t *state);
+
+#endif /* __DC1394_SIMD_CHECK_H__ */
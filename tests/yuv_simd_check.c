@@ -0,0 +1,104 @@
+/*
+ * 1394-Based Digital Camera Control Library
+ *
+ * Check that the SIMD conversions of YUV to RGB8 stay within 1 of the scalar code
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+  Random frames of YUV444, of YUV422 in both byte orders and of YUV411 are
+  converted to RGB8, with widths that leave a tail after the last vector of
+  each kernel, by the raw buffer function and by the frame one. Each sample
+  of the output may differ by at most 1 from that of the scalar code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dc1394/dc1394.h>
+#include "simd_check.h"
+
+static const uint32_t sizes[][2] = { { 4, 3 }, { 36, 7 }, { 100, 9 }, { 1028, 5 }, { 1924, 4 } };
+
+static const struct {
+    dc1394color_coding_t coding;
+    uint32_t byte_order;
+    uint32_t bits;             /* per pixel */
+    uint32_t pixels;           /* of which the width must be a multiple */
+} inputs[] = {
+    { DC1394_COLOR_CODING_YUV444, DC1394_BYTE_ORDER_UYVY, 24, 1 },
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_UYVY, 16, 2 },
+    { DC1394_COLOR_CODING_YUV422, DC1394_BYTE_ORDER_YUYV, 16, 2 },
+    { DC1394_COLOR_CODING_YUV411, DC1394_BYTE_ORDER_UYVY, 12, 4 }
+};
+
+static void
+cases(simd_check_t *check)
+{
+    dc1394video_frame_t in, out;
+    uint32_t s, k, i, w, h, bytes, state = 2463534242u;
+    uint8_t *src, *rgb;
+    char name[128];
+    dc1394error_t err;
+
+    for (k = 0; k < sizeof(inputs) / sizeof(inputs[0]); k++) {
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            w = sizes[s][0] / inputs[k].pixels * inputs[k].pixels;
+            h = sizes[s][1];
+            bytes = w * h * inputs[k].bits / 8;
+            src = (uint8_t*)malloc(bytes);
+            rgb = (uint8_t*)malloc(3 * w * h);
+            if ((src == NULL) || (rgb == NULL))
+                exit(1);
+            for (i = 0; i < bytes; i++)
+                src[i] = (uint8_t)simd_check_random(&state);
+
+            memset(rgb, 0, 3 * w * h);
+            err = dc1394_convert_to_RGB8(src, rgb, w, h, inputs[k].byte_order, inputs[k].coding, 8);
+            snprintf(name, sizeof(name), "coding %d byte order %u %ux%u", inputs[k].coding, inputs[k].byte_order,
+                     w, h);
+            simd_check_output(check, name, &err, sizeof(err), 0);
+            simd_check_output(check, name, rgb, 3 * w * h, 1);
+
+            memset(&in, 0, sizeof(in));
+            memset(&out, 0, sizeof(out));
+            in.size[0] = w;
+            in.size[1] = h;
+            in.color_coding = inputs[k].coding;
+            in.yuv_byte_order = inputs[k].byte_order;
+            in.data_depth = 8;
+            in.image = src;
+            in.image_bytes = bytes;
+            out.color_coding = DC1394_COLOR_CODING_RGB8;
+            err = dc1394_convert_frames(&in, &out);
+            snprintf(name, sizeof(name), "frame of coding %d byte order %u %ux%u", inputs[k].coding,
+                     inputs[k].byte_order, w, h);
+            simd_check_output(check, name, &err, sizeof(err), 0);
+            if (err == DC1394_SUCCESS)
+                simd_check_output(check, name, out.image, out.image_bytes, 1);
+            free(out.image);
+
+            free(src);
+            free(rgb);
+        }
+    }
+}
+
+int
+main(void)
+{
+    return simd_check_run(cases);
+}